@@ -0,0 +1,103 @@
+#ifndef __EMUONCE_H__
+#define __EMUONCE_H__
+
+// internal header - thread-safe one-time initialization
+//
+// Used for lookup tables that are shared by all instances of a sound core.
+// Usage:
+//	static EMU_ONCE tablesInit = EMU_ONCE_INIT;
+//	...
+//	EmuOnce_Run(&tablesInit, init_tables);	// in device_start
+// When multiple threads call EmuOnce_Run at the same time, one of them runs the
+// initialization function and the others wait until it is finished.
+
+#include "../stdtype.h"
+#include "../common_def.h"	// for INLINE
+
+#if defined(_MSC_VER) && _MSC_VER >= 1400
+#include <intrin.h>
+#define EMUONCE_MSVC
+#elif defined(__GNUC__)
+#define EMUONCE_GCC
+#if defined(__unix__) || defined(__APPLE__)
+#include <sched.h>	// for sched_yield()
+#define EMUONCE_SCHED
+#endif
+#endif
+// Other compilers (including MS VC6) fall back to a simple flag that is not thread-safe.
+
+typedef volatile long EMU_ONCE;
+#define EMU_ONCE_INIT	0	// not initialized yet
+#define EMU_ONCE_BUSY	1	// initialization is running
+#define EMU_ONCE_DONE	2	// initialization is finished
+
+typedef void (*EMU_ONCE_FUNC)(void);
+
+INLINE long EmuOnce_Load(EMU_ONCE* once)
+{
+#if defined(EMUONCE_MSVC)
+	return _InterlockedCompareExchange(once, 0, 0);	// full barrier
+#elif defined(EMUONCE_GCC) && defined(__ATOMIC_ACQUIRE)
+	return __atomic_load_n(once, __ATOMIC_ACQUIRE);
+#elif defined(EMUONCE_GCC)
+	return __sync_val_compare_and_swap(once, 0, 0);	// full barrier
+#else
+	return *once;
+#endif
+}
+
+// returns the previous value
+INLINE long EmuOnce_CmpXchg(EMU_ONCE* once, long oldVal, long newVal)
+{
+#if defined(EMUONCE_MSVC)
+	return _InterlockedCompareExchange(once, newVal, oldVal);
+#elif defined(EMUONCE_GCC)
+	return __sync_val_compare_and_swap(once, oldVal, newVal);
+#else
+	long curVal = *once;
+	if (curVal == oldVal)
+		*once = newVal;
+	return curVal;
+#endif
+}
+
+INLINE void EmuOnce_Store(EMU_ONCE* once, long val)
+{
+#if defined(EMUONCE_MSVC)
+	_InterlockedExchange(once, val);
+#elif defined(EMUONCE_GCC) && defined(__ATOMIC_RELEASE)
+	__atomic_store_n(once, val, __ATOMIC_RELEASE);
+#elif defined(EMUONCE_GCC)
+	__sync_synchronize();
+	*once = val;
+#else
+	*once = val;
+#endif
+	return;
+}
+
+INLINE void EmuOnce_Run(EMU_ONCE* once, EMU_ONCE_FUNC initFunc)
+{
+	if (EmuOnce_Load(once) == EMU_ONCE_DONE)
+		return;	// fast path: already initialized
+	
+	if (EmuOnce_CmpXchg(once, EMU_ONCE_INIT, EMU_ONCE_BUSY) == EMU_ONCE_INIT)
+	{
+		initFunc();
+		EmuOnce_Store(once, EMU_ONCE_DONE);
+		return;
+	}
+	
+	// Another thread is running the initialization. As this takes only a few milliseconds,
+	// just wait for it to finish.
+	while(EmuOnce_Load(once) != EMU_ONCE_DONE)
+	{
+#ifdef EMUONCE_SCHED
+		sched_yield();
+#endif
+	}
+	
+	return;
+}
+
+#endif	// __EMUONCE_H__
@@ -41,6 +41,9 @@ typedef UINT16 (*DEVFUNC_READ_A16D16)(void* info, UINT16 addr);
 typedef UINT32 (*DEVFUNC_READ_CLOCK)(void* info);
 typedef UINT32 (*DEVFUNC_READ_SRATE)(void* info);
 typedef UINT32 (*DEVFUNC_READ_VOLUME)(void* info);
+// idle query: returns 1 if the Update function would only output silence and not change
+// the emulation state, so that calling it can be skipped
+typedef UINT8 (*DEVFUNC_READ_IDLE)(void* info);
 
 typedef void (*DEVFUNC_WRITE_A8D8)(void* info, UINT8 addr, UINT8 data);
 typedef void (*DEVFUNC_WRITE_A8D16)(void* info, UINT8 addr, UINT16 data);
@@ -48,10 +51,22 @@ typedef void (*DEVFUNC_WRITE_A16D8)(void* info, UINT16 addr, UINT8 data);
 typedef void (*DEVFUNC_WRITE_A16D16)(void* info, UINT16 addr, UINT16 data);
 typedef void (*DEVFUNC_WRITE_MEMSIZE)(void* info, UINT32 memsize);
 typedef void (*DEVFUNC_WRITE_BLOCK)(void* info, UINT32 offset, UINT32 length, const UINT8* data);
+// link external ROM data: The device uses the data directly instead of its own copy.
+// The data is read-only and must stay valid until the device is stopped or another ROM is linked.
+// Calling DEVRW_MEMSIZE with a different size or DEVRW_BLOCK unlinks it again. (copy-on-write)
+typedef void (*DEVFUNC_WRITE_MEMLINK)(void* info, UINT32 memsize, const UINT8* data);
 typedef void (*DEVFUNC_WRITE_CLOCK)(void* info, UINT32 clock);
 typedef void (*DEVFUNC_WRITE_VOLUME)(void* info, INT32 volume);	// 16.16 fixed point
 typedef void (*DEVFUNC_WRITE_VOL_LR)(void* info, INT32 volL, INT32 volR);
 
+// save state: returns number of bytes required/written, call with buffer == NULL to query the size
+typedef UINT32 (*DEVFUNC_SAVE_STATE)(void* info, UINT32 bufSize, void* buffer);
+// load state: returns 0 on success, data must come from the same device instance
+typedef UINT8 (*DEVFUNC_LOAD_STATE)(void* info, UINT32 bufSize, const void* buffer);
+// advance: emulates the given number of samples like the Update function, but without generating output
+// (The emulation state afterwards must be the same as after calling Update.)
+typedef void (*DEVFUNC_ADVANCE)(void* info, UINT32 samples);
+
 #define RWF_WRITE		0x00
 #define RWF_READ		0x01
 #define RWF_QUICKWRITE	(0x02 | RWF_WRITE)
@@ -63,8 +78,11 @@ typedef void (*DEVFUNC_WRITE_VOL_LR)(void* info, INT32 volL, INT32 volR);
 #define RWF_SRATE		0x82	// sample rate
 #define RWF_VOLUME		0x84	// volume (all speakers)
 #define RWF_VOLUME_LR	0x86	// volume (left/right separately)
+#define RWF_IDLE		0x88	// idle state (read only, DEVRW_VALUE)
+#define RWF_ADVANCE		0x8A	// advance emulation without output (write only, DEVRW_VALUE)
 #define RWF_CHN_MUTE	0x90	// set channel muting (DEVRW_VALUE = single channel, DEVRW_ALL = mask)
 #define RWF_CHN_PAN		0x92	// set channel panning (DEVRW_VALUE = single channel, DEVRW_ALL = array)
+#define RWF_STATE		0xA0	// save (read) / restore (write) emulation state (DEVRW_BLOCK)
 
 // register/memory DEVRW constants
 #define DEVRW_A8D8		0x11	//  8-bit address,  8-bit data
@@ -73,6 +91,7 @@ typedef void (*DEVFUNC_WRITE_VOL_LR)(void* info, INT32 volL, INT32 volR);
 #define DEVRW_A16D16	0x22	// 16-bit address, 16-bit data
 #define DEVRW_BLOCK		0x80	// write sample ROM/RAM
 #define DEVRW_MEMSIZE	0x81	// set ROM/RAM size
+#define DEVRW_MEMLINK	0x82	// use external, read-only ROM data
 // chip setting DEVRW constants
 #define DEVRW_VALUE		0x00
 #define DEVRW_ALL		0x01
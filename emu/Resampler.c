@@ -1,5 +1,7 @@
 #include <stddef.h>
 #include <stdlib.h>	// for malloc/free
+#include <string.h>	// for memmove
+#include <math.h>
 #ifdef _DEBUG
 #include <stdio.h>
 #endif
@@ -7,11 +9,14 @@
 #include "../stdtype.h"
 #include "EmuStructs.h"
 #include "Resampler.h"
+#include "ResmplKernels.h"
 
 static void Resmpl_Exec_Old(RESMPL_STATE* CAA, UINT32 length, WAVE_32BS* retSample);
 static void Resmpl_Exec_LinearUp(RESMPL_STATE* CAA, UINT32 length, WAVE_32BS* retSample);
 static void Resmpl_Exec_Copy(RESMPL_STATE* CAA, UINT32 length, WAVE_32BS* retSample);
 static void Resmpl_Exec_LinearDown(RESMPL_STATE* CAA, UINT32 length, WAVE_32BS* retSample);
+static void Resmpl_Exec_Sinc(RESMPL_STATE* CAA, UINT32 length, WAVE_32BS* retSample);
+static void Resmpl_FIR_Free(RESMPL_STATE* CAA);
 
 // Ensures `CAA->smplBufs[0]` and `CAA->smplBufs[1]` can each contain at least `length` samples.
 static void Resmpl_EnsureBuffers(RESMPL_STATE* CAA, UINT32 length)
@@ -30,11 +35,62 @@ static void Resmpl_EnsureBuffers(RESMPL_STATE* CAA, UINT32 length)
 	}
 }
 
+// Renders `length` samples of the device. Idle devices are not called and generate silence.
+static void Resmpl_StreamUpdate(RESMPL_STATE* CAA, UINT32 length, DEV_SMPL** outputs)
+{
+	if (CAA->su_IsIdle != NULL && CAA->su_IsIdle(CAA->su_DataPtr))
+	{
+		memset(outputs[0], 0x00, length * sizeof(DEV_SMPL));
+		memset(outputs[1], 0x00, length * sizeof(DEV_SMPL));
+		return;
+	}
+	CAA->StreamUpdate(CAA->su_DataPtr, length, outputs);
+	return;
+}
+
+// Emulates `length` samples of the device without using the output. Idle devices are not called.
+static void Resmpl_StreamAdvance(RESMPL_STATE* CAA, UINT32 length)
+{
+	UINT32 smpls;
+	
+	if (CAA->su_IsIdle != NULL && CAA->su_IsIdle(CAA->su_DataPtr))
+		return;
+	if (CAA->su_Advance != NULL)
+	{
+		CAA->su_Advance(CAA->su_DataPtr, length);
+		return;
+	}
+	
+	// fallback: render into the sample buffer and discard the data
+	while(length > 0)
+	{
+		smpls = (length < CAA->smplBufSize) ? length : CAA->smplBufSize;
+		CAA->StreamUpdate(CAA->su_DataPtr, smpls, CAA->smplBufs);
+		length -= smpls;
+	}
+	return;
+}
+
 void Resmpl_DevConnect(RESMPL_STATE* CAA, const DEV_INFO* devInf)
 {
+	const DEVDEF_RWFUNC* rwf;
+	
 	CAA->smpRateSrc = devInf->sampleRate;
 	CAA->StreamUpdate = devInf->devDef->Update;
 	CAA->su_DataPtr = devInf->dataPtr;
+	CAA->su_IsIdle = NULL;
+	CAA->su_Advance = NULL;
+	for (rwf = devInf->devDef->rwFuncs; rwf != NULL && rwf->funcPtr != NULL; rwf ++)
+	{
+		if (rwf->rwType != DEVRW_VALUE)
+			continue;
+		if (rwf->funcType == (RWF_SRATE | RWF_READ))
+			CAA->smpRateSrc = ((DEVFUNC_READ_SRATE)rwf->funcPtr)(CAA->su_DataPtr);	// options may have changed the rate
+		else if (rwf->funcType == (RWF_IDLE | RWF_READ))
+			CAA->su_IsIdle = (DEVFUNC_READ_IDLE)rwf->funcPtr;
+		else if (rwf->funcType == (RWF_ADVANCE | RWF_WRITE))
+			CAA->su_Advance = (DEVFUNC_ADVANCE)rwf->funcPtr;
+	}
 	if (devInf->devDef->SetSRateChgCB != NULL)
 		devInf->devDef->SetSRateChgCB(CAA->su_DataPtr, Resmpl_ChangeRate, CAA);
 	
@@ -78,6 +134,12 @@ static void Resmpl_ChooseResampler(RESMPL_STATE* CAA)
 		else if (CAA->smpRateSrc > CAA->smpRateDst)
 			CAA->resampler = Resmpl_Exec_Old;
 		break;
+	case RSMODE_SINC:	// windowed-sinc FIR filter (best quality)
+		if (CAA->smpRateSrc == CAA->smpRateDst)
+			CAA->resampler = Resmpl_Exec_Copy;
+		else
+			CAA->resampler = Resmpl_Exec_Sinc;
+		break;
 	default:
 #ifdef _DEBUG
 		printf("Invalid resampler mode 0x%02X used!\n", CAA->resampleMode);
@@ -96,12 +158,25 @@ void Resmpl_Init(RESMPL_STATE* CAA)
 	}
 	
 	Resmpl_ChooseResampler(CAA);
+	CAA->kernels = ResmplKern_GetBest();
+	CAA->fir = NULL;	// the filter is set up when it is used for the first time
 	
 	CAA->smplBufSize = 0;
 	CAA->smplBufs[0] = NULL;
 	CAA->smplBufs[1] = NULL;
 	Resmpl_EnsureBuffers(CAA, CAA->smpRateSrc / 1); // reserve initial buffer for 1 second of samples
 	
+	Resmpl_Reset(CAA);
+	
+	return;
+}
+
+void Resmpl_Reset(RESMPL_STATE* CAA)
+{
+	if (CAA->resampler == NULL)
+		return;
+	
+	Resmpl_FIR_Free(CAA);	// clears the filter history, the filter is set up again when it is used
 	CAA->smpP = 0x00;
 	CAA->smpLast = 0x00;
 	CAA->smpNext = 0x00;
@@ -110,7 +185,7 @@ void Resmpl_Init(RESMPL_STATE* CAA)
 	if (CAA->resampler == Resmpl_Exec_LinearUp)
 	{
 		// Pregenerate first Sample (the upsampler is always one too late)
-		CAA->StreamUpdate(CAA->su_DataPtr, 1, CAA->smplBufs);
+		Resmpl_StreamUpdate(CAA, 1, CAA->smplBufs);
 		CAA->nSmpl.L = CAA->smplBufs[0][0];
 		CAA->nSmpl.R = CAA->smplBufs[1][0];
 	}
@@ -129,6 +204,7 @@ void Resmpl_Deinit(RESMPL_STATE* CAA)
 	free(CAA->smplBufs[0]);
 	CAA->smplBufs[0] = NULL;
 	CAA->smplBufs[1] = NULL;
+	Resmpl_FIR_Free(CAA);
 	
 	return;
 }
@@ -161,6 +237,9 @@ void Resmpl_ChangeRate(void* DataPtr, UINT32 newSmplRate)
 	#define SLI_BITS	64
 #endif
 #define FIXPNT_MASK		(FIXPNT_FACT - 1)
+#if FIXPNT_BITS != RSMPLK_FRAC_BITS
+#error "FIXPNT_BITS must match the fraction of the resampler kernels!"
+#endif
 #define FIXPNT_OFLW_BIT	(SLI_BITS - FIXPNT_BITS)
 
 #define getfraction(x)	((x) & FIXPNT_MASK)
@@ -201,7 +280,7 @@ static void Resmpl_Exec_Old(RESMPL_STATE* CAA, UINT32 length, WAVE_32BS* retSamp
 			CurBufL = CAA->smplBufs[0];
 			CurBufR = CAA->smplBufs[1];
 			
-			CAA->StreamUpdate(CAA->su_DataPtr, SmpCnt, CAA->smplBufs);
+			Resmpl_StreamUpdate(CAA, SmpCnt, CAA->smplBufs);
 			
 			// This is a mix between nearest-neighbour resampling and interpolation.
 			// If only 1 sample is rendered by the sound core, the sample is copied over as-is.
@@ -256,66 +335,86 @@ static void Resmpl_Exec_LinearUp(RESMPL_STATE* CAA, UINT32 length, WAVE_32BS* re
 	UINT32 InBase;
 	UINT32 InPos;
 	UINT32 OutPos;
-	UINT32 SmpFrc;	// Sample Fraction
 	UINT32 InPre;
 	UINT32 InNow;
 	SLINT InPosL;
-	INT64 TempSmpL;
-	INT64 TempSmpR;
-	INT32 SmpCnt;	// must be signed, else I'm getting calculation errors
 	UINT64 ChipSmpRateFP;
+	UINT64 PosQuot;	// position = PosQuot + PosRem / smpRateDst
+	UINT32 PosRem;
+	UINT64 StepQuot;
+	UINT32 StepRem;
+	UINT32 PosList[0x100];
+	UINT32 BlkPos;
+	UINT32 BlkLen;
+	
+	if (! length)
+		return;
 	
 	ChipSmpRateFP = FIXPNT_FACT * (UINT64)CAA->smpRateSrc;
-	// TODO: Make it work *properly* with large blocks. (this is very hackish)
-	for (OutPos = 0; OutPos < length; OutPos ++)
+	// The interpolation for an output sample uses the input samples around its position.
+	// So all input samples up to the position of the last output sample are rendered at once.
+	InPosL = (SLINT)((CAA->smpP + length - 1) * ChipSmpRateFP / CAA->smpRateDst);
+	InNow = (UINT32)fp2i_ceil(InPosL);
+	
+	// Buffer layout: [0] = sample smpNext-1, [1] = sample smpNext, [2..] = newly rendered samples
+	// The interpolation kernel may read one sample past the last position, so there is 1 extra sample.
+	Resmpl_EnsureBuffers(CAA, InNow - CAA->smpNext + 3);
+	CurBufL = CAA->smplBufs[0];
+	CurBufR = CAA->smplBufs[1];
+	CurBufL[0] = CAA->lSmpl.L;
+	CurBufR[0] = CAA->lSmpl.R;
+	CurBufL[1] = CAA->nSmpl.L;
+	CurBufR[1] = CAA->nSmpl.R;
+	if (InNow != CAA->smpNext)
 	{
-		InPosL = (SLINT)(CAA->smpP * ChipSmpRateFP / CAA->smpRateDst);
-		InPre = (UINT32)fp2i_floor(InPosL);
-		InNow = (UINT32)fp2i_ceil(InPosL);
-		
-		Resmpl_EnsureBuffers(CAA, InNow - CAA->smpNext + 2);
-		CurBufL = CAA->smplBufs[0];
-		CurBufR = CAA->smplBufs[1];
-		
-		CurBufL[0] = CAA->lSmpl.L;
-		CurBufR[0] = CAA->lSmpl.R;
-		CurBufL[1] = CAA->nSmpl.L;
-		CurBufR[1] = CAA->nSmpl.R;
-		if (InNow != CAA->smpNext)
+		StreamPnt[0] = &CurBufL[2];
+		StreamPnt[1] = &CurBufR[2];
+		Resmpl_StreamUpdate(CAA, InNow - CAA->smpNext, StreamPnt);
+	}
+	CurBufL[InNow - CAA->smpNext + 2] = 0;
+	CurBufR[InNow - CAA->smpNext + 2] = 0;
+	
+	// I'm adding 1.0, because the buffer begins with the sample before smpNext.
+	InBase = FIXPNT_FACT - (UINT32)((SLINT)CAA->smpNext * FIXPNT_FACT);
+	// The positions are calculated incrementally, which gives the same result as
+	// (smpP + OutPos) * ChipSmpRateFP / smpRateDst, but without a division per sample.
+	PosQuot = CAA->smpP * ChipSmpRateFP;
+	PosRem = (UINT32)(PosQuot % CAA->smpRateDst);
+	PosQuot /= CAA->smpRateDst;
+	StepQuot = ChipSmpRateFP / CAA->smpRateDst;
+	StepRem = (UINT32)(ChipSmpRateFP % CAA->smpRateDst);
+	InPos = InBase;
+	for (OutPos = 0; OutPos < length; OutPos += BlkLen)
+	{
+		BlkLen = length - OutPos;
+		if (BlkLen > sizeof(PosList) / sizeof(PosList[0]))
+			BlkLen = sizeof(PosList) / sizeof(PosList[0]);
+		for (BlkPos = 0; BlkPos < BlkLen; BlkPos ++)
 		{
-			StreamPnt[0] = &CurBufL[2];
-			StreamPnt[1] = &CurBufR[2];
-			CAA->StreamUpdate(CAA->su_DataPtr, InNow - CAA->smpNext, StreamPnt);
+			PosList[BlkPos] = InBase + (UINT32)(SLINT)PosQuot;
+			PosQuot += StepQuot;
+			PosRem += StepRem;
+			if (PosRem >= CAA->smpRateDst)
+			{
+				PosRem -= CAA->smpRateDst;
+				PosQuot ++;
+			}
 		}
-		
-		InBase = FIXPNT_FACT + (UINT32)(InPosL - (SLINT)CAA->smpNext * FIXPNT_FACT);
-		SmpCnt = FIXPNT_FACT;
-		CAA->smpLast = InPre;
-		CAA->smpNext = InNow;
-		//for (OutPos = 0; OutPos < length; OutPos ++)
-		//{
-		//InPos = InBase + (UINT32)(OutPos * ChipSmpRateFP / CAA->smpRateDst);
-		InPos = InBase;
-		
-		InPre = fp2i_floor(InPos);
-		InNow = fp2i_ceil(InPos);
-		SmpFrc = getfraction(InPos);
-		
-		// Linear interpolation
-		TempSmpL = ((INT64)CurBufL[InPre] * (FIXPNT_FACT - SmpFrc)) +
-					((INT64)CurBufL[InNow] * SmpFrc);
-		TempSmpR = ((INT64)CurBufR[InPre] * (FIXPNT_FACT - SmpFrc)) +
-					((INT64)CurBufR[InNow] * SmpFrc);
-		retSample[OutPos].L += (INT32)(TempSmpL * CAA->volumeL / SmpCnt);
-		retSample[OutPos].R += (INT32)(TempSmpR * CAA->volumeR / SmpCnt);
-		//}
-		CAA->lSmpl.L = CurBufL[InPre];
-		CAA->lSmpl.R = CurBufR[InPre];
-		CAA->nSmpl.L = CurBufL[InNow];
-		CAA->nSmpl.R = CurBufR[InNow];
-		CAA->smpP ++;
+		CAA->kernels->linear(&retSample[OutPos], CurBufL, CurBufR, PosList, BlkLen,
+			CAA->volumeL, CAA->volumeR);
+		InPos = PosList[BlkLen - 1];
 	}
 	
+	InPre = fp2i_floor(InPos);
+	InNow = fp2i_ceil(InPos);
+	CAA->lSmpl.L = CurBufL[InPre];
+	CAA->lSmpl.R = CurBufR[InPre];
+	CAA->nSmpl.L = CurBufL[InNow];
+	CAA->nSmpl.R = CurBufR[InNow];
+	CAA->smpLast = (UINT32)fp2i_floor(InPosL);
+	CAA->smpNext = (UINT32)fp2i_ceil(InPosL);
+	CAA->smpP += length;
+	
 	if (CAA->smpLast >= CAA->smpRateSrc)
 	{
 		CAA->smpLast -= CAA->smpRateSrc;
@@ -329,17 +428,11 @@ static void Resmpl_Exec_LinearUp(RESMPL_STATE* CAA, UINT32 length, WAVE_32BS* re
 static void Resmpl_Exec_Copy(RESMPL_STATE* CAA, UINT32 length, WAVE_32BS* retSample)
 {
 	// RESALGO_COPY: Copying
-	UINT32 OutPos;
-	
 	CAA->smpNext = CAA->smpP * CAA->smpRateSrc / CAA->smpRateDst;
 	Resmpl_EnsureBuffers(CAA, length);
-	CAA->StreamUpdate(CAA->su_DataPtr, length, CAA->smplBufs);
+	Resmpl_StreamUpdate(CAA, length, CAA->smplBufs);
 	
-	for (OutPos = 0; OutPos < length; OutPos ++)
-	{
-		retSample[OutPos].L += CAA->smplBufs[0][OutPos] * CAA->volumeL;
-		retSample[OutPos].R += CAA->smplBufs[1][OutPos] * CAA->volumeR;
-	}
+	CAA->kernels->copy(retSample, CAA->smplBufs[0], CAA->smplBufs[1], length, CAA->volumeL, CAA->volumeR);
 	CAA->smpP += length;
 	CAA->smpLast = CAA->smpNext;
 	
@@ -353,16 +446,12 @@ static void Resmpl_Exec_Copy(RESMPL_STATE* CAA, UINT32 length, WAVE_32BS* retSam
 	return;
 }
 
-// TODO: The resample is not completely stable.
-//	Resampling tiny blocks (1 resulting sample) sometimes causes values to be off-by-one,
-//	compared to resampling large blocks.
 static void Resmpl_Exec_LinearDown(RESMPL_STATE* CAA, UINT32 length, WAVE_32BS* retSample)
 {
 	// RESALGO_LINEAR_DOWN: Linear Downsampling
 	DEV_SMPL* CurBufL;
 	DEV_SMPL* CurBufR;
 	DEV_SMPL* StreamPnt[0x02];
-	UINT32 InBase;
 	UINT32 InPos;
 	UINT32 InPosNext;
 	UINT32 OutPos;
@@ -374,6 +463,12 @@ static void Resmpl_Exec_LinearDown(RESMPL_STATE* CAA, UINT32 length, WAVE_32BS*
 	INT64 TempSmpR;
 	INT32 SmpCnt;	// must be signed, else I'm getting calculation errors
 	UINT64 ChipSmpRateFP;
+	UINT64 PosQuot;	// position = PosQuot + PosRem / smpRateDst
+	UINT32 PosRem;
+	UINT64 StepQuot;
+	UINT32 StepRem;
+	INT64 SumL;
+	INT64 SumR;
 	
 	ChipSmpRateFP = FIXPNT_FACT * (UINT64)CAA->smpRateSrc;
 	InPosL = (SLINT)((CAA->smpP + length) * ChipSmpRateFP / CAA->smpRateDst);
@@ -395,18 +490,29 @@ static void Resmpl_Exec_LinearDown(RESMPL_STATE* CAA, UINT32 length, WAVE_32BS*
 	CurBufR[0] = CAA->lSmpl.R;
 	StreamPnt[0] = &CurBufL[1];
 	StreamPnt[1] = &CurBufR[1];
-	CAA->StreamUpdate(CAA->su_DataPtr, CAA->smpNext - CAA->smpLast, StreamPnt);
+	Resmpl_StreamUpdate(CAA, CAA->smpNext - CAA->smpLast, StreamPnt);
 	
-	InPosL = (SLINT)(CAA->smpP * ChipSmpRateFP / CAA->smpRateDst);
+	// Each output sample p averages the input range [p * R, p * R + floor(R)) with R = ChipSmpRateFP / smpRateDst.
+	// The window is calculated from the absolute sample number, so that the result
+	// doesn't depend on the size of the blocks that are rendered.
+	PosQuot = CAA->smpP * ChipSmpRateFP;
+	PosRem = (UINT32)(PosQuot % CAA->smpRateDst);
+	PosQuot /= CAA->smpRateDst;
+	StepQuot = ChipSmpRateFP / CAA->smpRateDst;
+	StepRem = (UINT32)(ChipSmpRateFP % CAA->smpRateDst);
 	// I'm adding 1.0 to avoid negative indexes
-	InBase = FIXPNT_FACT + (UINT32)(InPosL - (SLINT)CAA->smpLast * FIXPNT_FACT);
-	InPosNext = InBase;
-	InPre = fp2i_floor(InPosNext);
+	InPre = fp2i_floor(FIXPNT_FACT + (UINT32)((SLINT)PosQuot - (SLINT)CAA->smpLast * FIXPNT_FACT));
 	for (OutPos = 0; OutPos < length; OutPos ++)
 	{
-		//InPos = InBase + (UINT32)(OutPos * ChipSmpRateFP / CAA->smpRateDst);
-		InPos = InPosNext;
-		InPosNext = InBase + (UINT32)((OutPos+1) * ChipSmpRateFP / CAA->smpRateDst);
+		InPos = FIXPNT_FACT + (UINT32)((SLINT)PosQuot - (SLINT)CAA->smpLast * FIXPNT_FACT);
+		InPosNext = InPos + (UINT32)StepQuot;
+		PosQuot += StepQuot;
+		PosRem += StepRem;
+		if (PosRem >= CAA->smpRateDst)
+		{
+			PosRem -= CAA->smpRateDst;
+			PosQuot ++;
+		}
 		
 		// first fractional Sample
 		SmpFrc = getnfraction(InPos);
@@ -436,12 +542,22 @@ static void Resmpl_Exec_LinearDown(RESMPL_STATE* CAA, UINT32 length, WAVE_32BS*
 		//InPre = fp2i_floor(InPosNext);
 		InNow = fp2i_ceil(InPos);
 		SmpCnt += (InPre - InNow) * FIXPNT_FACT;	// this is faster
-		while(InNow < InPre)
+		if (InNow + 8 <= InPre)
 		{
-			TempSmpL += (INT64)CurBufL[InNow] * FIXPNT_FACT;
-			TempSmpR += (INT64)CurBufR[InNow] * FIXPNT_FACT;
-			//SmpCnt ++;
-			InNow ++;
+			// long runs (chips with very high sample rates) are summed up by the SIMD kernel
+			CAA->kernels->sum(&CurBufL[InNow], &CurBufR[InNow], InPre - InNow, &SumL, &SumR);
+			TempSmpL += SumL * FIXPNT_FACT;
+			TempSmpR += SumR * FIXPNT_FACT;
+		}
+		else
+		{
+			while(InNow < InPre)
+			{
+				TempSmpL += (INT64)CurBufL[InNow] * FIXPNT_FACT;
+				TempSmpR += (INT64)CurBufR[InNow] * FIXPNT_FACT;
+				//SmpCnt ++;
+				InNow ++;
+			}
 		}
 		
 		retSample[OutPos].L += (INT32)(TempSmpL * CAA->volumeL / SmpCnt);
@@ -463,6 +579,244 @@ static void Resmpl_Exec_LinearDown(RESMPL_STATE* CAA, UINT32 length, WAVE_32BS*
 	return;
 }
 
+// ---- windowed-sinc FIR resampler ----
+// The filter is stored as a polyphase table with FIR_PHASES+1 rows of coefficients.
+// Coefficients for positions between two rows are interpolated linearly.
+#define FIR_PHASES		64
+#define FIR_ZERO_CROSS	20		// number of zero crossings of the sinc function on each side
+#define FIR_MAX_TAPS	1024	// limits the filter length for chips with very high sample rates
+#define FIR_KAISER_BETA	9.0		// window shape, about 90 db stopband attenuation
+
+struct _resampler_fir
+{
+	UINT32 smpRateSrc;	// sample rates the filter was calculated for
+	UINT32 smpRateDst;
+	UINT32 taps;		// filter length (multiple of 8)
+	float* coefs;		// coefficient table: [FIR_PHASES + 1][taps]
+	UINT32 bufSize;
+	float* smplBuf[2];	// [0 .. taps-1] = last input samples, followed by new samples
+};
+
+static double Bessel_I0(double x)
+{
+	// modified Bessel function of the first kind, order 0
+	double sum = 1.0;
+	double term = 1.0;
+	double halfX2 = x * x / 4.0;
+	UINT32 k;
+	
+	for (k = 1; k < 100 && term > sum * 1e-12; k ++)
+	{
+		term *= halfX2 / ((double)k * k);
+		sum += term;
+	}
+	return sum;
+}
+
+static void Resmpl_FIR_Free(RESMPL_STATE* CAA)
+{
+	if (CAA->fir == NULL)
+		return;
+	
+	free(CAA->fir->coefs);
+	free(CAA->fir->smplBuf[0]);
+	free(CAA->fir);
+	CAA->fir = NULL;
+	
+	return;
+}
+
+static void Resmpl_FIR_Setup(RESMPL_STATE* CAA)
+{
+	const double PI = 3.14159265358979323846;
+	struct _resampler_fir* fir;
+	double scale;	// filter width factor (input samples per output sample, at least 1.0)
+	double cutoff;	// cutoff frequency, relative to the input sample rate
+	double halfLen;
+	double winDiv;
+	double* tapVals;
+	double pos;
+	double x;
+	double sum;
+	float* phaseCoefs;
+	UINT32 taps;
+	UINT32 curPhase;
+	UINT32 curTap;
+	
+	// The filter has to be wider for downsampling, in order to keep the same stopband attenuation.
+	scale = (double)CAA->smpRateSrc / CAA->smpRateDst;
+	if (scale < 1.0)
+		scale = 1.0;
+	cutoff = 0.5 / scale;
+	taps = 2 * (UINT32)ceil(FIR_ZERO_CROSS * scale);
+	taps = (taps + 7) & ~7;	// the kernels require a multiple of 8
+	if (taps > FIR_MAX_TAPS)
+		taps = FIR_MAX_TAPS;
+	halfLen = taps / 2;
+	
+	Resmpl_FIR_Free(CAA);
+	fir = (struct _resampler_fir*)calloc(1, sizeof(struct _resampler_fir));
+	if (fir == NULL)
+		abort();
+	fir->smpRateSrc = CAA->smpRateSrc;
+	fir->smpRateDst = CAA->smpRateDst;
+	fir->taps = taps;
+	fir->coefs = (float*)malloc((FIR_PHASES + 1) * taps * sizeof(float));
+	fir->bufSize = taps;
+	fir->smplBuf[0] = (float*)calloc(fir->bufSize * 2, sizeof(float));	// start with silence
+	tapVals = (double*)malloc(taps * sizeof(double));
+	if (fir->coefs == NULL || fir->smplBuf[0] == NULL || tapVals == NULL)
+		abort();
+	fir->smplBuf[1] = &fir->smplBuf[0][fir->bufSize];
+	CAA->fir = fir;
+	
+	// Kaiser-windowed sinc, each phase is normalized to a DC gain of 1.0
+	winDiv = Bessel_I0(FIR_KAISER_BETA);
+	for (curPhase = 0; curPhase <= FIR_PHASES; curPhase ++)
+	{
+		phaseCoefs = &fir->coefs[curPhase * taps];
+		sum = 0.0;
+		for (curTap = 0; curTap < taps; curTap ++)
+		{
+			// distance from the output sample, in input samples
+			pos = (double)curTap - halfLen + 1.0 - (double)curPhase / FIR_PHASES;
+			x = pos / halfLen;
+			if (x * x >= 1.0)
+			{
+				tapVals[curTap] = 0.0;
+				continue;
+			}
+			tapVals[curTap] = Bessel_I0(FIR_KAISER_BETA * sqrt(1.0 - x * x)) / winDiv;
+			x = 2.0 * cutoff * pos;
+			if (x != 0.0)
+				tapVals[curTap] *= sin(PI * x) / (PI * x);
+			sum += tapVals[curTap];
+		}
+		for (curTap = 0; curTap < taps; curTap ++)
+			phaseCoefs[curTap] = (float)(tapVals[curTap] / sum);
+	}
+	free(tapVals);
+	
+	return;
+}
+
+static void Resmpl_FIR_EnsureBuffer(struct _resampler_fir* fir, UINT32 length)
+{
+	float* newBuf;
+	
+	if (fir->bufSize >= length)
+		return;
+	
+	// keep the filter history at the beginning of the buffers
+	newBuf = (float*)malloc(length * 2 * sizeof(float));
+	if (newBuf == NULL)
+		abort();
+	memcpy(&newBuf[0], fir->smplBuf[0], fir->taps * sizeof(float));
+	memcpy(&newBuf[length], fir->smplBuf[1], fir->taps * sizeof(float));
+	free(fir->smplBuf[0]);
+	fir->bufSize = length;
+	fir->smplBuf[0] = &newBuf[0];
+	fir->smplBuf[1] = &newBuf[length];
+	
+	return;
+}
+
+static void Resmpl_Exec_Sinc(RESMPL_STATE* CAA, UINT32 length, WAVE_32BS* retSample)
+{
+	// RESALGO_SINC: windowed-sinc FIR filter
+	struct _resampler_fir* fir;
+	float* CurBufL;
+	float* CurBufR;
+	const float* CoefPtr;
+	UINT32 InNow;	// last input sample that is required
+	UINT32 InBase;
+	UINT32 NewSmpls;
+	UINT32 OutPos;
+	UINT32 CurSmpl;
+	UINT64 PosQuot;	// position = PosQuot + PosRem / smpRateDst
+	UINT32 PosRem;
+	UINT32 StepQuot;
+	UINT32 StepRem;
+	double PhaseMul;
+	double PhasePos;
+	UINT32 Phase;
+	float OutL;
+	float OutR;
+	
+	fir = CAA->fir;
+	if (fir == NULL || fir->smpRateSrc != CAA->smpRateSrc || fir->smpRateDst != CAA->smpRateDst)
+	{
+		Resmpl_FIR_Setup(CAA);
+		fir = CAA->fir;
+	}
+	if (! length)
+		return;
+	
+	// Output sample OutPos is at input position (smpP + OutPos) * smpRateSrc / smpRateDst.
+	// The filter ends at that position, i.e. the output is delayed by (taps / 2) input samples,
+	// so that only input samples up to the current position are required.
+	InNow = (UINT32)((UINT64)(CAA->smpP + length - 1) * CAA->smpRateSrc / CAA->smpRateDst);
+	NewSmpls = InNow + 1 - CAA->smpNext;
+	
+	Resmpl_FIR_EnsureBuffer(fir, fir->taps + NewSmpls);
+	CurBufL = fir->smplBuf[0];
+	CurBufR = fir->smplBuf[1];
+	if (NewSmpls)
+	{
+		Resmpl_EnsureBuffers(CAA, NewSmpls);
+		Resmpl_StreamUpdate(CAA, NewSmpls, CAA->smplBufs);
+		for (CurSmpl = 0; CurSmpl < NewSmpls; CurSmpl ++)
+		{
+			CurBufL[fir->taps + CurSmpl] = (float)CAA->smplBufs[0][CurSmpl];
+			CurBufR[fir->taps + CurSmpl] = (float)CAA->smplBufs[1][CurSmpl];
+		}
+	}
+	
+	// The filter for input sample N begins at buffer offset (N + 1 - smpNext).
+	InBase = CAA->smpNext - 1;
+	PosQuot = (UINT64)CAA->smpP * CAA->smpRateSrc;
+	PosRem = (UINT32)(PosQuot % CAA->smpRateDst);
+	PosQuot /= CAA->smpRateDst;
+	StepQuot = CAA->smpRateSrc / CAA->smpRateDst;
+	StepRem = CAA->smpRateSrc % CAA->smpRateDst;
+	PhaseMul = (double)FIR_PHASES / CAA->smpRateDst;
+	for (OutPos = 0; OutPos < length; OutPos ++)
+	{
+		PhasePos = PosRem * PhaseMul;
+		Phase = (UINT32)PhasePos;
+		CoefPtr = &fir->coefs[Phase * fir->taps];
+		CurSmpl = (UINT32)PosQuot - InBase;
+		CAA->kernels->fir(CoefPtr, CoefPtr + fir->taps, (float)(PhasePos - Phase),
+			&CurBufL[CurSmpl], &CurBufR[CurSmpl], fir->taps, &OutL, &OutR);
+		retSample[OutPos].L += (INT32)(OutL * CAA->volumeL);
+		retSample[OutPos].R += (INT32)(OutR * CAA->volumeR);
+		
+		PosQuot += StepQuot;
+		PosRem += StepRem;
+		if (PosRem >= CAA->smpRateDst)
+		{
+			PosRem -= CAA->smpRateDst;
+			PosQuot ++;
+		}
+	}
+	
+	// keep the last input samples as history for the next block
+	memmove(&CurBufL[0], &CurBufL[NewSmpls], fir->taps * sizeof(float));
+	memmove(&CurBufR[0], &CurBufR[NewSmpls], fir->taps * sizeof(float));
+	CAA->smpLast = InNow;
+	CAA->smpNext = InNow + 1;
+	CAA->smpP += length;
+	
+	if (CAA->smpLast >= CAA->smpRateSrc)
+	{
+		CAA->smpLast -= CAA->smpRateSrc;
+		CAA->smpNext -= CAA->smpRateSrc;
+		CAA->smpP -= CAA->smpRateDst;
+	}
+	
+	return;
+}
+
 void Resmpl_Execute(RESMPL_STATE* CAA, UINT32 smplCount, WAVE_32BS* smplBuffer)
 {
 	if (! smplCount)
@@ -474,3 +828,175 @@ void Resmpl_Execute(RESMPL_STATE* CAA, UINT32 smplCount, WAVE_32BS* smplBuffer)
 		CAA->smpP += CAA->smpRateDst;	// just skip the samples and do nothing else
 	return;
 }
+
+static void Resmpl_AdvanceBlock(RESMPL_STATE* CAA, UINT32 length)
+{
+	UINT64 ChipSmpRateFP;
+	UINT32 smpPos;		// output sample position after advancing
+	UINT32 inDone;		// number of input samples that were rendered so far
+	UINT32 inTarget;	// number of input samples that have to be rendered after advancing
+	UINT32 keep;		// number of input samples at the end that are required for interpolation
+	UINT32 newSmpls;
+	UINT32 advSmpls;
+	UINT32 curSmpl;
+	SLINT InPosL;
+	DEV_SMPL* lastBufL;
+	DEV_SMPL* lastBufR;
+	
+	// The number of input samples has to be calculated exactly like the resampling functions do it.
+	ChipSmpRateFP = FIXPNT_FACT * (UINT64)CAA->smpRateSrc;
+	smpPos = CAA->smpP + length;
+	InPosL = 0;
+	if (CAA->resampler == Resmpl_Exec_Copy)
+	{
+		inDone = CAA->smpP;
+		inTarget = smpPos;
+		keep = 0;
+	}
+	else if (CAA->resampler == Resmpl_Exec_Old)
+	{
+		inDone = CAA->smpNext;
+		inTarget = (UINT32)((UINT64)smpPos * CAA->smpRateSrc / CAA->smpRateDst);
+		// After a sample rate change, smpNext can be ahead of the first step.
+		// The resampling function continues rendering from the first step in that case.
+		curSmpl = (UINT32)((UINT64)(CAA->smpP + 1) * CAA->smpRateSrc / CAA->smpRateDst);
+		if (inDone > curSmpl)
+			inDone = curSmpl;
+		keep = 1;
+	}
+	else if (CAA->resampler == Resmpl_Exec_LinearDown)
+	{
+		InPosL = (SLINT)(smpPos * ChipSmpRateFP / CAA->smpRateDst);
+		inDone = CAA->smpNext;
+		inTarget = (UINT32)fp2i_ceil(InPosL);
+#if FIXPNT_OFLW_BIT < 32
+		if (inTarget < CAA->smpLast)
+		{
+			inTarget |= CAA->smpLast & ~(((UINT32)1 << FIXPNT_OFLW_BIT) - 1);
+			if (inTarget < CAA->smpLast)
+				inTarget += ((UINT32)1 << FIXPNT_OFLW_BIT);
+		}
+#endif
+		keep = 1;
+	}
+	else if (CAA->resampler == Resmpl_Exec_LinearUp)
+	{
+		// The upsampler has already rendered sample smpNext. (nSmpl)
+		InPosL = (SLINT)((smpPos - 1) * ChipSmpRateFP / CAA->smpRateDst);
+		inDone = CAA->smpNext + 1;
+		inTarget = (UINT32)fp2i_ceil(InPosL) + 1;
+		keep = 2;
+	}
+	else //if (CAA->resampler == Resmpl_Exec_Sinc)
+	{
+		if (CAA->fir == NULL || CAA->fir->smpRateSrc != CAA->smpRateSrc || CAA->fir->smpRateDst != CAA->smpRateDst)
+			Resmpl_FIR_Setup(CAA);
+		inDone = CAA->smpNext;
+		inTarget = (UINT32)((UINT64)(smpPos - 1) * CAA->smpRateSrc / CAA->smpRateDst) + 1;
+		keep = CAA->fir->taps;
+	}
+	
+	newSmpls = (inTarget > inDone) ? (inTarget - inDone) : 0;
+	advSmpls = (newSmpls > keep) ? (newSmpls - keep) : 0;
+	if (advSmpls)
+		Resmpl_StreamAdvance(CAA, advSmpls);
+	newSmpls -= advSmpls;
+	if (newSmpls)
+	{
+		Resmpl_EnsureBuffers(CAA, newSmpls);
+		Resmpl_StreamUpdate(CAA, newSmpls, CAA->smplBufs);
+	}
+	lastBufL = CAA->smplBufs[0];
+	lastBufR = CAA->smplBufs[1];
+	
+	// set the state to what the resampling function would have left
+	if (CAA->resampler == Resmpl_Exec_Copy)
+	{
+		CAA->smpNext = CAA->smpP;
+		CAA->smpLast = CAA->smpNext;
+	}
+	else if (CAA->resampler == Resmpl_Exec_Old)
+	{
+		if (newSmpls)
+		{
+			CAA->lSmpl.L = lastBufL[newSmpls - 1];
+			CAA->lSmpl.R = lastBufR[newSmpls - 1];
+		}
+		CAA->smpLast = (UINT32)((UINT64)(smpPos - 1) * CAA->smpRateSrc / CAA->smpRateDst);
+		CAA->smpNext = inTarget;
+	}
+	else if (CAA->resampler == Resmpl_Exec_LinearDown)
+	{
+		if (newSmpls)
+		{
+			CAA->lSmpl.L = lastBufL[newSmpls - 1];
+			CAA->lSmpl.R = lastBufR[newSmpls - 1];
+		}
+		CAA->smpLast = CAA->smpNext = inTarget;
+	}
+	else if (CAA->resampler == Resmpl_Exec_LinearUp)
+	{
+		// lSmpl = sample smpLast, nSmpl = sample smpNext
+		CAA->smpLast = (UINT32)fp2i_floor(InPosL);
+		CAA->smpNext = inTarget - 1;
+		if (newSmpls >= 2)
+		{
+			CAA->lSmpl.L = lastBufL[newSmpls - 2];
+			CAA->lSmpl.R = lastBufR[newSmpls - 2];
+		}
+		else if (newSmpls == 1)
+		{
+			CAA->lSmpl = CAA->nSmpl;
+		}
+		if (newSmpls)
+		{
+			CAA->nSmpl.L = lastBufL[newSmpls - 1];
+			CAA->nSmpl.R = lastBufR[newSmpls - 1];
+		}
+		if (CAA->smpLast == CAA->smpNext)
+			CAA->lSmpl = CAA->nSmpl;
+	}
+	else //if (CAA->resampler == Resmpl_Exec_Sinc)
+	{
+		struct _resampler_fir* fir = CAA->fir;
+		
+		// append the new samples to the filter history
+		Resmpl_FIR_EnsureBuffer(fir, fir->taps + newSmpls);
+		for (curSmpl = 0; curSmpl < newSmpls; curSmpl ++)
+		{
+			fir->smplBuf[0][fir->taps + curSmpl] = (float)lastBufL[curSmpl];
+			fir->smplBuf[1][fir->taps + curSmpl] = (float)lastBufR[curSmpl];
+		}
+		memmove(&fir->smplBuf[0][0], &fir->smplBuf[0][newSmpls], fir->taps * sizeof(float));
+		memmove(&fir->smplBuf[1][0], &fir->smplBuf[1][newSmpls], fir->taps * sizeof(float));
+		CAA->smpLast = inTarget - 1;
+		CAA->smpNext = inTarget;
+	}
+	CAA->smpP = smpPos;
+	
+	if (CAA->smpLast >= CAA->smpRateSrc)
+	{
+		CAA->smpLast -= CAA->smpRateSrc;
+		CAA->smpNext -= CAA->smpRateSrc;
+		CAA->smpP -= CAA->smpRateDst;
+	}
+	
+	return;
+}
+
+void Resmpl_Advance(RESMPL_STATE* CAA, UINT32 smplCount)
+{
+	UINT32 blkSize;
+	
+	if (CAA->resampler == NULL)
+		return;
+	
+	// advance in blocks of 1 second, so that the sample positions don't overflow
+	while(smplCount > 0)
+	{
+		blkSize = (smplCount < CAA->smpRateDst) ? smplCount : CAA->smpRateDst;
+		Resmpl_AdvanceBlock(CAA, blkSize);
+		smplCount -= blkSize;
+	}
+	return;
+}
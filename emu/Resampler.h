@@ -24,6 +24,7 @@ struct _waveform_32bit_stereo
 #define RSMODE_LINEAR	0x00	// linear interpolation (good quality)
 #define RSMODE_NEAREST	0x01	// nearest-neighbour (low quality)
 #define RSMODE_LUP_NDWN	0x02	// nearest-neighbour downsampling, interpolation upsampling
+#define RSMODE_SINC		0x03	// windowed-sinc polyphase FIR filter (best quality, slow)
 struct _resampling_state
 {
 	UINT32 smpRateSrc;
@@ -34,6 +35,8 @@ struct _resampling_state
 	RESAMPLER_FUNC resampler;
 	DEVFUNC_UPDATE StreamUpdate;
 	void* su_DataPtr;
+	DEVFUNC_READ_IDLE su_IsIdle;	// optional, StreamUpdate isn't called while it returns 1
+	DEVFUNC_ADVANCE su_Advance;		// optional, used by Resmpl_Advance instead of StreamUpdate
 	UINT32 smpP;		// Current Sample (Playback Rate)
 	UINT32 smpLast;		// Sample Number Last
 	UINT32 smpNext;		// Sample Number Next
@@ -41,6 +44,8 @@ struct _resampling_state
 	WAVE_32BS nSmpl;	// Next Sample
 	UINT32 smplBufSize;
 	DEV_SMPL* smplBufs[2];
+	const struct _resampler_kernels* kernels;	// block processing functions (internal)
+	struct _resampler_fir* fir;	// FIR filter state (internal, RSMODE_SINC only)
 };
 
 // ---- resampler helper functions (for quick/comfortable initialization) ----
@@ -68,6 +73,13 @@ void Resmpl_SetVals(RESMPL_STATE* CAA, UINT8 resampleMode, UINT16 volume, UINT32
  * @param CAA resampler to be initialized
  */
 void Resmpl_Init(RESMPL_STATE* CAA);
+/**
+ * @brief Resets the position and the sample history of a resampler, as if it was just initialized.
+ *        Should be called after the connected sound device was reset.
+ *
+ * @param CAA resampler to be reset
+ */
+void Resmpl_Reset(RESMPL_STATE* CAA);
 /**
  * @brief Deinitializes a resampler and frees used memory.
  *
@@ -88,6 +100,15 @@ void Resmpl_ChangeRate(void* DataPtr, UINT32 newSmplRate);
  * @param smplBuffer buffer for output data
  */
 void Resmpl_Execute(RESMPL_STATE* CAA, UINT32 samples, WAVE_32BS* smplBuffer);
+/**
+ * @brief Advances the device by the same amount of time as Resmpl_Execute, but without generating output.
+ *        Devices without an Advance function are rendered into a scratch buffer.
+ *        The last few input samples are rendered normally, so that Resmpl_Execute can continue seamlessly.
+ *
+ * @param CAA resampler to be advanced
+ * @param samples number of output samples to be skipped
+ */
+void Resmpl_Advance(RESMPL_STATE* CAA, UINT32 samples);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,639 @@
+// Resampler Kernels
+// -----------------
+// Block processing functions for the resampler, with SIMD versions that are selected at runtime.
+// All versions produce exactly the same results as the plain C versions.
+#include <stddef.h>
+
+#include "../stdtype.h"
+#include "../common_def.h"
+#include "snddef.h"
+#include "Resampler.h"
+#include "ResmplKernels.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define RSK_X86
+#if defined(__x86_64__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define RSK_SSE2_ALWAYS	// SSE2 is part of the base instruction set
+#endif
+#if defined(__GNUC__) && (__GNUC__ >= 5 || defined(__clang__))
+#define RSK_HAVE_SSE2
+#define RSK_HAVE_AVX2
+#define RSK_TGT_SSE2	__attribute__((target("sse2")))
+#define RSK_TGT_AVX2	__attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(_MSC_VER) && _MSC_VER >= 1800	// MSVC 2013+
+#define RSK_HAVE_SSE2
+#define RSK_HAVE_AVX2
+#define RSK_TGT_SSE2
+#define RSK_TGT_AVX2
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+#endif	// x86
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define RSK_HAVE_NEON
+#include <arm_neon.h>
+#endif
+
+#define FRAC_FACT	(1 << RSMPLK_FRAC_BITS)
+#define FRAC_MASK	(FRAC_FACT - 1)
+
+
+// ---- plain C ----
+static void Kern_Copy_C(WAVE_32BS* dst, const DEV_SMPL* srcL, const DEV_SMPL* srcR,
+	UINT32 length, INT32 volL, INT32 volR)
+{
+	UINT32 curSmpl;
+	
+	for (curSmpl = 0; curSmpl < length; curSmpl ++)
+	{
+		dst[curSmpl].L += srcL[curSmpl] * volL;
+		dst[curSmpl].R += srcR[curSmpl] * volR;
+	}
+	
+	return;
+}
+
+static void Kern_Linear_C(WAVE_32BS* dst, const DEV_SMPL* bufL, const DEV_SMPL* bufR,
+	const UINT32* posList, UINT32 length, INT32 volL, INT32 volR)
+{
+	UINT32 curSmpl;
+	UINT32 idx;
+	UINT32 frc;
+	INT64 tempL;
+	INT64 tempR;
+	
+	for (curSmpl = 0; curSmpl < length; curSmpl ++)
+	{
+		idx = posList[curSmpl] >> RSMPLK_FRAC_BITS;
+		frc = posList[curSmpl] & FRAC_MASK;
+		tempL = (INT64)bufL[idx] * (FRAC_FACT - frc) + (INT64)bufL[idx + 1] * frc;
+		tempR = (INT64)bufR[idx] * (FRAC_FACT - frc) + (INT64)bufR[idx + 1] * frc;
+		dst[curSmpl].L += (INT32)(tempL * volL / FRAC_FACT);
+		dst[curSmpl].R += (INT32)(tempR * volR / FRAC_FACT);
+	}
+	
+	return;
+}
+
+static void Kern_Sum_C(const DEV_SMPL* bufL, const DEV_SMPL* bufR, UINT32 count,
+	INT64* sumL, INT64* sumR)
+{
+	UINT32 curSmpl;
+	INT64 accL = 0;
+	INT64 accR = 0;
+	
+	for (curSmpl = 0; curSmpl < count; curSmpl ++)
+	{
+		accL += bufL[curSmpl];
+		accR += bufR[curSmpl];
+	}
+	*sumL = accL;
+	*sumR = accR;
+	
+	return;
+}
+
+static void Kern_FIR_C(const float* coefA, const float* coefB, float frac,
+	const float* bufL, const float* bufR, UINT32 taps, float* outL, float* outR)
+{
+	// 8 separate sums, like the 8 lanes of the SIMD versions
+	UINT32 curTap;
+	UINT32 curLane;
+	float coef;
+	float accL[8];
+	float accR[8];
+	
+	for (curLane = 0; curLane < 8; curLane ++)
+		accL[curLane] = accR[curLane] = 0.0f;
+	for (curTap = 0; curTap < taps; curTap += 8)
+	{
+		for (curLane = 0; curLane < 8; curLane ++)
+		{
+			coef = coefA[curTap + curLane] + (coefB[curTap + curLane] - coefA[curTap + curLane]) * frac;
+			accL[curLane] += bufL[curTap + curLane] * coef;
+			accR[curLane] += bufR[curTap + curLane] * coef;
+		}
+	}
+	for (curLane = 0; curLane < 4; curLane ++)
+	{
+		accL[curLane] += accL[curLane + 4];
+		accR[curLane] += accR[curLane + 4];
+	}
+	*outL = (accL[0] + accL[2]) + (accL[1] + accL[3]);
+	*outR = (accR[0] + accR[2]) + (accR[1] + accR[3]);
+	
+	return;
+}
+
+// The SIMD versions of the linear interpolation do the multiplication with the absolute volume
+// and negate the result afterwards. This gives the same result, because the division truncates.
+#define VOL_ABS(x)	(((x) < 0) ? -(x) : (x))
+#define VOL_NEG(x)	(((x) < 0) ? -1 : 0)
+
+
+// ---- SSE2 ----
+#ifdef RSK_HAVE_SSE2
+RSK_TGT_SSE2 INLINE __m128i MulLo32_SSE2(__m128i a, __m128i b)
+{
+	// 32x32 -> 32 bit multiplication (pmulld requires SSE4.1)
+	__m128i even = _mm_mul_epu32(a, b);
+	__m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+		_mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+RSK_TGT_SSE2 static void Kern_Copy_SSE2(WAVE_32BS* dst, const DEV_SMPL* srcL, const DEV_SMPL* srcR,
+	UINT32 length, INT32 volL, INT32 volR)
+{
+	UINT32 curSmpl;
+	__m128i vol = _mm_set_epi32(volR, volL, volR, volL);
+	
+	for (curSmpl = 0; curSmpl + 4 <= length; curSmpl += 4)
+	{
+		__m128i inL = _mm_loadu_si128((const __m128i*)&srcL[curSmpl]);
+		__m128i inR = _mm_loadu_si128((const __m128i*)&srcR[curSmpl]);
+		__m128i* out = (__m128i*)&dst[curSmpl];
+		__m128i smp01 = MulLo32_SSE2(_mm_unpacklo_epi32(inL, inR), vol);
+		__m128i smp23 = MulLo32_SSE2(_mm_unpackhi_epi32(inL, inR), vol);
+		_mm_storeu_si128(&out[0], _mm_add_epi32(_mm_loadu_si128(&out[0]), smp01));
+		_mm_storeu_si128(&out[1], _mm_add_epi32(_mm_loadu_si128(&out[1]), smp23));
+	}
+	Kern_Copy_C(&dst[curSmpl], &srcL[curSmpl], &srcR[curSmpl], length - curSmpl, volL, volR);
+	
+	return;
+}
+
+RSK_TGT_SSE2 static void Kern_Linear_SSE2(WAVE_32BS* dst, const DEV_SMPL* bufL, const DEV_SMPL* bufR,
+	const UINT32* posList, UINT32 length, INT32 volL, INT32 volR)
+{
+	// One sample per loop, with the L/R channels in the lower 32 bits of the two 64-bit lanes.
+	// pmuludq is unsigned, so the samples get an offset of 2^31. This adds 2^31 * FRAC_FACT
+	// to the interpolated value, which is removed afterwards.
+	UINT32 curSmpl;
+	UINT32 idx;
+	UINT32 frc;
+	const __m128i smplOfs = _mm_set_epi32(0, (INT32)0x80000000, 0, (INT32)0x80000000);
+	const __m128i interpOfs = _mm_set_epi32(FRAC_FACT >> 1, 0, FRAC_FACT >> 1, 0);
+	const __m128i divRound = _mm_set_epi32(0, FRAC_MASK, 0, FRAC_MASK);
+	const __m128i vol = _mm_set_epi32(0, VOL_ABS(volR), 0, VOL_ABS(volL));
+	const __m128i volNeg = _mm_set_epi32(0, 0, VOL_NEG(volR), VOL_NEG(volL));
+	__m128i smpA, smpB, wgtA, wgtB;
+	__m128i val, valSign, res;
+	
+	for (curSmpl = 0; curSmpl < length; curSmpl ++)
+	{
+		idx = posList[curSmpl] >> RSMPLK_FRAC_BITS;
+		frc = posList[curSmpl] & FRAC_MASK;
+		smpA = _mm_xor_si128(_mm_set_epi32(0, bufR[idx], 0, bufL[idx]), smplOfs);
+		smpB = _mm_xor_si128(_mm_set_epi32(0, bufR[idx + 1], 0, bufL[idx + 1]), smplOfs);
+		wgtA = _mm_set_epi32(0, FRAC_FACT - frc, 0, FRAC_FACT - frc);
+		wgtB = _mm_set_epi32(0, frc, 0, frc);
+		
+		// interpolation: A * (1-f) + B * f
+		val = _mm_add_epi64(_mm_mul_epu32(smpA, wgtA), _mm_mul_epu32(smpB, wgtB));
+		val = _mm_sub_epi64(val, interpOfs);
+		// 64x32 -> 64 bit multiplication with the volume
+		val = _mm_add_epi64(_mm_mul_epu32(val, vol),
+			_mm_slli_epi64(_mm_mul_epu32(_mm_srli_epi64(val, 32), vol), 32));
+		// signed division by FRAC_FACT, rounding towards zero (only the lower 32 bits are used)
+		valSign = _mm_shuffle_epi32(_mm_srai_epi32(val, 31), _MM_SHUFFLE(3, 3, 1, 1));
+		val = _mm_add_epi64(val, _mm_and_si128(valSign, divRound));
+		val = _mm_srli_epi64(val, RSMPLK_FRAC_BITS);
+		res = _mm_shuffle_epi32(val, _MM_SHUFFLE(3, 1, 2, 0));
+		res = _mm_sub_epi32(_mm_xor_si128(res, volNeg), volNeg);
+		
+		val = _mm_loadl_epi64((const __m128i*)&dst[curSmpl]);
+		_mm_storel_epi64((__m128i*)&dst[curSmpl], _mm_add_epi32(val, res));
+	}
+	
+	return;
+}
+
+RSK_TGT_SSE2 static void Kern_Sum_SSE2(const DEV_SMPL* bufL, const DEV_SMPL* bufR, UINT32 count,
+	INT64* sumL, INT64* sumR)
+{
+	UINT32 curSmpl;
+	__m128i accL = _mm_setzero_si128();
+	__m128i accR = _mm_setzero_si128();
+	__m128i inL, inR;
+	INT64 resL[2];
+	INT64 resR[2];
+	
+	for (curSmpl = 0; curSmpl + 4 <= count; curSmpl += 4)
+	{
+		// sign-extend to 64 bits and add
+		inL = _mm_loadu_si128((const __m128i*)&bufL[curSmpl]);
+		inR = _mm_loadu_si128((const __m128i*)&bufR[curSmpl]);
+		accL = _mm_add_epi64(accL, _mm_unpacklo_epi32(inL, _mm_srai_epi32(inL, 31)));
+		accL = _mm_add_epi64(accL, _mm_unpackhi_epi32(inL, _mm_srai_epi32(inL, 31)));
+		accR = _mm_add_epi64(accR, _mm_unpacklo_epi32(inR, _mm_srai_epi32(inR, 31)));
+		accR = _mm_add_epi64(accR, _mm_unpackhi_epi32(inR, _mm_srai_epi32(inR, 31)));
+	}
+	_mm_storeu_si128((__m128i*)resL, accL);
+	_mm_storeu_si128((__m128i*)resR, accR);
+	Kern_Sum_C(&bufL[curSmpl], &bufR[curSmpl], count - curSmpl, sumL, sumR);
+	*sumL += resL[0] + resL[1];
+	*sumR += resR[0] + resR[1];
+	
+	return;
+}
+
+RSK_TGT_SSE2 INLINE float HSum_SSE2(__m128 acc0, __m128 acc1)
+{
+	// (a0+a4 + a2+a6) + (a1+a5 + a3+a7)
+	__m128 sum = _mm_add_ps(acc0, acc1);
+	sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+	sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1)));
+	return _mm_cvtss_f32(sum);
+}
+
+RSK_TGT_SSE2 static void Kern_FIR_SSE2(const float* coefA, const float* coefB, float frac,
+	const float* bufL, const float* bufR, UINT32 taps, float* outL, float* outR)
+{
+	UINT32 curTap;
+	__m128 fracV = _mm_set1_ps(frac);
+	__m128 accL0 = _mm_setzero_ps();
+	__m128 accL1 = _mm_setzero_ps();
+	__m128 accR0 = _mm_setzero_ps();
+	__m128 accR1 = _mm_setzero_ps();
+	__m128 cA, coef0, coef1;
+	
+	for (curTap = 0; curTap < taps; curTap += 8)
+	{
+		cA = _mm_loadu_ps(&coefA[curTap + 0]);
+		coef0 = _mm_add_ps(cA, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&coefB[curTap + 0]), cA), fracV));
+		cA = _mm_loadu_ps(&coefA[curTap + 4]);
+		coef1 = _mm_add_ps(cA, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&coefB[curTap + 4]), cA), fracV));
+		accL0 = _mm_add_ps(accL0, _mm_mul_ps(_mm_loadu_ps(&bufL[curTap + 0]), coef0));
+		accL1 = _mm_add_ps(accL1, _mm_mul_ps(_mm_loadu_ps(&bufL[curTap + 4]), coef1));
+		accR0 = _mm_add_ps(accR0, _mm_mul_ps(_mm_loadu_ps(&bufR[curTap + 0]), coef0));
+		accR1 = _mm_add_ps(accR1, _mm_mul_ps(_mm_loadu_ps(&bufR[curTap + 4]), coef1));
+	}
+	*outL = HSum_SSE2(accL0, accL1);
+	*outR = HSum_SSE2(accR0, accR1);
+	
+	return;
+}
+
+static const RSMPL_KERNELS kernSSE2 =
+{
+	RSMPLK_TYPE_SSE2,
+	Kern_Copy_SSE2,
+	Kern_Linear_SSE2,
+	Kern_Sum_SSE2,
+	Kern_FIR_SSE2,
+};
+#endif	// RSK_HAVE_SSE2
+
+
+// ---- AVX2 ----
+#ifdef RSK_HAVE_AVX2
+RSK_TGT_AVX2 static void Kern_Copy_AVX2(WAVE_32BS* dst, const DEV_SMPL* srcL, const DEV_SMPL* srcR,
+	UINT32 length, INT32 volL, INT32 volR)
+{
+	UINT32 curSmpl;
+	__m256i vol = _mm256_set_epi32(volR, volL, volR, volL, volR, volL, volR, volL);
+	
+	for (curSmpl = 0; curSmpl + 8 <= length; curSmpl += 8)
+	{
+		__m256i inL = _mm256_loadu_si256((const __m256i*)&srcL[curSmpl]);
+		__m256i inR = _mm256_loadu_si256((const __m256i*)&srcR[curSmpl]);
+		__m256i* out = (__m256i*)&dst[curSmpl];
+		// unpack works within 128-bit lanes: lo = samples 0,1,4,5, hi = samples 2,3,6,7
+		__m256i unpLo = _mm256_unpacklo_epi32(inL, inR);
+		__m256i unpHi = _mm256_unpackhi_epi32(inL, inR);
+		__m256i smp0123 = _mm256_mullo_epi32(_mm256_permute2x128_si256(unpLo, unpHi, 0x20), vol);
+		__m256i smp4567 = _mm256_mullo_epi32(_mm256_permute2x128_si256(unpLo, unpHi, 0x31), vol);
+		_mm256_storeu_si256(&out[0], _mm256_add_epi32(_mm256_loadu_si256(&out[0]), smp0123));
+		_mm256_storeu_si256(&out[1], _mm256_add_epi32(_mm256_loadu_si256(&out[1]), smp4567));
+	}
+	Kern_Copy_C(&dst[curSmpl], &srcL[curSmpl], &srcR[curSmpl], length - curSmpl, volL, volR);
+	
+	return;
+}
+
+RSK_TGT_AVX2 static void Kern_Linear_AVX2(WAVE_32BS* dst, const DEV_SMPL* bufL, const DEV_SMPL* bufR,
+	const UINT32* posList, UINT32 length, INT32 volL, INT32 volR)
+{
+	// Two samples per loop, 64-bit lanes: L0, R0, L1, R1
+	UINT32 curSmpl;
+	UINT32 idx0, idx1;
+	UINT32 frc0, frc1;
+	const __m256i divRound = _mm256_set1_epi64x(FRAC_MASK);
+	const __m256i vol = _mm256_set_epi32(0, VOL_ABS(volR), 0, VOL_ABS(volL), 0, VOL_ABS(volR), 0, VOL_ABS(volL));
+	const __m128i volNeg = _mm_set_epi32(VOL_NEG(volR), VOL_NEG(volL), VOL_NEG(volR), VOL_NEG(volL));
+	const __m256i packIdx = _mm256_set_epi32(7, 5, 3, 1, 6, 4, 2, 0);
+	__m256i smpA, smpB, wgtA, wgtB;
+	__m256i val;
+	__m128i res, out;
+	
+	for (curSmpl = 0; curSmpl + 2 <= length; curSmpl += 2)
+	{
+		idx0 = posList[curSmpl + 0] >> RSMPLK_FRAC_BITS;
+		frc0 = posList[curSmpl + 0] & FRAC_MASK;
+		idx1 = posList[curSmpl + 1] >> RSMPLK_FRAC_BITS;
+		frc1 = posList[curSmpl + 1] & FRAC_MASK;
+		smpA = _mm256_set_epi32(0, bufR[idx1], 0, bufL[idx1], 0, bufR[idx0], 0, bufL[idx0]);
+		smpB = _mm256_set_epi32(0, bufR[idx1 + 1], 0, bufL[idx1 + 1], 0, bufR[idx0 + 1], 0, bufL[idx0 + 1]);
+		wgtA = _mm256_set_epi32(0, FRAC_FACT - frc1, 0, FRAC_FACT - frc1, 0, FRAC_FACT - frc0, 0, FRAC_FACT - frc0);
+		wgtB = _mm256_set_epi32(0, frc1, 0, frc1, 0, frc0, 0, frc0);
+		
+		// interpolation: A * (1-f) + B * f
+		val = _mm256_add_epi64(_mm256_mul_epi32(smpA, wgtA), _mm256_mul_epi32(smpB, wgtB));
+		// 64x32 -> 64 bit multiplication with the volume
+		val = _mm256_add_epi64(_mm256_mul_epu32(val, vol),
+			_mm256_slli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(val, 32), vol), 32));
+		// signed division by FRAC_FACT, rounding towards zero (only the lower 32 bits are used)
+		val = _mm256_add_epi64(val, _mm256_and_si256(_mm256_cmpgt_epi64(_mm256_setzero_si256(), val), divRound));
+		val = _mm256_srli_epi64(val, RSMPLK_FRAC_BITS);
+		res = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(val, packIdx));
+		res = _mm_sub_epi32(_mm_xor_si128(res, volNeg), volNeg);
+		
+		out = _mm_loadu_si128((const __m128i*)&dst[curSmpl]);
+		_mm_storeu_si128((__m128i*)&dst[curSmpl], _mm_add_epi32(out, res));
+	}
+	Kern_Linear_C(&dst[curSmpl], bufL, bufR, &posList[curSmpl], length - curSmpl, volL, volR);
+	
+	return;
+}
+
+RSK_TGT_AVX2 static void Kern_Sum_AVX2(const DEV_SMPL* bufL, const DEV_SMPL* bufR, UINT32 count,
+	INT64* sumL, INT64* sumR)
+{
+	UINT32 curSmpl;
+	__m256i accL = _mm256_setzero_si256();
+	__m256i accR = _mm256_setzero_si256();
+	INT64 resL[4];
+	INT64 resR[4];
+	
+	for (curSmpl = 0; curSmpl + 4 <= count; curSmpl += 4)
+	{
+		accL = _mm256_add_epi64(accL, _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)&bufL[curSmpl])));
+		accR = _mm256_add_epi64(accR, _mm256_cvtepi32_epi64(_mm_loadu_si128((const __m128i*)&bufR[curSmpl])));
+	}
+	_mm256_storeu_si256((__m256i*)resL, accL);
+	_mm256_storeu_si256((__m256i*)resR, accR);
+	Kern_Sum_C(&bufL[curSmpl], &bufR[curSmpl], count - curSmpl, sumL, sumR);
+	*sumL += resL[0] + resL[1] + resL[2] + resL[3];
+	*sumR += resR[0] + resR[1] + resR[2] + resR[3];
+	
+	return;
+}
+
+RSK_TGT_AVX2 static void Kern_FIR_AVX2(const float* coefA, const float* coefB, float frac,
+	const float* bufL, const float* bufR, UINT32 taps, float* outL, float* outR)
+{
+	// no FMA here, so that the rounding is the same as with the other versions
+	UINT32 curTap;
+	__m256 fracV = _mm256_set1_ps(frac);
+	__m256 accL = _mm256_setzero_ps();
+	__m256 accR = _mm256_setzero_ps();
+	__m256 cA, coef;
+	__m128 sum;
+	
+	for (curTap = 0; curTap < taps; curTap += 8)
+	{
+		cA = _mm256_loadu_ps(&coefA[curTap]);
+		coef = _mm256_add_ps(cA, _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(&coefB[curTap]), cA), fracV));
+		accL = _mm256_add_ps(accL, _mm256_mul_ps(_mm256_loadu_ps(&bufL[curTap]), coef));
+		accR = _mm256_add_ps(accR, _mm256_mul_ps(_mm256_loadu_ps(&bufR[curTap]), coef));
+	}
+	sum = _mm_add_ps(_mm256_castps256_ps128(accL), _mm256_extractf128_ps(accL, 1));
+	sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+	*outL = _mm_cvtss_f32(_mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1))));
+	sum = _mm_add_ps(_mm256_castps256_ps128(accR), _mm256_extractf128_ps(accR, 1));
+	sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+	*outR = _mm_cvtss_f32(_mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1))));
+	
+	return;
+}
+
+static const RSMPL_KERNELS kernAVX2 =
+{
+	RSMPLK_TYPE_AVX2,
+	Kern_Copy_AVX2,
+	Kern_Linear_AVX2,
+	Kern_Sum_AVX2,
+	Kern_FIR_AVX2,
+};
+#endif	// RSK_HAVE_AVX2
+
+
+// ---- NEON ----
+#ifdef RSK_HAVE_NEON
+static void Kern_Copy_NEON(WAVE_32BS* dst, const DEV_SMPL* srcL, const DEV_SMPL* srcR,
+	UINT32 length, INT32 volL, INT32 volR)
+{
+	UINT32 curSmpl;
+	int32x4x2_t out;
+	
+	for (curSmpl = 0; curSmpl + 4 <= length; curSmpl += 4)
+	{
+		// vld2 splits the interleaved L/R samples
+		out = vld2q_s32((const int32_t*)&dst[curSmpl]);
+		out.val[0] = vmlaq_n_s32(out.val[0], vld1q_s32((const int32_t*)&srcL[curSmpl]), volL);
+		out.val[1] = vmlaq_n_s32(out.val[1], vld1q_s32((const int32_t*)&srcR[curSmpl]), volR);
+		vst2q_s32((int32_t*)&dst[curSmpl], out);
+	}
+	Kern_Copy_C(&dst[curSmpl], &srcL[curSmpl], &srcR[curSmpl], length - curSmpl, volL, volR);
+	
+	return;
+}
+
+static void Kern_Linear_NEON(WAVE_32BS* dst, const DEV_SMPL* bufL, const DEV_SMPL* bufR,
+	const UINT32* posList, UINT32 length, INT32 volL, INT32 volR)
+{
+	// One sample per loop, lanes: L, R
+	UINT32 curSmpl;
+	UINT32 idx;
+	UINT32 frc;
+	int32x2_t smpA, smpB;
+	int64x2_t val;
+	uint64x2_t valU;
+	int32x2_t res;
+	const uint32x2_t vol = vcreate_u32(((UINT64)(UINT32)VOL_ABS(volR) << 32) | (UINT32)VOL_ABS(volL));
+	const int32x2_t volNeg = vcreate_s32(((UINT64)(UINT32)VOL_NEG(volR) << 32) | (UINT32)VOL_NEG(volL));
+	const int64x2_t divRound = vdupq_n_s64(FRAC_MASK);
+	
+	for (curSmpl = 0; curSmpl < length; curSmpl ++)
+	{
+		idx = posList[curSmpl] >> RSMPLK_FRAC_BITS;
+		frc = posList[curSmpl] & FRAC_MASK;
+		smpA = vset_lane_s32(bufR[idx], vdup_n_s32(bufL[idx]), 1);
+		smpB = vset_lane_s32(bufR[idx + 1], vdup_n_s32(bufL[idx + 1]), 1);
+		
+		// interpolation: A * (1-f) + B * f
+		val = vmull_n_s32(smpA, (int32_t)(FRAC_FACT - frc));
+		val = vmlal_n_s32(val, smpB, (int32_t)frc);
+		// 64x32 -> 64 bit multiplication with the volume
+		valU = vreinterpretq_u64_s64(val);
+		valU = vaddq_u64(vmull_u32(vmovn_u64(valU), vol),
+			vshlq_n_u64(vmull_u32(vshrn_n_u64(valU, 32), vol), 32));
+		val = vreinterpretq_s64_u64(valU);
+		// signed division by FRAC_FACT, rounding towards zero
+		val = vaddq_s64(val, vandq_s64(vshrq_n_s64(val, 63), divRound));
+		res = vmovn_s64(vshrq_n_s64(val, RSMPLK_FRAC_BITS));
+		res = vsub_s32(veor_s32(res, volNeg), volNeg);
+		
+		vst1_s32((int32_t*)&dst[curSmpl], vadd_s32(vld1_s32((const int32_t*)&dst[curSmpl]), res));
+	}
+	
+	return;
+}
+
+static void Kern_Sum_NEON(const DEV_SMPL* bufL, const DEV_SMPL* bufR, UINT32 count,
+	INT64* sumL, INT64* sumR)
+{
+	UINT32 curSmpl;
+	int64x2_t accL = vdupq_n_s64(0);
+	int64x2_t accR = vdupq_n_s64(0);
+	
+	for (curSmpl = 0; curSmpl + 4 <= count; curSmpl += 4)
+	{
+		// pairwise add with widening to 64 bits
+		accL = vpadalq_s32(accL, vld1q_s32((const int32_t*)&bufL[curSmpl]));
+		accR = vpadalq_s32(accR, vld1q_s32((const int32_t*)&bufR[curSmpl]));
+	}
+	Kern_Sum_C(&bufL[curSmpl], &bufR[curSmpl], count - curSmpl, sumL, sumR);
+	*sumL += vgetq_lane_s64(accL, 0) + vgetq_lane_s64(accL, 1);
+	*sumR += vgetq_lane_s64(accR, 0) + vgetq_lane_s64(accR, 1);
+	
+	return;
+}
+
+static float HSum_NEON(float32x4_t acc0, float32x4_t acc1)
+{
+	float32x4_t sum = vaddq_f32(acc0, acc1);
+	float32x2_t sum2 = vadd_f32(vget_low_f32(sum), vget_high_f32(sum));
+	return vget_lane_f32(sum2, 0) + vget_lane_f32(sum2, 1);
+}
+
+static void Kern_FIR_NEON(const float* coefA, const float* coefB, float frac,
+	const float* bufL, const float* bufR, UINT32 taps, float* outL, float* outR)
+{
+	// vmlaq_f32 is not fused, but may be on AArch64 - use separate mul/add for consistent results
+	UINT32 curTap;
+	float32x4_t accL0 = vdupq_n_f32(0.0f);
+	float32x4_t accL1 = vdupq_n_f32(0.0f);
+	float32x4_t accR0 = vdupq_n_f32(0.0f);
+	float32x4_t accR1 = vdupq_n_f32(0.0f);
+	float32x4_t cA, coef0, coef1;
+	
+	for (curTap = 0; curTap < taps; curTap += 8)
+	{
+		cA = vld1q_f32(&coefA[curTap + 0]);
+		coef0 = vaddq_f32(cA, vmulq_n_f32(vsubq_f32(vld1q_f32(&coefB[curTap + 0]), cA), frac));
+		cA = vld1q_f32(&coefA[curTap + 4]);
+		coef1 = vaddq_f32(cA, vmulq_n_f32(vsubq_f32(vld1q_f32(&coefB[curTap + 4]), cA), frac));
+		accL0 = vaddq_f32(accL0, vmulq_f32(vld1q_f32(&bufL[curTap + 0]), coef0));
+		accL1 = vaddq_f32(accL1, vmulq_f32(vld1q_f32(&bufL[curTap + 4]), coef1));
+		accR0 = vaddq_f32(accR0, vmulq_f32(vld1q_f32(&bufR[curTap + 0]), coef0));
+		accR1 = vaddq_f32(accR1, vmulq_f32(vld1q_f32(&bufR[curTap + 4]), coef1));
+	}
+	*outL = HSum_NEON(accL0, accL1);
+	*outR = HSum_NEON(accR0, accR1);
+	
+	return;
+}
+
+static const RSMPL_KERNELS kernNEON =
+{
+	RSMPLK_TYPE_NEON,
+	Kern_Copy_NEON,
+	Kern_Linear_NEON,
+	Kern_Sum_NEON,
+	Kern_FIR_NEON,
+};
+#endif	// RSK_HAVE_NEON
+
+
+static const RSMPL_KERNELS kernC =
+{
+	RSMPLK_TYPE_C,
+	Kern_Copy_C,
+	Kern_Linear_C,
+	Kern_Sum_C,
+	Kern_FIR_C,
+};
+
+
+// ---- CPU feature detection ----
+#if defined(RSK_HAVE_SSE2) && ! defined(RSK_SSE2_ALWAYS)
+static UINT8 CPU_HasSSE2(void)
+{
+#if defined(_MSC_VER)
+	int cpuInfo[4];
+	__cpuid(cpuInfo, 1);
+	return (cpuInfo[3] >> 26) & 0x01;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("sse2") ? 1 : 0;
+#endif
+}
+#endif
+
+#ifdef RSK_HAVE_AVX2
+static UINT8 CPU_HasAVX2(void)
+{
+#if defined(_MSC_VER)
+	int cpuInfo[4];
+	__cpuid(cpuInfo, 0);
+	if (cpuInfo[0] < 7)
+		return 0;
+	__cpuid(cpuInfo, 1);
+	if (((cpuInfo[2] >> 27) & 0x03) != 0x03)	// require OSXSAVE + AVX
+		return 0;
+	if ((_xgetbv(0) & 0x06) != 0x06)	// OS saves XMM + YMM registers
+		return 0;
+	__cpuidex(cpuInfo, 7, 0);
+	return (cpuInfo[1] >> 5) & 0x01;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") ? 1 : 0;
+#endif
+}
+#endif
+
+const RSMPL_KERNELS* ResmplKern_Get(UINT8 type)
+{
+	switch(type)
+	{
+	case RSMPLK_TYPE_C:
+		return &kernC;
+#ifdef RSK_HAVE_SSE2
+	case RSMPLK_TYPE_SSE2:
+#ifndef RSK_SSE2_ALWAYS
+		if (! CPU_HasSSE2())
+			return NULL;
+#endif
+		return &kernSSE2;
+#endif
+#ifdef RSK_HAVE_AVX2
+	case RSMPLK_TYPE_AVX2:
+		return CPU_HasAVX2() ? &kernAVX2 : NULL;
+#endif
+#ifdef RSK_HAVE_NEON
+	case RSMPLK_TYPE_NEON:
+		return &kernNEON;
+#endif
+	default:
+		return NULL;
+	}
+}
+
+const RSMPL_KERNELS* ResmplKern_GetBest(void)
+{
+	static const UINT8 KERN_ORDER[] = {RSMPLK_TYPE_AVX2, RSMPLK_TYPE_NEON, RSMPLK_TYPE_SSE2};
+	const RSMPL_KERNELS* kern;
+	size_t curKern;
+	
+	for (curKern = 0; curKern < sizeof(KERN_ORDER) / sizeof(KERN_ORDER[0]); curKern ++)
+	{
+		kern = ResmplKern_Get(KERN_ORDER[curKern]);
+		if (kern != NULL)
+			return kern;
+	}
+	return &kernC;
+}
@@ -0,0 +1,70 @@
+#ifndef __RESMPLKERNELS_H__
+#define __RESMPLKERNELS_H__
+
+// internal header - kernels used by the resampler to process whole blocks of samples
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "../stdtype.h"
+#include "snddef.h"	// for DEV_SMPL
+#include "Resampler.h"	// for WAVE_32BS
+
+// number of fractional bits of the positions used by the kernels
+#define RSMPLK_FRAC_BITS	11
+
+// kernel types
+#define RSMPLK_TYPE_C		0x00	// plain C (always available)
+#define RSMPLK_TYPE_SSE2	0x01
+#define RSMPLK_TYPE_AVX2	0x02
+#define RSMPLK_TYPE_NEON	0x03
+
+// dst[i] += src[i] * vol
+typedef void (*RSMPLK_COPY)(WAVE_32BS* dst, const DEV_SMPL* srcL, const DEV_SMPL* srcR,
+	UINT32 length, INT32 volL, INT32 volR);
+// dst[i] += interpolate(buf, posList[i]) * vol
+// posList contains fixed-point positions with RSMPLK_FRAC_BITS fractional bits.
+// The sample after the integer part of each position must be readable, even if the fraction is 0.
+typedef void (*RSMPLK_LINEAR)(WAVE_32BS* dst, const DEV_SMPL* bufL, const DEV_SMPL* bufR,
+	const UINT32* posList, UINT32 length, INT32 volL, INT32 volR);
+// *sumL = sum(bufL[0 .. count-1]), *sumR = sum(bufR[0 .. count-1])
+typedef void (*RSMPLK_SUM)(const DEV_SMPL* bufL, const DEV_SMPL* bufR, UINT32 count,
+	INT64* sumL, INT64* sumR);
+
+// FIR filter: *outL = sum(bufL[i] * coef[i]), *outR = sum(bufR[i] * coef[i])
+// with coef[i] = coefA[i] + (coefB[i] - coefA[i]) * frac
+// taps must be a multiple of 8. All kernel types sum up the products in the same order,
+// so that they return exactly the same results.
+typedef void (*RSMPLK_FIR)(const float* coefA, const float* coefB, float frac,
+	const float* bufL, const float* bufR, UINT32 taps, float* outL, float* outR);
+
+typedef struct _resampler_kernels
+{
+	UINT8 type;	// see RSMPLK_TYPE_ constants
+	RSMPLK_COPY copy;
+	RSMPLK_LINEAR linear;
+	RSMPLK_SUM sum;
+	RSMPLK_FIR fir;
+} RSMPL_KERNELS;
+
+/**
+ * @brief Returns the fastest set of kernels that is supported by the CPU.
+ *
+ * @return kernel set, never NULL
+ */
+const RSMPL_KERNELS* ResmplKern_GetBest(void);
+/**
+ * @brief Returns a specific set of kernels.
+ *
+ * @param type kernel type, see RSMPLK_TYPE_ constants
+ * @return kernel set or NULL if it is not supported by the CPU or compiler
+ */
+const RSMPL_KERNELS* ResmplKern_Get(UINT8 type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// __RESMPLKERNELS_H__
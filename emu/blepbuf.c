@@ -0,0 +1,187 @@
+// Band-limited Step Buffer
+// ------------------------
+// Every change of the output level is added as a band-limited impulse (Kaiser-windowed sinc)
+// to a buffer of differences. Integrating the buffer when reading turns the impulses into
+// band-limited steps.
+// The impulses are stored as a polyphase table with BLEP_PHASES+1 rows. Steps between two rows
+// are split into two parts that use the neighbouring rows. As every row sums up to exactly
+// 1 << KERN_BITS, the integrated output has no rounding drift.
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../stdtype.h"
+#include "../common_def.h"
+#include "snddef.h"
+#include "EmuOnce.h"
+#include "blepbuf.h"
+
+#define BLEP_PHASE_BITS	6
+#define BLEP_PHASES		(1 << BLEP_PHASE_BITS)
+#define INTERP_BITS		15		// precision of the position between two phases
+#define KERN_BITS		14		// fixed point precision of the impulse table
+#define KAISER_BETA		6.0
+#define CUTOFF			0.45	// cutoff frequency, relative to the output sample rate
+
+static INT16 blepKernel[BLEP_PHASES + 1][BLEP_WIDTH];
+static EMU_ONCE kernelInit = EMU_ONCE_INIT;
+
+static double Bessel_I0(double x)
+{
+	// modified Bessel function of the first kind, order 0
+	double sum = 1.0;
+	double term = 1.0;
+	double halfX2 = x * x / 4.0;
+	UINT32 k;
+
+	for (k = 1; k < 100 && term > sum * 1e-12; k ++)
+	{
+		term *= halfX2 / ((double)k * k);
+		sum += term;
+	}
+	return sum;
+}
+
+static void BlepBuf_InitKernel(void)
+{
+	const double PI = 3.14159265358979323846;
+	const double halfLen = BLEP_WIDTH / 2;
+	double tapVals[BLEP_WIDTH];
+	double winDiv;
+	double pos;
+	double x;
+	double sum;
+	INT32 intSum;
+	UINT32 maxTap;
+	UINT32 curPhase;
+	UINT32 curTap;
+
+	winDiv = Bessel_I0(KAISER_BETA);
+	for (curPhase = 0; curPhase <= BLEP_PHASES; curPhase ++)
+	{
+		sum = 0.0;
+		for (curTap = 0; curTap < BLEP_WIDTH; curTap ++)
+		{
+			// distance from the step, in output samples
+			pos = (double)curTap - halfLen + 1.0 - (double)curPhase / BLEP_PHASES;
+			x = pos / halfLen;
+			if (x * x >= 1.0)
+			{
+				tapVals[curTap] = 0.0;
+				continue;
+			}
+			tapVals[curTap] = Bessel_I0(KAISER_BETA * sqrt(1.0 - x * x)) / winDiv;
+			x = 2.0 * CUTOFF * pos;
+			if (x != 0.0)
+				tapVals[curTap] *= sin(PI * x) / (PI * x);
+			sum += tapVals[curTap];
+		}
+
+		// The sum of each row has to be exact, so the rounding error is added to the largest tap.
+		intSum = 0;
+		maxTap = 0;
+		for (curTap = 0; curTap < BLEP_WIDTH; curTap ++)
+		{
+			blepKernel[curPhase][curTap] = (INT16)floor(tapVals[curTap] / sum * (1 << KERN_BITS) + 0.5);
+			intSum += blepKernel[curPhase][curTap];
+			if (tapVals[curTap] > tapVals[maxTap])
+				maxTap = curTap;
+		}
+		blepKernel[curPhase][maxTap] += (INT16)((1 << KERN_BITS) - intSum);
+	}
+
+	return;
+}
+
+void BlepBuf_Init(BLEP_BUF* bb, UINT32 clockRate, UINT32 smplRate)
+{
+	EmuOnce_Run(&kernelInit, BlepBuf_InitKernel);
+
+	bb->factor = ((UINT64)smplRate << 32) / clockRate;
+	BlepBuf_Clear(bb);
+
+	return;
+}
+
+void BlepBuf_Clear(BLEP_BUF* bb)
+{
+	bb->offset = 0;
+	bb->amp[0] = bb->amp[1] = 0;
+	bb->integ[0] = bb->integ[1] = 0;
+	memset(bb->buf, 0x00, sizeof(bb->buf));
+
+	return;
+}
+
+UINT32 BlepBuf_ClocksNeeded(const BLEP_BUF* bb, UINT32 samples)
+{
+	UINT64 needed;
+
+	needed = (UINT64)samples << 32;
+	if (needed <= bb->offset)
+		return 0;
+	needed -= bb->offset;
+	return (UINT32)((needed + bb->factor - 1) / bb->factor);
+}
+
+void BlepBuf_AddDelta(BLEP_BUF* bb, UINT8 chn, UINT32 clock, INT32 delta)
+{
+	UINT64 pos;
+	UINT32 frac;
+	UINT32 phase;
+	INT32 interp;
+	INT32 delta1;
+	INT32 delta2;
+	const INT16* kernA;
+	const INT16* kernB;
+	INT32* out;
+	UINT32 curTap;
+
+	pos = bb->offset + clock * bb->factor;
+	frac = (UINT32)pos;
+	phase = frac >> (32 - BLEP_PHASE_BITS);
+	interp = (INT32)(frac >> (32 - BLEP_PHASE_BITS - INTERP_BITS)) & ((1 << INTERP_BITS) - 1);
+	delta2 = (INT32)(((INT64)delta * interp) >> INTERP_BITS);
+	delta1 = delta - delta2;
+
+	kernA = blepKernel[phase];
+	kernB = blepKernel[phase + 1];
+	out = &bb->buf[chn][(UINT32)(pos >> 32)];
+	for (curTap = 0; curTap < BLEP_WIDTH; curTap ++)
+		out[curTap] += kernA[curTap] * delta1 + kernB[curTap] * delta2;
+
+	return;
+}
+
+void BlepBuf_EndFrame(BLEP_BUF* bb, UINT32 clocks)
+{
+	bb->offset += clocks * bb->factor;
+	return;
+}
+
+void BlepBuf_ReadSamples(BLEP_BUF* bb, UINT32 samples, DEV_SMPL** outputs)
+{
+	UINT8 curChn;
+	UINT32 curSmpl;
+
+	for (curChn = 0; curChn < 2; curChn ++)
+	{
+		INT32* buf = bb->buf[curChn];
+		DEV_SMPL* outBuf = outputs[curChn];
+		INT32 integ = bb->integ[curChn];
+
+		for (curSmpl = 0; curSmpl < samples; curSmpl ++)
+		{
+			integ += buf[curSmpl];
+			outBuf[curSmpl] = integ >> KERN_BITS;
+		}
+		bb->integ[curChn] = integ;
+
+		// keep the tails of the last steps
+		memmove(&buf[0], &buf[samples], BLEP_WIDTH * sizeof(INT32));
+		memset(&buf[BLEP_WIDTH], 0x00, samples * sizeof(INT32));
+	}
+	bb->offset -= (UINT64)samples << 32;
+
+	return;
+}
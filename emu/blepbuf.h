@@ -0,0 +1,107 @@
+#ifndef __BLEPBUF_H__
+#define __BLEPBUF_H__
+
+// internal header - band-limited step buffer
+//
+// Lets square wave/noise generators output directly at the final sample rate.
+// Instead of rendering every sample at the chip's native rate (which then has to be
+// resampled), the core reports each change of its output level at native clock resolution.
+// The buffer adds a band-limited step for every change and integrates them when reading,
+// so that the result doesn't alias.
+// Usage (per Update call):
+//	clocks = BlepBuf_ClocksNeeded(bb, samples);	// samples <= BLEP_MAX_SMPLS
+//	for (clk = 0; clk < clocks; clk ++)
+//		{ run the chip for 1 native clock; BlepBuf_SetAmp(bb, clk, outL, outR); }
+//	BlepBuf_EndFrame(bb, clocks);
+//	BlepBuf_ReadSamples(bb, samples, outputs);
+// The output is delayed by BLEP_WIDTH/2 samples.
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "../stdtype.h"
+#include "../common_def.h"	// for INLINE
+#include "snddef.h"	// for DEV_SMPL
+
+#define BLEP_MAX_SMPLS	1024	// maximum number of samples per frame
+#define BLEP_WIDTH		16		// length of a band-limited step, in output samples
+
+typedef struct _blep_buffer
+{
+	UINT64 factor;	// output samples per clock (32.32 fixed point)
+	UINT64 offset;	// position of the current clock in the buffer (32.32 fixed point)
+	INT32 amp[2];	// current output level (left/right)
+	INT32 integ[2];	// integrator (left/right)
+	INT32 buf[2][BLEP_MAX_SMPLS + BLEP_WIDTH];	// differences, the integrator turns them into samples
+} BLEP_BUF;
+
+/**
+ * @brief Sets the clock and sample rate and clears the buffer.
+ *
+ * @param bb buffer to be initialized
+ * @param clockRate rate of the chip's native clock, must not be lower than smplRate
+ * @param smplRate output sample rate
+ */
+void BlepBuf_Init(BLEP_BUF* bb, UINT32 clockRate, UINT32 smplRate);
+/**
+ * @brief Clears the buffer and resets the output level to 0.
+ *
+ * @param bb buffer to be cleared
+ */
+void BlepBuf_Clear(BLEP_BUF* bb);
+/**
+ * @brief Returns the number of clocks that need to be run in order to get a number of output samples.
+ *
+ * @param bb buffer to be checked
+ * @param samples number of output samples, at most BLEP_MAX_SMPLS
+ * @return number of native clocks
+ */
+UINT32 BlepBuf_ClocksNeeded(const BLEP_BUF* bb, UINT32 samples);
+/**
+ * @brief Adds a band-limited step to one channel.
+ *
+ * @param bb buffer to add the step to
+ * @param chn channel (0 = left, 1 = right)
+ * @param clock clock of the current frame where the step happens
+ * @param delta height of the step
+ */
+void BlepBuf_AddDelta(BLEP_BUF* bb, UINT8 chn, UINT32 clock, INT32 delta);
+/**
+ * @brief Ends the current frame, so that the samples can be read.
+ *
+ * @param bb buffer to be processed
+ * @param clocks length of the frame in native clocks, as returned by BlepBuf_ClocksNeeded
+ */
+void BlepBuf_EndFrame(BLEP_BUF* bb, UINT32 clocks);
+/**
+ * @brief Reads the samples of the last frame.
+ *
+ * @param bb buffer to read from
+ * @param samples number of samples, as passed to BlepBuf_ClocksNeeded
+ * @param outputs left/right sample buffers
+ */
+void BlepBuf_ReadSamples(BLEP_BUF* bb, UINT32 samples, DEV_SMPL** outputs);
+
+// sets the output level at a certain clock of the current frame
+INLINE void BlepBuf_SetAmp(BLEP_BUF* bb, UINT32 clock, INT32 ampL, INT32 ampR)
+{
+	if (ampL != bb->amp[0])
+	{
+		BlepBuf_AddDelta(bb, 0, clock, ampL - bb->amp[0]);
+		bb->amp[0] = ampL;
+	}
+	if (ampR != bb->amp[1])
+	{
+		BlepBuf_AddDelta(bb, 1, clock, ampR - bb->amp[1]);
+		bb->amp[1] = ampR;
+	}
+	return;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// __BLEPBUF_H__
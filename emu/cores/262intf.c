@@ -33,6 +33,7 @@ static DEVDEF_RWFUNC devFunc262_MAME[] =
 	{RWF_VOLUME | RWF_WRITE, DEVRW_VALUE, 0, ymf262_set_volume},
 	{RWF_VOLUME_LR | RWF_WRITE, DEVRW_VALUE, 0, ymf262_set_vol_lr},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, ymf262_set_mute_mask},
+	{RWF_ADVANCE | RWF_WRITE, DEVRW_VALUE, 0, ymf262_advance},
 	{0x00, 0x00, 0, NULL}
 };
 static DEV_DEF devDef262_MAME =
@@ -37,6 +37,7 @@
 
 #include "../../stdtype.h"
 #include "../snddef.h"
+#include "../EmuOnce.h"
 #include "adlibemu_opl_inc.h"
 
 
@@ -51,10 +52,7 @@ static Bit32s vibval_const[BLOCKBUF_SIZE];
 static Bit32s tremval_const[BLOCKBUF_SIZE];
 
 // vibrato value tables (used per-operator)
-static Bit32s vibval_var1[BLOCKBUF_SIZE];
-static Bit32s vibval_var2[BLOCKBUF_SIZE];
-//static Bit32s vibval_var3[BLOCKBUF_SIZE];
-//static Bit32s vibval_var4[BLOCKBUF_SIZE];
+// moved to adlib_getsample, so that multiple instances can be updated in parallel
 
 // vibrato/trmolo value table pointers
 //static Bit32s *vibval1, *vibval2, *vibval3, *vibval4;
@@ -581,17 +579,14 @@ static void disable_operator(op_type* op_pt, Bit32u act_type)
 	}
 }
 
+static EMU_ONCE tablesInit = EMU_ONCE_INIT;
+
 static void init_tables(void)
 {
-	static Bitu initfirstime = 0;
 	Bits i, j, oct;
 	Bit32s trem_table_int[TREMTAB_SIZE];
 
 
-	if (initfirstime)
-		return;
-	initfirstime = 1;
-
 	// create vibrato table
 	vib_table[0] = 8;
 	vib_table[1] = 4;
@@ -682,7 +677,7 @@ void* ADLIBEMU(init)(UINT32 clock, UINT32 samplerate)
 		OPL->frqmul[i] = (fltype)(frqmul_tab[i]*INTFREQU/(fltype)WAVEPREC*(fltype)FIXEDPT*OPL->recipsamp);
 	}
 
-	init_tables();
+	EmuOnce_Run(&tablesInit, init_tables);
 
 	// vibrato at ~6.1 ?? (opl3 docs say 6.1, opl4 docs say 6.0, y8950 docs say 6.4)
 	OPL->vibtab_add = (Bit32u)(VIBTAB_SIZE*FIXEDPT_LFO/8192*INTFREQU/OPL->int_samplerate);
@@ -1195,6 +1190,9 @@ void ADLIBEMU(getsample)(void *chip, UINT32 numsamples, DEV_SMPL** sndptr)
 	// vibrato/tremolo lookup tables (global, to possibly be used by all operators)
 	Bit32s vib_lut[BLOCKBUF_SIZE];
 	Bit32s trem_lut[BLOCKBUF_SIZE];
+	// vibrato value tables (used per-operator)
+	Bit32s vibval_var1[BLOCKBUF_SIZE];
+	Bit32s vibval_var2[BLOCKBUF_SIZE];
 
 	Bit32u cursmp;
 	Bit32s vib_tshift;
@@ -542,10 +542,14 @@ YM2203 Japanese datasheet contents, translated: http://www.larwe.com/technical/c
 #include "../EmuCores.h"
 #include "../EmuHelper.h"
 #include "../logging.h"
+#include "../blepbuf.h"
 #include "ayintf.h"
 #include "ay8910.h"
 
 
+static UINT32 ay8910_get_native_rate(ay8910_context *psg);
+static void ay8910_setup_blep(ay8910_context *psg);
+
 static DEVDEF_RWFUNC devFunc[] =
 {
 	{RWF_REGISTER | RWF_WRITE, DEVRW_A8D8, 0, ay8910_write},
@@ -566,7 +570,7 @@ DEV_DEF devDef_AY8910_MAME =
 	ay8910_reset,
 	ay8910_update_one,
 	
-	NULL,	// SetOptionBits
+	ay8910_set_options,	// SetOptionBits
 	ay8910_set_mute_mask,
 	NULL,	// SetPanning
 	ay8910_set_srchg_cb,	// SetSampleRateChangeCallback
@@ -698,6 +702,11 @@ struct _ay8910_context
 	
 	DEVCB_SRATE_CHG SmpRateFunc;
 	void* SmpRateData;
+	
+	UINT32 smpl_rate;   /* output sample rate (for BLEP mode) */
+	UINT8 blep_enable;  /* BLEP mode requested via OPT_AY8910_BLEP */
+	UINT8 blep_active;  /* output band-limited steps at smpl_rate instead of the native rate */
+	BLEP_BUF blep;
 };
 
 
@@ -1110,134 +1119,223 @@ void ay8910_write_reg(ay8910_context *psg, UINT8 r, UINT8 v)
 	}
 }
 
-void ay8910_update_one(void *param, UINT32 samples, DEV_SMPL **outputs)
+INLINE void ay8910_clock(ay8910_context *psg)
 {
-	ay8910_context *psg = (ay8910_context *)param;
 	int chan;
-	UINT32 cur_smpl;
-	DEV_SMPL *bufL = outputs[0];
-	DEV_SMPL *bufR = outputs[1];
-	DEV_SMPL chnout;
-	
-	memset(outputs[0], 0x00, samples * sizeof(DEV_SMPL));
-	memset(outputs[1], 0x00, samples * sizeof(DEV_SMPL));
-	
-	/* The 8910 has three outputs, each output is the mix of one of the three */
-	/* tone generators and of the (single) noise generator. The two are mixed */
-	/* BEFORE going into the DAC. The formula to mix each channel is: */
-	/* (ToneOn | ToneDisable) & (NoiseOn | NoiseDisable). */
-	/* Note that this means that if both tone and noise are disabled, the output */
-	/* is 1, not 0, and can be modulated changing the volume. */
 
-	/* buffering loop */
-	for (cur_smpl = 0; cur_smpl < samples; cur_smpl++)
+	for (chan = 0; chan < NUM_CHANNELS; chan++)
 	{
-		for (chan = 0; chan < NUM_CHANNELS; chan++)
+		psg->count[chan]++;
+		if (psg->count[chan] >= TONE_PERIOD(psg, chan))
 		{
-			psg->count[chan]++;
-			if (psg->count[chan] >= TONE_PERIOD(psg, chan))
-			{
-				psg->output[chan] ^= 1;
-				psg->count[chan] = 0;
-			}
+			psg->output[chan] ^= 1;
+			psg->count[chan] = 0;
 		}
+	}
 
-		psg->count_noise++;
-		if (psg->count_noise >= NOISE_PERIOD(psg))
-		{
-			/* toggle the prescaler output. Noise is no different to
-			 * channels.
-			 */
-			psg->count_noise = 0;
-			psg->prescale_noise ^= 1;
+	psg->count_noise++;
+	if (psg->count_noise >= NOISE_PERIOD(psg))
+	{
+		/* toggle the prescaler output. Noise is no different to
+		 * channels.
+		 */
+		psg->count_noise = 0;
+		psg->prescale_noise ^= 1;
 
-			if ( psg->prescale_noise)
-			{
-				/* The Random Number Generator of the 8910 is a 17-bit shift */
-				/* register. The input to the shift register is bit0 XOR bit3 */
-				/* (bit0 is the output). This was verified on AY-3-8910 and YM2149 chips. */
+		if ( psg->prescale_noise)
+		{
+			/* The Random Number Generator of the 8910 is a 17-bit shift */
+			/* register. The input to the shift register is bit0 XOR bit3 */
+			/* (bit0 is the output). This was verified on AY-3-8910 and YM2149 chips. */
 
-				psg->rng ^= (((psg->rng & 1) ^ ((psg->rng >> 3) & 1)) << 17);
-				psg->rng >>= 1;
-			}
+			psg->rng ^= (((psg->rng & 1) ^ ((psg->rng >> 3) & 1)) << 17);
+			psg->rng >>= 1;
 		}
+	}
 
-		for (chan = 0; chan < NUM_CHANNELS; chan++)
-		{
-			psg->vol_enabled[chan] = (psg->output[chan] | TONE_ENABLEQ(psg, chan)) & (NOISE_OUTPUT(psg) | NOISE_ENABLEQ(psg, chan));
-		}
+	for (chan = 0; chan < NUM_CHANNELS; chan++)
+	{
+		psg->vol_enabled[chan] = (psg->output[chan] | TONE_ENABLEQ(psg, chan)) & (NOISE_OUTPUT(psg) | NOISE_ENABLEQ(psg, chan));
+	}
 
-		/* update envelope */
-		if (psg->holding == 0)
+	/* update envelope */
+	if (psg->holding == 0)
+	{
+		psg->count_env++;
+		if (psg->count_env >= ENVELOPE_PERIOD(psg) * psg->step )
 		{
-			psg->count_env++;
-			if (psg->count_env >= ENVELOPE_PERIOD(psg) * psg->step )
-			{
-				psg->count_env = 0;
-				psg->env_step--;
+			psg->count_env = 0;
+			psg->env_step--;
 
-				/* check envelope current position */
-				if (psg->env_step < 0)
+			/* check envelope current position */
+			if (psg->env_step < 0)
+			{
+				if (psg->hold)
 				{
-					if (psg->hold)
-					{
-						if (psg->alternate)
-							psg->attack ^= psg->env_step_mask;
-						psg->holding = 1;
-						psg->env_step = 0;
-					}
-					else
-					{
-						/* if CountEnv has looped an odd number of times (usually 1), */
-						/* invert the output. */
-						if (psg->alternate && (psg->env_step & (psg->env_step_mask + 1)))
+					if (psg->alternate)
+						psg->attack ^= psg->env_step_mask;
+					psg->holding = 1;
+					psg->env_step = 0;
+				}
+				else
+				{
+					/* if CountEnv has looped an odd number of times (usually 1), */
+					/* invert the output. */
+					if (psg->alternate && (psg->env_step & (psg->env_step_mask + 1)))
  							psg->attack ^= psg->env_step_mask;
 
-						psg->env_step &= psg->env_step_mask;
-					}
+					psg->env_step &= psg->env_step_mask;
 				}
-
 			}
+
 		}
-		psg->env_volume = (psg->env_step ^ psg->attack);
+	}
+	psg->env_volume = (psg->env_step ^ psg->attack);
+}
+
+INLINE INT32 ay8910_clocks_to_event(ay8910_context *psg, INT32 max_clocks)
+{
+	/* returns the number of clocks until one of the counters expires */
+	int chan;
+	INT32 clocks = max_clocks;
+	INT32 remaining;
+
+	for (chan = 0; chan < NUM_CHANNELS; chan++)
+	{
+		remaining = TONE_PERIOD(psg, chan) - psg->count[chan];
+		if (remaining < clocks)
+			clocks = remaining;
+	}
+	remaining = NOISE_PERIOD(psg) - psg->count_noise;
+	if (remaining < clocks)
+		clocks = remaining;
+	if (psg->holding == 0)
+	{
+		remaining = ENVELOPE_PERIOD(psg) * psg->step - psg->count_env;
+		if (remaining < clocks)
+			clocks = remaining;
+	}
+	return (clocks > 1) ? clocks : 1;
+}
+
+INLINE void ay8910_skip_clocks(ay8910_context *psg, INT32 clocks)
+{
+	/* same as calling ay8910_clock() multiple times, as long as no counter expires */
+	int chan;
+
+	for (chan = 0; chan < NUM_CHANNELS; chan++)
+		psg->count[chan] += clocks;
+	psg->count_noise += clocks;
+	if (psg->holding == 0)
+		psg->count_env += clocks;
+}
+
+INLINE void ay8910_calc_output(ay8910_context *psg, DEV_SMPL *outL, DEV_SMPL *outR)
+{
+	int chan;
+	DEV_SMPL chnout;
+	DEV_SMPL left = 0;
+	DEV_SMPL right = 0;
 
 #if ENABLE_CUSTOM_OUTPUTS
-		if (psg->streams == 3)
+	if (psg->streams == 3)
 #endif
+	{
+		for (chan = 0; chan < NUM_CHANNELS; chan++)
 		{
-			for (chan = 0; chan < NUM_CHANNELS; chan++)
+			if (! psg->MuteMsk[chan])
+				continue;
+			if (TONE_ENVELOPE(psg, chan) != 0)
 			{
-				if (! psg->MuteMsk[chan])
-					continue;
-				if (TONE_ENVELOPE(psg, chan) != 0)
+				if (psg->chip_type == AYTYPE_AY8914) // AY8914 Has a two bit tone_envelope field
 				{
-					if (psg->chip_type == AYTYPE_AY8914) // AY8914 Has a two bit tone_envelope field
-					{
-						chnout = psg->env_table[chan][psg->vol_enabled[chan] ? psg->env_volume >> (3-TONE_ENVELOPE(psg,chan)) : 0];
-					}
-					else
-					{
-						chnout = psg->env_table[chan][psg->vol_enabled[chan] ? psg->env_volume : 0];
-					}
+					chnout = psg->env_table[chan][psg->vol_enabled[chan] ? psg->env_volume >> (3-TONE_ENVELOPE(psg,chan)) : 0];
 				}
 				else
 				{
-					chnout = psg->vol_table[chan][psg->vol_enabled[chan] ? TONE_VOLUME(psg, chan) : 0];
+					chnout = psg->env_table[chan][psg->vol_enabled[chan] ? psg->env_volume : 0];
 				}
-				if (psg->StereoMask[chan] & 0x01)
-					bufL[cur_smpl] += chnout;
-				if (psg->StereoMask[chan] & 0x02)
-					bufR[cur_smpl] += chnout;
 			}
+			else
+			{
+				chnout = psg->vol_table[chan][psg->vol_enabled[chan] ? TONE_VOLUME(psg, chan) : 0];
+			}
+			if (psg->StereoMask[chan] & 0x01)
+				left += chnout;
+			if (psg->StereoMask[chan] & 0x02)
+				right += chnout;
 		}
+	}
 #if ENABLE_CUSTOM_OUTPUTS
-		else
+	else
+	{
+		chnout = mix_3D(psg);
+		left += chnout;
+		right += chnout;
+	}
+#endif
+	*outL = left;
+	*outR = right;
+}
+
+static void ay8910_update_blep(ay8910_context *psg, UINT32 samples, DEV_SMPL **outputs)
+{
+	DEV_SMPL *outBufs[2];
+	DEV_SMPL outL, outR;
+	UINT32 smplCnt;
+	UINT32 clocks;
+	UINT32 clk;
+	INT32 skip;
+
+	outBufs[0] = outputs[0];
+	outBufs[1] = outputs[1];
+	while (samples > 0)
+	{
+		smplCnt = (samples < BLEP_MAX_SMPLS) ? samples : BLEP_MAX_SMPLS;
+		clocks = BlepBuf_ClocksNeeded(&psg->blep, smplCnt);
+		for (clk = 0; clk < clocks; clk += skip)
 		{
-			chnout = mix_3D(psg);
-			bufL[cur_smpl] += chnout;
-			bufR[cur_smpl] += chnout;
+			/* The output can only change when a counter expires, so jump right to the next one. */
+			/* (Register writes happen between update calls, so the first clock is always rendered.) */
+			skip = (clk == 0) ? 1 : ay8910_clocks_to_event(psg, (INT32)(clocks - clk));
+			ay8910_skip_clocks(psg, skip - 1);
+			ay8910_clock(psg);
+			ay8910_calc_output(psg, &outL, &outR);
+			BlepBuf_SetAmp(&psg->blep, clk + skip - 1, outL, outR);
 		}
-#endif
+		BlepBuf_EndFrame(&psg->blep, clocks);
+		BlepBuf_ReadSamples(&psg->blep, smplCnt, outBufs);
+		outBufs[0] += smplCnt;
+		outBufs[1] += smplCnt;
+		samples -= smplCnt;
+	}
+}
+
+void ay8910_update_one(void *param, UINT32 samples, DEV_SMPL **outputs)
+{
+	ay8910_context *psg = (ay8910_context *)param;
+	UINT32 cur_smpl;
+	DEV_SMPL *bufL = outputs[0];
+	DEV_SMPL *bufR = outputs[1];
+
+	/* The 8910 has three outputs, each output is the mix of one of the three */
+	/* tone generators and of the (single) noise generator. The two are mixed */
+	/* BEFORE going into the DAC. The formula to mix each channel is: */
+	/* (ToneOn | ToneDisable) & (NoiseOn | NoiseDisable). */
+	/* Note that this means that if both tone and noise are disabled, the output */
+	/* is 1, not 0, and can be modulated changing the volume. */
+
+	if (psg->blep_active)
+	{
+		ay8910_update_blep(psg, samples, outputs);
+		return;
+	}
+
+	/* buffering loop */
+	for (cur_smpl = 0; cur_smpl < samples; cur_smpl++)
+	{
+		ay8910_clock(psg);
+		ay8910_calc_output(psg, &bufL[cur_smpl], &bufR[cur_smpl]);
 	}
 }
 
@@ -1375,6 +1473,8 @@ UINT8 device_start_ay8910_mame(const AY8910_CFG* cfg, DEV_INFO* retDevInf)
 	if (chip == NULL)
 		return 0xFF;
 	
+	((ay8910_context*)chip)->smpl_rate = cfg->_genCfg.smplRate;
+	
 	devData = (DEV_DATA*)chip;
 	devData->chipInf = chip;
 	INIT_DEVINF(retDevInf, devData, rate, &devDef_AY8910_MAME);
@@ -1445,6 +1545,8 @@ void ay8910_reset(void *chip)
 	for (i = 0;i < AY_PORTA;i++)
 		ay8910_write_reg(psg,i,0);
 	//psg->ready = 1;
+	if (psg->blep_active)
+		BlepBuf_Clear(&psg->blep);
 #if ENABLE_REGISTER_TEST
 	ay8910_write_reg(psg, AY_AFINE, 0);
 	ay8910_write_reg(psg, AY_ACOARSE, 1);
@@ -1468,6 +1570,8 @@ void ay8910_set_clock(void *chip, UINT32 clock)
 	ay8910_context *psg = (ay8910_context *)chip;
 	
 	psg->clock = clock;
+	if (psg->blep_enable)
+		ay8910_setup_blep(psg);
 	if (psg->SmpRateFunc != NULL)
 		psg->SmpRateFunc(psg->SmpRateData, ay8910_get_sample_rate(psg));
 	
@@ -1477,6 +1581,12 @@ void ay8910_set_clock(void *chip, UINT32 clock)
 UINT32 ay8910_get_sample_rate(void *chip)
 {
 	ay8910_context *psg = (ay8910_context *)chip;
+	
+	return psg->blep_active ? psg->smpl_rate : ay8910_get_native_rate(psg);
+}
+
+static UINT32 ay8910_get_native_rate(ay8910_context *psg)
+{
 	UINT32 master_clock = psg->clock;
 	
 	if (psg->type == PSG_TYPE_YM)
@@ -1578,6 +1688,34 @@ UINT8 ay8910_read(void *chip, UINT8 addr)
 	else return psg->regs[r];
 }
 
+static void ay8910_setup_blep(ay8910_context *psg)
+{
+	UINT32 native_rate = ay8910_get_native_rate(psg);
+	
+	// BLEP mode is only useful when the chip runs faster than the output
+	psg->blep_active = psg->blep_enable && psg->smpl_rate > 0 && native_rate > psg->smpl_rate;
+	if (psg->blep_active)
+		BlepBuf_Init(&psg->blep, native_rate, psg->smpl_rate);
+	
+	return;
+}
+
+void ay8910_set_options(void *chip, UINT32 Flags)
+{
+	ay8910_context *psg = (ay8910_context *)chip;
+	UINT8 blep_enable = (Flags & OPT_AY8910_BLEP) ? 1 : 0;
+	
+	if (blep_enable == psg->blep_enable)
+		return;
+	
+	psg->blep_enable = blep_enable;
+	ay8910_setup_blep(psg);
+	if (psg->SmpRateFunc != NULL)
+		psg->SmpRateFunc(psg->SmpRateData, ay8910_get_sample_rate(psg));
+	
+	return;
+}
+
 void ay8910_set_mute_mask(void *chip, UINT32 MuteMask)
 {
 	ay8910_context *psg = (ay8910_context *)chip;
@@ -30,6 +30,8 @@
 #include "c352.h"
 
 static void c352_update(void *chip, UINT32 samples, DEV_SMPL **outputs);
+static void c352_advance(void *chip, UINT32 samples);
+static UINT8 c352_is_idle(void *chip);
 static UINT8 device_start_c352(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf);
 static void device_stop_c352(void *chip);
 static void device_reset_c352(void *chip);
@@ -39,6 +41,7 @@ static void c352_w(void *chip, UINT16 offset, UINT16 data);
 
 static void c352_alloc_rom(void* chip, UINT32 memsize);
 static void c352_write_rom(void *chip, UINT32 offset, UINT32 length, const UINT8* data);
+static void c352_link_rom(void *chip, UINT32 memsize, const UINT8* data);
 
 static void c352_set_mute_mask(void *chip, UINT32 MuteMask);
 static UINT32 c352_get_mute_mask(void *chip);
@@ -51,7 +54,10 @@ static DEVDEF_RWFUNC devFunc[] =
 	{RWF_REGISTER | RWF_READ, DEVRW_A16D16, 0, c352_r},
 	{RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 0, c352_write_rom},
 	{RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 0, c352_alloc_rom},
+	{RWF_MEMORY | RWF_WRITE, DEVRW_MEMLINK, 0, c352_link_rom},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, c352_set_mute_mask},
+	{RWF_ADVANCE | RWF_WRITE, DEVRW_VALUE, 0, c352_advance},
+	{RWF_IDLE | RWF_READ, DEVRW_VALUE, 0, c352_is_idle},
 	{0x00, 0x00, 0, NULL}
 };
 static DEV_DEF devDef =
@@ -159,6 +165,7 @@ typedef struct {
 	UINT8* wave;
 	UINT32 wavesize;
 	UINT32 wave_mask;
+	UINT8 wave_linked;  // wave points to external read-only data
 
 	UINT8 muteRear;     // flag from VGM header
 	UINT8 optMuteRear;  // option
@@ -235,12 +242,57 @@ static void c352_ramp_volume(C352_Voice* v,int ch,UINT8 val)
 		v->curr_vol[ch] += (vol_delta>0) ? -1 : 1;
 }
 
+// returns a bitmask of all voices that are playing
+static UINT32 c352_get_active_mask(C352 *c)
+{
+	UINT32 mask = 0;
+	int j;
+
+	for(j=0;j<C352_VOICES;j++)
+	{
+		if(c->v[j].flags & C352_FLG_BUSY)
+			mask |= (1U << j);
+	}
+	return mask;
+}
+
+static UINT8 c352_is_idle(void *chip)
+{
+	C352 *c = (C352 *)chip;
+
+	// voices that aren't busy neither change their state nor generate output
+	return (c->wave == NULL || ! c352_get_active_mask(c));
+}
+
+// advances the voice's sample counter, fetches new samples and ramps the volume
+INLINE void c352_step_voice(C352 *c, C352_Voice* v)
+{
+	INT32 next_counter;
+
+	next_counter = v->counter+v->freq;
+
+	if(next_counter & 0x10000)
+	{
+		C352_fetch_sample(c,v);
+	}
+
+	if((next_counter^v->counter) & 0x18000)
+	{
+		c352_ramp_volume(v,0,v->vol_f>>8);
+		c352_ramp_volume(v,1,v->vol_f&0xff);
+		c352_ramp_volume(v,2,v->vol_r>>8);
+		c352_ramp_volume(v,3,v->vol_r&0xff);
+	}
+
+	v->counter = next_counter&0xffff;
+}
+
 static void c352_update(void *chip, UINT32 samples, DEV_SMPL **outputs)
 {
 	C352 *c = (C352 *)chip;
 	UINT32 i, j;
+	UINT32 act_mask, vmask;
 	INT32 s;
-	INT32 next_counter;
 	C352_Voice* v;
 
 	DEV_SMPL out[4];
@@ -250,43 +302,31 @@ static void c352_update(void *chip, UINT32 samples, DEV_SMPL **outputs)
 	if (c->wave == NULL)
 		return;
 
-	for(i=0;i<samples;i++)
+	// Voices can only be keyed on by register writes, so the set of active voices
+	// can only shrink during an update.
+	act_mask = c352_get_active_mask(c);
+	for(i=0;i<samples && act_mask;i++)
 	{
 		out[0]=out[1]=out[2]=out[3]=0;
 
-		for(j=0;j<C352_VOICES;j++)
+		for(j=0,vmask=act_mask;vmask;j++,vmask>>=1)
 		{
+			if(!(vmask & 1))
+				continue;
 
 			v = &c->v[j];
-			s = 0;
+			c352_step_voice(c, v);
 
-			if(v->flags & C352_FLG_BUSY)
-			{
-				next_counter = v->counter+v->freq;
-
-				if(next_counter & 0x10000)
-				{
-					C352_fetch_sample(c,v);
-				}
-
-				if((next_counter^v->counter) & 0x18000)
-				{
-					c352_ramp_volume(v,0,v->vol_f>>8);
-					c352_ramp_volume(v,1,v->vol_f&0xff);
-					c352_ramp_volume(v,2,v->vol_r>>8);
-					c352_ramp_volume(v,3,v->vol_r&0xff);
-				}
-
-				v->counter = next_counter&0xffff;
-
-				// Interpolate samples
-				if((v->flags & C352_FLG_FILTER) == 0)
-					s = v->last_sample + (INT32)((INT64)v->counter*(v->sample-v->last_sample)>>16);
-				else
-					s = v->sample;
-			}
+			// Interpolate samples
+			if((v->flags & C352_FLG_FILTER) == 0)
+				s = v->last_sample + (INT32)((INT64)v->counter*(v->sample-v->last_sample)>>16);
+			else
+				s = v->sample;
 
-			if(!c->v[j].mute)
+			if(!(v->flags & C352_FLG_BUSY))
+				act_mask &= ~(1U << j);	// the voice stopped, it will output silence from now on
+
+			if(!v->mute)
 			{
 				// Left
 				out[0] += (((v->flags & C352_FLG_PHASEFL) ? -s : s) * v->curr_vol[0])>>8;
@@ -308,6 +348,31 @@ static void c352_update(void *chip, UINT32 samples, DEV_SMPL **outputs)
 	}
 }
 
+static void c352_advance(void *chip, UINT32 samples)
+{
+	C352 *c = (C352 *)chip;
+	UINT32 i, j;
+	UINT32 act_mask, vmask;
+
+	if (c->wave == NULL)
+		return;
+
+	// same as c352_update, but without interpolation and mixing
+	act_mask = c352_get_active_mask(c);
+	for(i=0;i<samples && act_mask;i++)
+	{
+		for(j=0,vmask=act_mask;vmask;j++,vmask>>=1)
+		{
+			if(!(vmask & 1))
+				continue;
+
+			c352_step_voice(c, &c->v[j]);
+			if(!(c->v[j].flags & C352_FLG_BUSY))
+				act_mask &= ~(1U << j);
+		}
+	}
+}
+
 static UINT8 device_start_c352(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 {
 	C352 *c;
@@ -356,7 +421,8 @@ static void device_stop_c352(void *chip)
 {
 	C352 *c = (C352 *)chip;
 	
-	free(c->wave);
+	if (! c->wave_linked)
+		free(c->wave);
 	free(c);
 	
 	return;
@@ -454,6 +520,11 @@ static void c352_alloc_rom(void* chip, UINT32 memsize)
 	if (c->wavesize == memsize)
 		return;
 	
+	if (c->wave_linked)
+	{
+		c->wave = NULL;
+		c->wave_linked = 0;
+	}
 	c->wave = (UINT8*)realloc(c->wave, memsize);
 	c->wavesize = memsize;
 	memset(c->wave, 0xFF, memsize);
@@ -471,11 +542,33 @@ static void c352_write_rom(void *chip, UINT32 offset, UINT32 length, const UINT8
 	if (offset + length > c->wavesize)
 		length = c->wavesize - offset;
 	
+	if (c->wave_linked)
+	{
+		// copy-on-write
+		UINT8* newWave = (UINT8*)malloc(c->wavesize);
+		memcpy(newWave, c->wave, c->wavesize);
+		c->wave = newWave;
+		c->wave_linked = 0;
+	}
 	memcpy(c->wave + offset, data, length);
 	
 	return;
 }
 
+static void c352_link_rom(void *chip, UINT32 memsize, const UINT8* data)
+{
+	C352 *c = (C352 *)chip;
+	
+	if (! c->wave_linked)
+		free(c->wave);
+	c->wave = (UINT8*)data;
+	c->wavesize = (data != NULL) ? memsize : 0x00;
+	c->wave_mask = pow2_mask(c->wavesize);
+	c->wave_linked = (data != NULL);
+	
+	return;
+}
+
 static void c352_set_mute_mask(void *chip, UINT32 MuteMask)
 {
 	C352 *c = (C352 *)chip;
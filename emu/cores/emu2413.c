@@ -20,6 +20,7 @@
 #include "../EmuStructs.h"
 #include "../EmuCores.h"
 #include "../EmuHelper.h"
+#include "../EmuOnce.h"
 #include "emu2413.h"
 #include "emu2413_private.h"
 #include "../panning.h" // Maxim
@@ -427,14 +428,13 @@ static void makeDefaultPatch(void) {
       EOPLL_getDefaultPatch(i, j, &default_patch[i][j * 2]);
 }
 
-static uint8_t table_initialized = 0;
+static EMU_ONCE table_initialized = EMU_ONCE_INIT;
 
 static void initializeTables(void) {
   makeTllTable();
   makeRksTable();
   makeSinTable();
   makeDefaultPatch();
-  table_initialized = 1;
 }
 
 /*********************************************************
@@ -1110,9 +1110,7 @@ EOPLL *EOPLL_new(uint32_t clk, uint32_t rate) {
   EOPLL *opll;
   int i;
 
-  if (!table_initialized) {
-    initializeTables();
-  }
+  EmuOnce_Run(&table_initialized, initializeTables);
 
   opll = (EOPLL *)calloc(1, sizeof(EOPLL));
   if (opll == NULL)
@@ -54,6 +54,7 @@ static void es5503_w(void *info, UINT8 offset, UINT8 data);
 static UINT8 es5503_r(void *info, UINT8 offset);
 
 static void es5503_pcm_update(void *param, UINT32 samples, DEV_SMPL **outputs);
+static UINT8 es5503_is_idle(void *param);
 static UINT8 device_start_es5503(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf);
 static void device_stop_es5503(void *info);
 static void device_reset_es5503(void *info);
@@ -70,6 +71,7 @@ static DEVDEF_RWFUNC devFunc[] =
 	{RWF_REGISTER | RWF_READ, DEVRW_A8D8, 0, es5503_r},
 	{RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 0, es5503_write_ram},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, es5503_set_mute_mask},
+	{RWF_IDLE | RWF_READ, DEVRW_VALUE, 0, es5503_is_idle},
 	{0x00, 0x00, 0, NULL}
 };
 static DEV_DEF devDef =
@@ -251,6 +253,28 @@ static void es5503_halt_osc(ES5503Chip *chip, int onum, int type, UINT32 *accumu
 	}
 }
 
+// returns a bitmask of all enabled oscillators that are running and not muted
+static UINT32 es5503_get_active_mask(ES5503Chip *chip)
+{
+	UINT32 mask = 0;
+	UINT8 osc;
+
+	for (osc = 0; osc < chip->oscsenabled; osc++)
+	{
+		const ES5503Osc *pOsc = &chip->oscillators[osc];
+		if (!(pOsc->control & 1) && ! pOsc->Muted)
+			mask |= (1U << osc);
+	}
+	return mask;
+}
+
+static UINT8 es5503_is_idle(void *param)
+{
+	ES5503Chip *chip = (ES5503Chip *)param;
+
+	return (chip->docram == NULL || ! es5503_get_active_mask(chip));
+}
+
 static void es5503_pcm_update(void *param, UINT32 samples, DEV_SMPL **outputs)
 {
 	UINT8 osc;
@@ -258,20 +282,23 @@ static void es5503_pcm_update(void *param, UINT32 samples, DEV_SMPL **outputs)
 	UINT32 ramptr;
 	ES5503Chip *chip = (ES5503Chip *)param;
 	UINT8 chnsStereo, chan;
+	UINT32 act_mask, omask;
 
 	memset(outputs[0], 0, samples * sizeof(DEV_SMPL));
 	memset(outputs[1], 0, samples * sizeof(DEV_SMPL));
 	if (chip->docram == NULL)
 		return;
 
+	// Halting an oscillator may start its partner, so the mask is refreshed after each halt.
+	act_mask = es5503_get_active_mask(chip);
 	chnsStereo = chip->output_channels & ~1;
-	for (snum = 0; snum < samples; snum++)
+	for (snum = 0; snum < samples && act_mask; snum++)
 	{
-		for (osc = 0; osc < chip->oscsenabled; osc++)
+		for (osc = 0, omask = act_mask; omask; osc++, omask >>= 1)
 		{
 			ES5503Osc *pOsc = &chip->oscillators[osc];
 
-			if (!(pOsc->control & 1) && ! pOsc->Muted)
+			if (omask & 1)
 			{
 				UINT32 wtptr = pOsc->wavetblpointer & wavemasks[pOsc->wavetblsize];
 				UINT32 altram;
@@ -294,6 +321,8 @@ static void es5503_pcm_update(void *param, UINT32 samples, DEV_SMPL **outputs)
 				if (pOsc->data == 0x00)
 				{
 					es5503_halt_osc(chip, osc, 1, &pOsc->accumulator, resshift);
+					act_mask = es5503_get_active_mask(chip);
+					omask = act_mask >> osc;
 				}
 				else
 				{
@@ -343,6 +372,8 @@ static void es5503_pcm_update(void *param, UINT32 samples, DEV_SMPL **outputs)
 					if (altram >= wtsize)
 					{
 						es5503_halt_osc(chip, osc, 0, &pOsc->accumulator, resshift);
+						act_mask = es5503_get_active_mask(chip);
+						omask = act_mask >> osc;
 					}
 				}
 			}	// end if (oscillators[osc] playing)
@@ -78,6 +78,7 @@ Revision History:
 #include "../../stdtype.h"
 #include "../snddef.h"
 #include "../EmuHelper.h"
+#include "../EmuOnce.h"
 #include "../logging.h"
 
 #ifndef SNDDEV_SELECT
@@ -588,9 +589,6 @@ static const INT8 lfo_pm_table[8*8*2] = {
 };
 
 
-/* lock level of common table */
-static int num_lock = 0;
-
 
 #define SLOT7_1 (&OPL->P_CH[7].SLOT[SLOT1])
 #define SLOT7_2 (&OPL->P_CH[7].SLOT[SLOT2])
@@ -599,7 +597,7 @@ static int num_lock = 0;
 
 
 
-static UINT8 tablesInit = 0;
+static EMU_ONCE tablesInit = EMU_ONCE_INIT;
 
 /* status set and IRQ handling */
 INLINE void OPL_STATUS_SET(FM_OPL *OPL,int flag)
@@ -920,6 +918,38 @@ INLINE void OPL_CALC_CH( FM_OPL *OPL, OPL_CH *CH )
 		OPL->output[0] += op_calc(SLOT->Cnt, env, OPL->phase_modulation, SLOT->wavetable);
 }
 
+/* calculate operator 1 feedback only (used when advancing without output) */
+INLINE void OPL_CALC_FB( FM_OPL *OPL, OPL_SLOT *SLOT )
+{
+	unsigned int env;
+	signed int out;
+
+	env  = volume_calc(SLOT);
+	out  = SLOT->op1_out[0] + SLOT->op1_out[1];
+	SLOT->op1_out[0] = SLOT->op1_out[1];
+	SLOT->op1_out[1] = 0;
+	if( env < ENV_QUIET )
+	{
+		if (!SLOT->FB)
+			out = 0;
+		SLOT->op1_out[1] = op_calc1(SLOT->Cnt, env, (out<<SLOT->FB), SLOT->wavetable );
+	}
+}
+
+/* update the feedback state of all channels without calculating the output */
+INLINE void OPL_CALC_FB_ALL( FM_OPL *OPL, UINT8 rhythm )
+{
+	int ch;
+
+	for (ch = 0; ch < (rhythm ? 6 : 9); ch ++)
+	{
+		if (! OPL->P_CH[ch].Muted)
+			OPL_CALC_FB(OPL, &OPL->P_CH[ch].SLOT[SLOT1]);
+	}
+	if (rhythm)
+		OPL_CALC_FB(OPL, &OPL->P_CH[6].SLOT[SLOT1]);  /* Bass Drum */
+}
+
 /*
     operators used in the rhythm sounds generation process:
 
@@ -1122,16 +1152,12 @@ INLINE void OPL_CALC_RH( FM_OPL *OPL, OPL_CH *CH, unsigned int noise )
 
 
 /* generic table initialize */
-static int init_tables(void)
+static void init_tables(void)
 {
 	signed int i,x;
 	signed int n;
 	double o,m;
 
-	if (tablesInit)
-		return 1;
-	tablesInit = 1;
-
 	for (x=0; x<TL_RES_LEN; x++)
 	{
 		m = (1<<16) / pow(2, (x+1) * (ENV_STEP/4.0) / 8.0);
@@ -1222,9 +1248,6 @@ static int init_tables(void)
 		logerror("FMOPL.C: sin3[%4i]= %4i (tl_tab value=%5i)\n", i, sin_tab[3*SIN_LEN+i], tl_tab[sin_tab[3*SIN_LEN+i]] );*/
 	}
 	/*logerror("FMOPL.C: ENV_QUIET= %08x (dec*8=%i)\n", ENV_QUIET, ENV_QUIET*8 );*/
-
-
-	return 1;
 }
 
 static void OPLCloseTable( void )
@@ -1690,28 +1713,13 @@ static void OPLWriteReg(FM_OPL *OPL, UINT8 r, UINT8 v)
 /* lock/unlock for common table */
 static int OPL_LockTable(void)
 {
-	num_lock++;
-	if(num_lock>1) return 0;
-
-	/* first time */
-
-	/* allocate total level table (128kb space) */
-	if( !init_tables() )
-	{
-		num_lock--;
-		return -1;
-	}
-
+	/* the tables are shared by all chips and initialized only once (thread-safe) */
+	EmuOnce_Run(&tablesInit, init_tables);
 	return 0;
 }
 
 static void OPL_UnLockTable(void)
 {
-	if(num_lock) num_lock--;
-	if(num_lock) return;
-
-	/* last time */
-
 	OPLCloseTable();
 }
 
@@ -2043,8 +2051,15 @@ void ym3812_update_one(void *chip, UINT32 length, DEV_SMPL **buffer)
 		return;
 	}
 
-	bufL = buffer[0];
-	bufR = buffer[1];
+	if (buffer != NULL)
+	{
+		bufL = buffer[0];
+		bufR = buffer[1];
+	}
+	else
+	{
+		bufL = bufR = NULL;
+	}
 	for( i=0; i < length ; i++ )
 	{
 		int lt;
@@ -2053,6 +2068,14 @@ void ym3812_update_one(void *chip, UINT32 length, DEV_SMPL **buffer)
 
 		advance_lfo(OPL);
 
+		if (bufL == NULL)
+		{
+			/* advancing without output */
+			OPL_CALC_FB_ALL(OPL, rhythm);
+			advance(OPL);
+			continue;
+		}
+
 		/* FM part */
 		OPL_CALC_CH(OPL, &OPL->P_CH[0]);
 		OPL_CALC_CH(OPL, &OPL->P_CH[1]);
@@ -2082,6 +2105,12 @@ void ym3812_update_one(void *chip, UINT32 length, DEV_SMPL **buffer)
 	}
 
 }
+
+/* advance the emulation without generating output */
+void ym3812_advance(void *chip, UINT32 length)
+{
+	ym3812_update_one(chip, length, NULL);
+}
 #endif /* BUILD_YM3812 */
 
 
@@ -2178,8 +2207,15 @@ void ym3526_update_one(void *chip, UINT32 length, DEV_SMPL **buffer)
 		return;
 	}
 	
-	bufL = buffer[0];
-	bufR = buffer[1];
+	if (buffer != NULL)
+	{
+		bufL = buffer[0];
+		bufR = buffer[1];
+	}
+	else
+	{
+		bufL = bufR = NULL;
+	}
 	for( i=0; i < length ; i++ )
 	{
 		int lt;
@@ -2188,6 +2224,14 @@ void ym3526_update_one(void *chip, UINT32 length, DEV_SMPL **buffer)
 
 		advance_lfo(OPL);
 
+		if (bufL == NULL)
+		{
+			/* advancing without output */
+			OPL_CALC_FB_ALL(OPL, rhythm);
+			advance(OPL);
+			continue;
+		}
+
 		/* FM part */
 		OPL_CALC_CH(OPL, &OPL->P_CH[0]);
 		OPL_CALC_CH(OPL, &OPL->P_CH[1]);
@@ -2217,6 +2261,12 @@ void ym3526_update_one(void *chip, UINT32 length, DEV_SMPL **buffer)
 	}
 
 }
+
+/* advance the emulation without generating output */
+void ym3526_advance(void *chip, UINT32 length)
+{
+	ym3526_update_one(chip, length, NULL);
+}
 #endif /* BUILD_YM3526 */
 
 
@@ -2369,8 +2419,15 @@ void y8950_update_one(void *chip, UINT32 length, DEV_SMPL **buffer)
 		return;
 	}
 	
-	bufL = buffer[0];
-	bufR = buffer[1];
+	if (buffer != NULL)
+	{
+		bufL = buffer[0];
+		bufR = buffer[1];
+	}
+	else
+	{
+		bufL = bufR = NULL;
+	}
 	for( i=0; i < length ; i++ )
 	{
 		int lt;
@@ -2384,6 +2441,14 @@ void y8950_update_one(void *chip, UINT32 length, DEV_SMPL **buffer)
 		if( DELTAT->portstate&0x80 && ! OPL->MuteSpc[5] )
 			YM_DELTAT_ADPCM_CALC(DELTAT);
 
+		if (bufL == NULL)
+		{
+			/* advancing without output */
+			OPL_CALC_FB_ALL(OPL, rhythm);
+			advance(OPL);
+			continue;
+		}
+
 		/* FM part */
 		OPL_CALC_CH(OPL, &OPL->P_CH[0]);
 		OPL_CALC_CH(OPL, &OPL->P_CH[1]);
@@ -2414,6 +2479,12 @@ void y8950_update_one(void *chip, UINT32 length, DEV_SMPL **buffer)
 
 }
 
+/* advance the emulation without generating output */
+void y8950_advance(void *chip, UINT32 length)
+{
+	y8950_update_one(chip, length, NULL);
+}
+
 void y8950_set_port_handler(void *chip,OPL_PORTHANDLER_W PortHandler_w,OPL_PORTHANDLER_R PortHandler_r,void * param)
 {
 	FM_OPL      *OPL = (FM_OPL *)chip;
@@ -39,6 +39,7 @@ void ym3812_write(void *chip, UINT8 a, UINT8 v);
 UINT8 ym3812_read(void *chip, UINT8 a);
 UINT8 ym3812_timer_over(void *chip, UINT8 c);
 void ym3812_update_one(void *chip, UINT32 length, DEV_SMPL **buffer);
+void ym3812_advance(void *chip, UINT32 length);
 
 void ym3812_set_timer_handler(void *chip, OPL_TIMERHANDLER TimerHandler, void *param);
 void ym3812_set_irq_handler(void *chip, OPL_IRQHANDLER IRQHandler, void *param);
@@ -71,6 +72,7 @@ UINT8 ym3526_timer_over(void *chip, UINT8 c);
 ** 'length' is the number of samples that should be generated
 */
 void ym3526_update_one(void *chip, UINT32 length, DEV_SMPL **buffer);
+void ym3526_advance(void *chip, UINT32 length);
 
 void ym3526_set_timer_handler(void *chip, OPL_TIMERHANDLER TimerHandler, void *param);
 void ym3526_set_irq_handler(void *chip, OPL_IRQHANDLER IRQHandler, void *param);
@@ -94,6 +96,7 @@ void y8950_write(void *chip, UINT8 a, UINT8 v);
 UINT8 y8950_read (void *chip, UINT8 a);
 UINT8 y8950_timer_over(void *chip, UINT8 c);
 void y8950_update_one(void *chip, UINT32 length, DEV_SMPL **buffer);
+void y8950_advance(void *chip, UINT32 length);
 
 void y8950_set_timer_handler(void *chip, OPL_TIMERHANDLER TimerHandler, void *param);
 void y8950_set_irq_handler(void *chip, OPL_IRQHANDLER IRQHandler, void *param);
@@ -164,6 +164,7 @@
 #include "../../stdtype.h"
 #include "../snddef.h"
 #include "../EmuHelper.h"
+#include "../EmuOnce.h"
 #include "../logging.h"
 
 #ifndef SNDDEV_SELECT
@@ -730,7 +731,7 @@ typedef struct
 }
 
 
-static UINT8 tablesInit = 0;
+static EMU_ONCE tablesInit = EMU_ONCE_INIT;
 
 /* status set and IRQ handling */
 INLINE void FM_STATUS_SET(FM_ST *ST,int flag)
@@ -1626,6 +1627,36 @@ INLINE signed int op_calc1(UINT32 phase, unsigned int env, signed int pm)
 	return tl_tab[p];
 }
 
+/* update phase counters of a channel */
+INLINE void chan_update_phase(FM_OPN *OPN, FM_CH *CH)
+{
+	if (CH->pms)
+	{
+		/* 3-slot mode */
+		if ((OPN->ST.mode & 0xC0) && (CH == &OPN->P_CH[2]))
+		{
+			/* keyscale code is not modified by LFO */
+			UINT8 kc = CH->kcode;
+			UINT32 pm = CH->pms + OPN->LFO_PM;
+			update_phase_lfo_slot(OPN, &CH->SLOT[SLOT1], pm, kc, OPN->SL3.block_fnum[1]);
+			update_phase_lfo_slot(OPN, &CH->SLOT[SLOT2], pm, kc, OPN->SL3.block_fnum[2]);
+			update_phase_lfo_slot(OPN, &CH->SLOT[SLOT3], pm, kc, OPN->SL3.block_fnum[0]);
+			update_phase_lfo_slot(OPN, &CH->SLOT[SLOT4], pm, kc, CH->block_fnum);
+		}
+		else
+		{
+			update_phase_lfo_channel(OPN, CH);
+		}
+	}
+	else  /* no LFO phase modulation */
+	{
+		CH->SLOT[SLOT1].phase += CH->SLOT[SLOT1].Incr;
+		CH->SLOT[SLOT2].phase += CH->SLOT[SLOT2].Incr;
+		CH->SLOT[SLOT3].phase += CH->SLOT[SLOT3].Incr;
+		CH->SLOT[SLOT4].phase += CH->SLOT[SLOT4].Incr;
+	}
+}
+
 INLINE void chan_calc(FM_OPN *OPN, FM_CH *CH, int chnum)
 {
 	INT32 out = 0;
@@ -1675,31 +1706,34 @@ INLINE void chan_calc(FM_OPN *OPN, FM_CH *CH, int chnum)
 	CH->mem_value = OPN->mem;
 
 	/* update phase counters AFTER output calculations */
-	if (CH->pms)
-	{
-		/* 3-slot mode */
-		if ((OPN->ST.mode & 0xC0) && (CH == &OPN->P_CH[2]))
-		{
-			/* keyscale code is not modified by LFO */
-			UINT8 kc = CH->kcode;
-			UINT32 pm = CH->pms + OPN->LFO_PM;
-			update_phase_lfo_slot(OPN, &CH->SLOT[SLOT1], pm, kc, OPN->SL3.block_fnum[1]);
-			update_phase_lfo_slot(OPN, &CH->SLOT[SLOT2], pm, kc, OPN->SL3.block_fnum[2]);
-			update_phase_lfo_slot(OPN, &CH->SLOT[SLOT3], pm, kc, OPN->SL3.block_fnum[0]);
-			update_phase_lfo_slot(OPN, &CH->SLOT[SLOT4], pm, kc, CH->block_fnum);
-		}
-		else
-		{
-			update_phase_lfo_channel(OPN, CH);
-		}
-	}
-	else  /* no LFO phase modulation */
+	chan_update_phase(OPN, CH);
+}
+
+/* Calculate only SLOT 1, whose feedback is part of the emulation state, and update the phase counters.
+   This is used when advancing the chip without generating output. The outputs of the other slots and
+   the MEM value are only required for the last sample before output is generated again. */
+INLINE void chan_calc_m1(FM_OPN *OPN, FM_CH *CH)
+{
+	INT32 out = 0;
+	UINT32 AM = OPN->LFO_AM >> CH->ams;
+	unsigned int eg_out;
+
+	if (CH->Muted)
+		return;
+
+	eg_out = volume_calc(&CH->SLOT[SLOT1]);
+	if( eg_out < ENV_QUIET )  /* SLOT 1 */
 	{
-		CH->SLOT[SLOT1].phase += CH->SLOT[SLOT1].Incr;
-		CH->SLOT[SLOT2].phase += CH->SLOT[SLOT2].Incr;
-		CH->SLOT[SLOT3].phase += CH->SLOT[SLOT3].Incr;
-		CH->SLOT[SLOT4].phase += CH->SLOT[SLOT4].Incr;
+		if (CH->FB < SIN_BITS)
+			out = (CH->op1_out[0] + CH->op1_out[1]) << (FREQ_SH - CH->FB);
+
+		out = op_calc1(CH->SLOT[SLOT1].phase, eg_out, out);
 	}
+
+	CH->op1_out[0] = CH->op1_out[1];
+	CH->op1_out[1] = out;
+
+	chan_update_phase(OPN, CH);
 }
 
 
@@ -2102,10 +2136,6 @@ static void init_tables(void)
 	signed int n;
 	double o,m;
 
-	if (tablesInit)
-		return;
-	tablesInit = 1;
-
 	/* build Linear Power Table */
 	for (x=0; x<TL_RES_LEN; x++)
 	{
@@ -2418,9 +2448,19 @@ void ym2203_update_one(void *chip, UINT32 length, DEV_SMPL **buffer)
 		update_ssg_eg_channel(&cch[2]->SLOT[SLOT1]);
 
 		/* calculate FM */
-		chan_calc(OPN, cch[0], 0 );
-		chan_calc(OPN, cch[1], 1 );
-		chan_calc(OPN, cch[2], 2 );
+		if (bufL != NULL || i + 1 >= length)
+		{
+			chan_calc(OPN, cch[0], 0 );
+			chan_calc(OPN, cch[1], 1 );
+			chan_calc(OPN, cch[2], 2 );
+		}
+		else
+		{
+			/* advancing without output */
+			chan_calc_m1(OPN, cch[0]);
+			chan_calc_m1(OPN, cch[1]);
+			chan_calc_m1(OPN, cch[2]);
+		}
 
 		/* advance envelope generator */
 		OPN->eg_timer += OPN->eg_timer_add;
@@ -2435,6 +2475,7 @@ void ym2203_update_one(void *chip, UINT32 length, DEV_SMPL **buffer)
 		}
 
 		/* buffering */
+		if (bufL != NULL)
 		{
 			DEV_SMPL lt;
 
@@ -2468,6 +2509,12 @@ void ym2203_update_one(void *chip, UINT32 length, DEV_SMPL **buffer)
 	INTERNAL_TIMER_B(&OPN->ST,length)
 }
 
+/* advance the emulation without generating output */
+void ym2203_advance(void *chip, UINT32 length)
+{
+	ym2203_update_one(chip, length, NULL);
+}
+
 static void ym2203_update_req(void *param)
 {
 	ym2203_update_one(param, 0, NULL);
@@ -2525,7 +2572,7 @@ void * ym2203_init(void *param, UINT32 clock, UINT32 rate,
 		return NULL;
 
 	/* allocate total level table (128kb space) */
-	init_tables();
+	EmuOnce_Run(&tablesInit, init_tables);
 
 	F2203->OPN.ST.param = param;
 	F2203->OPN.type = TYPE_YM2203;
@@ -2748,6 +2795,7 @@ static const int step_inc[8] = { -1*16, -1*16, -1*16, -1*16, 2*16, 5*16, 7*16, 9
 
 /* speedup purposes only */
 static int jedi_table[ 49*16 ];
+static EMU_ONCE adpcmaTableInit = EMU_ONCE_INIT;
 
 
 static void Init_ADPCMATable(void)
@@ -3088,12 +3136,25 @@ void ym2608_update_one(void *chip, UINT32 length, DEV_SMPL **buffer)
 		update_ssg_eg_channel(&cch[5]->SLOT[SLOT1]);
 
 		/* calculate FM */
-		chan_calc(OPN, cch[0], 0 );
-		chan_calc(OPN, cch[1], 1 );
-		chan_calc(OPN, cch[2], 2 );
-		chan_calc(OPN, cch[3], 3 );
-		chan_calc(OPN, cch[4], 4 );
-		chan_calc(OPN, cch[5], 5 );
+		if (bufL != NULL || i + 1 >= length)
+		{
+			chan_calc(OPN, cch[0], 0 );
+			chan_calc(OPN, cch[1], 1 );
+			chan_calc(OPN, cch[2], 2 );
+			chan_calc(OPN, cch[3], 3 );
+			chan_calc(OPN, cch[4], 4 );
+			chan_calc(OPN, cch[5], 5 );
+		}
+		else
+		{
+			/* advancing without output */
+			chan_calc_m1(OPN, cch[0]);
+			chan_calc_m1(OPN, cch[1]);
+			chan_calc_m1(OPN, cch[2]);
+			chan_calc_m1(OPN, cch[3]);
+			chan_calc_m1(OPN, cch[4]);
+			chan_calc_m1(OPN, cch[5]);
+		}
 
 		/* deltaT ADPCM */
 		if( DELTAT->portstate&0x80 && ! F2608->MuteDeltaT )
@@ -3125,6 +3186,7 @@ void ym2608_update_one(void *chip, UINT32 length, DEV_SMPL **buffer)
 		}
 
 		/* buffering */
+		if (bufL != NULL)
 		{
 			DEV_SMPL lt,rt;
 
@@ -3180,6 +3242,12 @@ void ym2608_update_one(void *chip, UINT32 length, DEV_SMPL **buffer)
 	FM_STATUS_SET(&OPN->ST, 0);
 }
 
+/* advance the emulation without generating output */
+void ym2608_advance(void *chip, UINT32 length)
+{
+	ym2608_update_one(chip, length, NULL);
+}
+
 static void ym2608_update_req(void *param)
 {
 	ym2608_update_one(param, 0, NULL);
@@ -3207,7 +3275,7 @@ void * ym2608_init(void *param, UINT32 clock, UINT32 rate,
 		return NULL;
 
 	/* allocate total level table (128kb space) */
-	init_tables();
+	EmuOnce_Run(&tablesInit, init_tables);
 
 	F2608->OPN.ST.param = param;
 	F2608->OPN.type = TYPE_YM2608;
@@ -3244,7 +3312,7 @@ void * ym2608_init(void *param, UINT32 clock, UINT32 rate,
 	F2608->pcmbuf   = (UINT8*)YM2608_ADPCM_ROM;
 	F2608->pcm_size = 0x2000;
 
-	Init_ADPCMATable();
+	EmuOnce_Run(&adpcmaTableInit, Init_ADPCMATable);
 
 	ym2608_set_mute_mask(F2608, 0x00);
 
@@ -3683,10 +3751,21 @@ void ym2610_update_one(void *chip, UINT32 length, DEV_SMPL **buffer)
 		update_ssg_eg_channel(&cch[3]->SLOT[SLOT1]);
 
 		/* calculate FM */
-		chan_calc(OPN, cch[0], 1 );	/*remapped to 1*/
-		chan_calc(OPN, cch[1], 2 );	/*remapped to 2*/
-		chan_calc(OPN, cch[2], 4 );	/*remapped to 4*/
-		chan_calc(OPN, cch[3], 5 );	/*remapped to 5*/
+		if (bufL != NULL || i + 1 >= length)
+		{
+			chan_calc(OPN, cch[0], 1 );	/*remapped to 1*/
+			chan_calc(OPN, cch[1], 2 );	/*remapped to 2*/
+			chan_calc(OPN, cch[2], 4 );	/*remapped to 4*/
+			chan_calc(OPN, cch[3], 5 );	/*remapped to 5*/
+		}
+		else
+		{
+			/* advancing without output */
+			chan_calc_m1(OPN, cch[0]);
+			chan_calc_m1(OPN, cch[1]);
+			chan_calc_m1(OPN, cch[2]);
+			chan_calc_m1(OPN, cch[3]);
+		}
 
 		/* deltaT ADPCM */
 		if( DELTAT->portstate&0x80 && ! F2610->MuteDeltaT )
@@ -3716,6 +3795,7 @@ void ym2610_update_one(void *chip, UINT32 length, DEV_SMPL **buffer)
 		}
 
 		/* buffering */
+		if (bufL != NULL)
 		{
 			DEV_SMPL lt,rt;
 
@@ -3766,6 +3846,12 @@ void ym2610_update_one(void *chip, UINT32 length, DEV_SMPL **buffer)
 	INTERNAL_TIMER_B(&OPN->ST,length)
 }
 
+/* advance the emulation without generating output */
+void ym2610_advance(void *chip, UINT32 length)
+{
+	ym2610_update_one(chip, length, NULL);
+}
+
 static void ym2610_update_req(void *param)
 {
 	ym2610b_update_one(param, 0, NULL);
@@ -3854,12 +3940,25 @@ void ym2610b_update_one(void *chip, UINT32 length, DEV_SMPL **buffer)
 		update_ssg_eg_channel(&cch[5]->SLOT[SLOT1]);
 
 		/* calculate FM */
-		chan_calc(OPN, cch[0], 0 );
-		chan_calc(OPN, cch[1], 1 );
-		chan_calc(OPN, cch[2], 2 );
-		chan_calc(OPN, cch[3], 3 );
-		chan_calc(OPN, cch[4], 4 );
-		chan_calc(OPN, cch[5], 5 );
+		if (bufL != NULL || i + 1 >= length)
+		{
+			chan_calc(OPN, cch[0], 0 );
+			chan_calc(OPN, cch[1], 1 );
+			chan_calc(OPN, cch[2], 2 );
+			chan_calc(OPN, cch[3], 3 );
+			chan_calc(OPN, cch[4], 4 );
+			chan_calc(OPN, cch[5], 5 );
+		}
+		else
+		{
+			/* advancing without output */
+			chan_calc_m1(OPN, cch[0]);
+			chan_calc_m1(OPN, cch[1]);
+			chan_calc_m1(OPN, cch[2]);
+			chan_calc_m1(OPN, cch[3]);
+			chan_calc_m1(OPN, cch[4]);
+			chan_calc_m1(OPN, cch[5]);
+		}
 
 		/* deltaT ADPCM */
 		if( DELTAT->portstate&0x80 && ! F2610->MuteDeltaT )
@@ -3892,6 +3991,7 @@ void ym2610b_update_one(void *chip, UINT32 length, DEV_SMPL **buffer)
 
 
 		/* buffering */
+		if (bufL != NULL)
 		{
 			DEV_SMPL lt,rt;
 
@@ -3943,6 +4043,12 @@ void ym2610b_update_one(void *chip, UINT32 length, DEV_SMPL **buffer)
 	/* timer B control */
 	INTERNAL_TIMER_B(&OPN->ST,length)
 }
+
+/* advance the emulation without generating output */
+void ym2610b_advance(void *chip, UINT32 length)
+{
+	ym2610b_update_one(chip, length, NULL);
+}
 #endif /* BUILD_YM2610B */
 
 
@@ -3968,7 +4074,7 @@ void *ym2610_init(void *param, UINT32 clock, UINT32 rate,
 		return NULL;
 
 	/* allocate total level table (128kb space) */
-	init_tables();
+	EmuOnce_Run(&tablesInit, init_tables);
 
 	/* FM */
 	F2610->OPN.ST.param = param;
@@ -3998,7 +4104,7 @@ void *ym2610_init(void *param, UINT32 clock, UINT32 rate,
 
 	YM_DELTAT_ADPCM_Init(&F2610->deltaT,YM_DELTAT_EMULATION_MODE_YM2610,8,F2610->OPN.out_delta,1<<23);
 
-	Init_ADPCMATable();
+	EmuOnce_Run(&adpcmaTableInit, Init_ADPCMATable);
 
 	ym2610_set_mute_mask(F2610, 0x00);
 
@@ -4446,7 +4552,19 @@ void ym2612_update_one(void *chip, UINT32 length, DEV_SMPL **buffer)
 		update_ssg_eg_channel(&cch[5]->SLOT[SLOT1]);
 
 		/* calculate FM */
-		if (! F2612->dac_test)
+		/* (When advancing without output, the last 2 samples are calculated completely for the WaveOut latch.) */
+		if (! F2612->dac_test && bufL == NULL && i + 2 < length)
+		{
+			/* advancing without output */
+			chan_calc_m1(OPN, cch[0]);
+			chan_calc_m1(OPN, cch[1]);
+			chan_calc_m1(OPN, cch[2]);
+			chan_calc_m1(OPN, cch[3]);
+			chan_calc_m1(OPN, cch[4]);
+			if( ! F2612->dacen )
+				chan_calc_m1(OPN, cch[5]);
+		}
+		else if (! F2612->dac_test)
 		{
 			chan_calc(OPN, cch[0], 0 );
 			chan_calc(OPN, cch[1], 1 );
@@ -4534,8 +4652,11 @@ void ym2612_update_one(void *chip, UINT32 length, DEV_SMPL **buffer)
 			F2612->WaveL = lt;
 			F2612->WaveR = rt;
 		}
-		bufL[i] = F2612->WaveL;
-		bufR[i] = F2612->WaveR;
+		if (bufL != NULL)
+		{
+			bufL[i] = F2612->WaveL;
+			bufR[i] = F2612->WaveR;
+		}
 
 		/* CSM mode: if CSM Key ON has occured, CSM Key OFF need to be sent       */
 		/* only if Timer A does not overflow again (i.e CSM Key ON not set again) */
@@ -4560,6 +4681,12 @@ void ym2612_update_one(void *chip, UINT32 length, DEV_SMPL **buffer)
 	INTERNAL_TIMER_B(&OPN->ST,length)
 }
 
+/* advance the emulation without generating output */
+void ym2612_advance(void *chip, UINT32 length)
+{
+	ym2612_update_one(chip, length, NULL);
+}
+
 static void ym2612_update_req(void *param)
 {
 	ym2612_update_one(param, 0, NULL);
@@ -4577,7 +4704,7 @@ void * ym2612_init(void *param, UINT32 clock, UINT32 rate,
 		return NULL;
 
 	/* allocate total level table (128kb space) */
-	init_tables();
+	EmuOnce_Run(&tablesInit, init_tables);
 
 	/* FM */
 	F2612->OPN.ST.param = param;
@@ -4810,4 +4937,41 @@ void ym2612_set_log_cb(void* chip, DEVCB_LOG func, void* param)
 	dev_logger_set(&F2612->OPN.logger, F2612, func, param);
 	return;
 }
+
+/* save/restore chip state */
+/* The chip structure is self-contained (all internal pointers point into the
+   structure itself), so a state can be restored into the same instance
+   by copying it back. Muting and logging settings are kept. */
+UINT32 ym2612_save_state(void *chip, UINT32 bufSize, void *buffer)
+{
+	if (buffer == NULL || bufSize < sizeof(YM2612))
+		return sizeof(YM2612);
+	memcpy(buffer, chip, sizeof(YM2612));
+	return sizeof(YM2612);
+}
+
+UINT8 ym2612_load_state(void *chip, UINT32 bufSize, const void *buffer)
+{
+	YM2612 *F2612 = (YM2612 *)chip;
+	DEV_LOGGER logger;
+	UINT8 muted[6];
+	UINT8 muteDAC;
+	UINT8 CurChn;
+	
+	if (bufSize != sizeof(YM2612))
+		return 0xFF;
+	
+	logger = F2612->OPN.logger;
+	for (CurChn = 0; CurChn < 6; CurChn ++)
+		muted[CurChn] = F2612->CH[CurChn].Muted;
+	muteDAC = F2612->MuteDAC;
+	
+	memcpy(F2612, buffer, sizeof(YM2612));
+	
+	F2612->OPN.logger = logger;
+	for (CurChn = 0; CurChn < 6; CurChn ++)
+		F2612->CH[CurChn].Muted = muted[CurChn];
+	F2612->MuteDAC = muteDAC;
+	return 0x00;
+}
 #endif /* (BUILD_YM2612) */
@@ -117,6 +117,7 @@ void ym2203_reset_chip(void *chip);
 ** update one of chip
 */
 void ym2203_update_one(void *chip, UINT32 length, DEV_SMPL **buffer);
+void ym2203_advance(void *chip, UINT32 length);
 
 /*
 ** Write
@@ -155,6 +156,7 @@ void ym2608_set_srchg_cb(void *chip, DEVCB_SRATE_CHG cbFunc, void* dataPtr);
 void ym2608_shutdown(void *chip);
 void ym2608_reset_chip(void *chip);
 void ym2608_update_one(void *chip, UINT32 length, DEV_SMPL **buffer);
+void ym2608_advance(void *chip, UINT32 length);
 
 void ym2608_write(void *chip, UINT8 a, UINT8 v);
 UINT8 ym2608_read(void *chip, UINT8 a);
@@ -174,9 +176,11 @@ void ym2610_link_ssg(void *chip, const ssg_callbacks *ssg, void *ssg_param);
 void ym2610_shutdown(void *chip);
 void ym2610_reset_chip(void *chip);
 void ym2610_update_one(void *chip, UINT32 length, DEV_SMPL **buffer);
+void ym2610_advance(void *chip, UINT32 length);
 
 #if BUILD_YM2610B
 void ym2610b_update_one(void *chip, UINT32 length, DEV_SMPL **buffer);
+void ym2610b_advance(void *chip, UINT32 length);
 #endif /* BUILD_YM2610B */
 
 void ym2610_write(void *chip, UINT8 a, UINT8 v);
@@ -197,6 +201,7 @@ void * ym2612_init(void *param, UINT32 baseclock, UINT32 rate,
 void ym2612_shutdown(void *chip);
 void ym2612_reset_chip(void *chip);
 void ym2612_update_one(void *chip, UINT32 length, DEV_SMPL **buffer);
+void ym2612_advance(void *chip, UINT32 length);
 
 void ym2612_write(void *chip, UINT8 a, UINT8 v);
 UINT8 ym2612_read(void *chip, UINT8 a);
@@ -205,6 +210,8 @@ UINT8 ym2612_timer_over(void *chip, UINT8 c );
 void ym2612_set_mute_mask(void *chip, UINT32 MuteMask);
 void ym2612_set_options(void *chip, UINT32 Flags);
 void ym2612_set_log_cb(void* chip, DEVCB_LOG func, void* param);
+UINT32 ym2612_save_state(void *chip, UINT32 bufSize, void *buffer);
+UINT8 ym2612_load_state(void *chip, UINT32 bufSize, const void *buffer);
 #endif /* (BUILD_YM2612||BUILD_YM3438) */
 
 #endif	// __FMOPN_H__
@@ -63,6 +63,7 @@ TODO:
 #include "../snddef.h"
 #include "../EmuHelper.h"
 #include "../RatioCntr.h"
+#include "../blepbuf.h"
 #include "gb.h"
 
 
@@ -79,6 +80,8 @@ static void device_reset_gameboy_sound(void *chip);
 static void gameboy_sound_set_mute_mask(void *chip, UINT32 MuteMask);
 static UINT32 gameboy_sound_get_mute_mask(void *chip);
 static void gameboy_sound_set_options(void *chip, UINT32 Flags);
+static UINT32 gameboy_sound_get_rate(void *chip);
+static void gameboy_sound_set_srchg_cb(void *chip, DEVCB_SRATE_CHG CallbackFunc, void* DataPtr);
 
 
 
@@ -86,6 +89,7 @@ static DEVDEF_RWFUNC devFunc[] =
 {
 	{RWF_REGISTER | RWF_WRITE, DEVRW_A8D8, 0, gb_sound_w},
 	{RWF_REGISTER | RWF_READ, DEVRW_A8D8, 0, gb_sound_r},
+	{RWF_SRATE | RWF_READ, DEVRW_VALUE, 0, gameboy_sound_get_rate},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, gameboy_sound_set_mute_mask},
 	{0x00, 0x00, 0, NULL}
 };
@@ -101,7 +105,7 @@ static DEV_DEF devDef =
 	gameboy_sound_set_options,	// SetOptionBits
 	gameboy_sound_set_mute_mask,
 	NULL,	// SetPanning
-	NULL,	// SetSampleRateChangeCallback
+	gameboy_sound_set_srchg_cb,	// SetSampleRateChangeCallback
 	NULL,	// SetLoggingCallback
 	NULL,	// LinkDevice
 	
@@ -269,6 +273,7 @@ struct _gb_sound_t
 	DEV_DATA _devData;
 
 	UINT32 rate;
+	UINT32 smplRate;	// output sample rate (for BLEP mode)
 
 	struct SOUND  snd_1;
 	struct SOUND  snd_2;
@@ -284,6 +289,11 @@ struct _gb_sound_t
 	UINT8 BoostWaveChn;
 	UINT8 NoWaveCorrupt;
 	UINT8 LegacyMode;
+	UINT8 BlepMode;
+
+	DEVCB_SRATE_CHG SmpRateFunc;
+	void* SmpRateData;
+	BLEP_BUF blep;
 };
 
 
@@ -1130,72 +1140,116 @@ INLINE UINT32 gb_noise_period_cycles(gb_sound_t *gb)
 }
 
 
-static void gameboy_update(void *chip, UINT32 samples, DEV_SMPL **outputs)
+INLINE void gb_calc_output(gb_sound_t *gb, DEV_SMPL *outL, DEV_SMPL *outR)
 {
-	gb_sound_t *gb = (gb_sound_t *)chip;
 	DEV_SMPL sample, left, right;
-	UINT32 i;
 
-	for (i = 0; i < samples; i++)
+	left = right = 0;
+
+	/* Mode 1 - Wave with Envelope and Sweep */
+	if (gb->snd_1.on && !gb->snd_1.Muted)
 	{
-		left = right = 0;
+		sample = gb->snd_1.signal * gb->snd_1.envelope_value;
 
-		RC_STEP(&gb->cycleCntr);
-		gb_update_state(gb, RC_GET_VAL(&gb->cycleCntr));
-		RC_MASK(&gb->cycleCntr);
+		if (gb->snd_control.mode1_left)
+			left += sample;
+		if (gb->snd_control.mode1_right)
+			right += sample;
+	}
 
-		/* Mode 1 - Wave with Envelope and Sweep */
-		if (gb->snd_1.on && !gb->snd_1.Muted)
-		{
-			sample = gb->snd_1.signal * gb->snd_1.envelope_value;
+	/* Mode 2 - Wave with Envelope */
+	if (gb->snd_2.on && !gb->snd_2.Muted)
+	{
+		sample = gb->snd_2.signal * gb->snd_2.envelope_value;
+		if (gb->snd_control.mode2_left)
+			left += sample;
+		if (gb->snd_control.mode2_right)
+			right += sample;
+	}
 
-			if (gb->snd_control.mode1_left)
-				left += sample;
-			if (gb->snd_control.mode1_right)
-				right += sample;
-		}
+	/* Mode 3 - Wave patterns from WaveRAM */
+	if (gb->snd_3.on && !gb->snd_3.Muted)
+	{
+		sample = gb->snd_3.signal;
+		if (gb->snd_control.mode3_left)
+			left += sample;
+		if (gb->snd_control.mode3_right)
+			right += sample;
+	}
 
-		/* Mode 2 - Wave with Envelope */
-		if (gb->snd_2.on && !gb->snd_2.Muted)
-		{
-			sample = gb->snd_2.signal * gb->snd_2.envelope_value;
-			if (gb->snd_control.mode2_left)
-				left += sample;
-			if (gb->snd_control.mode2_right)
-				right += sample;
-		}
+	/* Mode 4 - Noise with Envelope */
+	if (gb->snd_4.on && !gb->snd_4.Muted)
+	{
+		sample = gb->snd_4.signal * gb->snd_4.envelope_value;
+		if (gb->snd_control.mode4_left)
+			left += sample;
+		if (gb->snd_control.mode4_right)
+			right += sample;
+	}
 
-		/* Mode 3 - Wave patterns from WaveRAM */
-		if (gb->snd_3.on && !gb->snd_3.Muted)
-		{
-			sample = gb->snd_3.signal;
-			if (gb->snd_control.mode3_left)
-				left += sample;
-			if (gb->snd_control.mode3_right)
-				right += sample;
-		}
+	/* Adjust for master volume */
+	left *= gb->snd_control.vol_left;
+	right *= gb->snd_control.vol_right;
+
+	/* pump up the volume */
+	left <<= 6;
+	right <<= 6;
 
-		/* Mode 4 - Noise with Envelope */
-		if (gb->snd_4.on && !gb->snd_4.Muted)
+	/* Update the buffers */
+	*outL = left;
+	*outR = right;
+}
+
+static void gameboy_update_blep(gb_sound_t *gb, UINT32 samples, DEV_SMPL **outputs)
+{
+	DEV_SMPL* outBufs[2];
+	DEV_SMPL left, right;
+	UINT32 smplCnt;
+	UINT32 clocks;
+	UINT32 clk;
+
+	outBufs[0] = outputs[0];
+	outBufs[1] = outputs[1];
+	while (samples > 0)
+	{
+		smplCnt = (samples < BLEP_MAX_SMPLS) ? samples : BLEP_MAX_SMPLS;
+		clocks = BlepBuf_ClocksNeeded(&gb->blep, smplCnt);
+		for (clk = 0; clk < clocks; clk++)
 		{
-			sample = gb->snd_4.signal * gb->snd_4.envelope_value;
-			if (gb->snd_control.mode4_left)
-				left += sample;
-			if (gb->snd_control.mode4_right)
-				right += sample;
+			RC_STEP(&gb->cycleCntr);
+			gb_update_state(gb, RC_GET_VAL(&gb->cycleCntr));
+			RC_MASK(&gb->cycleCntr);
+
+			gb_calc_output(gb, &left, &right);
+			BlepBuf_SetAmp(&gb->blep, clk, left, right);
 		}
+		BlepBuf_EndFrame(&gb->blep, clocks);
+		BlepBuf_ReadSamples(&gb->blep, smplCnt, outBufs);
+		outBufs[0] += smplCnt;
+		outBufs[1] += smplCnt;
+		samples -= smplCnt;
+	}
+}
 
-		/* Adjust for master volume */
-		left *= gb->snd_control.vol_left;
-		right *= gb->snd_control.vol_right;
+static void gameboy_update(void *chip, UINT32 samples, DEV_SMPL **outputs)
+{
+	gb_sound_t *gb = (gb_sound_t *)chip;
+	UINT32 i;
 
-		/* pump up the volume */
-		left <<= 6;
-		right <<= 6;
+	if (gb->BlepMode)
+	{
+		gameboy_update_blep(gb, samples, outputs);
+	}
+	else
+	{
+		for (i = 0; i < samples; i++)
+		{
+			RC_STEP(&gb->cycleCntr);
+			gb_update_state(gb, RC_GET_VAL(&gb->cycleCntr));
+			RC_MASK(&gb->cycleCntr);
 
-		/* Update the buffers */
-		outputs[0][i] = left;
-		outputs[1][i] = right;
+			gb_calc_output(gb, &outputs[0][i], &outputs[1][i]);
+		}
 	}
 
 	gb->snd_regs[NR52] = (gb->snd_regs[NR52]&0xf0) | gb->snd_1.on | (gb->snd_2.on << 1) | (gb->snd_3.on << 2) | (gb->snd_4.on << 3);
@@ -1212,6 +1266,7 @@ static UINT8 device_start_gameboy_sound(const DEV_GEN_CFG* cfg, DEV_INFO* retDev
 
 	gb->rate = cfg->clock / 64;
 	SRATE_CUSTOM_HIGHEST(cfg->srMode, gb->rate, cfg->smplRate);
+	gb->smplRate = cfg->smplRate;
 
 	gb->gbMode = (cfg->flags & 0x01) ? GBMODE_CGB04 : GBMODE_DMG;
 	RC_SET_RATIO(&gb->cycleCntr, cfg->clock, gb->rate);
@@ -1220,6 +1275,8 @@ static UINT8 device_start_gameboy_sound(const DEV_GEN_CFG* cfg, DEV_INFO* retDev
 	gb->BoostWaveChn = 0x00;
 	gb->NoWaveCorrupt = 0x00;
 	gb->LegacyMode = 0x00;
+	gb->BlepMode = 0x00;
+	gb->SmpRateFunc = NULL;
 
 	gb->_devData.chipInf = gb;
 	INIT_DEVINF(retDevInf, &gb->_devData, gb->rate, &devDef);
@@ -1302,6 +1359,9 @@ static void device_reset_gameboy_sound(void *chip)
 		break;
 	}
 
+	if (gb->BlepMode)
+		BlepBuf_Clear(&gb->blep);
+
 	return;
 }
 
@@ -1333,10 +1393,40 @@ static UINT32 gameboy_sound_get_mute_mask(void *chip)
 static void gameboy_sound_set_options(void *chip, UINT32 Flags)
 {
 	gb_sound_t *gb = (gb_sound_t *)chip;
+	UINT8 blepMode;
 	
 	gb->BoostWaveChn = (Flags & 0x01) >> 0;
 	gb->NoWaveCorrupt = (Flags & 0x02) >> 1;
 	gb->LegacyMode = (Flags & 0x80) >> 7;
 	
+	// BLEP mode is only useful when the chip runs faster than the output
+	blepMode = (Flags & OPT_GB_DMG_BLEP) && gb->smplRate > 0 && gb->rate > gb->smplRate;
+	if (blepMode != gb->BlepMode)
+	{
+		gb->BlepMode = blepMode;
+		if (gb->BlepMode)
+			BlepBuf_Init(&gb->blep, gb->rate, gb->smplRate);
+		if (gb->SmpRateFunc != NULL)
+			gb->SmpRateFunc(gb->SmpRateData, gameboy_sound_get_rate(gb));
+	}
+	
+	return;
+}
+
+static UINT32 gameboy_sound_get_rate(void *chip)
+{
+	gb_sound_t *gb = (gb_sound_t *)chip;
+	
+	return gb->BlepMode ? gb->smplRate : gb->rate;
+}
+
+static void gameboy_sound_set_srchg_cb(void *chip, DEVCB_SRATE_CHG CallbackFunc, void* DataPtr)
+{
+	gb_sound_t *gb = (gb_sound_t *)chip;
+	
+	// set Sample Rate Change Callback routine
+	gb->SmpRateFunc = CallbackFunc;
+	gb->SmpRateData = DataPtr;
+	
 	return;
 }
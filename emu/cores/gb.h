@@ -9,6 +9,8 @@
 #define OPT_GB_DMG_NO_WAVE_CORRUPT	0x02	// disable WaveRAM corruption
 											// Non-GBC models overwrite parts of the WaveRAM when triggered
 											// while reading a sample. (hardware bug, fixed in GBC)
+#define OPT_GB_DMG_BLEP	0x04				// render band-limited steps directly at the output sample rate
+											// (default: disabled)
 #define OPT_GB_DMG_LEGACY_MODE	0x80		// simulate behaviour of old MAME core
 											// required for playing older VGM files optimized with vgm_cmp
 											// (default: disabled)
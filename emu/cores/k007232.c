@@ -283,6 +283,8 @@ static void k007232_write(void* chip, UINT8 offset, UINT8 data)
 			v->step = ((pitch_msb & 0x0F) << 8) | pitch_lsb;
 			break;
 		}
+		if (v->step > 0x0FFF)
+			v->step = 0x0FFF;	// the update loop never advances with a step of 0x1000
 		break;
 	}
 	case 0x02: case 0x08: // Start address LSB
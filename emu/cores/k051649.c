@@ -292,6 +292,8 @@ static void k052539_waveform_w(void *chip, UINT8 offset, UINT8 data)
 	// waveram is read-only?
 	if (info->test & 0x40)
 		return;
+	if (offset >= 0xA0)
+		return;
 
 	info->channel_list[offset>>5].waveram[offset&0x1f]=data;
 }
@@ -314,7 +316,10 @@ static UINT8 k052539_waveform_r(void *chip, UINT8 offset)
 static void k051649_volume_w(void *chip, UINT8 offset, UINT8 data)
 {
 	k051649_state *info = (k051649_state *)chip;
-	info->channel_list[offset&0x7].volume=data&0xf;
+	offset &= 0x07;
+	if (offset >= 0x05)
+		return;	// there are only 5 channels
+	info->channel_list[offset].volume=data&0xf;
 }
 
 
@@ -322,7 +327,11 @@ static void k051649_frequency_w(void *chip, UINT8 offset, UINT8 data)
 {
 	k051649_state *info = (k051649_state *)chip;
 	UINT8 freq_hi = offset & 1;
-	k051649_sound_channel* chn = &info->channel_list[offset >> 1];
+	k051649_sound_channel* chn;
+	
+	if (offset >= 0x0A)
+		return;
+	chn = &info->channel_list[offset >> 1];
 
 	// update frequency
 	if (freq_hi)
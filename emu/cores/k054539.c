@@ -24,6 +24,7 @@
 #include "k054539.h"
 
 static void k054539_update(void *param, UINT32 samples, DEV_SMPL **outputs);
+static UINT8 k054539_is_idle(void *param);
 static UINT8 device_start_k054539(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf);
 static void device_stop_k054539(void *chip);
 static void device_reset_k054539(void *chip);
@@ -36,6 +37,7 @@ static void k054539_set_gain(void *chip, UINT8 channel, double _gain);
 
 static void k054539_alloc_rom(void* chip, UINT32 memsize);
 static void k054539_write_rom(void *chip, UINT32 offset, UINT32 length, const UINT8* data);
+static void k054539_link_rom(void *chip, UINT32 memsize, const UINT8* data);
 
 static void k054539_set_mute_mask(void *chip, UINT32 MuteMask);
 static void k054539_set_log_cb(void* chip, DEVCB_LOG func, void* param);
@@ -47,7 +49,9 @@ static DEVDEF_RWFUNC devFunc[] =
 	{RWF_REGISTER | RWF_READ, DEVRW_A16D8, 0, k054539_r},
 	{RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 0, k054539_write_rom},
 	{RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 0, k054539_alloc_rom},
+	{RWF_MEMORY | RWF_WRITE, DEVRW_MEMLINK, 0, k054539_link_rom},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, k054539_set_mute_mask},
+	{RWF_IDLE | RWF_READ, DEVRW_VALUE, 0, k054539_is_idle},
 	{0x00, 0x00, 0, NULL}
 };
 static DEV_DEF devDef =
@@ -166,6 +170,7 @@ struct _k054539_state {
 	UINT8 *rom;
 	UINT32 rom_size;
 	UINT32 rom_mask;
+	UINT8 rom_linked;	// rom points to external read-only data
 
 	k054539_channel channels[8];
 	UINT8 Muted[8];
@@ -209,6 +214,15 @@ static void k054539_keyoff(k054539_state *info, int channel)
 		info->regs[0x22c] &= ~(1 << channel);
 }
 
+static UINT8 k054539_is_idle(void *param)
+{
+	k054539_state *info = (k054539_state *)param;
+
+	// Note: Without active channels, the reverb buffer is still being played back,
+	//       so this only checks whether or not the chip is enabled.
+	return (info->rom == NULL || !(info->regs[0x22f] & 1));
+}
+
 static void k054539_update(void *param, UINT32 samples, DEV_SMPL **outputs)
 {
 	k054539_state *info = (k054539_state *)param;
@@ -221,6 +235,7 @@ static void k054539_update(void *param, UINT32 samples, DEV_SMPL **outputs)
 
 	INT16 *rbase = (INT16 *)info->ram;
 	UINT32 sample, ch;
+	UINT8 act_mask, cmask;
 
 	if(info->rom == NULL || !(info->regs[0x22f] & 1))
 	{
@@ -229,6 +244,14 @@ static void k054539_update(void *param, UINT32 samples, DEV_SMPL **outputs)
 		return;
 	}
 
+	// Channels can only be keyed on by register writes, so the set of active channels
+	// can only shrink during an update.
+	act_mask = 0;
+	for(ch=0; ch<8; ch++)
+		if(! info->Muted[ch])
+			act_mask |= (1<<ch);
+	act_mask &= info->regs[0x22c];
+
 	for(sample = 0; sample != samples; sample++) {
 		float lval, rval;
 		if(!(info->flags & K054539_DISABLE_REVERB))
@@ -237,8 +260,8 @@ static void k054539_update(void *param, UINT32 samples, DEV_SMPL **outputs)
 			lval = rval = 0;
 		rbase[info->reverb_pos] = 0;
 
-		for(ch=0; ch<8; ch++)
-			if(info->regs[0x22c] & (1<<ch) && ! info->Muted[ch]) {
+		for(ch=0, cmask=act_mask; cmask; ch++, cmask>>=1)
+			if((cmask & 1) && (info->regs[0x22c] & (1<<ch))) {
 				UINT8 *base1 = info->regs + 0x20*ch;
 				UINT8 *base2 = info->regs + 0x200 + 0x2*ch;
 				k054539_channel *chan = info->channels + ch;
@@ -413,6 +436,7 @@ static void k054539_update(void *param, UINT32 samples, DEV_SMPL **outputs)
 					base1[0x0e] = cur_pos>>16 & 0xff;
 				}
 			}
+		act_mask &= info->regs[0x22c];
 		info->reverb_pos = (info->reverb_pos + 1) & 0x1fff;
 		outputs[0][sample] = (DEV_SMPL)(lval);
 		outputs[1][sample] = (DEV_SMPL)(rval);
@@ -433,6 +457,9 @@ static void k054539_w(void *chip, UINT16 offset, UINT8 data)
 	UINT8 latch;
 	int ch;
 
+	if (offset >= 0x230)
+		return;	// unmapped
+
 	if(0) {
 		int voice, reg;
 
@@ -660,7 +687,9 @@ static void device_stop_k054539(void *chip)
 {
 	k054539_state *info = (k054539_state *)chip;
 	
-	free(info->rom);	info->rom = NULL;
+	if (! info->rom_linked)
+		free(info->rom);
+	info->rom = NULL;
 	free(info->ram);	info->ram = NULL;
 	free(info);
 	
@@ -688,6 +717,11 @@ static void k054539_alloc_rom(void* chip, UINT32 memsize)
 	if (info->rom_size == memsize)
 		return;
 	
+	if (info->rom_linked)
+	{
+		info->rom = NULL;
+		info->rom_linked = 0;
+	}
 	info->rom = (UINT8*)realloc(info->rom, memsize);
 	info->rom_size = memsize;
 	memset(info->rom, 0xFF, memsize);
@@ -706,11 +740,35 @@ static void k054539_write_rom(void *chip, UINT32 offset, UINT32 length, const UI
 	if (offset + length > info->rom_size)
 		length = info->rom_size - offset;
 	
+	if (info->rom_linked)
+	{
+		// copy-on-write
+		UINT8* newROM = (UINT8*)malloc(info->rom_size);
+		memcpy(newROM, info->rom, info->rom_size);
+		info->rom = newROM;
+		info->rom_linked = 0;
+		reset_zones(info);
+	}
 	memcpy(info->rom + offset, data, length);
 	
 	return;
 }
 
+static void k054539_link_rom(void *chip, UINT32 memsize, const UINT8* data)
+{
+	k054539_state *info = (k054539_state *)chip;
+	
+	if (! info->rom_linked)
+		free(info->rom);
+	info->rom = (UINT8*)data;
+	info->rom_size = (data != NULL) ? memsize : 0x00;
+	info->rom_mask = pow2_mask(info->rom_size);
+	info->rom_linked = (data != NULL);
+	reset_zones(info);	// Note: register 0x22D writes only to RAM, so the ROM data stays read-only.
+	
+	return;
+}
+
 
 static void k054539_set_mute_mask(void *chip, UINT32 MuteMask)
 {
@@ -66,6 +66,7 @@
 #include "../../stdtype.h"
 #include "../snddef.h"
 #include "../EmuHelper.h"
+#include "../EmuOnce.h"
 #include "../EmuCores.h"
 #include "../logging.h"
 #include "../SoundDevs.h"
@@ -116,7 +117,7 @@ typedef struct _msm5205_state {
 // ========== Global Tables ==========
 static const int index_shift[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
 static int diff_lookup[49*16];
-static UINT8 tables_computed = 0;
+static EMU_ONCE tables_computed = EMU_ONCE_INIT;
 
 // ========== Device Definition ==========
 static DEVDEF_RWFUNC devFunc[] = {
@@ -180,8 +181,6 @@ static void compute_tables(void) {
         {-1,1,0,0}, {-1,1,0,1}, {-1,1,1,0}, {-1,1,1,1}
     };
 
-    if (tables_computed) return;
-
     for (int step = 0; step <= 48; step++) {
         int stepval = (int)floor(16.0 * pow(11.0 / 10.0, (double)step));
         for (int nib = 0; nib < 16; nib++) {
@@ -192,7 +191,6 @@ static void compute_tables(void) {
                  stepval/8);
         }
     }
-    tables_computed = 1;
 }
 
 INLINE UINT32 get_prescaler(msm5205_state *info) {
@@ -235,7 +233,7 @@ static INT16 clock_adpcm(msm5205_state *chip, UINT8 data) {
 static UINT8 device_start_msm5205(const DEV_GEN_CFG *cfg, DEV_INFO *retDevInf) {
     msm5205_state *info;
 
-    compute_tables();
+    EmuOnce_Run(&tables_computed, compute_tables);
     
     info = (msm5205_state*)calloc(1, sizeof(msm5205_state));
     if (!info) return 0xFF;
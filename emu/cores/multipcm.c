@@ -46,9 +46,11 @@
 #include "../EmuCores.h"
 #include "../snddef.h"
 #include "../EmuHelper.h"
+#include "../EmuOnce.h"
 #include "multipcm.h"
 
 static void MultiPCM_update(void *info, UINT32 samples, DEV_SMPL **outputs);
+static UINT8 MultiPCM_is_idle(void *info);
 static UINT8 device_start_multipcm(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf);
 static void device_stop_multipcm(void *info);
 static void device_reset_multipcm(void *info);
@@ -59,6 +61,7 @@ static UINT8 multipcm_r(void *info, UINT8 offset);
 
 static void multipcm_alloc_rom(void* info, UINT32 memsize);
 static void multipcm_write_rom(void *info, UINT32 offset, UINT32 length, const UINT8* data);
+static void multipcm_link_rom(void *info, UINT32 memsize, const UINT8* data);
 
 static void multipcm_set_mute_mask(void *info, UINT32 MuteMask);
 
@@ -70,7 +73,9 @@ static DEVDEF_RWFUNC devFunc[] =
 	{RWF_REGISTER | RWF_READ, DEVRW_A8D8, 0, multipcm_r},
 	{RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 0, multipcm_write_rom},
 	{RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 0, multipcm_alloc_rom},
+	{RWF_MEMORY | RWF_WRITE, DEVRW_MEMLINK, 0, multipcm_link_rom},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, multipcm_set_mute_mask},
+	{RWF_IDLE | RWF_READ, DEVRW_VALUE, 0, MultiPCM_is_idle},
 	{0x00, 0x00, 0, NULL}
 };
 static DEV_DEF devDef =
@@ -225,10 +230,11 @@ struct _MultiPCM
 	UINT32 ROMMask;
 	UINT32 ROMSize;
 	UINT8 *ROM;
+	UINT8 ROMLinked;	// ROM points to external read-only data
 };
 
 
-static UINT8 IsInit = 0;
+static EMU_ONCE tablesInit = EMU_ONCE_INIT;
 
 static INT32 left_pan_table[0x800];
 static INT32 right_pan_table[0x800];
@@ -577,25 +583,10 @@ INLINE void lfo_compute_step(MultiPCM *ptChip, lfo_t *lfo, UINT8 lfo_frequency,
 	}
 }
 
-static UINT8 device_start_multipcm(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
+static void init_tables(void)
 {
-	MultiPCM *ptChip;
-	INT32 i;
-
-	ptChip = (MultiPCM *)calloc(1, sizeof(MultiPCM));
-	if (ptChip == NULL)
-		return 0xFF;
-	
-	ptChip->ROM = NULL;
-	ptChip->ROMSize = 0x00;
-	ptChip->ROMMask = 0x00;
-	ptChip->rate = (float)cfg->clock / MULTIPCM_CLOCKDIV;
-
-	if (! IsInit)
-	{
 	INT32 level;
-
-	IsInit = 1;
+	INT32 i;
 
 	// Volume + pan table
 	for (level = 0; level < 0x80; ++level)
@@ -657,7 +648,23 @@ static UINT8 device_start_multipcm(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 	}
 
 	lfo_init();
-	}
+}
+
+static UINT8 device_start_multipcm(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
+{
+	MultiPCM *ptChip;
+	INT32 i;
+
+	ptChip = (MultiPCM *)calloc(1, sizeof(MultiPCM));
+	if (ptChip == NULL)
+		return 0xFF;
+	
+	ptChip->ROM = NULL;
+	ptChip->ROMSize = 0x00;
+	ptChip->ROMMask = 0x00;
+	ptChip->rate = (float)cfg->clock / MULTIPCM_CLOCKDIV;
+
+	EmuOnce_Run(&tablesInit, init_tables);
 
 	// Pitch steps
 	for (i = 0; i < 0x400; ++i)
@@ -686,7 +693,8 @@ static void device_stop_multipcm(void *info)
 {
 	MultiPCM *ptChip = (MultiPCM *)info;
 	
-	free(ptChip->ROM);
+	if (! ptChip->ROMLinked)
+		free(ptChip->ROM);
 	free(ptChip);
 	
 	return;
@@ -807,12 +815,36 @@ INLINE UINT8 read_byte(MultiPCM *ptChip, UINT32 addr)
 	return ptChip->ROM[addr & ptChip->ROMMask];
 }
 
+// returns a bitmask of all slots that are playing and not muted
+static UINT32 get_active_mask(MultiPCM *ptChip)
+{
+	UINT32 mask = 0;
+	UINT32 sl;
+
+	for (sl = 0; sl < 28; ++sl)
+	{
+		if (ptChip->slots[sl].playing && ! ptChip->slots[sl].muted)
+			mask |= (1U << sl);
+	}
+	return mask;
+}
+
+static UINT8 MultiPCM_is_idle(void *info)
+{
+	MultiPCM *ptChip = (MultiPCM *)info;
+
+	// muted slots are not updated at all, so they don't count as active
+	return (ptChip->ROM == NULL || ! get_active_mask(ptChip));
+}
+
 static void MultiPCM_update(void *info, UINT32 samples, DEV_SMPL **outputs)
 {
 	MultiPCM *ptChip = (MultiPCM *)info;
 	UINT32 i, sl;
+	UINT32 act_mask, smask;
 
-	if (ptChip->ROM == NULL)
+	act_mask = (ptChip->ROM != NULL) ? get_active_mask(ptChip) : 0;
+	if (! act_mask)
 	{
 		memset(outputs[0], 0, samples * sizeof(DEV_SMPL));
 		memset(outputs[1], 0, samples * sizeof(DEV_SMPL));
@@ -823,10 +855,11 @@ static void MultiPCM_update(void *info, UINT32 samples, DEV_SMPL **outputs)
 	{
 		DEV_SMPL smpl = 0;
 		DEV_SMPL smpr = 0;
-		for (sl = 0; sl < 28; ++sl)
+		// slots can only be keyed on by register writes, so only the active ones are processed
+		for (sl = 0, smask = act_mask; smask; ++sl, smask >>= 1)
 		{
 			slot_t *slot = &ptChip->slots[sl];
-			if (slot->playing && ! slot->muted)
+			if (smask & 1)
 			{
 				UINT32 vol = (slot->total_level >> TL_SHIFT) | (slot->pan << 7);
 				UINT32 spos = slot->offset >> TL_SHIFT;
@@ -897,6 +930,9 @@ static void MultiPCM_update(void *info, UINT32 samples, DEV_SMPL **outputs)
 
 				smpl += (left_pan_table[vol] * sample) >> TL_SHIFT;
 				smpr += (right_pan_table[vol] * sample) >> TL_SHIFT;
+
+				if (! slot->playing)
+					act_mask &= ~(1U << sl);
 			}
 		}
 
@@ -966,6 +1002,11 @@ static void multipcm_alloc_rom(void* info, UINT32 memsize)
 	if (ptChip->ROMSize == memsize)
 		return;
 	
+	if (ptChip->ROMLinked)
+	{
+		ptChip->ROM = NULL;
+		ptChip->ROMLinked = 0;
+	}
 	ptChip->ROM = (UINT8*)realloc(ptChip->ROM, memsize);
 	ptChip->ROMSize = memsize;
 	memset(ptChip->ROM, 0xFF, memsize);
@@ -984,11 +1025,33 @@ static void multipcm_write_rom(void *info, UINT32 offset, UINT32 length, const U
 	if (offset + length > ptChip->ROMSize)
 		length = ptChip->ROMSize - offset;
 	
+	if (ptChip->ROMLinked)
+	{
+		// copy-on-write
+		UINT8* newROM = (UINT8*)malloc(ptChip->ROMSize);
+		memcpy(newROM, ptChip->ROM, ptChip->ROMSize);
+		ptChip->ROM = newROM;
+		ptChip->ROMLinked = 0;
+	}
 	memcpy(ptChip->ROM + offset, data, length);
 	
 	return;
 }
 
+static void multipcm_link_rom(void *info, UINT32 memsize, const UINT8* data)
+{
+	MultiPCM *ptChip = (MultiPCM *)info;
+	
+	if (! ptChip->ROMLinked)
+		free(ptChip->ROM);
+	ptChip->ROM = (UINT8*)data;
+	ptChip->ROMSize = (data != NULL) ? memsize : 0x00;
+	ptChip->ROMMask = pow2_mask(ptChip->ROMSize);
+	ptChip->ROMLinked = (data != NULL);
+	
+	return;
+}
+
 
 static void multipcm_set_mute_mask(void *info, UINT32 MuteMask)
 {
@@ -47,6 +47,8 @@
 #include "../../common_def.h"
 #include "../snddef.h"
 #include "../panning.h"
+#include "../EmuOnce.h"
+#include "../blepbuf.h"
 #include "nes_apu.h"
 
 /* AN EXPLANATION
@@ -81,11 +83,13 @@ struct _nesapu_state
 	uint32  vbl_times[SYNCS_MAX1]; /* VBL durations in samples */
 	uint32  sync_times1[SYNCS_MAX1]; /* Samples per sync table */
 	uint32  sync_times2[SYNCS_MAX2]; /* Samples per sync table */
+	uint8   blep_mode;             /* output band-limited steps instead of one sample per APU step */
+	BLEP_BUF blep;
 };
 
 static DEV_SMPL square_lut[31];       // Non-linear Square wave output LUT
 static DEV_SMPL tnd_lut[16][16][128]; // Non-linear Triangle, Noise, DMC output LUT
-static UINT8 tablesInit = 0;
+static EMU_ONCE tablesInit = EMU_ONCE_INIT;
 
 static UINT8 DPCMBase0 = 0x01;
 
@@ -115,10 +119,6 @@ static void create_mixer_lut(void)
 {
 	int i, t;
 
-	if (tablesInit)
-		return;
-	tablesInit = 0;
-
 	// calculate mixer output
 	/*
 	pulse channel output:
@@ -725,56 +725,105 @@ logerror("invalid apu write: $%02X at $%04X\n", value, offset);
 	}
 }
 
+INLINE void nes_apu_clock(nesapu_state *info)
+{
+	apu_t *apu = &info->APU;
+
+	apu_square(info, &apu->squ[0]);
+	apu_square(info, &apu->squ[1]);
+	apu_triangle(info, &apu->tri);
+	apu_noise(info, &apu->noi);
+	apu_dpcm(info, &apu->dpcm);
+}
+
+INLINE void nes_apu_calc_output(nesapu_state *info, DEV_SMPL *outL, DEV_SMPL *outR)
+{
+	apu_t *apu = &info->APU;
+	INT16 squ1, squ2, tri, noi, dpcm;
+	DEV_SMPL left, right;
+
+	if (info->nonlinear_mixing)
+	{
+		squ1 = (apu->squ[0].output >= 0) ? apu->squ[0].output : 0;
+		squ2 = (apu->squ[1].output >= 0) ? apu->squ[1].output : 0;
+		tri  = (apu->tri.output + 0x10) / 2;
+		noi  = (apu->noi.output >= 0) ? apu->noi.output : 0;
+		dpcm = apu->dpcm.output;
+		left = square_lut[squ1 + squ2];
+		left += tnd_lut[tri][noi][dpcm];
+		right = left;
+	}
+	else
+	{
+		// These volumes should match NSFPlay's NES core better
+		squ1 = apu->squ[0].output * 0x100;	// [-15..+15] << 8 * 1.0
+		squ2 = apu->squ[1].output * 0x100;	// [-15..+15] << 8 * 1.0
+		tri  = apu->tri.output * 0xC0;	// [-16..+16] << 8 * 0.75
+		noi  = apu->noi.output * 0xC0;	// [-15..+15] << 8 * 0.75
+		dpcm = apu->dpcm.output * 0xC0;	// [0..+127] << 8 * 0.75
+
+		left  = APPLY_PANNING_S(squ1, apu->squ[0].Pan[0]);
+		right  = APPLY_PANNING_S(squ1, apu->squ[0].Pan[1]);
+		left += APPLY_PANNING_S(squ2, apu->squ[1].Pan[0]);
+		right += APPLY_PANNING_S(squ2, apu->squ[1].Pan[1]);
+		left += APPLY_PANNING_S(tri, apu->tri.Pan[0]);
+		right += APPLY_PANNING_S(tri, apu->tri.Pan[1]);
+		left += APPLY_PANNING_S(noi, apu->noi.Pan[0]);
+		right += APPLY_PANNING_S(noi, apu->noi.Pan[1]);
+		left += APPLY_PANNING_L(dpcm, apu->dpcm.Pan[0]);	// could be 0..24384, thus use _L macro
+		right += APPLY_PANNING_L(dpcm, apu->dpcm.Pan[1]);
+	}
+
+	*outL = left;
+	*outR = right;
+}
+
+static void nes_apu_update_blep(nesapu_state *info, UINT32 samples, DEV_SMPL **outputs)
+{
+	DEV_SMPL* outBufs[2];
+	DEV_SMPL left, right;
+	UINT32 smplCnt;
+	UINT32 clocks;
+	UINT32 clk;
+
+	outBufs[0] = outputs[0];
+	outBufs[1] = outputs[1];
+	while (samples > 0)
+	{
+		smplCnt = (samples < BLEP_MAX_SMPLS) ? samples : BLEP_MAX_SMPLS;
+		clocks = BlepBuf_ClocksNeeded(&info->blep, smplCnt);
+		for (clk = 0; clk < clocks; clk++)
+		{
+			nes_apu_clock(info);
+			nes_apu_calc_output(info, &left, &right);
+			BlepBuf_SetAmp(&info->blep, clk, left, right);
+		}
+		BlepBuf_EndFrame(&info->blep, clocks);
+		BlepBuf_ReadSamples(&info->blep, smplCnt, outBufs);
+		outBufs[0] += smplCnt;
+		outBufs[1] += smplCnt;
+		samples -= smplCnt;
+	}
+}
+
 /* UPDATE SOUND BUFFER USING CURRENT DATA */
 void nes_apu_update(void* chip, UINT32 samples, DEV_SMPL **outputs)
 {
 	nesapu_state *info = (nesapu_state*)chip;
-	apu_t *apu = &info->APU;
 	DEV_SMPL* bufL = outputs[0];
 	DEV_SMPL* bufR = outputs[1];
 	UINT32 i;
 
-	for (i = 0; i < samples; i++)
+	if (info->blep_mode)
 	{
-		INT16 squ1, squ2, tri, noi, dpcm;
-
-		apu_square(info, &apu->squ[0]);
-		apu_square(info, &apu->squ[1]);
-		apu_triangle(info, &apu->tri);
-		apu_noise(info, &apu->noi);
-		apu_dpcm(info, &apu->dpcm);
+		nes_apu_update_blep(info, samples, outputs);
+		return;
+	}
 
-		if (info->nonlinear_mixing)
-		{
-			squ1 = (apu->squ[0].output >= 0) ? apu->squ[0].output : 0;
-			squ2 = (apu->squ[1].output >= 0) ? apu->squ[1].output : 0;
-			tri  = (apu->tri.output + 0x10) / 2;
-			noi  = (apu->noi.output >= 0) ? apu->noi.output : 0;
-			dpcm = apu->dpcm.output;
-			bufL[i] = square_lut[squ1 + squ2];
-			bufL[i] += tnd_lut[tri][noi][dpcm];
-			bufR[i] = bufL[i];
-		}
-		else
-		{
-			// These volumes should match NSFPlay's NES core better
-			squ1 = apu->squ[0].output * 0x100;	// [-15..+15] << 8 * 1.0
-			squ2 = apu->squ[1].output * 0x100;	// [-15..+15] << 8 * 1.0
-			tri  = apu->tri.output * 0xC0;	// [-16..+16] << 8 * 0.75
-			noi  = apu->noi.output * 0xC0;	// [-15..+15] << 8 * 0.75
-			dpcm = apu->dpcm.output * 0xC0;	// [0..+127] << 8 * 0.75
-
-			bufL[i]  = APPLY_PANNING_S(squ1, apu->squ[0].Pan[0]);
-			bufR[i]  = APPLY_PANNING_S(squ1, apu->squ[0].Pan[1]);
-			bufL[i] += APPLY_PANNING_S(squ2, apu->squ[1].Pan[0]);
-			bufR[i] += APPLY_PANNING_S(squ2, apu->squ[1].Pan[1]);
-			bufL[i] += APPLY_PANNING_S(tri, apu->tri.Pan[0]);
-			bufR[i] += APPLY_PANNING_S(tri, apu->tri.Pan[1]);
-			bufL[i] += APPLY_PANNING_S(noi, apu->noi.Pan[0]);
-			bufR[i] += APPLY_PANNING_S(noi, apu->noi.Pan[1]);
-			bufL[i] += APPLY_PANNING_L(dpcm, apu->dpcm.Pan[0]);	// could be 0..24384, thus use _L macro
-			bufR[i] += APPLY_PANNING_L(dpcm, apu->dpcm.Pan[1]);
-		}
+	for (i = 0; i < samples; i++)
+	{
+		nes_apu_clock(info);
+		nes_apu_calc_output(info, &bufL[i], &bufR[i]);
 	}
 }
 
@@ -843,7 +892,7 @@ void* device_start_nesapu(UINT32 clock, UINT32 rate)
 	calculate_rates(info, clock, rate);
 
 	/* Use initializer calls */
-	create_mixer_lut();
+	EmuOnce_Run(&tablesInit, create_mixer_lut);
 
 	info->APU.dpcm.memory = NULL;
 
@@ -901,6 +950,9 @@ void device_reset_nesapu(void* chip)
 	nes_apu_write(info, 0x15, 0x00);
 	nes_apu_write(info, 0x15, 0x0F);
 	
+	if (info->blep_mode)
+		BlepBuf_Clear(&info->blep);
+	
 	return;
 }
 
@@ -947,6 +999,19 @@ void nesapu_set_options(void *chip, UINT32 Flags)
 	info->old_rp2a03 = (Flags >> 15) & 0x01;
 }
 
+void nesapu_set_blep(void* chip, UINT32 stepRate, UINT32 smplRate)
+{
+	nesapu_state *info = (nesapu_state*)chip;
+	
+	// The APU keeps being stepped at stepRate (the rate it was started with).
+	// Its output is converted to smplRate. (0 = BLEP off)
+	info->blep_mode = (smplRate > 0);
+	if (info->blep_mode)
+		BlepBuf_Init(&info->blep, stepRate, smplRate);
+	
+	return;
+}
+
 void nesapu_set_panning(void* chip, INT16 square1, INT16 square2, INT16 triangle, INT16 noise, INT16 dpcm)
 {
 	nesapu_state *info = (nesapu_state*)chip;
@@ -47,6 +47,8 @@ static UINT8 nes_read_fds(void* chip_fds, UINT8 offset);
 static void nes_write_ram(void* chip, UINT32 offset, UINT32 length, const UINT8* data);
 
 static void nes_set_chip_option_mame(void* chip, UINT32 NesOptions);
+static UINT32 nes_get_rate_mame(void* chip);
+static void nes_set_srchg_cb_mame(void* chip, DEVCB_SRATE_CHG CallbackFunc, void* DataPtr);
 static void nes_set_chip_option_nsfplay(void* chip, UINT32 NesOptions);
 static void nes_set_chip_option_fds(NESAPU_INF* info, UINT32 NesOptions);
 static void nes_set_mute_mask_mame(void* chip, UINT32 MuteMask);
@@ -61,6 +63,7 @@ static DEVDEF_RWFUNC devFunc_MAME[] =
 	{RWF_REGISTER | RWF_WRITE, DEVRW_A8D8, 0, nes_w_mame},
 	{RWF_REGISTER | RWF_READ, DEVRW_A8D8, 0, nes_r_mame},
 	{RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 0, nes_write_ram},
+	{RWF_SRATE | RWF_READ, DEVRW_VALUE, 0, nes_get_rate_mame},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, nes_set_mute_mask_mame},
 	{RWF_CHN_PAN | RWF_WRITE, DEVRW_ALL, 0, nes_set_pan_mame},
 	{0x00, 0x00, 0, NULL}
@@ -77,7 +80,7 @@ static DEV_DEF devDef_MAME =
 	nes_set_chip_option_mame,	// SetOptionBits
 	nes_set_mute_mask_mame,
 	nes_set_pan_mame,
-	NULL,	// SetSampleRateChangeCallback
+	nes_set_srchg_cb_mame,	// SetSampleRateChangeCallback
 	NULL,	// SetLoggingCallback
 	NULL,	// LinkDevice
 	
@@ -172,6 +175,12 @@ struct nesapu_info
 	void* chip_fds;
 	UINT8* memory;
 	UINT8 fds_disable;
+	
+	UINT32 rate;		// native sample rate
+	UINT32 smplRate;	// output sample rate requested by the host
+	UINT8 blepMode;
+	DEVCB_SRATE_CHG SmpRateFunc;
+	void* SmpRateData;
 };
 
 // bit shift for transforming the "usual" panning values (factor 1<<16) into
@@ -270,6 +279,10 @@ static UINT8 device_start_nes_mame(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 	nesapu_set_rom(info->chip_apu, info->memory - 0x8000);
 	
 	info->fds_disable = 0;
+	info->rate = rate;
+	info->smplRate = cfg->smplRate;
+	info->blepMode = 0;
+	info->SmpRateFunc = NULL;
 	
 	// store pointer to NESAPU_INF into sound chip structures
 	info->_devData.chipInf = info;
@@ -552,6 +565,7 @@ static void nes_write_ram(void* chip, UINT32 offset, UINT32 length, const UINT8*
 static void nes_set_chip_option_mame(void* chip, UINT32 NesOptions)
 {
 	NESAPU_INF* info = (NESAPU_INF*)chip;
+	UINT8 blepMode;
 	
 	nesapu_set_options(info->chip_apu, NesOptions);
 	
@@ -560,6 +574,39 @@ static void nes_set_chip_option_mame(void* chip, UINT32 NesOptions)
 		nes_set_chip_option_fds(info, NesOptions);
 #endif
 	
+	// BLEP mode is only useful when the APU runs faster than the output
+	blepMode = (NesOptions & OPT_NES_BLEP) && info->smplRate > 0 && info->rate > info->smplRate;
+	if (blepMode != info->blepMode)
+	{
+		info->blepMode = blepMode;
+		nesapu_set_blep(info->chip_apu, info->rate, info->blepMode ? info->smplRate : 0);
+#ifdef EC_NES_NSFP_FDS
+		// the FDS is mixed into the APU output, so it has to follow the rate
+		if (info->chip_fds != NULL)
+			NES_FDS_SetRate(info->chip_fds, nes_get_rate_mame(info));
+#endif
+		if (info->SmpRateFunc != NULL)
+			info->SmpRateFunc(info->SmpRateData, nes_get_rate_mame(info));
+	}
+	
+	return;
+}
+
+static UINT32 nes_get_rate_mame(void* chip)
+{
+	NESAPU_INF* info = (NESAPU_INF*)chip;
+	
+	return info->blepMode ? info->smplRate : info->rate;
+}
+
+static void nes_set_srchg_cb_mame(void* chip, DEVCB_SRATE_CHG CallbackFunc, void* DataPtr)
+{
+	NESAPU_INF* info = (NESAPU_INF*)chip;
+	
+	// set Sample Rate Change Callback routine
+	info->SmpRateFunc = CallbackFunc;
+	info->SmpRateData = DataPtr;
+	
 	return;
 }
 #endif
@@ -38,6 +38,9 @@
 // [NSFPlay FDS core] options
 #define OPT_NES_4085_RESET			0x0400	// OPT_4085_RESET (default: disabled)
 #define OPT_NES_FDS_DISABLE			0x0800	// OPT_WRITE_PROTECT (default: disabled)
+// [MAME core] output options
+#define OPT_NES_BLEP				0x1000	// render band-limited steps directly at the output sample rate
+											// (default: disabled)
 
 // default option bitmask: 0x01B7
 //	OPT_NES_UNMUTE_ON_RESET | OPT_NES_NONLINEAR_MIXER | OPT_NES_PHASE_REFRESH |
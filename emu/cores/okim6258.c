@@ -20,6 +20,7 @@
 #include "../EmuStructs.h"
 #include "../SoundDevs.h"
 #include "../EmuHelper.h"
+#include "../EmuOnce.h"
 #include "../EmuCores.h"
 #include "../logging.h"
 #include "okim6258.h"
@@ -163,7 +164,7 @@ static const int index_shift[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
 static int diff_lookup[49*16];
 
 /* tables computed? */
-static int tables_computed = 0;
+static EMU_ONCE tables_computed = EMU_ONCE_INIT;
 
 
 INLINE UINT32 ReadLE32(const UINT8* buffer)
@@ -200,9 +201,6 @@ static void compute_tables(void)
 
 	int step, nib;
 
-	if (tables_computed)
-		return;
-	
 	/* loop over all possible steps */
 	for (step = 0; step <= 48; step++)
 	{
@@ -219,8 +217,6 @@ static void compute_tables(void)
 				 stepval/8);
 		}
 	}
-
-	tables_computed = 1;
 }
 
 
@@ -363,7 +359,7 @@ static UINT8 device_start_okim6258(const OKIM6258_CFG* cfg, DEV_INFO* retDevInf)
 	if (! info->adpcm_type)
 		info->adpcm_type = 4;
 
-	compute_tables();
+	EmuOnce_Run(&tables_computed, compute_tables);
 
 	info->master_clock = info->initial_clock;
 	WriteLE32(info->clock_buffer, info->master_clock);
@@ -72,6 +72,7 @@ static void okim6295_set_clock(void *chip, UINT32 clock);
 INLINE void okim6295_set_pin7(okim6295_state *info, UINT8 pin7);
 
 static void okim6295_update(void* info, UINT32 samples, DEV_SMPL** outputs);
+static void okim6295_advance(void* info, UINT32 samples);
 static UINT8 device_start_okim6295(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf);
 static void device_stop_okim6295(void* chipptr);
 static void device_reset_okim6295(void *chip);
@@ -84,6 +85,8 @@ static void okim6295_write_rom(void* info, UINT32 offset, UINT32 length, const U
 static void okim6295_set_mute_mask(void *info, UINT32 MuteMask);
 static void okim6295_set_srchg_cb(void* chip, DEVCB_SRATE_CHG CallbackFunc, void* DataPtr);
 static void okim6295_set_log_cb(void* chip, DEVCB_LOG func, void* param);
+static UINT32 okim6295_save_state(void* info, UINT32 bufSize, void* buffer);
+static UINT8 okim6295_load_state(void* info, UINT32 bufSize, const void* buffer);
 
 
 static DEVDEF_RWFUNC devFunc[] =
@@ -95,6 +98,9 @@ static DEVDEF_RWFUNC devFunc[] =
 	{RWF_CLOCK | RWF_WRITE, DEVRW_VALUE, 0, okim6295_set_clock},
 	{RWF_SRATE | RWF_READ, DEVRW_VALUE, 0, okim6295_get_rate},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, okim6295_set_mute_mask},
+	{RWF_ADVANCE | RWF_WRITE, DEVRW_VALUE, 0, okim6295_advance},
+	{RWF_STATE | RWF_READ, DEVRW_BLOCK, 0, okim6295_save_state},
+	{RWF_STATE | RWF_WRITE, DEVRW_BLOCK, 0, okim6295_load_state},
 	{0x00, 0x00, 0, NULL}
 };
 static DEV_DEF devDef =
@@ -289,7 +295,10 @@ static void generate_adpcm(okim6295_state *chip, okim_voice *voice, DEV_SMPL *bu
 
 		// output to the buffer, scaling by the volume
 		// signal in range -2048..2047, volume in range 2..32 => signal * volume / 2 in range -32768..32767
-		buffer[i] += oki_adpcm_clock(&voice->adpcm, nibble) * voice->volume / 2;
+		if (buffer != NULL)
+			buffer[i] += oki_adpcm_clock(&voice->adpcm, nibble) * voice->volume / 2;
+		else
+			oki_adpcm_clock(&voice->adpcm, nibble);	// advancing: only the decoder state matters
 
 		// next!
 		if (++voice->sample >= voice->count)
@@ -326,6 +335,18 @@ static void okim6295_update(void* info, UINT32 samples, DEV_SMPL** outputs)
 	memcpy(outputs[1], outputs[0], samples * sizeof(*outputs[0]));
 }
 
+static void okim6295_advance(void* info, UINT32 samples)
+{
+	okim6295_state *chip = (okim6295_state *)info;
+	int i;
+
+	if (chip->ROM == NULL)
+		return;
+
+	for (i = 0; i < OKIM6295_VOICES; i++)
+		generate_adpcm(chip, &chip->voice[i], NULL, samples);
+}
+
 
 
 /**********************************************************************************************
@@ -668,3 +689,36 @@ static void okim6295_set_log_cb(void* chip, DEVCB_LOG func, void* param)
 	dev_logger_set(&info->logger, info, func, param);
 	return;
 }
+
+static UINT32 okim6295_save_state(void* info, UINT32 bufSize, void* buffer)
+{
+	if (buffer == NULL || bufSize < sizeof(okim6295_state))
+		return sizeof(okim6295_state);
+	memcpy(buffer, info, sizeof(okim6295_state));
+	return sizeof(okim6295_state);
+}
+
+static UINT8 okim6295_load_state(void* info, UINT32 bufSize, const void* buffer)
+{
+	okim6295_state *chip = (okim6295_state *)info;
+	okim6295_state oldState;
+	UINT8 CurChn;
+	
+	if (bufSize != sizeof(okim6295_state))
+		return 0xFF;
+	
+	// The ROM is not part of the state, it may have been reallocated since the state was saved.
+	oldState = *chip;
+	memcpy(chip, buffer, sizeof(okim6295_state));
+	chip->logger = oldState.logger;
+	chip->ROMSize = oldState.ROMSize;
+	chip->ROM = oldState.ROM;
+	chip->SmpRateFunc = oldState.SmpRateFunc;
+	chip->SmpRateData = oldState.SmpRateData;
+	for (CurChn = 0; CurChn < OKIM6295_VOICES; CurChn ++)
+		chip->voice[CurChn].Muted = oldState.voice[CurChn].Muted;
+	
+	if (okim6295_get_rate(chip) != okim6295_get_rate(&oldState) && chip->SmpRateFunc != NULL)
+		chip->SmpRateFunc(chip->SmpRateData, okim6295_get_rate(chip));
+	return 0x00;
+}
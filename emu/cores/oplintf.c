@@ -40,6 +40,7 @@ static DEVDEF_RWFUNC devFunc3812_MAME[] =
 	{RWF_REGISTER | RWF_WRITE, DEVRW_A8D8, 0, ym3812_write},
 	{RWF_REGISTER | RWF_READ, DEVRW_A8D8, 0, ym3812_read},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, opl_set_mute_mask},
+	{RWF_ADVANCE | RWF_WRITE, DEVRW_VALUE, 0, ym3812_advance},
 	{0x00, 0x00, 0, NULL}
 };
 static DEV_DEF devDef3812_MAME =
@@ -168,6 +169,7 @@ static DEVDEF_RWFUNC devFunc3526_MAME[] =
 	{RWF_REGISTER | RWF_WRITE, DEVRW_A8D8, 0, ym3526_write},
 	{RWF_REGISTER | RWF_READ, DEVRW_A8D8, 0, ym3526_read},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, opl_set_mute_mask},
+	{RWF_ADVANCE | RWF_WRITE, DEVRW_VALUE, 0, ym3526_advance},
 	{0x00, 0x00, 0, NULL}
 };
 static DEV_DEF devDef3526_MAME =
@@ -216,6 +218,7 @@ static DEVDEF_RWFUNC devFunc8950_MAME[] =
 	{RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 0, y8950_write_pcmrom},
 	{RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 0, y8950_alloc_pcmrom},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, opl_set_mute_mask},
+	{RWF_ADVANCE | RWF_WRITE, DEVRW_VALUE, 0, y8950_advance},
 	{0x00, 0x00, 0, NULL}
 };
 static DEV_DEF devDef8950_MAME =
@@ -51,6 +51,7 @@ static DEVDEF_RWFUNC devFunc_MAME_2203[] =
 	{RWF_REGISTER | RWF_WRITE, DEVRW_A8D8, 0, ym2203_write},
 	{RWF_REGISTER | RWF_READ, DEVRW_A8D8, 0, ym2203_read},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, ym2203_set_mute_mask},
+	{RWF_ADVANCE | RWF_WRITE, DEVRW_VALUE, 0, ym2203_advance},
 	{0x00, 0x00, 0, NULL}
 };
 static DEV_DEF devDef_MAME_2203 =
@@ -109,6 +110,7 @@ static DEVDEF_RWFUNC devFunc_MAME_2608[] =
 	{RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 'B', ym2608_write_pcmromb},
 	{RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 'B', ym2608_alloc_pcmromb},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, ym2608_set_mute_mask},
+	{RWF_ADVANCE | RWF_WRITE, DEVRW_VALUE, 0, ym2608_advance},
 	{0x00, 0x00, 0, NULL}
 };
 static DEV_DEF devDef_MAME_2608 =
@@ -175,6 +177,19 @@ static DEVDEF_RWFUNC devFunc_MAME_2610[] =
 	{RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 'B', ym2610_write_pcmromb},
 	{RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 'B', ym2610_alloc_pcmromb},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, ym2610_set_mute_mask},
+	{RWF_ADVANCE | RWF_WRITE, DEVRW_VALUE, 0, ym2610_advance},
+	{0x00, 0x00, 0, NULL}
+};
+static DEVDEF_RWFUNC devFunc_MAME_2610B[] =
+{
+	{RWF_REGISTER | RWF_WRITE, DEVRW_A8D8, 0, ym2610_write},
+	{RWF_REGISTER | RWF_READ, DEVRW_A8D8, 0, ym2610_read},
+	{RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 'A', ym2610_write_pcmroma},
+	{RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 'A', ym2610_alloc_pcmroma},
+	{RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 'B', ym2610_write_pcmromb},
+	{RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 'B', ym2610_alloc_pcmromb},
+	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, ym2610_set_mute_mask},
+	{RWF_ADVANCE | RWF_WRITE, DEVRW_VALUE, 0, ym2610b_advance},
 	{0x00, 0x00, 0, NULL}
 };
 static DEV_DEF devDef_MAME_2610 =
@@ -211,7 +226,7 @@ static DEV_DEF devDef_MAME_2610B =
 	ym2610_set_log_cb,	// SetLoggingCallback
 	device_ym2610_link_ssg,	// LinkDevice
 	
-	devFunc_MAME_2610,	// rwFuncs
+	devFunc_MAME_2610B,	// rwFuncs
 };
 
 static const char* DeviceName_YM2610(const DEV_GEN_CFG* devCfg)
@@ -79,6 +79,7 @@ struct qsound_chip {
 	UINT8* romData;
 	UINT32 romSize;
 	UINT32 romMask;
+	UINT8 romLinked;	// romData points to external read-only data
 	UINT32 muteMask;
 	
 	// ==================================================== //
@@ -147,6 +148,7 @@ static void qsoundc_write_data(void* info, UINT8 address, UINT16 data);
 
 static void qsoundc_alloc_rom(void* info, UINT32 memsize);
 static void qsoundc_write_rom(void* info, UINT32 offset, UINT32 length, const UINT8* data);
+static void qsoundc_link_rom(void* info, UINT32 memsize, const UINT8* data);
 static void qsoundc_set_options(void* info, UINT32 options);
 static void qsoundc_set_mute_mask(void* info, UINT32 MuteMask);
 
@@ -157,6 +159,7 @@ static DEVDEF_RWFUNC devFunc[] =
 	{RWF_REGISTER | RWF_QUICKWRITE, DEVRW_A8D16, 0, qsoundc_write_data},
 	{RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 0, qsoundc_write_rom},
 	{RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 0, qsoundc_alloc_rom},
+	{RWF_MEMORY | RWF_WRITE, DEVRW_MEMLINK, 0, qsoundc_link_rom},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, qsoundc_set_mute_mask},
 	{0x00, 0x00, 0, NULL}
 };
@@ -190,6 +193,7 @@ static UINT8 device_start_qsound_ctr(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf
 	chip->romData = NULL;
 	chip->romSize = 0x00;
 	chip->romMask = 0x00;
+	chip->romLinked = 0;
 	chip->opt_nowait = 0;
 	
 	qsoundc_set_mute_mask(chip, 0x00000);
@@ -207,7 +211,8 @@ static void device_stop_qsound_ctr(void* info)
 {
 	struct qsound_chip* chip = (struct qsound_chip*)info;
 	
-	free(chip->romData);
+	if (! chip->romLinked)
+		free(chip->romData);
 	free(chip);
 	
 	return;
@@ -299,6 +304,11 @@ static void qsoundc_alloc_rom(void* info, UINT32 memsize)
 	if (chip->romSize == memsize)
 		return;
 	
+	if (chip->romLinked)
+	{
+		chip->romData = NULL;
+		chip->romLinked = 0;
+	}
 	chip->romData = (UINT8*)realloc(chip->romData, memsize);
 	chip->romSize = memsize;
 	chip->romMask = pow2_mask(memsize);
@@ -316,11 +326,33 @@ static void qsoundc_write_rom(void* info, UINT32 offset, UINT32 length, const UI
 	if (offset + length > chip->romSize)
 		length = chip->romSize - offset;
 	
+	if (chip->romLinked)
+	{
+		// copy-on-write
+		UINT8* newROM = (UINT8*)malloc(chip->romSize);
+		memcpy(newROM, chip->romData, chip->romSize);
+		chip->romData = newROM;
+		chip->romLinked = 0;
+	}
 	memcpy(chip->romData + offset, data, length);
 	
 	return;
 }
 
+static void qsoundc_link_rom(void* info, UINT32 memsize, const UINT8* data)
+{
+	struct qsound_chip* chip = (struct qsound_chip*)info;
+	
+	if (! chip->romLinked)
+		free(chip->romData);
+	chip->romData = (UINT8*)data;
+	chip->romSize = (data != NULL) ? memsize : 0x00;
+	chip->romMask = pow2_mask(chip->romSize);
+	chip->romLinked = (data != NULL);
+	
+	return;
+}
+
 static void qsoundc_set_options(void* info, UINT32 options)
 {
 	struct qsound_chip* chip = (struct qsound_chip*)info;
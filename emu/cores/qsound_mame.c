@@ -41,6 +41,7 @@
 
 
 static void qsound_update(void *param, UINT32 samples, DEV_SMPL **outputs);
+static void qsound_advance(void *param, UINT32 samples);
 static UINT8 device_start_qsound(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf);
 static void device_stop_qsound(void *info);
 static void device_reset_qsound(void *info);
@@ -64,6 +65,7 @@ static DEVDEF_RWFUNC devFunc[] =
 	{RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 0, qsound_write_rom},
 	{RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 0, qsound_alloc_rom},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, qsound_set_mute_mask},
+	{RWF_ADVANCE | RWF_WRITE, DEVRW_VALUE, 0, qsound_advance},
 	{0x00, 0x00, 0, NULL}
 };
 DEV_DEF devDef_QSound_MAME =
@@ -101,6 +103,7 @@ typedef struct QSOUND_CHANNEL
 
 	// work variables
 	UINT8 enabled;      // key on / key off
+	UINT8 ended;        // reached the end of a non-looped sample
 	int lvol;           // left volume
 	int rvol;           // right volume
 	UINT32 step_ptr;    // current offset counter
@@ -248,11 +251,13 @@ static void qsound_write_data(void *info, UINT8 address, UINT16 data)
 		case 1:
 			// start/cur address
 			chip->channel[ch].address = data;
+			chip->channel[ch].ended = 0;
 			break;
 
 		case 2:
 			// frequency
 			chip->channel[ch].freq = data;
+			chip->channel[ch].ended = 0;
 #if 0
 			if (data == 0)
 			{
@@ -266,16 +271,19 @@ static void qsound_write_data(void *info, UINT8 address, UINT16 data)
 			// key on (does the value matter? it always writes 0x8000)
 			chip->channel[ch].enabled = (data & 0x8000) >> 15;
 			chip->channel[ch].step_ptr = 0;
+			chip->channel[ch].ended = 0;
 			break;
 
 		case 4:
 			// loop address
 			chip->channel[ch].loop = data;
+			chip->channel[ch].ended = 0;
 			break;
 
 		case 5:
 			// end address
 			chip->channel[ch].end = data;
+			chip->channel[ch].ended = 0;
 			break;
 
 		case 6:
@@ -321,16 +329,19 @@ static void qsound_update(void *param, UINT32 samples, DEV_SMPL **outputs)
 	INT8 sample;
 	qsound_channel *pC;
 
-	// Clear the buffers
-	memset(outputs[0], 0, samples * sizeof(*outputs[0]));
-	memset(outputs[1], 0, samples * sizeof(*outputs[1]));
+	// Clear the buffers (outputs == NULL: advance without output)
+	if (outputs != NULL)
+	{
+		memset(outputs[0], 0, samples * sizeof(*outputs[0]));
+		memset(outputs[1], 0, samples * sizeof(*outputs[1]));
+	}
 	if (chip->sample_rom == NULL || ! chip->sample_rom_length)
 		return;
 
 	for (j = 0; j < QSOUND_CHANNELS; j++)
 	{
 		pC=&chip->channel[j];
-		if (pC->enabled && ! pC->Muted)
+		if (pC->enabled && ! pC->ended && ! pC->Muted)
 		{
 			// Go through the buffer and add voice contributions
 			for (i = 0; i < samples; i++)
@@ -358,10 +369,16 @@ static void qsound_update(void *param, UINT32 samples, DEV_SMPL **outputs)
 						//pC->enabled = 0;
 						pC->address --;	// ensure that old ripped VGMs still work
 						pC->step_ptr += 0x1000;
+						// The channel stays here until it is written to, so that the position
+						// doesn't depend on the number of update calls.
+						pC->ended = 1;
 						break;
 					}
 				}
 				
+				if (outputs == NULL)
+					continue;
+				
 				offset = pC->bank | pC->address;
 				sample = chip->sample_rom[offset & chip->sample_rom_mask];
 				outputs[0][i] += ((sample * pC->lvol * pC->vol) >> 14);
@@ -371,6 +388,11 @@ static void qsound_update(void *param, UINT32 samples, DEV_SMPL **outputs)
 	}
 }
 
+static void qsound_advance(void *param, UINT32 samples)
+{
+	qsound_update(param, samples, NULL);
+}
+
 static void qsound_alloc_rom(void* info, UINT32 memsize)
 {
 	qsound_state* chip = (qsound_state *)info;
@@ -40,6 +40,7 @@
 #include "../EmuCores.h"
 #include "../snddef.h"
 #include "../EmuHelper.h"
+#include "../EmuOnce.h"
 #include "../logging.h"
 #include "scsp.h"
 #include "scspdsp.h"
@@ -609,7 +610,7 @@ static void SCSP_Init(scsp_state *scsp, UINT32 clock)
 		scsp->Slots[i].EG.state=SCSP_RELEASE;
 	}
 
-	LFO_Init();
+	EmuOnce_Run(&IsInit, LFO_Init);
 	// no "pend"
 	scsp->udata.data[0x20/2] = 0;
 	//scsp->TimCnt[0] = 0xffff;
@@ -972,27 +973,24 @@ INLINE INT32 SCSP_UpdateSlot(scsp_state *scsp, SCSP_SLOT *slot)
 		addr1+=smp; addr2+=smp;
 	}
 
-#ifdef VGM_BIG_ENDIAN
-#define READ_BE16(ptr)	(*(INT16*)ptr)
-#else
-#define READ_BE16(ptr)	(INT16)(((ptr)[0] << 8) | (ptr)[1])
-#endif
 	if (SSCTL(slot) == 0) // External DRAM data
 	{
+		// the address wraps around at the end of the RAM (its size is a power of 2)
+		UINT32 ramMask = scsp->SCSPRAM_LENGTH - 1;
 		if (PCM8B(slot)) //8 bit signed
 		{
-			INT16 p1=(INT8)scsp->SCSPRAM[SA(slot)+addr1]<<8;
-			INT16 p2=(INT8)scsp->SCSPRAM[SA(slot)+addr2]<<8;
+			INT16 p1=(INT8)scsp->SCSPRAM[(SA(slot)+addr1)&ramMask]<<8;
+			INT16 p2=(INT8)scsp->SCSPRAM[(SA(slot)+addr2)&ramMask]<<8;
 			INT32 fpart=slot->cur_addr&((1<<SHIFT)-1);
 			INT32 s=(int)p1*((1<<SHIFT)-fpart)+(int)p2*fpart;
 			sample=(s>>SHIFT);
 		}
 		else    //16 bit signed
 		{
-			const UINT8 *pp1 = &scsp->SCSPRAM[SA(slot)+addr1];
-			const UINT8 *pp2 = &scsp->SCSPRAM[SA(slot)+addr2];
-			INT16 p1 = READ_BE16(pp1);
-			INT16 p2 = READ_BE16(pp2);
+			UINT32 ofs1 = (SA(slot)+addr1)&ramMask;
+			UINT32 ofs2 = (SA(slot)+addr2)&ramMask;
+			INT16 p1 = (INT16)((scsp->SCSPRAM[ofs1] << 8) | scsp->SCSPRAM[(ofs1+1)&ramMask]);
+			INT16 p2 = (INT16)((scsp->SCSPRAM[ofs2] << 8) | scsp->SCSPRAM[(ofs2+1)&ramMask]);
 			INT32 fpart=slot->cur_addr&((1<<SHIFT)-1);
 			INT32 s=(int)p1*((1<<SHIFT)-fpart)+(int)p2*fpart;
 			sample=(s>>SHIFT);
@@ -1103,11 +1101,31 @@ INLINE INT32 SCSP_UpdateSlot(scsp_state *scsp, SCSP_SLOT *slot)
 	return sample;
 }
 
+INLINE void SCSP_MixSlot(scsp_state *scsp, SCSP_SLOT *slot, DEV_SMPL *smpl, DEV_SMPL *smpr)
+{
+	unsigned short Enc;
+	signed int sample;
+
+	sample=SCSP_UpdateSlot(scsp, slot);
+
+	if (! BypassDSP)
+	{
+		Enc=((TL(slot))<<0x0)|((IMXL(slot))<<0xd);
+		SCSPDSP_SetSample(&scsp->DSP,(sample*scsp->LPANTABLE[Enc])>>(SHIFT-2),ISEL(slot),IMXL(slot));
+	}
+	Enc=((TL(slot))<<0x0)|((DIPAN(slot))<<0x8)|((DISDL(slot))<<0xd);
+	{
+		*smpl+=(sample*scsp->LPANTABLE[Enc])>>SHIFT;
+		*smpr+=(sample*scsp->RPANTABLE[Enc])>>SHIFT;
+	}
+}
+
 static void SCSP_DoMasterSamples(void* info, UINT32 nsamples, DEV_SMPL **outputs)
 {
 	scsp_state *scsp = (scsp_state *)info;
 	DEV_SMPL *bufr,*bufl;
 	UINT32 sl, s, i;
+	UINT32 act_mask;
 
 	bufl = outputs[0];
 	bufr = outputs[1];
@@ -1119,49 +1137,68 @@ static void SCSP_DoMasterSamples(void* info, UINT32 nsamples, DEV_SMPL **outputs
 		return;
 	}
 
+	// Slots can only be keyed on by register writes, so the set of active slots
+	// can only shrink during an update. (Muted slots are not updated at all.)
+	act_mask = 0;
+	for(sl=0;sl<32;++sl)
+	{
+		if(scsp->Slots[sl].active && ! scsp->Slots[sl].Muted)
+			act_mask |= (1U << sl);
+	}
+#if ! FM_DELAY
+	if (! act_mask && BypassDSP)
+	{
+		// nothing to do except for moving the ring buffer pointer by 32 slots per sample
+		memset(bufl, 0, nsamples * sizeof(DEV_SMPL));
+		memset(bufr, 0, nsamples * sizeof(DEV_SMPL));
+		scsp->BUFPTR = (scsp->BUFPTR + nsamples * 32) & 63;
+		return;
+	}
+#endif
+
 	for(s=0;s<nsamples;++s)
 	{
 		DEV_SMPL smpl, smpr;
 
 		smpl = smpr = 0;
 
+#if FM_DELAY
 		for(sl=0;sl<32;++sl)
 		{
-#if FM_DELAY
 			scsp->RBUFDST=scsp->DELAYBUF+scsp->DELAYPTR;
-#else
-			scsp->RBUFDST=scsp->RINGBUF+scsp->BUFPTR;
-#endif
-			if(scsp->Slots[sl].active && ! scsp->Slots[sl].Muted)
+			if(act_mask & (1U << sl))
 			{
-				SCSP_SLOT *slot=scsp->Slots+sl;
-				unsigned short Enc;
-				signed int sample;
-
-				sample=SCSP_UpdateSlot(scsp, slot);
-
-				if (! BypassDSP)
-				{
-					Enc=((TL(slot))<<0x0)|((IMXL(slot))<<0xd);
-					SCSPDSP_SetSample(&scsp->DSP,(sample*scsp->LPANTABLE[Enc])>>(SHIFT-2),ISEL(slot),IMXL(slot));
-				}
-				Enc=((TL(slot))<<0x0)|((DIPAN(slot))<<0x8)|((DISDL(slot))<<0xd);
-				{
-					smpl+=(sample*scsp->LPANTABLE[Enc])>>SHIFT;
-					smpr+=(sample*scsp->RPANTABLE[Enc])>>SHIFT;
-				}
+				SCSP_MixSlot(scsp, scsp->Slots+sl, &smpl, &smpr);
+				if(! scsp->Slots[sl].active)
+					act_mask &= ~(1U << sl);
 			}
 
-#if FM_DELAY
 			scsp->RINGBUF[(scsp->BUFPTR+64-(FM_DELAY-1))&63] = scsp->DELAYBUF[(scsp->DELAYPTR+FM_DELAY-(FM_DELAY-1))%FM_DELAY];
-#endif
 			++scsp->BUFPTR;
 			scsp->BUFPTR&=63;
-#if FM_DELAY
 			++scsp->DELAYPTR;
 			if(scsp->DELAYPTR>FM_DELAY-1) scsp->DELAYPTR=0;
-#endif
 		}
+#else
+		{
+			UINT8 baseptr = scsp->BUFPTR;
+			UINT32 smask;
+
+			// Inactive slots don't touch the ring buffer, so only the pointer needs to be
+			// correct for the active ones.
+			for(sl=0,smask=act_mask;smask;++sl,smask>>=1)
+			{
+				if(!(smask & 1))
+					continue;
+				scsp->BUFPTR=(baseptr+sl)&63;
+				scsp->RBUFDST=scsp->RINGBUF+scsp->BUFPTR;
+				SCSP_MixSlot(scsp, scsp->Slots+sl, &smpl, &smpr);
+				if(! scsp->Slots[sl].active)
+					act_mask &= ~(1U << sl);
+			}
+			scsp->BUFPTR=(baseptr+32)&63;
+		}
+#endif
 
 		if (! BypassDSP)
 		{
@@ -31,6 +31,8 @@ static void sega_pcm_fwrite_romusage(void *chip);
 #endif
 
 static void segapcm_set_mute_mask(void *chip, UINT32 MuteMask);
+static UINT32 segapcm_save_state(void *chip, UINT32 bufSize, void *buffer);
+static UINT8 segapcm_load_state(void *chip, UINT32 bufSize, const void *buffer);
 
 
 static DEVDEF_RWFUNC devFunc[] =
@@ -40,6 +42,8 @@ static DEVDEF_RWFUNC devFunc[] =
 	{RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 0, sega_pcm_write_rom},
 	{RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 0, sega_pcm_alloc_rom},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, segapcm_set_mute_mask},
+	{RWF_STATE | RWF_READ, DEVRW_BLOCK, 0, segapcm_save_state},
+	{RWF_STATE | RWF_WRITE, DEVRW_BLOCK, 0, segapcm_load_state},
 	{0x00, 0x00, 0, NULL}
 };
 static DEV_DEF devDef =
@@ -330,3 +334,29 @@ static void segapcm_set_mute_mask(void *chip, UINT32 MuteMask)
 	
 	return;
 }
+
+// state: [low 16 bytes] [RAM 0x800 bytes]
+#define SEGAPCM_STATE_SIZE	(16 + 0x800)
+static UINT32 segapcm_save_state(void *chip, UINT32 bufSize, void *buffer)
+{
+	segapcm_state *spcm = (segapcm_state *)chip;
+	UINT8* data = (UINT8*)buffer;
+	
+	if (data == NULL || bufSize < SEGAPCM_STATE_SIZE)
+		return SEGAPCM_STATE_SIZE;
+	memcpy(&data[0x00], spcm->low, 16);
+	memcpy(&data[0x10], spcm->ram, 0x800);
+	return SEGAPCM_STATE_SIZE;
+}
+
+static UINT8 segapcm_load_state(void *chip, UINT32 bufSize, const void *buffer)
+{
+	segapcm_state *spcm = (segapcm_state *)chip;
+	const UINT8* data = (const UINT8*)buffer;
+	
+	if (bufSize != SEGAPCM_STATE_SIZE)
+		return 0xFF;
+	memcpy(spcm->low, &data[0x00], 16);
+	memcpy(spcm->ram, &data[0x10], 0x800);
+	return 0x00;
+}
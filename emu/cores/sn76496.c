@@ -145,6 +145,7 @@
 #include "../EmuCores.h"
 #include "../EmuHelper.h"
 #include "../logging.h"
+#include "../blepbuf.h"
 #include "sn764intf.h"
 #include "sn76496.h"
 
@@ -158,8 +159,13 @@ static void sn76496_connect_t6w28(void *noisechip, void *tonechip);
 static void sn76496_shutdown(void *chip);
 static void sn76496_reset(void *chip);
 static void sn76496_freq_limiter(void* chip, UINT32 sample_rate);
+static void sn76496_set_options(void *chip, UINT32 Flags);
 static void sn76496_set_mute_mask(void *chip, UINT32 MuteMask);
+static UINT32 sn76496_get_rate(void *chip);
+static void sn76496_set_srchg_cb(void *chip, DEVCB_SRATE_CHG CallbackFunc, void* DataPtr);
 static void sn76496_set_log_cb(void *info, DEVCB_LOG func, void* param);
+static UINT32 sn76496_save_state(void *chip, UINT32 bufSize, void *buffer);
+static UINT8 sn76496_load_state(void *chip, UINT32 bufSize, const void *buffer);
 
 static UINT8 device_start_sn76496_mame(const SN76496_CFG* cfg, DEV_INFO* retDevInf);
 static void sn76496_w_mame(void *chip, UINT8 reg, UINT8 data);
@@ -168,7 +174,10 @@ static void sn76496_w_mame(void *chip, UINT8 reg, UINT8 data);
 static DEVDEF_RWFUNC devFunc[] =
 {
 	{RWF_REGISTER | RWF_WRITE, DEVRW_A8D8, 0, sn76496_w_mame},
+	{RWF_SRATE | RWF_READ, DEVRW_VALUE, 0, sn76496_get_rate},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, sn76496_set_mute_mask},
+	{RWF_STATE | RWF_READ, DEVRW_BLOCK, 0, sn76496_save_state},
+	{RWF_STATE | RWF_WRITE, DEVRW_BLOCK, 0, sn76496_load_state},
 	{0x00, 0x00, 0, NULL}
 };
 DEV_DEF devDef_SN76496_MAME =
@@ -180,10 +189,10 @@ DEV_DEF devDef_SN76496_MAME =
 	sn76496_reset,
 	sn76496_update,
 	
-	NULL,	// SetOptionBits
+	sn76496_set_options,	// SetOptionBits
 	sn76496_set_mute_mask,
 	NULL,	// SetPanning
-	NULL,	// SetSampleRateChangeCallback
+	sn76496_set_srchg_cb,	// SetSampleRateChangeCallback
 	sn76496_set_log_cb,	// SetLoggingCallback
 	NULL,	// LinkDevice
 	
@@ -229,6 +238,13 @@ struct _sn76496_state
 	UINT32 MuteMsk[4];
 	UINT8 NgpFlags;         // bit 7 - NGP Mode on/off, bit 0 - is 2nd NGP chip
 	sn76496_state* NgpChip2;    // pointer to other chip instance of T6W28
+	
+	UINT32 native_rate;     // rate of the divided clock
+	UINT32 smpl_rate;       // output sample rate (for BLEP mode)
+	UINT8 blep_mode;        // output band-limited steps at smpl_rate instead of native_rate
+	DEVCB_SRATE_CHG SmpRateFunc;
+	void* SmpRateData;
+	BLEP_BUF blep;
 };
 
 
@@ -323,218 +339,302 @@ INLINE void countdown_cycles(sn76496_state *R)
 	}
 }
 
-static void sn76496_update(void* param, UINT32 samples, DEV_SMPL** outputs)
+INLINE void skip_cycles(sn76496_state *R, INT32 cycles)
 {
-	UINT32 i;
-	UINT32 j;
-	sn76496_state *R = (sn76496_state *)param;
-	sn76496_state *R2;
-	DEV_SMPL* lbuffer = outputs[0];
-	DEV_SMPL* rbuffer = outputs[1];
-	DEV_SMPL out = 0;
-	DEV_SMPL out2 = 0;
-	INT32 vol[4];
-	INT32 ggst[2];
-
-	R2 = R->NgpFlags ? R->NgpChip2 : NULL;
-	if (R->NgpFlags)
+	// same as running clock_chip() 'cycles' times, as long as no channel flips its output
+	UINT8 i;
+	
+	if (cycles <= 0)
+		return;
+	for (i = 0; i < 4; i++)
+		R->count[i] -= cycles;
+	if (R->cycles_to_ready >= cycles)
 	{
-		// Speed Hack
-		out = 0;
-		for (i = 0; i < 3; i ++)
+		R->cycles_to_ready -= cycles;
+		R->ready_state = 0;
+	}
+	else
+	{
+		R->cycles_to_ready = 0;
+		R->ready_state = 1;
+	}
+}
+
+INLINE void clock_chip(sn76496_state *R)
+{
+	UINT8 i;
+	
+	// disabled, because dividing the output sample rate is easier and faster
+//	// clock chip once
+//	if (R->current_clock > 0) // not ready for new divided clock
+//	{
+//		R->current_clock--;
+//	}
+//	else // ready for new divided clock, make a new sample
+//	{
+//		R->current_clock = R->clock_divider-1;
+		// decrement Cycles to READY by one
+		countdown_cycles(R);
+		
+		// handle channels 0,1,2
+		for (i = 0; i < 3; i++)
 		{
-			if (R->period[i] || R->volume[i])
+			R->count[i]--;
+			if (R->count[i] <= 0)
 			{
-				out = 1;
-				break;
+				R->output[i] ^= 1;
+				R->count[i] = R->period[i];
 			}
 		}
-		if (R->volume[3])
-			out = 1;
-		if (! out)
+		
+		// handle channel 3
+		R->count[3]--;
+		if (R->count[3] <= 0)
 		{
-			memset(lbuffer, 0x00, sizeof(DEV_SMPL) * samples);
-			memset(rbuffer, 0x00, sizeof(DEV_SMPL) * samples);
-			return;
+			// if noisemode is 1, both taps are enabled
+			// if noisemode is 0, the lower tap, whitenoisetap2, is held at 0
+			// The != was a bit-XOR (^) before
+			if (((R->RNG & R->whitenoise_tap1)!=0) != (((R->RNG & R->whitenoise_tap2)!=(R->ncr_style_psg?R->whitenoise_tap2:0)) && in_noise_mode(R)))
+			{
+				R->RNG >>= 1;
+				R->RNG |= R->feedback_mask;
+			}
+			else
+			{
+				R->RNG >>= 1;
+			}
+			R->output[3] = R->RNG & 1;
+			
+			R->count[3] = R->period[3];
 		}
-	}
+	//}
+}
+
+INLINE void calc_output(sn76496_state *R, DEV_SMPL *outL, DEV_SMPL *outR)
+{
+	UINT32 i;
+	sn76496_state *R2;
+	DEV_SMPL out = 0;
+	DEV_SMPL out2 = 0;
+	INT32 vol[4];
+	INT32 ggst[2];
 	
+	R2 = R->NgpFlags ? R->NgpChip2 : NULL;
 	ggst[0] = 0x01;
 	ggst[1] = 0x01;
-	for (j = 0; j < samples; j++)
+
+#if 0
+	if (R->stereo)
 	{
-		// disabled, because dividing the output sample rate is easier and faster
-	//	// clock chip once
-	//	if (R->current_clock > 0) // not ready for new divided clock
-	//	{
-	//		R->current_clock--;
-	//	}
-	//	else // ready for new divided clock, make a new sample
-	//	{
-	//		R->current_clock = R->clock_divider-1;
-			// decrement Cycles to READY by one
-			countdown_cycles(R);
-
-			// handle channels 0,1,2
-			for (i = 0; i < 3; i++)
+		out = ((((R->stereo_mask & 0x10)!=0) && (R->output[0]!=0))? R->volume[0] : 0)
+			+ ((((R->stereo_mask & 0x20)!=0) && (R->output[1]!=0))? R->volume[1] : 0)
+			+ ((((R->stereo_mask & 0x40)!=0) && (R->output[2]!=0))? R->volume[2] : 0)
+			+ ((((R->stereo_mask & 0x80)!=0) && (R->output[3]!=0))? R->volume[3] : 0);
+		
+		out2= ((((R->stereo_mask & 0x1)!=0) && (R->output[0]!=0))? R->volume[0] : 0)
+			+ ((((R->stereo_mask & 0x2)!=0) && (R->output[1]!=0))? R->volume[1] : 0)
+			+ ((((R->stereo_mask & 0x4)!=0) && (R->output[2]!=0))? R->volume[2] : 0)
+			+ ((((R->stereo_mask & 0x8)!=0) && (R->output[3]!=0))? R->volume[3] : 0);
+	}
+	else
+	{
+		out= ((R->output[0]!=0)? R->volume[0]:0)
+			+((R->output[1]!=0)? R->volume[1]:0)
+			+((R->output[2]!=0)? R->volume[2]:0)
+			+((R->output[3]!=0)? R->volume[3]:0);
+		out2 = out;
+	}
+#endif
+	
+	// --- CUSTOM CODE START --
+	out = out2 = 0;
+	if (! R->NgpFlags)
+	{
+		for (i = 0; i < 4; i ++)
+		{
+			// --- Preparation Start ---
+			// Bipolar output
+			vol[i] = R->output[i] ? +1 : -1;
+			
+			// Disable high frequencies (> SampleRate / 2) for tone channels
+			// Freq. 0/1 isn't disabled because it would also disable PCM
+			if (i != 3)
 			{
-				R->count[i]--;
-				if (R->count[i] <= 0)
-				{
-					R->output[i] ^= 1;
-					R->count[i] = R->period[i];
-				}
+				if (R->period[i] <= R->FNumLimit && R->period[i] > 1)
+					vol[i] = 0;
 			}
-
-			// handle channel 3
-			R->count[3]--;
-			if (R->count[3] <= 0)
+			vol[i] &= R->MuteMsk[i];
+			// --- Preparation End ---
+			
+			if (R->stereo)
 			{
-				// if noisemode is 1, both taps are enabled
-				// if noisemode is 0, the lower tap, whitenoisetap2, is held at 0
-				// The != was a bit-XOR (^) before
-				if (((R->RNG & R->whitenoise_tap1)!=0) != (((R->RNG & R->whitenoise_tap2)!=(R->ncr_style_psg?R->whitenoise_tap2:0)) && in_noise_mode(R)))
-				{
-					R->RNG >>= 1;
-					R->RNG |= R->feedback_mask;
-				}
-				else
-				{
-					R->RNG >>= 1;
-				}
-				R->output[3] = R->RNG & 1;
-
-				R->count[3] = R->period[3];
+				ggst[0] = (R->stereo_mask & (0x10 << i)) ? 1 : 0;
+				ggst[1] = (R->stereo_mask & (0x01 << i)) ? 1 : 0;
+			}
+			if (R->period[i] > 1 || i == 3)
+			{
+				out += vol[i] * R->volume[i] * ggst[0];
+				out2 += vol[i] * R->volume[i] * ggst[1];
+			}
+			else if (R->MuteMsk[i])
+			{
+				// Make Bipolar Output with PCM possible
+				out += R->volume[i] * ggst[0];
+				out2 += R->volume[i] * ggst[1];
 			}
-		//}
-
-#if 0
-		if (R->stereo)
-		{
-			out = ((((R->stereo_mask & 0x10)!=0) && (R->output[0]!=0))? R->volume[0] : 0)
-				+ ((((R->stereo_mask & 0x20)!=0) && (R->output[1]!=0))? R->volume[1] : 0)
-				+ ((((R->stereo_mask & 0x40)!=0) && (R->output[2]!=0))? R->volume[2] : 0)
-				+ ((((R->stereo_mask & 0x80)!=0) && (R->output[3]!=0))? R->volume[3] : 0);
-
-			out2= ((((R->stereo_mask & 0x1)!=0) && (R->output[0]!=0))? R->volume[0] : 0)
-				+ ((((R->stereo_mask & 0x2)!=0) && (R->output[1]!=0))? R->volume[1] : 0)
-				+ ((((R->stereo_mask & 0x4)!=0) && (R->output[2]!=0))? R->volume[2] : 0)
-				+ ((((R->stereo_mask & 0x8)!=0) && (R->output[3]!=0))? R->volume[3] : 0);
-		}
-		else
-		{
-			out= ((R->output[0]!=0)? R->volume[0]:0)
-				+((R->output[1]!=0)? R->volume[1]:0)
-				+((R->output[2]!=0)? R->volume[2]:0)
-				+((R->output[3]!=0)? R->volume[3]:0);
-			out2 = out;
 		}
-#endif
-
-		// --- CUSTOM CODE START --
-		out = out2 = 0;
-		if (! R->NgpFlags)
+	}
+	else
+	{
+		i = 3;	// the T6W28 code below was written for i being left at 3 by the channel loop
+		if (! (R->NgpFlags & 0x01))
 		{
-			for (i = 0; i < 4; i ++)
+			// Tone Channel 1-3
+			if (R->stereo)
+			{
+				ggst[0] = (R->stereo_mask & (0x10 << i)) ? 1 : 0;
+				ggst[1] = (R->stereo_mask & (0x01 << i)) ? 1 : 0;
+			}
+			for (i = 0; i < 3; i ++)
 			{
 				// --- Preparation Start ---
 				// Bipolar output
 				vol[i] = R->output[i] ? +1 : -1;
 				
 				// Disable high frequencies (> SampleRate / 2) for tone channels
-				// Freq. 0/1 isn't disabled because it would also disable PCM
-				if (i != 3)
-				{
-					if (R->period[i] <= R->FNumLimit && R->period[i] > 1)
-						vol[i] = 0;
-				}
+				// Freq. 0 isn't disabled becaus it would also disable PCM
+				if (R->period[i] <= R->FNumLimit && R->period[i] > 1)
+					vol[i] = 0;
 				vol[i] &= R->MuteMsk[i];
 				// --- Preparation End ---
 				
-				if (R->stereo)
-				{
-					ggst[0] = (R->stereo_mask & (0x10 << i)) ? 1 : 0;
-					ggst[1] = (R->stereo_mask & (0x01 << i)) ? 1 : 0;
-				}
-				if (R->period[i] > 1 || i == 3)
+				if (R->period[i])
 				{
 					out += vol[i] * R->volume[i] * ggst[0];
-					out2 += vol[i] * R->volume[i] * ggst[1];
+					out2 += vol[i] * R2->volume[i] * ggst[1];
 				}
 				else if (R->MuteMsk[i])
 				{
 					// Make Bipolar Output with PCM possible
 					out += R->volume[i] * ggst[0];
-					out2 += R->volume[i] * ggst[1];
+					out2 += R2->volume[i] * ggst[1];
 				}
 			}
 		}
 		else
 		{
-			if (! (R->NgpFlags & 0x01))
+			// --- Preparation Start ---
+			// Bipolar output
+			vol[i] = R->output[i] ? +1 : -1;
+			
+			vol[i] &= R2->MuteMsk[i];	// use MuteMask from chip 0
+			// --- Preparation End ---
+			
+			// Noise Channel
+			if (R->stereo)
 			{
-				// Tone Channel 1-3
-				if (R->stereo)
-				{
-					ggst[0] = (R->stereo_mask & (0x10 << i)) ? 1 : 0;
-					ggst[1] = (R->stereo_mask & (0x01 << i)) ? 1 : 0;
-				}
-				for (i = 0; i < 3; i ++)
-				{
-					// --- Preparation Start ---
-					// Bipolar output
-					vol[i] = R->output[i] ? +1 : -1;
-					
-					// Disable high frequencies (> SampleRate / 2) for tone channels
-					// Freq. 0 isn't disabled becaus it would also disable PCM
-					if (R->period[i] <= R->FNumLimit && R->period[i] > 1)
-						vol[i] = 0;
-					vol[i] &= R->MuteMsk[i];
-					// --- Preparation End ---
-					
-					if (R->period[i])
-					{
-						out += vol[i] * R->volume[i] * ggst[0];
-						out2 += vol[i] * R2->volume[i] * ggst[1];
-					}
-					else if (R->MuteMsk[i])
-					{
-						// Make Bipolar Output with PCM possible
-						out += R->volume[i] * ggst[0];
-						out2 += R2->volume[i] * ggst[1];
-					}
-				}
+				ggst[0] = (R->stereo_mask & 0x80) ? 1 : 0;
+				ggst[1] = (R->stereo_mask & 0x08) ? 1 : 0;
 			}
 			else
 			{
-				// --- Preparation Start ---
-				// Bipolar output
-				vol[i] = R->output[i] ? +1 : -1;
-				
-				vol[i] &= R2->MuteMsk[i];	// use MuteMask from chip 0
-				// --- Preparation End ---
-				
-				// Noise Channel
-				if (R->stereo)
-				{
-					ggst[0] = (R->stereo_mask & 0x80) ? 1 : 0;
-					ggst[1] = (R->stereo_mask & 0x08) ? 1 : 0;
-				}
-				else
-				{
-					ggst[0] = 1;
-					ggst[1] = 1;
-				}
-				out += vol[3] * R2->volume[3] * ggst[0];
-				out2 += vol[3] * R->volume[3] * ggst[1];
+				ggst[0] = 1;
+				ggst[1] = 1;
 			}
+			out += vol[3] * R2->volume[3] * ggst[0];
+			out2 += vol[3] * R->volume[3] * ggst[1];
 		}
-		// --- CUSTOM CODE END --
-		
-		if(R->negate) { out = -out; out2 = -out2; }
+	}
+	// --- CUSTOM CODE END --
+	
+	if(R->negate) { out = -out; out2 = -out2; }
+	
+	*outL = out >> 1;	// >>1 to make up for bipolar output
+	*outR = out2 >> 1;
+}
 
-		lbuffer[j] = out >> 1;	// >>1 to make up for bipolar output
-		rbuffer[j] = out2 >> 1;
+static void sn76496_update_blep(sn76496_state *R, UINT32 samples, DEV_SMPL** outputs)
+{
+	DEV_SMPL* outBufs[2];
+	DEV_SMPL out;
+	DEV_SMPL out2;
+	UINT32 smplCnt;
+	UINT32 clocks;
+	UINT32 clk;
+	INT32 skip;
+	UINT8 i;
+	
+	outBufs[0] = outputs[0];
+	outBufs[1] = outputs[1];
+	while (samples > 0)
+	{
+		smplCnt = (samples < BLEP_MAX_SMPLS) ? samples : BLEP_MAX_SMPLS;
+		clocks = BlepBuf_ClocksNeeded(&R->blep, smplCnt);
+		for (clk = 0; clk < clocks; clk += skip)
+		{
+			// The output can only change when a channel flips, so jump right to the next flip.
+			// (Register writes happen between update calls, so the first clock is always rendered.)
+			skip = (clk == 0) ? 1 : (INT32)(clocks - clk);
+			for (i = 0; i < 4; i++)
+			{
+				if (R->count[i] < skip)
+					skip = (R->count[i] > 1) ? R->count[i] : 1;
+			}
+			skip_cycles(R, skip - 1);
+			clock_chip(R);
+			calc_output(R, &out, &out2);
+			BlepBuf_SetAmp(&R->blep, clk + skip - 1, out, out2);
+		}
+		BlepBuf_EndFrame(&R->blep, clocks);
+		BlepBuf_ReadSamples(&R->blep, smplCnt, outBufs);
+		outBufs[0] += smplCnt;
+		outBufs[1] += smplCnt;
+		samples -= smplCnt;
+	}
+	
+	return;
+}
+
+static void sn76496_update(void* param, UINT32 samples, DEV_SMPL** outputs)
+{
+	UINT32 i;
+	UINT32 j;
+	sn76496_state *R = (sn76496_state *)param;
+	DEV_SMPL* lbuffer = outputs[0];
+	DEV_SMPL* rbuffer = outputs[1];
+	DEV_SMPL out = 0;
+	
+	if (R->blep_mode)
+	{
+		sn76496_update_blep(R, samples, outputs);
+		return;
+	}
+	if (R->NgpFlags)
+	{
+		// Speed Hack
+		out = 0;
+		for (i = 0; i < 3; i ++)
+		{
+			if (R->period[i] || R->volume[i])
+			{
+				out = 1;
+				break;
+			}
+		}
+		if (R->volume[3])
+			out = 1;
+		if (! out)
+		{
+			memset(lbuffer, 0x00, sizeof(DEV_SMPL) * samples);
+			memset(rbuffer, 0x00, sizeof(DEV_SMPL) * samples);
+			return;
+		}
+	}
+	
+	for (j = 0; j < samples; j++)
+	{
+		clock_chip(R);
+		calc_output(R, &lbuffer[j], &rbuffer[j]);
 	}
 }
 
@@ -590,6 +690,9 @@ static void sn76496_reset(void *chip)
 
 	R->ready_state = 1;
 
+	if (R->blep_mode)
+		BlepBuf_Clear(&R->blep);
+
 	return;
 }
 
@@ -602,6 +705,43 @@ static void sn76496_freq_limiter(void* chip, UINT32 sample_rate)
 	return;
 }
 
+static void sn76496_set_options(void *chip, UINT32 Flags)
+{
+	sn76496_state *R = (sn76496_state*)chip;
+	UINT8 blepMode;
+	
+	// BLEP mode is only useful when the chip runs faster than the output
+	blepMode = (Flags & OPT_SN76496_BLEP) && R->smpl_rate > 0 && R->native_rate > R->smpl_rate;
+	if (blepMode == R->blep_mode)
+		return;
+	
+	R->blep_mode = blepMode;
+	if (R->blep_mode)
+		BlepBuf_Init(&R->blep, R->native_rate, R->smpl_rate);
+	if (R->SmpRateFunc != NULL)
+		R->SmpRateFunc(R->SmpRateData, sn76496_get_rate(R));
+	
+	return;
+}
+
+static UINT32 sn76496_get_rate(void *chip)
+{
+	sn76496_state *R = (sn76496_state*)chip;
+	
+	return R->blep_mode ? R->smpl_rate : R->native_rate;
+}
+
+static void sn76496_set_srchg_cb(void *chip, DEVCB_SRATE_CHG CallbackFunc, void* DataPtr)
+{
+	sn76496_state *R = (sn76496_state*)chip;
+	
+	// set Sample Rate Change Callback routine
+	R->SmpRateFunc = CallbackFunc;
+	R->SmpRateData = DataPtr;
+	
+	return;
+}
+
 static void sn76496_set_mute_mask(void *chip, UINT32 MuteMask)
 {
 	sn76496_state *R = (sn76496_state*)chip;
@@ -620,6 +760,48 @@ static void sn76496_set_log_cb(void *chip, DEVCB_LOG func, void* param)
 	return;
 }
 
+static UINT32 sn76496_save_state(void *chip, UINT32 bufSize, void *buffer)
+{
+	if (buffer == NULL || bufSize < sizeof(sn76496_state))
+		return sizeof(sn76496_state);
+	memcpy(buffer, chip, sizeof(sn76496_state));
+	return sizeof(sn76496_state);
+}
+
+static UINT8 sn76496_load_state(void *chip, UINT32 bufSize, const void *buffer)
+{
+	sn76496_state *R = (sn76496_state*)chip;
+	DEV_LOGGER logger;
+	UINT32 muteMsk[4];
+	sn76496_state* chip2;
+	UINT8 blepMode;
+	DEVCB_SRATE_CHG smpRateFunc;
+	void* smpRateData;
+	
+	if (bufSize != sizeof(sn76496_state))
+		return 0xFF;
+	
+	// keep settings and links to other instances
+	logger = R->logger;
+	memcpy(muteMsk, R->MuteMsk, sizeof(muteMsk));
+	chip2 = R->NgpChip2;
+	blepMode = R->blep_mode;
+	smpRateFunc = R->SmpRateFunc;
+	smpRateData = R->SmpRateData;
+	
+	memcpy(R, buffer, sizeof(sn76496_state));
+	
+	R->logger = logger;
+	memcpy(R->MuteMsk, muteMsk, sizeof(muteMsk));
+	R->NgpChip2 = chip2;
+	R->blep_mode = blepMode;
+	R->SmpRateFunc = smpRateFunc;
+	R->SmpRateData = smpRateData;
+	if (R->blep_mode)
+		BlepBuf_Init(&R->blep, R->native_rate, R->smpl_rate);
+	return 0x00;
+}
+
 static UINT8 device_start_sn76496_mame(const SN76496_CFG* cfg, DEV_INFO* retDevInf)
 {
 	sn76496_state* chip;
@@ -660,6 +842,10 @@ static UINT8 device_start_sn76496_mame(const SN76496_CFG* cfg, DEV_INFO* retDevI
 	chip->NgpFlags = 0x00;
 	chip->NgpChip2 = NULL;
 	rate = chip->clock / 2 / chip->clock_divider;
+	chip->native_rate = rate;
+	chip->smpl_rate = cfg->_genCfg.smplRate;
+	chip->blep_mode = 0;
+	chip->SmpRateFunc = NULL;
 	
 	// build volume table (2dB per step)
 	// four channels, each gets 1/4 of the total range
@@ -49,4 +49,6 @@ extern const DEV_DECL sndDev_SN76496;
 #define SN76496_W_REG	0x00	// normal register write
 #define SN76496_W_GGST	0x01	// GameGear stereo write
 
+#define OPT_SN76496_BLEP	0x01	// [MAME core] render band-limited steps directly at the output sample rate
+
 #endif	// __SN764INTF_H__
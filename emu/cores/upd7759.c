@@ -144,6 +144,7 @@ static UINT8 device_start_upd7759(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf);
 static void device_stop_upd7759(void *info);
 
 static void upd7759_set_bank_base(void *info, UINT32 base);
+static void upd7759_update_rom_ptr(void *info);
 
 static void upd7759_reset_w(void *info, UINT8 data);
 static void upd7759_start_w(void *info, UINT8 data);
@@ -323,6 +324,7 @@ struct _upd7759_state
 	UINT8 *     rombase;                    /* pointer to ROM data or NULL for slave mode */
 	UINT32      romoffset;                  /* ROM offset to make save/restore easier */
 	UINT32      rommask;                    /* maximum address offset */
+	UINT32      romlimit;                   /* number of ROM bytes from the bank base to the end of the ROM */
 
 	UINT8       Muted;
 
@@ -374,6 +376,12 @@ static const int upd7759_state_table[16] = { -1, -1, 0, 0, 1, 2, 2, 3, -1, -1, 0
 
 *************************************************************/
 
+/* bank windows may end past the ROM, unmapped bytes read as 0xFF (like unwritten ROM data) */
+INLINE UINT8 read_rom(upd7759_state *chip, UINT32 offset)
+{
+	return (offset < chip->romlimit) ? chip->rom[offset] : 0xFF;
+}
+
 INLINE void update_adpcm(upd7759_state *chip, int data)
 {
 	/* update the sample and the state */
@@ -471,7 +479,7 @@ static void advance_state(upd7759_state *chip)
 		/* Last sample state: latch the last sample value and issue a request for the second byte */
 		/* The second byte read will be just a dummy */
 		case STATE_LAST_SAMPLE:
-			chip->last_sample = chip->rom ? chip->rom[0] : chip->fifo_in;
+			chip->last_sample = chip->rom ? read_rom(chip, 0) : chip->fifo_in;
 			if (DEBUG_STATES) emu_logf(&chip->logger, DEVLOG_TRACE, "last_sample = %02X, requesting dummy 1\n", chip->last_sample);
 			chip->drq = 1;
 
@@ -494,7 +502,7 @@ static void advance_state(upd7759_state *chip)
 		/* Address MSB state: latch the MSB of the sample address and issue a request for the fourth byte */
 		/* The expected response will be the LSB of the sample address */
 		case STATE_ADDR_MSB:
-			chip->offset = (chip->rom ? chip->rom[chip->req_sample * 2 + 5] : chip->fifo_in) << (8 + chip->sample_offset_shift);
+			chip->offset = (chip->rom ? read_rom(chip, chip->req_sample * 2 + 5) : chip->fifo_in) << (8 + chip->sample_offset_shift);
 			if (DEBUG_STATES) emu_logf(&chip->logger, DEVLOG_TRACE, "offset_hi = %02X, requesting offset_lo\n", chip->offset >> (8 + chip->sample_offset_shift));
 			chip->drq = 1;
 
@@ -506,7 +514,7 @@ static void advance_state(upd7759_state *chip)
 		/* Address LSB state: latch the LSB of the sample address and issue a request for the fifth byte */
 		/* The expected response will be just a dummy */
 		case STATE_ADDR_LSB:
-			chip->offset |= (chip->rom ? chip->rom[chip->req_sample * 2 + 6] : chip->fifo_in) << chip->sample_offset_shift;
+			chip->offset |= (chip->rom ? read_rom(chip, chip->req_sample * 2 + 6) : chip->fifo_in) << chip->sample_offset_shift;
 			if (DEBUG_STATES) emu_logf(&chip->logger, DEVLOG_TRACE, "offset_lo = %02X, requesting dummy 2\n", (chip->offset >> chip->sample_offset_shift) & 0xff);
 			if (chip->offset > chip->rommask) emu_logf(&chip->logger, DEVLOG_DEBUG, "offset %X > rommask %X\n",chip->offset, chip->rommask);
 			chip->drq = 1;
@@ -538,7 +546,7 @@ static void advance_state(upd7759_state *chip)
 				chip->repeat_count--;
 				chip->offset = chip->repeat_offset;
 			}
-			chip->block_header = chip->rom ? chip->rom[chip->offset++ & chip->rommask] : chip->fifo_in;
+			chip->block_header = chip->rom ? read_rom(chip, chip->offset++ & chip->rommask) : chip->fifo_in;
 			if (DEBUG_STATES) emu_logf(&chip->logger, DEVLOG_TRACE, "header (@%05X) = %02X, requesting next byte\n", chip->offset, chip->block_header);
 			chip->drq = 1;
 
@@ -581,7 +589,7 @@ static void advance_state(upd7759_state *chip)
 		/* Nibble count state: latch the number of nibbles to play and request another byte */
 		/* The expected response will be the first data byte */
 		case STATE_NIBBLE_COUNT:
-			chip->nibbles_left = (chip->rom ? chip->rom[chip->offset++ & chip->rommask] : chip->fifo_in) + 1;
+			chip->nibbles_left = (chip->rom ? read_rom(chip, chip->offset++ & chip->rommask) : chip->fifo_in) + 1;
 			if (DEBUG_STATES) emu_logf(&chip->logger, DEVLOG_TRACE, "nibble_count = %u, requesting next byte\n", (unsigned)chip->nibbles_left);
 			chip->drq = 1;
 
@@ -593,7 +601,7 @@ static void advance_state(upd7759_state *chip)
 		/* MSN state: latch the data for this pair of samples and request another byte */
 		/* The expected response will be the next sample data or another header */
 		case STATE_NIBBLE_MSN:
-			chip->adpcm_data = chip->rom ? chip->rom[chip->offset++ & chip->rommask] : chip->fifo_in;
+			chip->adpcm_data = chip->rom ? read_rom(chip, chip->offset++ & chip->rommask) : chip->fifo_in;
 			update_adpcm(chip, chip->adpcm_data >> 4);
 			chip->drq = 1;
 
@@ -793,6 +801,7 @@ static UINT8 device_start_upd7759(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 	chip->romoffset = 0x00;
 	chip->romsize = 0x00;
 	chip->rom = chip->rombase = NULL;
+	chip->romlimit = 0x00;
 	if (chip->mode == MODE_SLAVE)
 	{
 		//assert(type() == UPD7759); // other chips do not support slave mode
@@ -910,8 +919,30 @@ static UINT8 upd7759_get_fifo_space(void *info)
 static void upd7759_set_bank_base(void *info, UINT32 base)
 {
 	upd7759_state *chip = (upd7759_state *)info;
-	chip->rom = chip->rombase + base;
 	chip->romoffset = base;
+	upd7759_update_rom_ptr(chip);
+}
+
+static void upd7759_update_rom_ptr(void *info)
+{
+	upd7759_state *chip = (upd7759_state *)info;
+	UINT32 base = chip->romoffset;
+	
+	if (chip->rombase == NULL)
+	{
+		chip->rom = NULL;
+		chip->romlimit = 0;
+		return;
+	}
+	// The bank base is kept as it is. read_rom() checks the offset against the end of the ROM.
+	if (base >= chip->romsize)
+	{
+		chip->rom = chip->rombase;	// bank is completely outside of the ROM
+		chip->romlimit = 0;
+		return;
+	}
+	chip->rom = chip->rombase + base;
+	chip->romlimit = chip->romsize - base;
 }
 
 static void upd7759_write(void *info, UINT8 offset, UINT8 data)
@@ -957,7 +988,7 @@ static void upd7759_alloc_rom(void* info, UINT32 memsize)
 	if (chip->rommask >= 0x20000)
 		chip->rommask = 0x1FFFF;
 	
-	chip->rom = chip->rombase + chip->romoffset;
+	upd7759_update_rom_ptr(chip);
 	
 	return;
 }
@@ -244,12 +244,12 @@ static void seta_update(void *param, UINT32 samples, DEV_SMPL **outputs)
 				}
 				info->smp_offset[ch] = smp_offs;
 			} else {                                            // Wave form
-				start    = (INT8 *)&(info->reg[reg->volume*128+0x1000]);
+				start    = (INT8 *)&(info->reg[(reg->volume&0x1f)*128+0x1000]);	// 32 waveforms at 0x1000..0x1FFF
 				smp_offs = info->smp_offset[ch];
 				freq     = ((reg->pitch_hi<<8)+reg->frequency)>>div;
 				smp_step = (UINT32)((float)info->base_clock/128.0/1024.0/4.0*freq*(1<<FREQ_BASE_BITS)/(float)info->rate+0.5f);
 
-				env      = (UINT8 *)&(info->reg[reg->end*128]);
+				env      = (UINT8 *)&(info->reg[(reg->end&0x3f)*128]);	// envelope numbers 0x00..0x3F cover the whole 0x2000 bytes
 				env_offs = info->env_offset[ch];
 				env_step = (UINT32)((float)info->base_clock/128.0/1024.0/4.0*reg->start*(1<<ENV_BASE_BITS)/(float)info->rate+0.5f);
 				/* Print some more debug info */
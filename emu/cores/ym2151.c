@@ -40,6 +40,7 @@
 #include "../EmuCores.h"
 #include "../snddef.h"
 #include "../EmuHelper.h"
+#include "../EmuOnce.h"
 #include "ym2151.h"
 
 #ifdef _MSC_VER
@@ -53,7 +54,10 @@ static void * ym2151_init(UINT32 clock, UINT32 rate);
 static void ym2151_shutdown(void *_chip);
 static void ym2151_reset_chip(void *_chip);
 static void ym2151_update_one(void *chip, UINT32 length, DEV_SMPL **buffers);
+static void ym2151_advance(void *chip, UINT32 length);
 static void ym2151_set_mute_mask(void *chip, UINT32 MuteMask);
+static UINT32 ym2151_save_state(void *chip, UINT32 bufSize, void *buffer);
+static UINT8 ym2151_load_state(void *chip, UINT32 bufSize, const void *buffer);
 static UINT8 device_start_ym2151(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf);
 static UINT8 ym2151_r(void *chip, UINT8 offset);
 static void ym2151_w(void *chip, UINT8 offset, UINT8 data);
@@ -65,6 +69,9 @@ static DEVDEF_RWFUNC devFunc_MAME[] =
 	{RWF_REGISTER | RWF_READ, DEVRW_A8D8, 0, ym2151_r},
 	{RWF_REGISTER | RWF_QUICKWRITE, DEVRW_A8D8, 0, ym2151_write_reg},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, ym2151_set_mute_mask},
+	{RWF_ADVANCE | RWF_WRITE, DEVRW_VALUE, 0, ym2151_advance},
+	{RWF_STATE | RWF_READ, DEVRW_BLOCK, 0, ym2151_save_state},
+	{RWF_STATE | RWF_WRITE, DEVRW_BLOCK, 0, ym2151_load_state},
 	{0x00, 0x00, 0, NULL}
 };
 DEV_DEF devDef_YM2151_MAME =
@@ -527,17 +534,13 @@ static const UINT8 lfo_noise_waveform[256] = {
 
 
 
-static UINT8 tablesInit = 0;
+static EMU_ONCE tablesInit = EMU_ONCE_INIT;
 
 static void init_tables(void)
 {
 	signed int i,x,n;
 	double o,m;
 
-	if (tablesInit)
-		return;
-	tablesInit = 1;
-
 	for (x=0; x<TL_RES_LEN; x++)
 	{
 		// note: this formula is broken in MAME 0.183
@@ -1233,7 +1236,7 @@ static void * ym2151_init(UINT32 clock, UINT32 rate)
 	PSG->irqhandler = NULL;
 	PSG->portwritehandler = NULL;
 
-	init_tables();
+	EmuOnce_Run(&tablesInit, init_tables);
 	init_chip_tables(PSG);
 
 	PSG->tim_A      = 0;
@@ -1474,6 +1477,34 @@ INLINE void chan7_calc(YM2151 *PSG)
 	op->mem_value = PSG->mem;
 }
 
+/* calculate only M1, whose feedback output is part of the emulation state (used when advancing without output) */
+INLINE void chan_calc_m1(YM2151 *PSG, unsigned int chan)
+{
+	YM2151Operator *op;
+	unsigned int env;
+	UINT32 AM = 0;
+
+	if (PSG->Muted[chan])
+		return;
+
+	op = &PSG->oper[chan*4];    /* M1 */
+	if (op->ams)
+		AM = PSG->lfa << (op->ams-1);
+	env = volume_calc(op);
+	{
+		INT32 out = op->fb_out_prev + op->fb_out_curr;
+		op->fb_out_prev = op->fb_out_curr;
+
+		op->fb_out_curr = 0;
+		if (env < ENV_QUIET)
+		{
+			if (!op->fb_shift)
+				out=0;
+			op->fb_out_curr = op_calc1(op, env, (out<<op->fb_shift) );
+		}
+	}
+}
+
 
 
 
@@ -1949,6 +1980,46 @@ INLINE void advance(YM2151 *PSG)
 }
 
 
+/* calculate timer A (called once per sample) */
+INLINE void timer_A_step(YM2151 *PSG)
+{
+	if (PSG->tim_A)
+	{
+		PSG->tim_A_val -= ( 1 << TIMER_SH );
+		if (PSG->tim_A_val <= 0)
+		{
+			PSG->tim_A_val += PSG->tim_A_tab[ PSG->timer_A_index ];
+			if (PSG->irq_enable & 0x04)
+			{
+				int oldstate = PSG->status & 3;
+				PSG->status |= 1;
+				if ((!oldstate) && (PSG->irqhandler)) PSG->irqhandler(PSG, 1);
+			}
+			if (PSG->irq_enable & 0x80)
+				PSG->csm_req = 2;   /* request KEY ON / KEY OFF sequence */
+		}
+	}
+}
+
+/* calculate timer B (called once per update) */
+INLINE void timer_B_update(YM2151 *PSG, UINT32 length)
+{
+	if (PSG->tim_B)
+	{
+		PSG->tim_B_val -= ( length << TIMER_SH );
+		if (PSG->tim_B_val<=0)
+		{
+			PSG->tim_B_val += PSG->tim_B_tab[ PSG->timer_B_index ];
+			if ( PSG->irq_enable & 0x08 )
+			{
+				int oldstate = PSG->status & 3;
+				PSG->status |= 2;
+				if ((!oldstate) && (PSG->irqhandler)) PSG->irqhandler(PSG, 1);
+			}
+		}
+	}
+}
+
 /*  Generate samples for one of the YM2151's
 *
 *   'chip' is a pointer to the virtual YM2151
@@ -1983,40 +2054,43 @@ static void ym2151_update_one(void *chip, UINT32 length, DEV_SMPL **buffers)
 		buffers[1][i] = outr;
 
 		advance(PSG);
-
-		/* calculate timer A */
-		if (PSG->tim_A)
-		{
-			PSG->tim_A_val -= ( 1 << TIMER_SH );
-			if (PSG->tim_A_val <= 0)
-			{
-				PSG->tim_A_val += PSG->tim_A_tab[ PSG->timer_A_index ];
-				if (PSG->irq_enable & 0x04)
-				{
-					int oldstate = PSG->status & 3;
-					PSG->status |= 1;
-					if ((!oldstate) && (PSG->irqhandler)) PSG->irqhandler(PSG, 1);
-				}
-				if (PSG->irq_enable & 0x80)
-					PSG->csm_req = 2;   /* request KEY ON / KEY OFF sequence */
-			}
-		}
+		timer_A_step(PSG);
 	}
 
-	if (PSG->tim_B)
+	timer_B_update(PSG, length);
+}
+
+/*  Advance the YM2151 by 'length' samples without generating output.
+*   Only M1 is calculated, because its feedback is part of the state.
+*   The last sample is calculated completely, in order to get the delayed (MEM) values right.
+*/
+static void ym2151_advance(void *chip, UINT32 length)
+{
+	YM2151 *PSG = (YM2151 *)chip;
+	UINT32 i;
+	int ch;
+
+	for (i=0; i<length; i++)
 	{
-		PSG->tim_B_val -= ( length << TIMER_SH );
-		if (PSG->tim_B_val<=0)
+		advance_eg(PSG);
+
+		if (i == length - 1)
 		{
-			PSG->tim_B_val += PSG->tim_B_tab[ PSG->timer_B_index ];
-			if ( PSG->irq_enable & 0x08 )
-			{
-				int oldstate = PSG->status & 3;
-				PSG->status |= 2;
-				if ((!oldstate) && (PSG->irqhandler)) PSG->irqhandler(PSG, 1);
-			}
+			for(ch=0; ch<7; ch++)
+				chan_calc(PSG, ch);
+			chan7_calc(PSG);
+		}
+		else
+		{
+			for(ch=0; ch<8; ch++)
+				chan_calc_m1(PSG, ch);
 		}
+
+		advance(PSG);
+		timer_A_step(PSG);
 	}
+
+	timer_B_update(PSG, length);
 }
 
 void ym2151_set_irq_handler(void *chip, void(*handler)(void *param, UINT8 irq))
@@ -2036,6 +2110,28 @@ static void ym2151_set_mute_mask(void *chip, UINT32 MuteMask)
 	return;
 }
 
+static UINT32 ym2151_save_state(void *chip, UINT32 bufSize, void *buffer)
+{
+	if (buffer == NULL || bufSize < sizeof(YM2151))
+		return sizeof(YM2151);
+	memcpy(buffer, chip, sizeof(YM2151));
+	return sizeof(YM2151);
+}
+
+static UINT8 ym2151_load_state(void *chip, UINT32 bufSize, const void *buffer)
+{
+	YM2151 *PSG = (YM2151 *)chip;
+	UINT8 muted[8];
+	
+	if (bufSize != sizeof(YM2151))
+		return 0xFF;
+	
+	memcpy(muted, PSG->Muted, sizeof(muted));
+	memcpy(PSG, buffer, sizeof(YM2151));
+	memcpy(PSG->Muted, muted, sizeof(muted));
+	return 0x00;
+}
+
 
 static UINT8 device_start_ym2151(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 {
@@ -1489,63 +1489,73 @@ UINT8 nukedopn2_read(void *chip, UINT8 port)
 	return NOPN2_Read((ym3438_t*)chip, port);
 }
 
+/* channel that is output during each group of 4 cycles (Ch 6 is replaced by the DAC when it is enabled) */
+static const Bit8u cycle_mute_ch[6] = { 1, 5, 3, 0, 4, 2 };
+
+static Bit64u NOPN2_NextWriteTime(ym3438_t *chip)
+{
+    if (!(chip->writebuf[chip->writebuf_cur].port & 0x04))
+    {
+        return (Bit64u)-1;
+    }
+    return chip->writebuf[chip->writebuf_cur].time;
+}
+
+static Bit64u NOPN2_ProcessWriteBuf(ym3438_t *chip)
+{
+    while (chip->writebuf[chip->writebuf_cur].time <= chip->writebuf_samplecnt)
+    {
+        if (!(chip->writebuf[chip->writebuf_cur].port & 0x04))
+        {
+            break;
+        }
+        chip->writebuf[chip->writebuf_cur].port &= 0x03;
+        NOPN2_Write(chip, chip->writebuf[chip->writebuf_cur].port,
+                      chip->writebuf[chip->writebuf_cur].data);
+        chip->writebuf_cur = (chip->writebuf_cur + 1) % NOPN_WRITEBUF_SIZE;
+    }
+    return NOPN2_NextWriteTime(chip);
+}
+
 void NOPN2_GenerateResampled(ym3438_t *chip, Bit32s *buf)
 {
     Bit32u i;
     Bit32s buffer[2];
     Bit32u mute;
-    
+    Bit32s smpl_l, smpl_r;
+    Bit64u next_write;
+
+    /* The write buffer can't change while generating, so only the time of the next write is checked. */
+    next_write = NOPN2_NextWriteTime(chip);
     while (chip->samplecnt >= chip->rateratio)
     {
         chip->oldsamples[0] = chip->samples[0];
         chip->oldsamples[1] = chip->samples[1];
-        chip->samples[0] = chip->samples[1] = 0;
+        smpl_l = smpl_r = 0;
         for (i = 0; i < 24; i++)
         {
-            switch (chip->cycles >> 2)
+            /* the DAC enable bit may change during the clock, so check it before */
+            mute = cycle_mute_ch[chip->cycles >> 2];
+            if (mute == 5)
             {
-            case 0: // Ch 2
-                mute = chip->mute[1];
-                break;
-            case 1: // Ch 6, DAC
-                mute = chip->mute[5 + chip->dacen];
-                break;
-            case 2: // Ch 4
-                mute = chip->mute[3];
-                break;
-            case 3: // Ch 1
-                mute = chip->mute[0];
-                break;
-            case 4: // Ch 5
-                mute = chip->mute[4];
-                break;
-            case 5: // Ch 3
-                mute = chip->mute[2];
-                break;
-            default:
-                mute = 0;
-                break;
+                mute += chip->dacen;
             }
+            mute = chip->mute[mute];
             NOPN2_Clock(chip, buffer);
             if (!mute)
             {
-                chip->samples[0] += buffer[0];
-                chip->samples[1] += buffer[1];
+                smpl_l += buffer[0];
+                smpl_r += buffer[1];
             }
 
-            while (chip->writebuf[chip->writebuf_cur].time <= chip->writebuf_samplecnt)
+            if (chip->writebuf_samplecnt >= next_write)
             {
-                if (!(chip->writebuf[chip->writebuf_cur].port & 0x04))
-                {
-                    break;
-                }
-                chip->writebuf[chip->writebuf_cur].port &= 0x03;
-                NOPN2_Write(chip, chip->writebuf[chip->writebuf_cur].port,
-                              chip->writebuf[chip->writebuf_cur].data);
-                chip->writebuf_cur = (chip->writebuf_cur + 1) % NOPN_WRITEBUF_SIZE;
+                next_write = NOPN2_ProcessWriteBuf(chip);
             }
             chip->writebuf_samplecnt++;
         }
+        chip->samples[0] = smpl_l;
+        chip->samples[1] = smpl_r;
         if(!chip->use_filter)
         {
             chip->samples[0] *= 11;
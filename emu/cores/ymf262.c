@@ -64,6 +64,7 @@ differences between OPL2 and OPL3 shown in datasheets:
 #include "../../stdtype.h"
 #include "../snddef.h"
 #include "../EmuHelper.h"
+#include "../EmuOnce.h"
 #include "../logging.h"
 #include "ymf262.h"
 
@@ -572,9 +573,6 @@ static const INT8 lfo_pm_table[8*8*2] = {
 };
 
 
-/* lock level of common table */
-static int num_lock = 0;
-
 /* work table */
 #define SLOT7_1 (&chip->P_CH[7].SLOT[SLOT1])
 #define SLOT7_2 (&chip->P_CH[7].SLOT[SLOT2])
@@ -583,7 +581,7 @@ static int num_lock = 0;
 
 
 
-static UINT8 tablesInit = 0;
+static EMU_ONCE tablesInit = EMU_ONCE_INIT;
 
 /* status set and IRQ handling */
 INLINE void OPL3_STATUS_SET(OPL3 *chip,int flag)
@@ -906,6 +904,42 @@ INLINE void chan_calc_ext( OPL3 *chip, OPL3_CH *CH )
 
 }
 
+/* calculate operator 1 feedback only (used when advancing without output) */
+INLINE void chan_calc_fb( OPL3 *chip, OPL3_SLOT *SLOT )
+{
+	unsigned int env;
+	signed int out;
+
+	env  = volume_calc(SLOT);
+	out  = SLOT->op1_out[0] + SLOT->op1_out[1];
+	SLOT->op1_out[0] = SLOT->op1_out[1];
+	SLOT->op1_out[1] = 0;
+	if( env < ENV_QUIET )
+	{
+		if (!SLOT->FB)
+			out = 0;
+		SLOT->op1_out[1] = op_calc1(SLOT->Cnt, env, (out<<SLOT->FB), SLOT->wavetable );
+	}
+}
+
+/* update the feedback state of all channels without calculating the output */
+INLINE void chan_calc_fb_all( OPL3 *chip, UINT8 rhythm )
+{
+	int ch;
+
+	for (ch = 0; ch < 18; ch ++)
+	{
+		if (rhythm && ch >= 6 && ch <= 8)
+			continue;
+		if (((ch >= 3 && ch <= 5) || (ch >= 12 && ch <= 14)) && chip->P_CH[ch - 3].extended)
+			continue;   /* 2nd part of 4op channel: no feedback */
+		if (! chip->P_CH[ch].Muted)
+			chan_calc_fb(chip, &chip->P_CH[ch].SLOT[SLOT1]);
+	}
+	if (rhythm)
+		chan_calc_fb(chip, &chip->P_CH[6].SLOT[SLOT1]);  /* Bass Drum */
+}
+
 /*
     operators used in the rhythm sounds generation process:
 
@@ -1111,16 +1145,12 @@ INLINE void chan_calc_rhythm( OPL3 *chip, OPL3_CH *CH, unsigned int noise )
 
 
 /* generic table initialize */
-static int init_tables(void)
+static void init_tables(void)
 {
 	signed int i,x;
 	signed int n;
 	double o,m;
 
-	if (tablesInit)
-		return 1;
-	tablesInit = 1;
-
 	for (x=0; x<TL_RES_LEN; x++)
 	{
 		m = (1<<16) / pow(2, (x+1) * (ENV_STEP/4.0) / 8.0);
@@ -1264,8 +1294,6 @@ static int init_tables(void)
 		//logerror("YMF262.C: sin7[%4i]= %4i (tl_tab value=%5i)\n", i, sin_tab[7*SIN_LEN+i], tl_tab[sin_tab[7*SIN_LEN+i]] );
 	}
 	/*logerror("YMF262.C: ENV_QUIET= %08x (dec*8=%i)\n", ENV_QUIET, ENV_QUIET*8 );*/
-
-	return 1;
 }
 
 static void OPLCloseTable( void )
@@ -2207,28 +2235,15 @@ static void OPL3WriteReg(OPL3 *chip, int r, int v)
 }
 
 /* lock/unlock for common table */
-static int OPL3_LockTable()
+static int OPL3_LockTable(void)
 {
-	num_lock++;
-	if(num_lock>1) return 0;
-
-	/* first time */
-
-	if( !init_tables() )
-	{
-		num_lock--;
-		return -1;
-	}
-
+	/* the tables are shared by all chips and initialized only once (thread-safe) */
+	EmuOnce_Run(&tablesInit, init_tables);
 	return 0;
 }
 
 static void OPL3_UnLockTable(void)
 {
-	if(num_lock) num_lock--;
-	if(num_lock) return;
-
-	/* last time */
 	OPLCloseTable();
 }
 
@@ -2528,6 +2543,20 @@ void ymf262_update_one(void *_chip, UINT32 length, DEV_SMPL **buffers)
 		return;
 	}
 	
+	if (buffers == NULL)
+	{
+		// advancing without output
+		if (chip->isDisabled)
+			return;
+		for( i=0; i < length ; i++ )
+		{
+			advance_lfo(chip);
+			chan_calc_fb_all(chip, rhythm);
+			advance(chip);
+		}
+		return;
+	}
+	
 	ch_a = buffers[0];
 	ch_b = buffers[1];
 	if (chip->isDisabled)
@@ -2627,6 +2656,12 @@ void ymf262_update_one(void *_chip, UINT32 length, DEV_SMPL **buffers)
 
 }
 
+/* advance the emulation without generating output */
+void ymf262_advance(void *chip, UINT32 length)
+{
+	ymf262_update_one(chip, length, NULL);
+}
+
 void ymf262_set_log_cb(void* chip, DEVCB_LOG func, void* param)
 {
 	OPL3 *opl3 = (OPL3 *)chip;
@@ -15,6 +15,7 @@ void ymf262_write(void *chip, UINT8 a, UINT8 v);
 UINT8 ymf262_read(void *chip, UINT8 a);
 UINT8 ymf262_timer_over(void *chip, UINT8 c);
 void ymf262_update_one(void *_chip, UINT32 length, DEV_SMPL **buffers);
+void ymf262_advance(void *chip, UINT32 length);
 
 void ymf262_set_timer_handler(void *chip, OPL3_TIMERHANDLER TimerHandler, void *param);
 void ymf262_set_irq_handler(void *chip, OPL3_IRQHANDLER IRQHandler, void *param);
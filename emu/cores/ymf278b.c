@@ -103,6 +103,7 @@
 #include "../snddef.h"
 #include "../SoundEmu.h"
 #include "../EmuHelper.h"
+#include "../EmuOnce.h"
 #include "../logging.h"
 #include "ymf278b.h"
 
@@ -125,6 +126,7 @@ static void ymf278b_alloc_rom(void* info, UINT32 memsize);
 static void ymf278b_alloc_ram(void* info, UINT32 memsize);
 static void ymf278b_write_rom(void *info, UINT32 offset, UINT32 length, const UINT8* data);
 static void ymf278b_write_ram(void *info, UINT32 offset, UINT32 length, const UINT8* data);
+static void ymf278b_link_rom(void *info, UINT32 memsize, const UINT8* data);
 
 static void ymf278b_set_mute_mask(void *info, UINT32 MuteMask);
 static void ymf278b_set_log_cb(void *info, DEVCB_LOG func, void* param);
@@ -136,6 +138,7 @@ static DEVDEF_RWFUNC devFunc[] =
 	{RWF_REGISTER | RWF_READ, DEVRW_A8D8, 0, ymf278b_r},
 	{RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 0x524F, ymf278b_write_rom},	// 0x524F = 'RO' for ROM
 	{RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 0x524F, ymf278b_alloc_rom},
+	{RWF_MEMORY | RWF_WRITE, DEVRW_MEMLINK, 0x524F, ymf278b_link_rom},
 	{RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 0x5241, ymf278b_write_ram},	// 0x5241 = 'RA' for RAM
 	{RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 0x5241, ymf278b_alloc_ram},
 	{RWF_CHN_MUTE | RWF_WRITE, DEVRW_ALL, 0, ymf278b_set_mute_mask},
@@ -256,6 +259,7 @@ struct _YMF278BChip
 
 	UINT32 ROMSize;
 	UINT8 *rom;
+	UINT8 ROMLinked;	// rom points to external read-only data
 	UINT32 RAMSize;
 	UINT8 *ram;
 	UINT32 clock;
@@ -436,7 +440,7 @@ static const UINT8 am_depth[8] = {
 };
 
 
-static UINT8 tablesInit = 0;
+static EMU_ONCE tablesInit = EMU_ONCE_INIT;
 
 // Sign extend a 4-bit value to 8-bit int
 // require: x in range [0..15]
@@ -1428,11 +1432,33 @@ static void init_opl3_devinfo(DEV_INFO* devInf, const DEV_GEN_CFG* baseCfg)
 	return;
 }
 
+static void init_tables(void)
+{
+	UINT32 i;
+	
+	// Volume table (envelope levels)
+	for (i = 0x00; i < ENV_LEN; i ++)
+	{
+		if (i < MAX_ATT_INDEX)
+		{
+			int vol_mul = 0x80 - (i & 0x3F);	// 0x40 values per 6 db
+			int vol_shift = 7 + (i >> 6);		// approximation: -6 dB == divide by two (shift right)
+			vol_tab[i] = (0x8000 * vol_mul) >> vol_shift;
+		}
+		else
+		{
+			// OPL4 hardware seems to clip to silence here below -60 db.
+			vol_tab[i] = 0;
+		}
+	}
+	
+	return;
+}
+
 static UINT8 device_start_ymf278b(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 {
 	YMF278BChip *chip;
 	UINT32 rate;
-	UINT32 i;
 
 	chip = (YMF278BChip *)calloc(1, sizeof(YMF278BChip));
 	if (chip == NULL)
@@ -1449,31 +1475,13 @@ static UINT8 device_start_ymf278b(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 
 	chip->ROMSize = 0;
 	chip->rom = NULL;
+	chip->ROMLinked = 0;
 	chip->RAMSize = 0;
 	chip->ram = NULL;
 
 	chip->memadr = 0; // avoid UMR
 
-	if (! tablesInit)
-	{
-		tablesInit = 1;
-		
-		// Volume table (envelope levels)
-		for (i = 0x00; i < ENV_LEN; i ++)
-		{
-			if (i < MAX_ATT_INDEX)
-			{
-				int vol_mul = 0x80 - (i & 0x3F);	// 0x40 values per 6 db
-				int vol_shift = 7 + (i >> 6);		// approximation: -6 dB == divide by two (shift right)
-				vol_tab[i] = (0x8000 * vol_mul) >> vol_shift;
-			}
-			else
-			{
-				// OPL4 hardware seems to clip to silence here below -60 db.
-				vol_tab[i] = 0;
-			}
-		}
-	}
+	EmuOnce_Run(&tablesInit, init_tables);
 
 	ymf278b_set_mute_mask(chip, 0x000000);
 
@@ -1489,7 +1497,8 @@ static void device_stop_ymf278b(void *info)
 	YMF278BChip* chip = (YMF278BChip *)info;
 	
 	free(chip->ram);
-	free(chip->rom);
+	if (! chip->ROMLinked)
+		free(chip->rom);
 	free(chip);
 	
 	return;
@@ -1573,6 +1582,11 @@ static void ymf278b_alloc_rom(void* info, UINT32 memsize)
 	if (chip->ROMSize == memsize)
 		return;
 	
+	if (chip->ROMLinked)
+	{
+		chip->rom = NULL;
+		chip->ROMLinked = 0;
+	}
 	chip->rom = (UINT8*)realloc(chip->rom, memsize);
 	chip->ROMSize = memsize;
 	memset(chip->rom, 0xFF, memsize);
@@ -1603,6 +1617,14 @@ static void ymf278b_write_rom(void *info, UINT32 offset, UINT32 length, const UI
 	if (offset + length > chip->ROMSize)
 		length = chip->ROMSize - offset;
 	
+	if (chip->ROMLinked)
+	{
+		// copy-on-write
+		UINT8* newROM = (UINT8*)malloc(chip->ROMSize);
+		memcpy(newROM, chip->rom, chip->ROMSize);
+		chip->rom = newROM;
+		chip->ROMLinked = 0;
+	}
 	memcpy(chip->rom + offset, data, length);
 	
 	return;
@@ -1622,6 +1644,19 @@ static void ymf278b_write_ram(void *info, UINT32 offset, UINT32 length, const UI
 	return;
 }
 
+static void ymf278b_link_rom(void *info, UINT32 memsize, const UINT8* data)
+{
+	YMF278BChip *chip = (YMF278BChip *)info;
+	
+	if (! chip->ROMLinked)
+		free(chip->rom);
+	chip->rom = (UINT8*)data;
+	chip->ROMSize = (data != NULL) ? memsize : 0;
+	chip->ROMLinked = (data != NULL);
+	
+	return;
+}
+
 
 static void ymf278b_set_mute_mask(void *info, UINT32 MuteMask)
 {
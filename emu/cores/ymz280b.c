@@ -39,6 +39,7 @@
 #include "../EmuCores.h"
 #include "../snddef.h"
 #include "../EmuHelper.h"
+#include "../EmuOnce.h"
 #include "../logging.h"
 #include "ymz280b.h"
 
@@ -201,7 +202,7 @@ static const int index_scale[8] = { 0x0e6, 0x0e6, 0x0e6, 0x0e6, 0x133, 0x199, 0x
 
 /* lookup table for the precomputed difference */
 static int diff_lookup[16];
-static UINT8 lookup_init = 0x00;	/* lookup-table is initialized */
+static EMU_ONCE lookup_init = EMU_ONCE_INIT;	/* lookup-table is initialized */
 
 
 INLINE UINT8 ymz280b_read_memory(ymz280b_state *chip, UINT32 offset)
@@ -303,17 +304,12 @@ static void compute_tables(void)
 {
 	int nib;
 
-	if (lookup_init)
-		return;
-
 	/* loop over all nibbles and compute the difference */
 	for (nib = 0; nib < 16; nib++)
 	{
 		int value = (nib & 0x07) * 2 + 1;
 		diff_lookup[nib] = (nib & 0x08) ? -value : value;
 	}
-	
-	lookup_init = 0x01;
 }
 
 
@@ -735,7 +731,7 @@ static UINT8 device_start_ymz280b(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 		return 0xFF;
 
 	/* compute ADPCM tables */
-	compute_tables();
+	EmuOnce_Run(&lookup_init, compute_tables);
 
 	/* initialize the rest of the structure */
 	chip->master_clock = (double)cfg->clock / 384.0;
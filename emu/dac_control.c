@@ -26,6 +26,12 @@
 #include "RatioCntr.h"
 #include "dac_control.h"
 
+static DEVDEF_RWFUNC devFunc_DAC[] =
+{
+	{RWF_STATE | RWF_READ, DEVRW_BLOCK, 0, daccontrol_save_state},
+	{RWF_STATE | RWF_WRITE, DEVRW_BLOCK, 0, daccontrol_load_state},
+	{0x00, 0x00, 0, NULL}
+};
 static DEV_DEF devDef_DAC =
 {
 	NULL, NULL, 0,
@@ -42,7 +48,7 @@ static DEV_DEF devDef_DAC =
 	NULL,	// SetLoggingCallback
 	NULL,	// LinkDevice
 	
-	NULL,	// rwFuncs
+	devFunc_DAC,	// rwFuncs
 };
 
 typedef struct
@@ -346,6 +352,34 @@ void daccontrol_update(void* info, UINT32 samples, DEV_SMPL** dummy)
 	return;
 }
 
+// Returns the number of samples until the next command is sent to the chip.
+// Calling daccontrol_update() with up to that many samples behaves exactly like
+// doing single-sample updates. Returns (UINT32)-1 when no commands are pending.
+UINT32 daccontrol_get_samples_to_write(void* info)
+{
+	dac_control* chip = (dac_control*)info;
+	RC_TYPE remVal;
+	RC_TYPE smplCnt;
+	
+	if (chip->Running & 0x80)	// disabled
+		return (UINT32)-1;
+	if (! (chip->Running & 0x01))	// stopped
+		return (UINT32)-1;
+	if (! chip->RemainCmds)
+		return 1;	// the next update will stop or restart the stream
+	if (! chip->stepCntr.inc)
+		return (UINT32)-1;
+	if ((RC_TYPE)(chip->stepCntr.val + chip->stepCntr.inc) >> RC_SHIFT)
+		return 1;	// sends a command with the next sample (also catches RC_RESET_PRESTEP)
+	
+	// distance to the next integer step of the counter
+	remVal = ((RC_TYPE)1 << RC_SHIFT) - chip->stepCntr.val;
+	smplCnt = (remVal + chip->stepCntr.inc - 1) / chip->stepCntr.inc;
+	if (smplCnt > (UINT32)-1)
+		return (UINT32)-1;
+	return (UINT32)smplCnt;
+}
+
 UINT8 device_start_daccontrol(const DEV_GEN_CFG* cfg, DEV_INFO* retDevInf)
 {
 	dac_control* chip;
@@ -582,3 +616,22 @@ void daccontrol_stop(void* info)
 	
 	return;
 }
+
+UINT32 daccontrol_save_state(void* info, UINT32 bufSize, void* buffer)
+{
+	if (buffer == NULL || bufSize < sizeof(dac_control))
+		return sizeof(dac_control);
+	memcpy(buffer, info, sizeof(dac_control));
+	return sizeof(dac_control);
+}
+
+UINT8 daccontrol_load_state(void* info, UINT32 bufSize, const void* buffer)
+{
+	// Note: The state includes the destination chip, which must still exist.
+	//       The data pointer has to be refreshed using daccontrol_refresh_data().
+	if (bufSize != sizeof(dac_control))
+		return 0xFF;
+	
+	memcpy(info, buffer, sizeof(dac_control));
+	return 0x00;
+}
@@ -20,6 +20,9 @@ void daccontrol_refresh_data(void* info, UINT8* Data, UINT32 DataLen);
 void daccontrol_set_frequency(void* info, UINT32 Frequency);
 void daccontrol_start(void* info, UINT32 DataPos, UINT8 LenMode, UINT32 Length);
 void daccontrol_stop(void* info);
+UINT32 daccontrol_get_samples_to_write(void* info);
+UINT32 daccontrol_save_state(void* info, UINT32 bufSize, void* buffer);
+UINT8 daccontrol_load_state(void* info, UINT32 bufSize, const void* buffer);
 
 #define DCTRL_LMODE_IGNORE	0x00
 #define DCTRL_LMODE_CMDS	0x01
@@ -0,0 +1,568 @@
+// Sound Core Benchmark
+// --------------------
+// Measures the speed of every sound core of every built-in device (sndEmu_Devices).
+// Each core is started in native and custom (44100 Hz) sample rate mode and is driven by a
+// deterministic pseudo-random stream of register writes. Devices with sample memory get
+// pseudo-random sample data.
+// The speed is measured twice:
+//	update: calling the core's Update function directly (samples at the core's sample rate)
+//	resample: calling Resmpl_Execute, which includes the core's Update (samples at 44100 Hz)
+//	blep: same as resample, but with the core's band-limited step output enabled
+//	      (only for cores that support it and only in native mode, the cores output at 44100 Hz then)
+// Each run renders for a fixed amount of CPU time and the fastest run is used.
+// The output is JSON, so that the results can be compared between versions.
+// Optional arguments filter the cores by device name or core FCC (case-sensitive substring).
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "stdtype.h"
+#include "emu/EmuStructs.h"
+#include "emu/SoundEmu.h"
+#include "emu/SoundDevs.h"
+#include "emu/EmuCores.h"
+#include "emu/Resampler.h"
+#include "emu/cores/sn764intf.h"
+#include "emu/cores/segapcm.h"
+#include "emu/cores/ayintf.h"
+#include "emu/cores/okim6258.h"
+#include "emu/cores/msm5232.h"
+#include "emu/cores/gb.h"
+#include "emu/cores/nesintf.h"
+
+#define OUT_SMPL_RATE	44100
+#define BLOCK_SMPLS		128		// number of samples rendered between register writes
+#define BLOCK_WRITES	4		// register writes per block (~1400 writes per second at 44.1 kHz)
+#define ROM_SIZE		0x100000
+#define DEF_SECONDS		0.25	// CPU time per run
+#define CHECK_BLOCKS	16		// number of blocks between checking the time
+#define DEF_RUNS		3		// the fastest run is used
+
+typedef struct _device_params
+{
+	DEV_ID devID;
+	UINT32 clock;
+	UINT8 flags;
+} DEV_PARAMS;
+
+typedef union _device_config
+{
+	DEV_GEN_CFG gen;
+	SN76496_CFG sn;
+	SEGAPCM_CFG spcm;
+	AY8910_CFG ay;
+	OKIM6258_CFG oki;
+	MSM5232_CFG msm;
+} DEV_CONFIG;
+
+typedef struct _core_option
+{
+	DEV_ID devID;
+	UINT32 coreID;
+	UINT32 options;
+} CORE_OPTION;
+
+typedef struct _write_stream
+{
+	void* writeFunc;
+	UINT8 rwType;
+	UINT16 addrMask;
+	UINT32 rngState;
+} WRITE_STREAM;
+
+// typical clocks (as used by VGM files)
+static const DEV_PARAMS DEV_LIST[] =
+{
+	{DEVID_SN76496,	3579545,	0},
+	{DEVID_YM2413,	3579545,	0},
+	{DEVID_YM2612,	7670453,	0},
+	{DEVID_YM2151,	3579545,	0},
+	{DEVID_SEGAPCM,	4000000,	0},
+	{DEVID_RF5C68,	12500000,	0},
+	{DEVID_YM2203,	3993600,	0},
+	{DEVID_YM2608,	7987200,	0},
+	{DEVID_YM2610,	8000000,	0},
+	{DEVID_YM3812,	3579545,	0},
+	{DEVID_YM3526,	3579545,	0},
+	{DEVID_Y8950,	3579545,	0},
+	{DEVID_YMF262,	14318180,	0},
+	{DEVID_YMF278B,	33868800,	0},
+	{DEVID_YMF271,	16934400,	0},
+	{DEVID_YMZ280B,	16934400,	0},
+	{DEVID_32X_PWM,	23011361,	0},
+	{DEVID_AY8910,	1789773,	0},
+	{DEVID_GB_DMG,	4194304,	0},
+	{DEVID_NES_APU,	1789772,	0},
+	{DEVID_YMW258,	9878400,	0},
+	{DEVID_uPD7759,	640000,		0},
+	{DEVID_OKIM6258,	4000000,	0},
+	{DEVID_OKIM6295,	1000000,	0},
+	{DEVID_K051649,	1789773,	0},
+	{DEVID_K054539,	18432000,	0},
+	{DEVID_C6280,	3579545,	0},
+	{DEVID_C140,	12288000,	0},
+	{DEVID_C219,	12288000,	0},
+	{DEVID_K053260,	3579545,	0},
+	{DEVID_POKEY,	1789772,	0},
+	{DEVID_QSOUND,	60000000,	0},
+	{DEVID_SCSP,	22579200,	0},
+	{DEVID_WSWAN,	3072000,	0},
+	{DEVID_VBOY_VSU,	5000000,	0},
+	{DEVID_SAA1099,	8000000,	0},
+	{DEVID_ES5503,	7159090,	2},	// flags = output channels
+	{DEVID_ES5506,	16000000,	2},	// flags = output channels
+	{DEVID_X1_010,	16000000,	0},
+	{DEVID_C352,	24192000,	0},
+	{DEVID_GA20,	3579545,	0},
+	{DEVID_MIKEY,	16000000,	0},
+	{DEVID_K007232,	3579545,	0},
+	{DEVID_MSM5205,	384000,		0},
+	{DEVID_K005289,	3579545,	0},
+	{DEVID_ICS2115,	33868800,	0},
+	{DEVID_MSM5232,	2000000,	0},
+	{DEVID_BSMT2000,	24000000,	0},
+	{0xFF, 0, 0}
+};
+
+// cores with band-limited step output
+static const CORE_OPTION BLEP_LIST[] =
+{
+	{DEVID_SN76496,	FCC_MAME,	OPT_SN76496_BLEP},
+	{DEVID_AY8910,	FCC_MAME,	OPT_AY8910_BLEP},
+	{DEVID_GB_DMG,	FCC_MAME,	OPT_GB_DMG_BLEP},
+	{DEVID_NES_APU,	FCC_MAME,	OPT_NES_BLEP},
+	{0xFF, 0, 0}
+};
+
+static const DEV_PARAMS* GetDeviceParams(DEV_ID devID);
+static UINT32 GetBlepOption(DEV_ID devID, UINT32 coreID);
+static void InitDeviceConfig(DEV_CONFIG* cfg, DEV_ID devID, UINT8 srMode);
+static UINT8 StartDevice(const DEV_DEF* devDef, DEV_ID devID, UINT8 srMode, UINT32 coreOpts, DEV_INFO* devInf, WRITE_STREAM* ws);
+static void DoRegWrites(const DEV_INFO* devInf, WRITE_STREAM* ws);
+static double GetElapsedTime(clock_t startTime);
+static double MeasureUpdate(const DEV_DEF* devDef, DEV_ID devID, UINT8 srMode, UINT32* retSmplRate);
+static double MeasureResample(const DEV_DEF* devDef, DEV_ID devID, UINT8 srMode, UINT32 coreOpts);
+static void GetCoreFCC(UINT32 coreID, char* buffer);
+static void PrintJSONString(const char* str);
+static int MatchesFilter(const char* devName, const char* coreFCC, int argc, char* argv[], int argbase);
+
+static UINT8* romData;
+static double measureSecs;
+static unsigned int measureRuns;
+
+int main(int argc, char* argv[])
+{
+	static const UINT8 SR_MODES[] = {DEVRI_SRMODE_NATIVE, DEVRI_SRMODE_CUSTOM};
+	static const char* SR_MODE_NAMES[] = {"native", "custom"};
+	const DEV_DECL* const* curDecl;
+	int argbase = 1;
+	int firstEntry = 1;
+	UINT32 curPos;
+	UINT32 rngState;
+	
+	measureSecs = DEF_SECONDS;
+	measureRuns = DEF_RUNS;
+	while (argbase + 1 < argc && argv[argbase][0] == '-')
+	{
+		if (! strcmp(argv[argbase], "-s"))
+			measureSecs = atof(argv[argbase + 1]);
+		else if (! strcmp(argv[argbase], "-r"))
+			measureRuns = (unsigned int)strtoul(argv[argbase + 1], NULL, 0);
+		else
+			break;
+		argbase += 2;
+	}
+	if (measureSecs <= 0.0 || ! measureRuns || (argbase < argc && argv[argbase][0] == '-'))
+	{
+		printf("Usage: %s [-s seconds] [-r runs] [device/core filter ...]\n", argv[0]);
+		printf("Renders with every sound core for %.2f seconds (default), %u times (default)\n", DEF_SECONDS, DEF_RUNS);
+		printf("and prints the speed of the fastest run as JSON.\n");
+		return 1;
+	}
+	
+	// pseudo-random sample data, so that PCM devices have something to play
+	romData = (UINT8*)malloc(ROM_SIZE);
+	rngState = 0x12345678;
+	for (curPos = 0; curPos < ROM_SIZE; curPos ++)
+	{
+		rngState = rngState * 1103515245 + 12345;
+		romData[curPos] = (UINT8)(rngState >> 24);
+	}
+	
+	printf("{\n");
+	printf("\t\"outSampleRate\": %u,\n", OUT_SMPL_RATE);
+	printf("\t\"seconds\": %.2f,\n", measureSecs);
+	printf("\t\"runs\": %u,\n", measureRuns);
+	printf("\t\"writesPerSecond\": %u,\n", OUT_SMPL_RATE * BLOCK_WRITES / BLOCK_SMPLS);
+	printf("\t\"cores\": [");
+	for (curDecl = sndEmu_Devices; *curDecl != NULL; curDecl ++)
+	{
+		const DEV_DECL* devDecl = *curDecl;
+		const DEV_DEF* const* curCore;
+		DEV_CONFIG devCfg;
+		const char* devName;
+		
+		InitDeviceConfig(&devCfg, devDecl->deviceID, DEVRI_SRMODE_NATIVE);
+		devName = devDecl->name(&devCfg.gen);
+		for (curCore = devDecl->cores; *curCore != NULL; curCore ++)
+		{
+			const DEV_DEF* devDef = *curCore;
+			char coreFCC[5];
+			size_t curMode;
+			
+			GetCoreFCC(devDef->coreID, coreFCC);
+			if (! MatchesFilter(devName, coreFCC, argc, argv, argbase))
+				continue;
+			
+			for (curMode = 0; curMode < sizeof(SR_MODES) / sizeof(SR_MODES[0]); curMode ++)
+			{
+				UINT32 smplRate;
+				UINT32 blepOpts;
+				double updSpeed;
+				double rsmplSpeed;
+				double blepSpeed;
+				
+				fprintf(stderr, "%s (%s), %s ...\n", devName, coreFCC, SR_MODE_NAMES[curMode]);
+				updSpeed = MeasureUpdate(devDef, devDecl->deviceID, SR_MODES[curMode], &smplRate);
+				rsmplSpeed = (updSpeed >= 0.0) ? MeasureResample(devDef, devDecl->deviceID, SR_MODES[curMode], 0x00) : -1.0;
+				// in custom mode, the cores already run at the output rate
+				blepOpts = (SR_MODES[curMode] == DEVRI_SRMODE_NATIVE) ? GetBlepOption(devDecl->deviceID, devDef->coreID) : 0x00;
+				blepSpeed = (updSpeed >= 0.0 && blepOpts) ?
+					MeasureResample(devDef, devDecl->deviceID, SR_MODES[curMode], blepOpts) : -1.0;
+				
+				printf("%s\n\t\t{\"device\": ", firstEntry ? "" : ",");
+				firstEntry = 0;
+				PrintJSONString(devName);
+				printf(", \"deviceID\": %u, \"core\": ", devDecl->deviceID);
+				PrintJSONString(coreFCC);
+				printf(", \"coreName\": ");
+				PrintJSONString(devDef->name);
+				printf(", \"srMode\": \"%s\"", SR_MODE_NAMES[curMode]);
+				if (updSpeed < 0.0)
+				{
+					printf(", \"error\": \"unable to start\"}");
+					continue;
+				}
+				printf(", \"sampleRate\": %u", smplRate);
+				printf(",\n\t\t\t\"update\": {\"samplesPerSec\": %.0f, \"realtime\": %.2f}",
+					updSpeed, (smplRate > 0) ? updSpeed / smplRate : 0.0);
+				printf(",\n\t\t\t\"resample\": {\"samplesPerSec\": %.0f, \"realtime\": %.2f}",
+					rsmplSpeed, rsmplSpeed / OUT_SMPL_RATE);
+				if (blepSpeed >= 0.0)
+					printf(",\n\t\t\t\"blep\": {\"samplesPerSec\": %.0f, \"realtime\": %.2f}",
+						blepSpeed, blepSpeed / OUT_SMPL_RATE);
+				printf("}");
+			}
+		}
+	}
+	printf("\n\t]\n");
+	printf("}\n");
+	
+	free(romData);
+	return 0;
+}
+
+static const DEV_PARAMS* GetDeviceParams(DEV_ID devID)
+{
+	const DEV_PARAMS* dp;
+	
+	for (dp = DEV_LIST; dp->devID != 0xFF; dp ++)
+	{
+		if (dp->devID == devID)
+			return dp;
+	}
+	return NULL;
+}
+
+static UINT32 GetBlepOption(DEV_ID devID, UINT32 coreID)
+{
+	const CORE_OPTION* co;
+	
+	for (co = BLEP_LIST; co->devID != 0xFF; co ++)
+	{
+		if (co->devID == devID && co->coreID == coreID)
+			return co->options;
+	}
+	return 0x00;
+}
+
+static void InitDeviceConfig(DEV_CONFIG* cfg, DEV_ID devID, UINT8 srMode)
+{
+	const DEV_PARAMS* dp;
+	
+	memset(cfg, 0x00, sizeof(DEV_CONFIG));
+	cfg->gen.emuCore = 0x00;
+	cfg->gen.srMode = srMode;
+	cfg->gen.flags = 0x00;
+	cfg->gen.clock = 4000000;	// fallback for devices that aren't in the list
+	cfg->gen.smplRate = OUT_SMPL_RATE;
+	dp = GetDeviceParams(devID);
+	if (dp != NULL)
+	{
+		cfg->gen.clock = dp->clock;
+		cfg->gen.flags = dp->flags;
+	}
+	
+	switch(devID)
+	{
+	case DEVID_SN76496:
+		cfg->sn.noiseTaps = 0x09;
+		cfg->sn.shiftRegWidth = 0x10;
+		cfg->sn.negate = 1;
+		cfg->sn.clkDiv = 8;
+		cfg->sn.ncrPSG = 0;
+		cfg->sn.segaPSG = 1;
+		cfg->sn.stereo = 1;
+		cfg->sn.t6w28_tone = NULL;
+		break;
+	case DEVID_SEGAPCM:
+		cfg->spcm.bnkshift = 0x00;
+		cfg->spcm.bnkmask = 0x70;
+		break;
+	case DEVID_AY8910:
+		cfg->ay.chipType = 0x00;	// AY-3-8910
+		cfg->ay.chipFlags = 0x01;
+		break;
+	case DEVID_OKIM6258:
+		cfg->oki.divider = 0;
+		cfg->oki.adpcmBits = 0;
+		cfg->oki.outputBits = 0;
+		break;
+	case DEVID_MSM5232:
+		{
+			int curCap;
+			for (curCap = 0; curCap < 8; curCap ++)
+				cfg->msm.capacitors[curCap] = 1e-6;
+		}
+		break;
+	}
+	
+	return;
+}
+
+static UINT8 StartDevice(const DEV_DEF* devDef, DEV_ID devID, UINT8 srMode, UINT32 coreOpts, DEV_INFO* devInf, WRITE_STREAM* ws)
+{
+	static const UINT8 RW_TYPES[] = {DEVRW_A8D8, DEVRW_A16D8, DEVRW_A8D16, DEVRW_A16D16};
+	DEV_CONFIG devCfg;
+	DEVFUNC_WRITE_MEMSIZE memSizeFunc;
+	DEVFUNC_WRITE_BLOCK blockFunc;
+	size_t curType;
+	UINT8 retVal;
+	
+	InitDeviceConfig(&devCfg, devID, srMode);
+	devCfg.gen.emuCore = devDef->coreID;
+	retVal = SndEmu_Start2(devID, &devCfg.gen, devInf, NULL, 0x00);
+	if (retVal)
+		return retVal;
+	SndEmu_FreeDevLinkData(devInf);	// linked devices (e.g. the SSG of OPN chips) aren't benchmarked
+	if (coreOpts && devInf->devDef->SetOptionBits != NULL)
+		devInf->devDef->SetOptionBits(devInf->dataPtr, coreOpts);	// may change the sample rate
+	devInf->devDef->Reset(devInf->dataPtr);
+	
+	if (! SndEmu_GetDeviceFunc(devInf->devDef, RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 0, (void**)&memSizeFunc) &&
+		! SndEmu_GetDeviceFunc(devInf->devDef, RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 0, (void**)&blockFunc))
+	{
+		memSizeFunc(devInf->dataPtr, ROM_SIZE);
+		blockFunc(devInf->dataPtr, 0x00, ROM_SIZE, romData);
+	}
+	
+	ws->writeFunc = NULL;
+	ws->rwType = 0x00;
+	for (curType = 0; curType < sizeof(RW_TYPES) / sizeof(RW_TYPES[0]); curType ++)
+	{
+		if (SndEmu_GetDeviceFunc(devInf->devDef, RWF_REGISTER | RWF_WRITE, RW_TYPES[curType], 0, &ws->writeFunc) < 0x80)
+		{
+			ws->rwType = RW_TYPES[curType];
+			break;
+		}
+		ws->writeFunc = NULL;
+	}
+	// 16-bit address spaces are mostly empty, so limit the range to where the registers usually are
+	ws->addrMask = (ws->rwType & 0x20) ? 0x3FF : 0xFF;
+	ws->rngState = 0x1234 + devID;
+	
+	return 0x00;
+}
+
+static void DoRegWrites(const DEV_INFO* devInf, WRITE_STREAM* ws)
+{
+	UINT32 curWrt;
+	
+	if (ws->writeFunc == NULL)
+		return;
+	for (curWrt = 0; curWrt < BLOCK_WRITES; curWrt ++)
+	{
+		UINT16 addr;
+		UINT16 data;
+		
+		ws->rngState = ws->rngState * 1103515245 + 12345;
+		addr = (UINT16)(ws->rngState >> 16) & ws->addrMask;
+		ws->rngState = ws->rngState * 1103515245 + 12345;
+		data = (UINT16)(ws->rngState >> 16);
+		switch(ws->rwType)
+		{
+		case DEVRW_A8D8:
+			((DEVFUNC_WRITE_A8D8)ws->writeFunc)(devInf->dataPtr, (UINT8)addr, (UINT8)data);
+			break;
+		case DEVRW_A16D8:
+			((DEVFUNC_WRITE_A16D8)ws->writeFunc)(devInf->dataPtr, addr, (UINT8)data);
+			break;
+		case DEVRW_A8D16:
+			((DEVFUNC_WRITE_A8D16)ws->writeFunc)(devInf->dataPtr, (UINT8)addr, data);
+			break;
+		case DEVRW_A16D16:
+			((DEVFUNC_WRITE_A16D16)ws->writeFunc)(devInf->dataPtr, addr, data);
+			break;
+		}
+	}
+	
+	return;
+}
+
+static double GetElapsedTime(clock_t startTime)
+{
+	return (double)(clock() - startTime) / CLOCKS_PER_SEC;
+}
+
+// returns samples per second or -1.0 on error
+static double MeasureUpdate(const DEV_DEF* devDef, DEV_ID devID, UINT8 srMode, UINT32* retSmplRate)
+{
+	DEV_SMPL* smplBufs[2];
+	double bestSpeed;
+	unsigned int curRun;
+	
+	smplBufs[0] = (DEV_SMPL*)malloc(BLOCK_SMPLS * sizeof(DEV_SMPL));
+	smplBufs[1] = (DEV_SMPL*)malloc(BLOCK_SMPLS * sizeof(DEV_SMPL));
+	*retSmplRate = 0;
+	bestSpeed = 0.0;
+	for (curRun = 0; curRun < measureRuns; curRun ++)
+	{
+		DEV_INFO devInf;
+		WRITE_STREAM ws;
+		UINT64 renderSmpls;
+		UINT32 curBlk;
+		clock_t startTime;
+		double runTime;
+		
+		if (StartDevice(devDef, devID, srMode, 0x00, &devInf, &ws))
+		{
+			free(smplBufs[0]);	free(smplBufs[1]);
+			return -1.0;
+		}
+		*retSmplRate = devInf.sampleRate;
+		renderSmpls = 0;
+		startTime = clock();
+		do
+		{
+			for (curBlk = 0; curBlk < CHECK_BLOCKS; curBlk ++)
+			{
+				DoRegWrites(&devInf, &ws);
+				devInf.devDef->Update(devInf.dataPtr, BLOCK_SMPLS, smplBufs);
+			}
+			renderSmpls += CHECK_BLOCKS * BLOCK_SMPLS;
+			runTime = GetElapsedTime(startTime);
+		} while(runTime < measureSecs);
+		SndEmu_Stop(&devInf);
+		if (renderSmpls / runTime > bestSpeed)
+			bestSpeed = renderSmpls / runTime;
+	}
+	free(smplBufs[0]);	free(smplBufs[1]);
+	
+	return bestSpeed;
+}
+
+// returns output samples per second or -1.0 on error
+static double MeasureResample(const DEV_DEF* devDef, DEV_ID devID, UINT8 srMode, UINT32 coreOpts)
+{
+	WAVE_32BS* smplData;
+	double bestSpeed;
+	unsigned int curRun;
+	
+	smplData = (WAVE_32BS*)calloc(BLOCK_SMPLS, sizeof(WAVE_32BS));
+	bestSpeed = 0.0;
+	for (curRun = 0; curRun < measureRuns; curRun ++)
+	{
+		RESMPL_STATE rs;
+		DEV_INFO devInf;
+		WRITE_STREAM ws;
+		UINT64 renderSmpls;
+		UINT32 curBlk;
+		clock_t startTime;
+		double runTime;
+		
+		if (StartDevice(devDef, devID, srMode, coreOpts, &devInf, &ws))
+		{
+			free(smplData);
+			return -1.0;
+		}
+		memset(&rs, 0x00, sizeof(RESMPL_STATE));
+		Resmpl_SetVals(&rs, RSMODE_LINEAR, 0x100, OUT_SMPL_RATE);
+		Resmpl_DevConnect(&rs, &devInf);
+		Resmpl_Init(&rs);
+		renderSmpls = 0;
+		startTime = clock();
+		do
+		{
+			for (curBlk = 0; curBlk < CHECK_BLOCKS; curBlk ++)
+			{
+				DoRegWrites(&devInf, &ws);
+				Resmpl_Execute(&rs, BLOCK_SMPLS, smplData);
+			}
+			renderSmpls += CHECK_BLOCKS * BLOCK_SMPLS;
+			runTime = GetElapsedTime(startTime);
+		} while(runTime < measureSecs);
+		Resmpl_Deinit(&rs);
+		SndEmu_Stop(&devInf);
+		if (renderSmpls / runTime > bestSpeed)
+			bestSpeed = renderSmpls / runTime;
+	}
+	free(smplData);
+	
+	return bestSpeed;
+}
+
+static void GetCoreFCC(UINT32 coreID, char* buffer)
+{
+	int curShift;
+	
+	// some FCCs use less than 4 characters (padded with '\0')
+	for (curShift = 24; curShift >= 0; curShift -= 8)
+	{
+		char c = (char)((coreID >> curShift) & 0xFF);
+		if (c != '\0')
+			*buffer++ = c;
+	}
+	*buffer = '\0';
+	return;
+}
+
+static void PrintJSONString(const char* str)
+{
+	putchar('"');
+	for (; *str != '\0'; str ++)
+	{
+		if (*str == '"' || *str == '\\')
+			printf("\\%c", *str);
+		else if ((unsigned char)*str < 0x20)
+			printf("\\u%04X", (unsigned char)*str);
+		else
+			putchar(*str);
+	}
+	putchar('"');
+	return;
+}
+
+static int MatchesFilter(const char* devName, const char* coreFCC, int argc, char* argv[], int argbase)
+{
+	int curArg;
+	
+	if (argbase >= argc)
+		return 1;	// no filter - run everything
+	for (curArg = argbase; curArg < argc; curArg ++)
+	{
+		if (strstr(devName, argv[curArg]) != NULL || strstr(coreFCC, argv[curArg]) != NULL)
+			return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,274 @@
+// Sound Core Golden Output Test
+// -----------------------------
+// Renders a fixed pseudo-random register stream with selected sound cores and compares a
+// checksum of the output with the stored value.
+// This is used to verify that optimizations of a core don't change its output.
+// The register streams are made for the respective chip, so that all features of the core
+// are used (key on/off, special modes, DAC, timers, buffer overflows, channel muting).
+// Usage: emu_golden [-u]
+//	-u prints the current checksums in the format of the GOLDEN_LIST table
+// The program returns 0 when all checksums match.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "stdtype.h"
+#include "emu/EmuStructs.h"
+#include "emu/SoundEmu.h"
+#include "emu/SoundDevs.h"
+#include "emu/EmuCores.h"
+#include "emu/cores/2612intf.h"
+
+#define OUT_SMPL_RATE	44100
+#define TEST_BLOCKS		3000	// number of register write blocks per test
+#define MAX_BLOCK_SMPLS	300		// maximum number of samples rendered between register writes
+
+typedef struct _write_stream WRITE_STREAM;
+typedef void (*STREAM_FUNC)(const DEV_INFO* devInf, WRITE_STREAM* ws);
+struct _write_stream
+{
+	DEVFUNC_WRITE_A8D8 writeFunc;
+	DEVFUNC_READ_A8D8 readFunc;
+	UINT32 rngState;
+};
+
+typedef struct _golden_test
+{
+	DEV_ID devID;
+	UINT32 coreID;
+	UINT32 clock;
+	UINT8 srMode;
+	UINT32 options;
+	STREAM_FUNC streamFunc;
+	UINT32 checksum;
+} GOLDEN_TEST;
+
+static void Stream_OPN2(const DEV_INFO* devInf, WRITE_STREAM* ws);
+
+static const GOLDEN_TEST GOLDEN_LIST[] =
+{
+	{DEVID_YM2612,	FCC_NUKE,	7670453,	DEVRI_SRMODE_NATIVE,	OPT_YM2612_TYPE_OPN2,	Stream_OPN2,	0x68DA1C42},
+	{DEVID_YM2612,	FCC_NUKE,	7670453,	DEVRI_SRMODE_CUSTOM,	OPT_YM2612_TYPE_OPN2,	Stream_OPN2,	0x4EF479D2},
+	{DEVID_YM2612,	FCC_NUKE,	7670453,	DEVRI_SRMODE_NATIVE,	OPT_YM2612_TYPE_OPN2C_ASIC,	Stream_OPN2,	0x62699D4E},
+	{DEVID_YM2612,	FCC_NUKE,	7670453,	DEVRI_SRMODE_NATIVE,	OPT_YM2612_TYPE_OPN2C_DISC,	Stream_OPN2,	0x68DA1C42},
+	{DEVID_YM2612,	FCC_NUKE,	7670453,	DEVRI_SRMODE_CUSTOM,	0x30,	Stream_OPN2,	0x5BE1F270},	// YM2612 + MD1 filter
+	{DEVID_YM2612,	FCC_GPGX,	7670453,	DEVRI_SRMODE_NATIVE,	0x00,	Stream_OPN2,	0x12B3BAC1},
+	{DEVID_YM2612,	FCC_GPGX,	7670453,	DEVRI_SRMODE_CUSTOM,	0x00,	Stream_OPN2,	0xAC17BFC0},
+	{0xFF, 0, 0, 0, 0, NULL, 0}
+};
+
+static UINT32 NextRandom(WRITE_STREAM* ws, UINT32 range);
+static UINT8 RunTest(const GOLDEN_TEST* gt, UINT32* retChecksum);
+static void GetCoreFCC(UINT32 coreID, char* buffer);
+
+int main(int argc, char* argv[])
+{
+	const GOLDEN_TEST* gt;
+	int updateMode = 0;
+	unsigned int failCnt = 0;
+
+	if (argc > 1)
+	{
+		if (strcmp(argv[1], "-u"))
+		{
+			printf("Usage: %s [-u]\n", argv[0]);
+			printf("Compares the output of sound cores with stored checksums.\n");
+			printf("-u prints the current checksums for updating the table.\n");
+			return 1;
+		}
+		updateMode = 1;
+	}
+
+	for (gt = GOLDEN_LIST; gt->streamFunc != NULL; gt ++)
+	{
+		const DEV_DECL* devDecl = SndEmu_GetDevDecl(gt->devID, NULL, 0x00);
+		char coreFCC[5];
+		UINT32 checksum;
+		UINT8 retVal;
+
+		GetCoreFCC(gt->coreID, coreFCC);
+		retVal = RunTest(gt, &checksum);
+		if (updateMode)
+		{
+			printf("%s (%s), %s, options 0x%02X: 0x%08X\n", (devDecl != NULL) ? devDecl->name(NULL) : "???",
+				coreFCC, (gt->srMode == DEVRI_SRMODE_NATIVE) ? "native" : "custom", gt->options, checksum);
+			continue;
+		}
+		printf("%s (%s), %s, options 0x%02X: ", (devDecl != NULL) ? devDecl->name(NULL) : "???",
+			coreFCC, (gt->srMode == DEVRI_SRMODE_NATIVE) ? "native" : "custom", gt->options);
+		if (retVal)
+		{
+			printf("unable to start\n");
+			failCnt ++;
+		}
+		else if (checksum != gt->checksum)
+		{
+			printf("FAILED (0x%08X, expected 0x%08X)\n", checksum, gt->checksum);
+			failCnt ++;
+		}
+		else
+		{
+			printf("OK\n");
+		}
+	}
+	if (updateMode)
+		return 0;
+
+	if (failCnt)
+		printf("%u test(s) failed.\n", failCnt);
+	else
+		printf("All tests passed.\n");
+	return failCnt ? 1 : 0;
+}
+
+static UINT32 NextRandom(WRITE_STREAM* ws, UINT32 range)
+{
+	ws->rngState = ws->rngState * 1103515245 + 12345;
+	return (ws->rngState >> 8) % range;
+}
+
+// YM2612/YM3438
+static void Stream_OPN2(const DEV_INFO* devInf, WRITE_STREAM* ws)
+{
+	UINT32 writeCnt;
+	UINT32 curWrt;
+
+	writeCnt = NextRandom(ws, 40);
+	if (NextRandom(ws, 50) == 0)
+		writeCnt = 600 + NextRandom(ws, 3000);	// overflow the write buffer of the Nuked core
+	for (curWrt = 0; curWrt < writeCnt; curWrt ++)
+	{
+		UINT32 type = NextRandom(ws, 100);
+		UINT8 port = (UINT8)NextRandom(ws, 2) * 2;
+		UINT8 data = (UINT8)NextRandom(ws, 0x100);
+		UINT8 addr;
+
+		if (type < 10)
+		{
+			port = 0;	addr = 0x28;	// key on/off
+			data = (UINT8)((NextRandom(ws, 0x10) << 4) | NextRandom(ws, 7));
+		}
+		else if (type < 14)
+		{
+			port = 0;	addr = 0x2A;	// DAC data
+		}
+		else if (type < 15)
+		{
+			port = 0;	addr = 0x2B;	// DAC enable
+		}
+		else if (type < 17)
+		{
+			port = 0;	addr = 0x27;	// CH3 mode/CSM, timer control
+		}
+		else if (type < 19)
+		{
+			port = 0;	addr = (UINT8)(0x24 + NextRandom(ws, 3));	// timers
+		}
+		else if (type < 20)
+		{
+			port = 0;	addr = 0x22;	// LFO
+		}
+		else if (type < 21 && NextRandom(ws, 20) == 0)
+		{
+			port = 0;	addr = NextRandom(ws, 2) ? 0x21 : 0x2C;	// test registers
+			data &= (UINT8)NextRandom(ws, 0x100);
+		}
+		else if (type < 50)
+		{
+			addr = (UINT8)(0x30 + NextRandom(ws, 0x70));	// operator registers
+		}
+		else
+		{
+			addr = (UINT8)(0xA0 + NextRandom(ws, 0x17));	// channel registers
+		}
+		ws->writeFunc(devInf->dataPtr, port + 0, addr);
+		ws->writeFunc(devInf->dataPtr, port + 1, data);
+		if (ws->readFunc != NULL && NextRandom(ws, 200) == 0)
+			ws->readFunc(devInf->dataPtr, (UINT8)NextRandom(ws, 4));
+	}
+	if (devInf->devDef->SetMuteMask != NULL && NextRandom(ws, 100) == 0)
+		devInf->devDef->SetMuteMask(devInf->dataPtr, NextRandom(ws, 0x80));
+
+	return;
+}
+
+// returns FNV-1a hash of the output
+static UINT8 RunTest(const GOLDEN_TEST* gt, UINT32* retChecksum)
+{
+	DEV_GEN_CFG devCfg;
+	DEV_INFO devInf;
+	WRITE_STREAM ws;
+	DEV_SMPL* smplBufs[2];
+	UINT32 hash;
+	UINT32 curBlk;
+	UINT32 curSmpl;
+	UINT8 curChn;
+	UINT8 retVal;
+
+	memset(&devCfg, 0x00, sizeof(DEV_GEN_CFG));
+	devCfg.emuCore = gt->coreID;
+	devCfg.srMode = gt->srMode;
+	devCfg.flags = 0x00;
+	devCfg.clock = gt->clock;
+	devCfg.smplRate = OUT_SMPL_RATE;
+	retVal = SndEmu_Start2(gt->devID, &devCfg, &devInf, NULL, 0x00);
+	if (retVal)
+	{
+		*retChecksum = 0;
+		return retVal;
+	}
+	SndEmu_FreeDevLinkData(&devInf);	// linked devices aren't tested here
+	if (devInf.devDef->SetOptionBits != NULL)
+		devInf.devDef->SetOptionBits(devInf.dataPtr, gt->options);
+	devInf.devDef->Reset(devInf.dataPtr);
+
+	ws.writeFunc = NULL;
+	ws.readFunc = NULL;
+	SndEmu_GetDeviceFunc(devInf.devDef, RWF_REGISTER | RWF_WRITE, DEVRW_A8D8, 0, (void**)&ws.writeFunc);
+	SndEmu_GetDeviceFunc(devInf.devDef, RWF_REGISTER | RWF_READ, DEVRW_A8D8, 0, (void**)&ws.readFunc);
+	ws.rngState = 1;
+
+	smplBufs[0] = (DEV_SMPL*)malloc(MAX_BLOCK_SMPLS * sizeof(DEV_SMPL));
+	smplBufs[1] = (DEV_SMPL*)malloc(MAX_BLOCK_SMPLS * sizeof(DEV_SMPL));
+	hash = 0x811C9DC5;
+	for (curBlk = 0; curBlk < TEST_BLOCKS; curBlk ++)
+	{
+		UINT32 smplCnt;
+
+		if (ws.writeFunc != NULL)
+			gt->streamFunc(&devInf, &ws);
+		smplCnt = 1 + NextRandom(&ws, MAX_BLOCK_SMPLS);
+		devInf.devDef->Update(devInf.dataPtr, smplCnt, smplBufs);
+		for (curChn = 0; curChn < 2; curChn ++)
+		{
+			for (curSmpl = 0; curSmpl < smplCnt; curSmpl ++)
+			{
+				UINT32 smpl = (UINT32)smplBufs[curChn][curSmpl];
+				UINT8 curByte;
+
+				for (curByte = 0; curByte < 4; curByte ++, smpl >>= 8)
+					hash = (hash ^ (smpl & 0xFF)) * 0x01000193;
+			}
+		}
+	}
+	SndEmu_Stop(&devInf);
+	free(smplBufs[0]);	free(smplBufs[1]);
+
+	*retChecksum = hash;
+	return 0x00;
+}
+
+static void GetCoreFCC(UINT32 coreID, char* buffer)
+{
+	int curShift;
+
+	// some FCCs use less than 4 characters (padded with '\0')
+	for (curShift = 24; curShift >= 0; curShift -= 8)
+	{
+		char c = (char)((coreID >> curShift) & 0xFF);
+		if (c != '\0')
+			*buffer++ = c;
+	}
+	*buffer = '\0';
+	return;
+}
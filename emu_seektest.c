@@ -0,0 +1,402 @@
+// Sound Core Seek Test
+// --------------------
+// Checks that skipping output with Resmpl_Advance leaves a sound core in the same state
+// as rendering the output with Resmpl_Execute. VGMPlayer uses this for accurate seeking.
+// Every core that has an advance function (RWF_ADVANCE) is started twice. Both instances
+// get the same pseudo-random register writes. The first one renders everything, the second
+// one skips the "seek" parts. The output after each seek has to be identical.
+// Each core is tested in native and custom (44100 Hz) sample rate mode with all resampling modes.
+// Optional arguments filter the cores by device name or core FCC (case-sensitive substring).
+// The program returns 0 when all tests pass.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "stdtype.h"
+#include "emu/EmuStructs.h"
+#include "emu/SoundEmu.h"
+#include "emu/SoundDevs.h"
+#include "emu/EmuCores.h"
+#include "emu/Resampler.h"
+
+#define OUT_SMPL_RATE	44100
+#define TEST_CYCLES		4		// number of seek + compare cycles per test
+#define SEEK_SMPLS		44100	// samples skipped per seek
+#define CMP_SMPLS		11025	// samples compared after each seek
+#define MAX_BLOCK_SMPLS	1000	// maximum number of samples rendered between register writes
+#define BLOCK_WRITES	8		// register writes per block
+#define ROM_SIZE		0x100000
+
+typedef struct _device_params
+{
+	DEV_ID devID;
+	UINT32 clock;
+	UINT8 ports;		// number of address/data port pairs, 0 = write to random offsets
+	UINT16 addrMask;	// mask for register numbers (ports > 0) or offsets (ports == 0)
+} DEV_PARAMS;
+
+typedef struct _write_stream
+{
+	void* writeFunc;
+	UINT8 rwType;
+	UINT8 ports;
+	UINT16 addrMask;
+	UINT32 rngState;
+} WRITE_STREAM;
+
+typedef struct _test_device
+{
+	DEV_INFO devInf;
+	RESMPL_STATE resmpl;
+} TEST_DEVICE;
+
+// typical clocks (as used by VGM files)
+static const DEV_PARAMS DEV_LIST[] =
+{
+	{DEVID_YM2612,	7670453,	2,	0xFF},
+	{DEVID_YM2151,	3579545,	1,	0xFF},
+	{DEVID_YM2203,	3993600,	1,	0xFF},
+	{DEVID_YM2608,	7987200,	2,	0xFF},
+	{DEVID_YM2610,	8000000,	2,	0xFF},
+	{DEVID_YM3812,	3579545,	1,	0xFF},
+	{DEVID_YM3526,	3579545,	1,	0xFF},
+	{DEVID_Y8950,	3579545,	1,	0xFF},
+	{DEVID_YMF262,	14318180,	2,	0xFF},
+	{DEVID_OKIM6295,	1000000,	0,	0x00},	// only the command register, the others change the clock
+	{DEVID_C352,	24192000,	0,	0x3FF},
+	{DEVID_QSOUND,	60000000,	0,	0x03},
+	{0xFF, 0, 0, 0}
+};
+
+static const DEV_PARAMS DEF_PARAMS = {0xFF, 4000000, 0, 0xFF};	// for devices that aren't in the list
+
+static const UINT8 RS_MODES[] = {RSMODE_LINEAR, RSMODE_NEAREST, RSMODE_LUP_NDWN, RSMODE_SINC};
+static const char* RS_MODE_NAMES[] = {"linear", "nearest", "lup_ndwn", "sinc"};
+
+static const DEV_PARAMS* GetDeviceParams(DEV_ID devID);
+static UINT8 StartDevice(const DEV_DEF* devDef, DEV_ID devID, UINT8 srMode, UINT8 rsMode, TEST_DEVICE* tDev);
+static void StopDevice(TEST_DEVICE* tDev);
+static void InitWriteStream(const DEV_INFO* devInf, DEV_ID devID, WRITE_STREAM* ws);
+static UINT32 NextRandom(WRITE_STREAM* ws, UINT32 range);
+static void DeviceWrite(const DEV_INFO* devInf, const WRITE_STREAM* ws, UINT16 addr, UINT16 data);
+static void DoRegWrites(TEST_DEVICE* tDevs, WRITE_STREAM* ws);
+static UINT8 RunTest(const DEV_DEF* devDef, DEV_ID devID, UINT8 srMode, UINT8 rsMode, UINT32* retFailPos);
+static void GetCoreFCC(UINT32 coreID, char* buffer);
+static int MatchesFilter(const char* devName, const char* coreFCC, int argc, char* argv[]);
+
+static UINT8* romData;
+
+int main(int argc, char* argv[])
+{
+	static const UINT8 SR_MODES[] = {DEVRI_SRMODE_NATIVE, DEVRI_SRMODE_CUSTOM};
+	static const char* SR_MODE_NAMES[] = {"native", "custom"};
+	const DEV_DECL* const* curDecl;
+	unsigned int testCnt = 0;
+	unsigned int failCnt = 0;
+	UINT32 curPos;
+	UINT32 rngState;
+
+	if (argc > 1 && argv[1][0] == '-')
+	{
+		printf("Usage: %s [device/core filter ...]\n", argv[0]);
+		printf("Compares seeking with Resmpl_Advance against rendering for all cores with an advance function.\n");
+		return 1;
+	}
+
+	// pseudo-random sample data, so that PCM devices have something to play
+	romData = (UINT8*)malloc(ROM_SIZE);
+	rngState = 0x12345678;
+	for (curPos = 0; curPos < ROM_SIZE; curPos ++)
+	{
+		rngState = rngState * 1103515245 + 12345;
+		romData[curPos] = (UINT8)(rngState >> 24);
+	}
+
+	for (curDecl = sndEmu_Devices; *curDecl != NULL; curDecl ++)
+	{
+		const DEV_DECL* devDecl = *curDecl;
+		const DEV_DEF* const* curCore;
+		const char* devName = devDecl->name(NULL);
+
+		for (curCore = devDecl->cores; *curCore != NULL; curCore ++)
+		{
+			const DEV_DEF* devDef = *curCore;
+			DEVFUNC_ADVANCE advFunc;
+			char coreFCC[5];
+			size_t curSRMode;
+			size_t curRSMode;
+
+			if (SndEmu_GetDeviceFunc(devDef, RWF_ADVANCE | RWF_WRITE, DEVRW_VALUE, 0, (void**)&advFunc))
+				continue;	// The resampler renders and discards the output for these cores.
+			GetCoreFCC(devDef->coreID, coreFCC);
+			if (! MatchesFilter(devName, coreFCC, argc, argv))
+				continue;
+
+			for (curSRMode = 0; curSRMode < sizeof(SR_MODES) / sizeof(SR_MODES[0]); curSRMode ++)
+			{
+				for (curRSMode = 0; curRSMode < sizeof(RS_MODES) / sizeof(RS_MODES[0]); curRSMode ++)
+				{
+					UINT32 failPos;
+					UINT8 retVal;
+
+					printf("%s (%s), %s, %s: ", devName, coreFCC, SR_MODE_NAMES[curSRMode], RS_MODE_NAMES[curRSMode]);
+					fflush(stdout);
+					testCnt ++;
+					retVal = RunTest(devDef, devDecl->deviceID, SR_MODES[curSRMode], RS_MODES[curRSMode], &failPos);
+					if (retVal == 0xFF)
+					{
+						printf("unable to start\n");
+						failCnt ++;
+					}
+					else if (retVal)
+					{
+						printf("FAILED (after seek %u, sample %u)\n", retVal, failPos);
+						failCnt ++;
+					}
+					else
+					{
+						printf("OK\n");
+					}
+				}
+			}
+		}
+	}
+	free(romData);
+
+	if (failCnt)
+		printf("%u of %u test(s) failed.\n", failCnt, testCnt);
+	else
+		printf("All %u tests passed.\n", testCnt);
+	return failCnt ? 1 : 0;
+}
+
+static const DEV_PARAMS* GetDeviceParams(DEV_ID devID)
+{
+	const DEV_PARAMS* dp;
+
+	for (dp = DEV_LIST; dp->devID != 0xFF; dp ++)
+	{
+		if (dp->devID == devID)
+			return dp;
+	}
+	return &DEF_PARAMS;
+}
+
+static UINT8 StartDevice(const DEV_DEF* devDef, DEV_ID devID, UINT8 srMode, UINT8 rsMode, TEST_DEVICE* tDev)
+{
+	DEV_GEN_CFG devCfg;
+	DEVFUNC_WRITE_MEMSIZE memSizeFunc;
+	DEVFUNC_WRITE_BLOCK blockFunc;
+	UINT8 retVal;
+
+	memset(&devCfg, 0x00, sizeof(DEV_GEN_CFG));
+	devCfg.emuCore = devDef->coreID;
+	devCfg.srMode = srMode;
+	devCfg.flags = 0x00;
+	devCfg.clock = GetDeviceParams(devID)->clock;
+	devCfg.smplRate = OUT_SMPL_RATE;
+	retVal = SndEmu_Start2(devID, &devCfg, &tDev->devInf, NULL, 0x00);
+	if (retVal)
+		return retVal;
+	SndEmu_FreeDevLinkData(&tDev->devInf);	// linked devices (e.g. the SSG of OPN chips) are tested separately
+	tDev->devInf.devDef->Reset(tDev->devInf.dataPtr);
+
+	if (! SndEmu_GetDeviceFunc(tDev->devInf.devDef, RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 0, (void**)&memSizeFunc) &&
+		! SndEmu_GetDeviceFunc(tDev->devInf.devDef, RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 0, (void**)&blockFunc))
+	{
+		memSizeFunc(tDev->devInf.dataPtr, ROM_SIZE);
+		blockFunc(tDev->devInf.dataPtr, 0x00, ROM_SIZE, romData);
+	}
+
+	memset(&tDev->resmpl, 0x00, sizeof(RESMPL_STATE));
+	Resmpl_SetVals(&tDev->resmpl, rsMode, 0x100, OUT_SMPL_RATE);
+	Resmpl_DevConnect(&tDev->resmpl, &tDev->devInf);
+	Resmpl_Init(&tDev->resmpl);
+
+	return 0x00;
+}
+
+static void StopDevice(TEST_DEVICE* tDev)
+{
+	Resmpl_Deinit(&tDev->resmpl);
+	SndEmu_Stop(&tDev->devInf);
+	return;
+}
+
+static void InitWriteStream(const DEV_INFO* devInf, DEV_ID devID, WRITE_STREAM* ws)
+{
+	static const UINT8 RW_TYPES[] = {DEVRW_A8D8, DEVRW_A16D8, DEVRW_A8D16, DEVRW_A16D16};
+	const DEV_PARAMS* dp = GetDeviceParams(devID);
+	size_t curType;
+
+	ws->writeFunc = NULL;
+	ws->rwType = 0x00;
+	for (curType = 0; curType < sizeof(RW_TYPES) / sizeof(RW_TYPES[0]); curType ++)
+	{
+		if (SndEmu_GetDeviceFunc(devInf->devDef, RWF_REGISTER | RWF_WRITE, RW_TYPES[curType], 0, &ws->writeFunc) < 0x80)
+		{
+			ws->rwType = RW_TYPES[curType];
+			break;
+		}
+		ws->writeFunc = NULL;
+	}
+	ws->ports = dp->ports;
+	ws->addrMask = dp->addrMask;
+	ws->rngState = 0x1234 + devID;
+
+	return;
+}
+
+static UINT32 NextRandom(WRITE_STREAM* ws, UINT32 range)
+{
+	ws->rngState = ws->rngState * 1103515245 + 12345;
+	return (ws->rngState >> 8) % range;
+}
+
+static void DeviceWrite(const DEV_INFO* devInf, const WRITE_STREAM* ws, UINT16 addr, UINT16 data)
+{
+	switch(ws->rwType)
+	{
+	case DEVRW_A8D8:
+		((DEVFUNC_WRITE_A8D8)ws->writeFunc)(devInf->dataPtr, (UINT8)addr, (UINT8)data);
+		break;
+	case DEVRW_A16D8:
+		((DEVFUNC_WRITE_A16D8)ws->writeFunc)(devInf->dataPtr, addr, (UINT8)data);
+		break;
+	case DEVRW_A8D16:
+		((DEVFUNC_WRITE_A8D16)ws->writeFunc)(devInf->dataPtr, (UINT8)addr, data);
+		break;
+	case DEVRW_A16D16:
+		((DEVFUNC_WRITE_A16D16)ws->writeFunc)(devInf->dataPtr, addr, data);
+		break;
+	}
+	return;
+}
+
+// sends the same register writes to both devices
+static void DoRegWrites(TEST_DEVICE* tDevs, WRITE_STREAM* ws)
+{
+	UINT32 curWrt;
+
+	if (ws->writeFunc == NULL)
+		return;
+	for (curWrt = 0; curWrt < BLOCK_WRITES; curWrt ++)
+	{
+		UINT16 addr = (UINT16)NextRandom(ws, (UINT32)ws->addrMask + 1);
+		UINT16 data = (UINT16)NextRandom(ws, 0x10000);
+
+		if (ws->ports)
+		{
+			// register number to the address port, then the value to the data port
+			UINT8 port = (UINT8)NextRandom(ws, ws->ports) * 2;
+			DeviceWrite(&tDevs[0].devInf, ws, port + 0, addr);
+			DeviceWrite(&tDevs[1].devInf, ws, port + 0, addr);
+			DeviceWrite(&tDevs[0].devInf, ws, port + 1, data & 0xFF);
+			DeviceWrite(&tDevs[1].devInf, ws, port + 1, data & 0xFF);
+		}
+		else
+		{
+			DeviceWrite(&tDevs[0].devInf, ws, addr, data);
+			DeviceWrite(&tDevs[1].devInf, ws, addr, data);
+		}
+	}
+
+	return;
+}
+
+// returns 0 if the output matches, 0xFF if the device can't be started or
+// the number of the seek after which the output differs
+static UINT8 RunTest(const DEV_DEF* devDef, DEV_ID devID, UINT8 srMode, UINT8 rsMode, UINT32* retFailPos)
+{
+	TEST_DEVICE tDevs[2];	// [0] renders everything, [1] skips the seek parts
+	WRITE_STREAM ws;
+	WAVE_32BS* smplData[2];
+	UINT32 curCycle;
+	UINT32 smplPos;
+	UINT32 smplCnt;
+	UINT32 curSmpl;
+	UINT8 retVal;
+
+	*retFailPos = 0;
+	if (StartDevice(devDef, devID, srMode, rsMode, &tDevs[0]))
+		return 0xFF;
+	if (StartDevice(devDef, devID, srMode, rsMode, &tDevs[1]))
+	{
+		StopDevice(&tDevs[0]);
+		return 0xFF;
+	}
+	InitWriteStream(&tDevs[0].devInf, devID, &ws);
+	smplData[0] = (WAVE_32BS*)malloc(MAX_BLOCK_SMPLS * sizeof(WAVE_32BS));
+	smplData[1] = (WAVE_32BS*)malloc(MAX_BLOCK_SMPLS * sizeof(WAVE_32BS));
+
+	retVal = 0x00;
+	for (curCycle = 0; curCycle < TEST_CYCLES && ! retVal; curCycle ++)
+	{
+		for (smplPos = 0; smplPos < SEEK_SMPLS; smplPos += smplCnt)
+		{
+			DoRegWrites(tDevs, &ws);
+			smplCnt = 1 + NextRandom(&ws, MAX_BLOCK_SMPLS);
+			if (smplCnt > SEEK_SMPLS - smplPos)
+				smplCnt = SEEK_SMPLS - smplPos;
+			memset(smplData[0], 0x00, smplCnt * sizeof(WAVE_32BS));
+			Resmpl_Execute(&tDevs[0].resmpl, smplCnt, smplData[0]);
+			Resmpl_Advance(&tDevs[1].resmpl, smplCnt);
+		}
+		for (smplPos = 0; smplPos < CMP_SMPLS && ! retVal; smplPos += smplCnt)
+		{
+			DoRegWrites(tDevs, &ws);
+			smplCnt = 1 + NextRandom(&ws, MAX_BLOCK_SMPLS);
+			if (smplCnt > CMP_SMPLS - smplPos)
+				smplCnt = CMP_SMPLS - smplPos;
+			memset(smplData[0], 0x00, smplCnt * sizeof(WAVE_32BS));
+			memset(smplData[1], 0x00, smplCnt * sizeof(WAVE_32BS));
+			Resmpl_Execute(&tDevs[0].resmpl, smplCnt, smplData[0]);
+			Resmpl_Execute(&tDevs[1].resmpl, smplCnt, smplData[1]);
+			for (curSmpl = 0; curSmpl < smplCnt; curSmpl ++)
+			{
+				if (smplData[0][curSmpl].L != smplData[1][curSmpl].L ||
+					smplData[0][curSmpl].R != smplData[1][curSmpl].R)
+				{
+					*retFailPos = smplPos + curSmpl;
+					retVal = (UINT8)(curCycle + 1);
+					break;
+				}
+			}
+		}
+	}
+
+	free(smplData[0]);	free(smplData[1]);
+	StopDevice(&tDevs[0]);
+	StopDevice(&tDevs[1]);
+
+	return retVal;
+}
+
+static void GetCoreFCC(UINT32 coreID, char* buffer)
+{
+	int curShift;
+
+	// some FCCs use less than 4 characters (padded with '\0')
+	for (curShift = 24; curShift >= 0; curShift -= 8)
+	{
+		char c = (char)((coreID >> curShift) & 0xFF);
+		if (c != '\0')
+			*buffer++ = c;
+	}
+	*buffer = '\0';
+	return;
+}
+
+static int MatchesFilter(const char* devName, const char* coreFCC, int argc, char* argv[])
+{
+	int curArg;
+
+	if (argc <= 1)
+		return 1;	// no filter - run everything
+	for (curArg = 1; curArg < argc; curArg ++)
+	{
+		if (strstr(devName, argv[curArg]) != NULL || strstr(coreFCC, argv[curArg]) != NULL)
+			return 1;
+	}
+	return 0;
+}
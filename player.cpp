@@ -30,19 +30,19 @@ extern "C" int __cdecl _kbhit(void);
 
 #include "common_def.h"
 #include "utils/DataLoader.h"
-#include "utils/FileLoader.h"
 #include "utils/MemoryLoader.h"
+#include "utils/MmapLoader.h"
 #include "player/playerbase.hpp"
 #include "player/s98player.hpp"
 #include "player/droplayer.hpp"
 #include "player/vgmplayer.hpp"
 #include "player/gymplayer.hpp"
 #include "player/playera.hpp"
+#include "player/renderahead.hpp"
 #include "audio/AudioStream.h"
 #include "audio/AudioStream_SpcDrvFuns.h"
 #include "emu/SoundDevs.h"	// for DEVID_*
 #include "emu/EmuCores.h"
-#include "utils/OSMutex.h"
 
 //#define USE_MEMORY_LOADER 1	// define to use the in-memory loader
 
@@ -53,7 +53,7 @@ static std::string FCC2Str(UINT32 fcc);
 static UINT8 *SlurpFile(const char *fileName, UINT32 *fileSize);
 static const char* GetFileTitle(const char* filePath);
 static UINT32 FillBuffer(void* drvStruct, void* userParam, UINT32 bufSize, void* Data);
-static UINT8 FilePlayCallback(PlayerBase* player, void* userParam, UINT8 evtType, void* evtParam);
+static void HandlePlayEvent(UINT8 evtType, UINT32 evtParam);
 static DATA_LOADER* RequestFileCallback(void* userParam, PlayerBase* player, const char* fileName);
 static const char* LogLevel2Str(UINT8 level);
 static void PlayerLogCallback(void* userParam, PlayerBase* player, UINT8 level, UINT8 srcType,
@@ -75,10 +75,10 @@ static int _kbhit(void);
 static void* audDrv;
 static void* audDrvLog;
 static std::vector<UINT8> locAudBuf;	// local audio buffer (for WAV dumping)
-static OS_MUTEX* renderMtx;	// render thread mutex
 
 static UINT32 sampleRate = 44100;
 static UINT32 maxLoops = 2;
+static UINT32 renderAheadBufs = 4;	// number of audio buffers that are rendered in advance
 static bool manualRenderLoop = false;
 static volatile UINT8 playState;
 
@@ -97,6 +97,7 @@ static UINT8 logLevel = DEVLOG_INFO;
 static UINT8 pbTimeMode = PLAYTIME_LOOP_INCL | PLAYTIME_TIME_FILE;
 
 static PlayerA mainPlr;
+static RenderAhead rendAhead;	// renders in a separate thread, passes the data to the audio driver
 
 int main(int argc, char* argv[])
 {
@@ -105,6 +106,7 @@ int main(int argc, char* argv[])
 	DATA_LOADER *dLoad;
 	int curSong;
 	bool needRefresh;
+	UINT32 underrunBase;
 	
 	if (argc < 2)
 	{
@@ -133,7 +135,6 @@ int main(int argc, char* argv[])
 	mainPlr.RegisterPlayerEngine(new S98Player);
 	mainPlr.RegisterPlayerEngine(new DROPlayer);
 	mainPlr.RegisterPlayerEngine(new GYMPlayer);
-	mainPlr.SetEventCallback(FilePlayCallback, NULL);
 	mainPlr.SetFileReqCallback(RequestFileCallback, NULL);
 	mainPlr.SetLogCallback(PlayerLogCallback, NULL);
 	//mainPlr.SetOutputSettings() is done in StartAudioDevice()
@@ -158,7 +159,7 @@ int main(int argc, char* argv[])
 	UINT8 *fileData = SlurpFile(argv[curSong],&fileSize);
 	dLoad = MemoryLoader_Init(fileData, fileSize);
 #else
-	dLoad = FileLoader_Init(argv[curSong]);
+	dLoad = MmapLoader_Init(argv[curSong]);
 #endif
 
 	if(dLoad == NULL) continue;
@@ -344,11 +345,20 @@ int main(int argc, char* argv[])
 	
 	StartDiskWriter("waveOut.wav");
 	
+	underrunBase = rendAhead.GetUnderrunCount();
 	if (audDrv != NULL)
-		retVal = AudioDrv_SetCallback(audDrv, FillBuffer, &mainPlr);
+	{
+		// The render thread has to run before the callback is set.
+		rendAhead.Start();
+		retVal = AudioDrv_SetCallback(audDrv, FillBuffer, &rendAhead);
+	}
 	else
+	{
 		retVal = 0xFF;
+	}
 	manualRenderLoop = (retVal != 0x00);
+	if (manualRenderLoop)
+		rendAhead.Stop();	// render from the main loop
 #ifndef _WIN32
 	changemode(1);
 #endif
@@ -356,6 +366,12 @@ int main(int argc, char* argv[])
 	needRefresh = true;
 	while(! (playState & PLAYSTATE_END))
 	{
+		UINT8 evtType;
+		UINT32 evtParam;
+		
+		while((evtType = rendAhead.PopEvent(&evtParam)) != PLREVT_NONE)
+			HandlePlayEvent(evtType, evtParam);
+		
 		if (! (playState & PLAYSTATE_PAUSE))
 			needRefresh = true;	// always update when playing
 		if (needRefresh)
@@ -395,7 +411,7 @@ int main(int argc, char* argv[])
 		
 		if (manualRenderLoop && ! (playState & PLAYSTATE_PAUSE))
 		{
-			UINT32 wrtBytes = FillBuffer(audDrvLog, &mainPlr, (UINT32)locAudBuf.size(), &locAudBuf[0]);
+			UINT32 wrtBytes = FillBuffer(audDrvLog, &rendAhead, (UINT32)locAudBuf.size(), &locAudBuf[0]);
 			AudioDrv_WriteData(audDrvLog, wrtBytes, &locAudBuf[0]);
 		}
 		else
@@ -421,9 +437,7 @@ int main(int argc, char* argv[])
 			}
 			else if (letter == 'R')	// restart
 			{
-				OSMutex_Lock(renderMtx);
-				mainPlr.Reset();
-				OSMutex_Unlock(renderMtx);
+				rendAhead.Reset();
 			}
 			else if (letter >= '0' && letter <= '9')
 			{
@@ -431,12 +445,10 @@ int main(int argc, char* argv[])
 				UINT8 pbPos10;
 				UINT32 destPos;
 				
-				OSMutex_Lock(renderMtx);
 				maxPos = mainPlr.GetPlayer()->GetTotalPlayTicks(maxLoops);
 				pbPos10 = letter - '0';
 				destPos = maxPos * pbPos10 / 10;
-				mainPlr.Seek(PLAYPOS_TICK, destPos);
-				OSMutex_Unlock(renderMtx);
+				rendAhead.Seek(PLAYPOS_TICK, destPos);
 			}
 			else if (letter == 'B')	// previous file
 			{
@@ -458,9 +470,7 @@ int main(int argc, char* argv[])
 			}
 			else if (letter == 'F')	// fade out
 			{
-				OSMutex_Lock(renderMtx);
-				mainPlr.FadeOut();
-				OSMutex_Unlock(renderMtx);
+				rendAhead.FadeOut();
 			}
 			else if (letter == 'C')	// chip control
 			{
@@ -482,6 +492,9 @@ int main(int argc, char* argv[])
 	// also waits for render thread to finish its work
 	if (audDrv != NULL)
 		AudioDrv_SetCallback(audDrv, NULL, NULL);
+	rendAhead.Stop();
+	if (rendAhead.GetUnderrunCount() != underrunBase)
+		printf("%u buffer underruns\n", rendAhead.GetUnderrunCount() - underrunBase);
 	
 	StopDiskWriter();
 	
@@ -1057,23 +1070,13 @@ static const char* GetFileTitle(const char* filePath)
 
 static UINT32 FillBuffer(void* drvStruct, void* userParam, UINT32 bufSize, void* data)
 {
-	PlayerA& myPlr = *(PlayerA*)userParam;
-	if (! (myPlr.GetState() & PLAYSTATE_PLAY))
-	{
-		fprintf(stderr, "Player Warning: calling Render while not playing! playState = 0x%02X\n", myPlr.GetState());
-		memset(data, 0x00, bufSize);
-		return bufSize;
-	}
-	
-	UINT32 renderedBytes;
-	OSMutex_Lock(renderMtx);
-	renderedBytes = myPlr.Render(bufSize, data);
-	OSMutex_Unlock(renderMtx);
-	
-	return renderedBytes;
+	RenderAhead& rAhead = *(RenderAhead*)userParam;
+	return rAhead.Read(bufSize, data);
 }
 
-static UINT8 FilePlayCallback(PlayerBase* player, void* userParam, UINT8 evtType, void* evtParam)
+// called from the main loop when the event is actually played
+// (events that happen while seeking are filtered by RenderAhead)
+static void HandlePlayEvent(UINT8 evtType, UINT32 evtParam)
 {
 	switch(evtType)
 	{
@@ -1084,12 +1087,7 @@ static UINT8 FilePlayCallback(PlayerBase* player, void* userParam, UINT8 evtType
 		//printf("Playback stopped.\n");
 		break;
 	case PLREVT_LOOP:
-		{
-			UINT32* curLoop = (UINT32*)evtParam;
-			if (player->GetState() & PLAYSTATE_SEEK)
-				break;
-			printf("Loop %u.\n", 1 + *curLoop);
-		}
+		printf("Loop %u.\n", 1 + evtParam);
 		break;
 	case PLREVT_END:
 		if (playState & PLAYSTATE_END)
@@ -1098,12 +1096,12 @@ static UINT8 FilePlayCallback(PlayerBase* player, void* userParam, UINT8 evtType
 		printf("Song End.\n");
 		break;
 	}
-	return 0x00;
+	return;
 }
 
 static DATA_LOADER* RequestFileCallback(void* userParam, PlayerBase* player, const char* fileName)
 {
-	DATA_LOADER* dLoad = FileLoader_Init(fileName);
+	DATA_LOADER* dLoad = MmapLoader_Init(fileName);
 	UINT8 retVal = DataLoader_Load(dLoad);
 	if (! retVal)
 		return dLoad;
@@ -1171,8 +1169,6 @@ static UINT8 InitAudioSystem(void)
 	AUDDRV_INFO* drvInfo;
 	UINT8 retVal;
 	
-	retVal = OSMutex_Init(&renderMtx, 0);
-	
 	printf("Opening Audio Device ...\n");
 	retVal = Audio_Init();
 	if (retVal == AERR_NODRVS)
@@ -1232,8 +1228,6 @@ static UINT8 DeinitAudioSystem(void)
 	}
 	Audio_Deinit();
 	
-	OSMutex_Deinit(renderMtx);	renderMtx = NULL;
-	
 	return retVal;
 }
 
@@ -1280,6 +1274,7 @@ static UINT8 StartAudioDevice(void)
 	
 	locAudBuf.resize(localAudBufSize);
 	mainPlr.SetOutputSettings(opts->sampleRate, opts->numChannels, opts->numBitsPerSmpl, smplAlloc);
+	rendAhead.Init(&mainPlr, smplAlloc * smplSize, renderAheadBufs);
 	
 	return 0x00;
 }
@@ -1291,6 +1286,7 @@ static UINT8 StopAudioDevice(void)
 	retVal = 0x00;
 	if (audDrv != NULL)
 		retVal = AudioDrv_Stop(audDrv);
+	rendAhead.Deinit();
 	locAudBuf.clear();
 	
 	return retVal;
@@ -52,12 +52,14 @@ DROPlayer::DROPlayer() :
 	size_t curDev;
 	
 	dev_logger_set(&_logger, this, DROPlayer::PlayerLogCB, NULL);
+	MixList_Init(&_mixList);
 	
 	_playOpts.genOpts.pbSpeed = 0x10000;
 	_playOpts.v2opl3Mode = DRO_V2OPL3_DETECT;
 	
 	_lastTsMult = 0;
 	_lastTsDiv = 0;
+	_probeOnly = 0x00;
 	
 	for (curDev = 0; curDev < 3; curDev ++)
 		InitDeviceOptions(_devOpts[curDev]);
@@ -99,6 +101,18 @@ UINT8 DROPlayer::CanLoadFile(DATA_LOADER *dataLoader) const
 }
 
 UINT8 DROPlayer::LoadFile(DATA_LOADER *dataLoader)
+{
+	return OpenFile(dataLoader, 0x00);
+}
+
+UINT8 DROPlayer::ProbeFile(DATA_LOADER *dataLoader)
+{
+	// The header contains the song length, so only the header and
+	// the initialization block (for OPL2/OPL3 detection) are read.
+	return OpenFile(dataLoader, 0x01);
+}
+
+UINT8 DROPlayer::OpenFile(DATA_LOADER *dataLoader, UINT8 probeOnly)
 {
 	UINT32 tempLng;
 	
@@ -132,7 +146,11 @@ UINT8 DROPlayer::LoadFile(DATA_LOADER *dataLoader)
 		return 0xF1;	// unsupported version
 	
 	_dLoad = dataLoader;
-	DataLoader_ReadAll(_dLoad);
+	_probeOnly = probeOnly;
+	if (! _probeOnly)
+		DataLoader_ReadAll(_dLoad);
+	else
+		DataLoader_ReadUntil(_dLoad, 0x1A + 0x80);	// maximum header size
 	_fileData = DataLoader_GetData(_dLoad);
 	
 	switch(_fileHdr.verMajor)
@@ -258,7 +276,7 @@ void DROPlayer::ScanInitBlock(void)
 		selPort = 0;
 		lastReg = 0x000;
 		// The file begins with a register dump with increasing register numbers.
-		while(filePos < DataLoader_GetSize(_dLoad))
+		while(IsDataAvailable(filePos))
 		{
 			curCmd = _fileData[filePos];
 			if (curCmd == 0x02 || curCmd == 0x03)
@@ -279,7 +297,7 @@ void DROPlayer::ScanInitBlock(void)
 			lastReg = curReg;
 			filePos += 0x02;
 		}
-		while(filePos < DataLoader_GetSize(_dLoad))
+		while(IsDataAvailable(filePos))
 		{
 			curCmd = _fileData[filePos];
 			
@@ -307,7 +325,7 @@ void DROPlayer::ScanInitBlock(void)
 	{
 		lastReg = 0x000;
 		// The file begins with a register dump with increasing register numbers.
-		while(filePos < DataLoader_GetSize(_dLoad))
+		while(IsDataAvailable(filePos))
 		{
 			curCmd = _fileData[filePos];
 			if (curCmd == _fileHdr.cmdDlyShort || curCmd == _fileHdr.cmdDlyLong)
@@ -327,6 +345,17 @@ void DROPlayer::ScanInitBlock(void)
 	return;
 }
 
+bool DROPlayer::IsDataAvailable(UINT32 filePos)
+{
+	// When probing, the file is read while scanning. (commands are up to 2 bytes long)
+	if (filePos + 0x02 > DataLoader_GetSize(_dLoad) && DataLoader_GetStatus(_dLoad) == DLSTAT_LOADING)
+	{
+		DataLoader_ReadUntil(_dLoad, filePos + 0x400);
+		_fileData = DataLoader_GetData(_dLoad);
+	}
+	return (filePos < DataLoader_GetSize(_dLoad));
+}
+
 UINT8 DROPlayer::UnloadFile(void)
 {
 	if (_playState & PLAYSTATE_PLAY)
@@ -335,6 +364,7 @@ UINT8 DROPlayer::UnloadFile(void)
 	_playState = 0x00;
 	_dLoad = NULL;
 	_fileData = NULL;
+	_probeOnly = 0x00;
 	_fileHdr.verMajor = 0xFF;
 	_fileHdr.dataOfs = 0x00;
 	_devTypes.clear();
@@ -696,6 +726,9 @@ UINT8 DROPlayer::Start(void)
 	size_t curDev;
 	UINT8 retVal;
 	
+	if (_probeOnly)
+		return 0xFF;	// only the header was loaded
+	
 	for (curDev = 0; curDev < 3; curDev ++)
 		_optDevMap[curDev] = (size_t)-1;
 	
@@ -710,6 +743,7 @@ UINT8 DROPlayer::Start(void)
 		
 		cDev->base.defInf.dataPtr = NULL;
 		cDev->base.linkDev = NULL;
+		cDev->base.mixGrp = NULL;
 		cDev->optID = DeviceID2OptionID((UINT32)curDev);
 		
 		devOpts = (cDev->optID != (size_t)-1) ? &_devOpts[cDev->optID] : NULL;
@@ -757,10 +791,13 @@ UINT8 DROPlayer::Start(void)
 			if (_devPanning[curDev] & 0x01)
 				clDev->resmpl.volumeR = 0x00;
 			Resmpl_DevConnect(&clDev->resmpl, &clDev->defInf);
+			DEVPROF_CONNECT(clDev);
 			Resmpl_Init(&clDev->resmpl);
 		}
 	}
+	SetupMixGroups();
 	
+	ResetProfile();
 	_playState |= PLAYSTATE_PLAY;
 	Reset();
 	if (_eventCbFunc != NULL)
@@ -775,6 +812,7 @@ UINT8 DROPlayer::Stop(void)
 	
 	_playState &= ~PLAYSTATE_PLAY;
 	
+	MixList_Deinit(&_mixList);	// accesses the devices
 	for (curDev = 0; curDev < _devices.size(); curDev ++)
 	{
 		DRO_CHIPDEV* cDev = &_devices[curDev];
@@ -787,6 +825,28 @@ UINT8 DROPlayer::Stop(void)
 	return 0x00;
 }
 
+// Groups devices with the same sample rate (e.g. the two chips of Dual OPL2 files),
+// so that they are mixed at their native sample rate and resampled together.
+void DROPlayer::SetupMixGroups(void)
+{
+	size_t curDev;
+	
+	MixList_Restart(&_mixList);
+	for (curDev = 0; curDev < _devices.size(); curDev ++)
+	{
+		DRO_CHIPDEV* cDev = &_devices[curDev];
+		const UINT8* disable = (cDev->optID != (size_t)-1) ? &_devOpts[cDev->optID].muteOpts.disable : NULL;
+		VGM_BASEDEV* clDev;
+		UINT8 linkID;
+		
+		for (clDev = &cDev->base, linkID = 0; clDev != NULL; clDev = clDev->linkDev, linkID ++)
+			MixList_AddDevice(&_mixList, clDev, disable, linkID);
+	}
+	MixList_Finish(&_mixList, _outSmplRate);
+	
+	return;
+}
+
 UINT8 DROPlayer::Reset(void)
 {
 	size_t curDev;
@@ -904,6 +964,32 @@ UINT8 DROPlayer::SeekToFilePos(UINT32 pos)
 	return 0x00;
 }
 
+UINT8 DROPlayer::GetProfile(PLR_PROFILE& prof) const
+{
+#ifdef PLAYER_PROFILING
+	size_t curDev;
+	
+	PlayerBase::GetProfile(prof);
+	for (curDev = 0; curDev < _devices.size(); curDev ++)
+		AddDevProfiles(prof.devices, (UINT32)curDev, &_devices[curDev].base);
+	return 0x00;
+#else
+	return 0xFF;
+#endif
+}
+
+void DROPlayer::ResetProfile(void)
+{
+#ifdef PLAYER_PROFILING
+	size_t curDev;
+	
+	PlayerBase::ResetProfile();
+	for (curDev = 0; curDev < _devices.size(); curDev ++)
+		ResetDevProfiles(&_devices[curDev].base);
+#endif
+	return;
+}
+
 UINT32 DROPlayer::Render(UINT32 smplCnt, WAVE_32BS* data)
 {
 	UINT32 curSmpl;
@@ -911,6 +997,7 @@ UINT32 DROPlayer::Render(UINT32 smplCnt, WAVE_32BS* data)
 	UINT32 maxSmpl;
 	INT32 smplStep;	// might be negative due to rounding errors in Tick2Sample
 	size_t curDev;
+	UINT32 curGrp;
 	
 	// Note: use do {} while(), so that "smplCnt == 0" can be used to process until reaching the next sample.
 	curSmpl = 0;
@@ -918,6 +1005,9 @@ UINT32 DROPlayer::Render(UINT32 smplCnt, WAVE_32BS* data)
 	{
 		smplFileTick = Sample2Tick(_playSmpl);
 		ParseFile(smplFileTick - _playTick);
+		// devices may change their sample rate during playback
+		if (MixList_RateChanged(&_mixList))
+			SetupMixGroups();
 		
 		// render as many samples at once as possible (for better performance)
 		maxSmpl = Tick2Sample(_fileTick);
@@ -935,10 +1025,12 @@ UINT32 DROPlayer::Render(UINT32 smplCnt, WAVE_32BS* data)
 			
 			for (clDev = &cDev->base; clDev != NULL; clDev = clDev->linkDev, disable >>= 1)
 			{
-				if (clDev->defInf.dataPtr != NULL && ! (disable & 0x01))
-					Resmpl_Execute(&clDev->resmpl, smplStep, &data[curSmpl]);
+				if (clDev->defInf.dataPtr != NULL && ! (disable & 0x01) && clDev->mixGrp == NULL)
+					DEVPROF_RESMPL_EXEC(clDev, smplStep, &data[curSmpl]);
 			}
 		}
+		for (curGrp = 0; curGrp < _mixList.grpCount; curGrp ++)
+			Resmpl_Execute(&_mixList.groups[curGrp].resmpl, smplStep, &data[curSmpl]);
 		curSmpl += smplStep;
 		_playSmpl += smplStep;
 		if (_psTrigger & PLAYSTATE_END)
@@ -957,6 +1049,7 @@ void DROPlayer::ParseFile(UINT32 ticks)
 	if (_playState & PLAYSTATE_END)
 		return;
 	
+	DEVPROF_TIMER_START(profTime);
 	if (_fileHdr.verMajor < 2)
 	{
 		while(_fileTick <= _playTick && ! (_playState & PLAYSTATE_END))
@@ -967,6 +1060,8 @@ void DROPlayer::ParseFile(UINT32 ticks)
 		while(_fileTick <= _playTick && ! (_playState & PLAYSTATE_END))
 			DoCommand_v2();
 	}
+	DEVPROF_TIMER_ADD(profTime, _profParseTime);
+	DEVPROF_COUNT(_profParseCalls);
 	
 	return;
 }
@@ -1090,6 +1185,7 @@ void DROPlayer::WriteReg(UINT8 port, UINT8 reg, UINT8 data)
 	if (dataPtr == NULL || cDev->write == NULL)
 		return;
 	
+	DEVPROF_REGWRITE(&cDev->base);
 	port &= _portMask;
 	cDev->write(dataPtr, (port << 1) | 0, reg);
 	cDev->write(dataPtr, (port << 1) | 1, data);
@@ -98,6 +98,7 @@ public:
 	static UINT8 PlayerCanLoadFile(DATA_LOADER *dataLoader);
 	UINT8 CanLoadFile(DATA_LOADER *dataLoader) const;
 	UINT8 LoadFile(DATA_LOADER *dataLoader);
+	UINT8 ProbeFile(DATA_LOADER *dataLoader);
 	UINT8 UnloadFile(void);
 	const DRO_HEADER* GetFileHeader(void) const;
 	
@@ -133,13 +134,17 @@ public:
 	UINT8 Reset(void);
 	UINT8 Seek(UINT8 unit, UINT32 pos);
 	UINT32 Render(UINT32 smplCnt, WAVE_32BS* data);
+	UINT8 GetProfile(PLR_PROFILE& prof) const;
+	void ResetProfile(void);
 	
 private:
 	size_t DeviceID2OptionID(UINT32 id) const;
 	void RefreshMuting(DRO_CHIPDEV& chipDev, const PLR_MUTE_OPTS& muteOpts);
 	void RefreshPanning(DRO_CHIPDEV& chipDev, const PLR_PAN_OPTS& panOpts);
 	
+	UINT8 OpenFile(DATA_LOADER *dataLoader, UINT8 probeOnly);
 	void ScanInitBlock(void);
+	bool IsDataAvailable(UINT32 filePos);
 
 	void RefreshTSRates(void);
 	
@@ -147,6 +152,7 @@ private:
 	static void SndEmuLogCB(void* userParam, void* source, UINT8 level, const char* message);
 	
 	void GenerateDeviceConfig(void);
+	void SetupMixGroups(void);
 	UINT8 SeekToTick(UINT32 tick);
 	UINT8 SeekToFilePos(UINT32 pos);
 	void ParseFile(UINT32 ticks);
@@ -158,6 +164,7 @@ private:
 	DEV_LOGGER _logger;
 	DATA_LOADER* _dLoad;
 	const UINT8* _fileData;	// data pointer for quick access, equals _dLoad->GetFileData().data()
+	UINT8 _probeOnly;	// file was opened using ProbeFile(), only the header and initialization block were read
 	
 	DRO_HEADER _fileHdr;
 	std::vector<DEV_ID> _devTypes;
@@ -188,6 +195,7 @@ private:
 	std::vector<DRO_CHIPDEV> _devices;
 	std::vector<std::string> _devNames;
 	size_t _optDevMap[3];	// maps _devOpts vector index to _devices vector
+	VGM_MIXLIST _mixList;	// devices that share a resampler
 	
 	UINT32 _filePos;
 	UINT32 _fileTick;
@@ -51,6 +51,7 @@ GYMPlayer::GYMPlayer() :
 
 	_lastTsMult = 0;
 	_lastTsDiv = 0;
+	_probeOnly = 0x00;
 	
 	for (curDev = 0; curDev < 2; curDev ++)
 		InitDeviceOptions(_devOpts[curDev]);
@@ -103,6 +104,18 @@ UINT8 GYMPlayer::CanLoadFile(DATA_LOADER *dataLoader) const
 }
 
 UINT8 GYMPlayer::LoadFile(DATA_LOADER *dataLoader)
+{
+	return OpenFile(dataLoader, 0x00);
+}
+
+UINT8 GYMPlayer::ProbeFile(DATA_LOADER *dataLoader)
+{
+	// The song length is known only after counting all frames, so the whole file is read.
+	// Compressed data is counted in small pieces instead of being decompressed into memory.
+	return OpenFile(dataLoader, 0x01);
+}
+
+UINT8 GYMPlayer::OpenFile(DATA_LOADER *dataLoader, UINT8 probeOnly)
 {
 	_dLoad = NULL;
 	DataLoader_ReadUntil(dataLoader,0x1AC);	// try to read the full GYMX header
@@ -134,6 +147,14 @@ UINT8 GYMPlayer::LoadFile(DATA_LOADER *dataLoader)
 	
 	LoadTags();
 	
+	_probeOnly = probeOnly;
+	if (_probeOnly && _fileHdr.uncomprSize > 0)
+	{
+		UINT8 retVal = CalcComprSongLength();
+		if (retVal & 0x80)
+			return 0xFF;	// decompression error
+		return 0x00;
+	}
 	if (_fileHdr.uncomprSize > 0)
 	{
 		UINT8 retVal = DecompressZlibData();
@@ -181,6 +202,84 @@ UINT8 GYMPlayer::DecompressZlibData(void)
 	return (ret == Z_OK || ret == Z_STREAM_END) ? 0x00 : 0x01;
 }
 
+UINT8 GYMPlayer::CalcComprSongLength(void)
+{
+	// same as CalcSongLength, but decompresses the data piece by piece
+	std::vector<UINT8> decBuf(0x10000);
+	z_stream zStream;
+	int ret;
+	UINT32 decPos;	// offset of decBuf[0] in the decompressed file
+	UINT32 decLen;
+	UINT32 bufPos;
+	bool fileEnd;
+	UINT8 curCmd;
+	
+	_totalTicks = 0;
+	_loopOfs = 0;
+	
+	zStream.zalloc = Z_NULL;
+	zStream.zfree = Z_NULL;
+	zStream.opaque = Z_NULL;
+	zStream.avail_in = DataLoader_GetSize(_dLoad) - _fileHdr.dataOfs;
+	zStream.next_in = (z_const Bytef*)&_fileData[_fileHdr.dataOfs];
+	ret = inflateInit2(&zStream, 0x20 | 15);
+	if (ret != Z_OK)
+		return 0xFF;
+	
+	fileEnd = false;
+	decPos = _fileHdr.dataOfs;
+	bufPos = 0;	// may be > 0 when a command continues in the next piece
+	while(! fileEnd && zStream.total_out < _fileHdr.uncomprSize)
+	{
+		decLen = (UINT32)decBuf.size();
+		if (decLen > _fileHdr.uncomprSize - zStream.total_out)
+			decLen = _fileHdr.uncomprSize - zStream.total_out;
+		zStream.avail_out = decLen;
+		zStream.next_out = (Bytef*)&decBuf[0];
+		ret = inflate(&zStream, Z_SYNC_FLUSH);
+		decLen -= zStream.avail_out;
+		
+		while(! fileEnd && bufPos < decLen)
+		{
+			if (_totalTicks == _fileHdr.loopFrame && _fileHdr.loopFrame != 0)
+				_loopOfs = decPos + bufPos;
+			
+			curCmd = decBuf[bufPos];
+			bufPos ++;
+			switch(curCmd)
+			{
+			case 0x00:	// wait 1 frame
+				_totalTicks ++;
+				break;
+			case 0x01:
+			case 0x02:
+				bufPos += 0x02;
+				break;
+			case 0x03:
+				bufPos += 0x01;
+				break;
+			default:
+				fileEnd = true;
+				break;
+			}
+		}
+		decPos += decLen;
+		bufPos = (bufPos > decLen) ? (bufPos - decLen) : 0;
+		if (ret != Z_OK || zStream.avail_out > 0)
+			break;	// end of stream, error or end of the compressed data
+	}
+	if (! (ret == Z_OK || ret == Z_STREAM_END))
+	{
+		emu_logf(&_logger, PLRLOG_ERROR, "GYM decompression error %d after decompressing %lu bytes.\n",
+			ret, zStream.total_out);
+	}
+	_fileHdr.realFileSize = decPos;
+	
+	inflateEnd(&zStream);
+	
+	return (ret == Z_OK || ret == Z_STREAM_END) ? 0x00 : 0x01;
+}
+
 void GYMPlayer::CalcSongLength(void)
 {
 	UINT32 filePos;
@@ -289,6 +388,7 @@ UINT8 GYMPlayer::UnloadFile(void)
 	_dLoad = NULL;
 	_fileData = NULL;
 	_decFData = std::vector<UINT8>();	// free allocated memory
+	_probeOnly = 0x00;
 	_fileHdr.hasHeader = 0;
 	_fileHdr.dataOfs = 0x00;
 	_devices.clear();
@@ -643,6 +743,9 @@ UINT8 GYMPlayer::Start(void)
 	size_t curDev;
 	UINT8 retVal;
 	
+	if (_probeOnly)
+		return 0xFF;	// the song data wasn't decompressed
+	
 	for (curDev = 0; curDev < 2; curDev ++)
 		_optDevMap[curDev] = (size_t)-1;
 	
@@ -657,6 +760,7 @@ UINT8 GYMPlayer::Start(void)
 		
 		cDev->base.defInf.dataPtr = NULL;
 		cDev->base.linkDev = NULL;
+		cDev->base.mixGrp = NULL;
 		cDev->optID = DeviceID2OptionID((UINT32)curDev);
 		
 		devOpts = (cDev->optID != (size_t)-1) ? &_devOpts[cDev->optID] : NULL;
@@ -695,10 +799,12 @@ UINT8 GYMPlayer::Start(void)
 			UINT8 resmplMode = (devOpts != NULL) ? devOpts->resmplMode : RSMODE_LINEAR;
 			Resmpl_SetVals(&clDev->resmpl, resmplMode, _devCfgs[curDev].volume, _outSmplRate);
 			Resmpl_DevConnect(&clDev->resmpl, &clDev->defInf);
+			DEVPROF_CONNECT(clDev);
 			Resmpl_Init(&clDev->resmpl);
 		}
 	}
 	
+	ResetProfile();
 	_playState |= PLAYSTATE_PLAY;
 	Reset();
 	if (_eventCbFunc != NULL)
@@ -807,6 +913,32 @@ UINT8 GYMPlayer::SeekToFilePos(UINT32 pos)
 	return 0x00;
 }
 
+UINT8 GYMPlayer::GetProfile(PLR_PROFILE& prof) const
+{
+#ifdef PLAYER_PROFILING
+	size_t curDev;
+	
+	PlayerBase::GetProfile(prof);
+	for (curDev = 0; curDev < _devices.size(); curDev ++)
+		AddDevProfiles(prof.devices, (UINT32)curDev, &_devices[curDev].base);
+	return 0x00;
+#else
+	return 0xFF;
+#endif
+}
+
+void GYMPlayer::ResetProfile(void)
+{
+#ifdef PLAYER_PROFILING
+	size_t curDev;
+	
+	PlayerBase::ResetProfile();
+	for (curDev = 0; curDev < _devices.size(); curDev ++)
+		ResetDevProfiles(&_devices[curDev].base);
+#endif
+	return;
+}
+
 UINT32 GYMPlayer::Render(UINT32 smplCnt, WAVE_32BS* data)
 {
 	UINT32 curSmpl;
@@ -828,11 +960,8 @@ UINT32 GYMPlayer::Render(UINT32 smplCnt, WAVE_32BS* data)
 		// render as many samples at once as possible (for better performance)
 		maxSmpl = Tick2Sample(_fileTick);
 		smplStep = maxSmpl - _playSmpl;
-		// reduce sample steps to 1 when PCM is active
-		if (smplStep < 1 || _pcmInPos > 0)
+		if (smplStep < 1)
 			smplStep = 1;	// must render at least 1 sample in order to advance
-		if ((UINT32)smplStep > smplCnt - curSmpl)
-			smplStep = smplCnt - curSmpl;
 		
 		if (_pcmInPos > 0)
 		{
@@ -852,13 +981,26 @@ UINT32 GYMPlayer::Render(UINT32 smplCnt, WAVE_32BS* data)
 				_pcmOutPos = pcmIdx;
 				if (! (dataPtr == NULL || cDev->write == NULL) && _pcmOutPos < _pcmInPos)
 				{
+					DEVPROF_DACCMD(&cDev->base);	// the PCM buffer works like a DAC stream
 					cDev->write(dataPtr, 0, 0x2A);
 					cDev->write(dataPtr, 1, _pcmBuffer[pcmIdx]);
 				}
 				if (_pcmOutPos == _pcmInPos - 1)
 					_pcmInPos = 0;	// reached the end of the buffer - disable further PCM streaming
 			}
+			if (_pcmInPos > 0)
+			{
+				// render only up to the sample where the next PCM write happens
+				UINT32 nextSmpl = pcmSmplStart +
+					((_pcmOutPos + 1) * pcmSmplLen + _pcmInPos - 1) / _pcmInPos;
+				if (nextSmpl <= _playSmpl)
+					smplStep = 1;
+				else if ((UINT32)smplStep > nextSmpl - _playSmpl)
+					smplStep = nextSmpl - _playSmpl;
+			}
 		}
+		if ((UINT32)smplStep > smplCnt - curSmpl)
+			smplStep = smplCnt - curSmpl;
 		
 		for (curDev = 0; curDev < _devices.size(); curDev ++)
 		{
@@ -869,7 +1011,7 @@ UINT32 GYMPlayer::Render(UINT32 smplCnt, WAVE_32BS* data)
 			for (clDev = &cDev->base; clDev != NULL; clDev = clDev->linkDev, disable >>= 1)
 			{
 				if (clDev->defInf.dataPtr != NULL && ! (disable & 0x01))
-					Resmpl_Execute(&clDev->resmpl, smplStep, &data[curSmpl]);
+					DEVPROF_RESMPL_EXEC(clDev, smplStep, &data[curSmpl]);
 			}
 		}
 		curSmpl += smplStep;
@@ -890,8 +1032,11 @@ void GYMPlayer::ParseFile(UINT32 ticks)
 	if (_playState & PLAYSTATE_END)
 		return;
 	
+	DEVPROF_TIMER_START(profTime);
 	while(_fileTick <= _playTick && ! (_playState & PLAYSTATE_END))
 		DoCommand();
+	DEVPROF_TIMER_ADD(profTime, _profParseTime);
+	DEVPROF_COUNT(_profParseCalls);
 	
 	return;
 }
@@ -945,6 +1090,7 @@ void GYMPlayer::DoCommand(void)
 			if (dataPtr == NULL || cDev->write == NULL)
 				return;
 			
+			DEVPROF_REGWRITE(&cDev->base);
 			if ((reg & 0xF0) == 0xA0)
 			{
 				// Note: The OPN series has a particular behaviour with frequency registers (Ax) that
@@ -1011,6 +1157,7 @@ void GYMPlayer::DoCommand(void)
 			if (dataPtr == NULL || cDev->write == NULL)
 				return;
 			
+			DEVPROF_REGWRITE(&cDev->base);
 			cDev->write(dataPtr, SN76496_W_REG, data);
 		}
 		return;
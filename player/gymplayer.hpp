@@ -74,6 +74,7 @@ public:
 	static UINT8 PlayerCanLoadFile(DATA_LOADER *dataLoader);
 	UINT8 CanLoadFile(DATA_LOADER *dataLoader) const;
 	UINT8 LoadFile(DATA_LOADER *dataLoader);
+	UINT8 ProbeFile(DATA_LOADER *dataLoader);
 	UINT8 UnloadFile(void);
 	const GYM_HEADER* GetFileHeader(void) const;
 	
@@ -109,13 +110,17 @@ public:
 	UINT8 Reset(void);
 	UINT8 Seek(UINT8 unit, UINT32 pos);
 	UINT32 Render(UINT32 smplCnt, WAVE_32BS* data);
+	UINT8 GetProfile(PLR_PROFILE& prof) const;
+	void ResetProfile(void);
 	
 private:
 	size_t DeviceID2OptionID(UINT32 id) const;
 	void RefreshMuting(GYM_CHIPDEV& chipDev, const PLR_MUTE_OPTS& muteOpts);
 	void RefreshPanning(GYM_CHIPDEV& chipDev, const PLR_PAN_OPTS& panOpts);
 	
+	UINT8 OpenFile(DATA_LOADER *dataLoader, UINT8 probeOnly);
 	UINT8 DecompressZlibData(void);
+	UINT8 CalcComprSongLength(void);
 	void CalcSongLength(void);
 	UINT8 LoadTags(void);
 	void LoadTag(const char* tagName, const void* data, size_t maxlen);
@@ -139,6 +144,7 @@ private:
 	UINT32 _fileLen;
 	const UINT8* _fileData;	// data pointer for quick access, equals _dLoad->GetFileData().data()
 	std::vector<UINT8> _decFData;
+	UINT8 _probeOnly;	// file was opened using ProbeFile(), compressed data wasn't decompressed
 	
 	GYM_HEADER _fileHdr;
 	std::vector<DevCfg> _devCfgs;
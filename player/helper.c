@@ -1,5 +1,12 @@
 #include <stdlib.h>
 #include <string.h>
+#ifdef PLAYER_PROFILING
+#ifdef _WIN32
+#include <windows.h>	// for QueryPerformanceCounter()
+#else
+#include <time.h>		// for clock_gettime()
+#endif
+#endif
 
 #include "../stdtype.h"
 #include "../emu/EmuStructs.h"
@@ -74,3 +81,358 @@ void FreeDeviceTree(VGM_BASEDEV* cBaseDev, UINT8 freeBase)
 	
 	return;
 }
+
+static UINT8 MixGrp_IsMemberActive(const VGM_MIXMBR* mbr)
+{
+	const RESMPL_STATE* rsmpl = &mbr->clDev->resmpl;
+	
+	if (mbr->disable != NULL && ((*mbr->disable >> mbr->linkID) & 0x01))
+		return 0;
+	if (rsmpl->su_IsIdle != NULL && rsmpl->su_IsIdle(rsmpl->su_DataPtr))
+		return 0;
+	return 1;
+}
+
+static void MixGrp_EnsureBuffer(VGM_MIXGRP* mGrp, UINT32 length)
+{
+	if (length <= mGrp->bufSize)
+		return;
+	mGrp->bufSize = length;
+	mGrp->smplBuf[0] = (DEV_SMPL*)realloc(mGrp->smplBuf[0], mGrp->bufSize * 2 * sizeof(DEV_SMPL));
+	mGrp->smplBuf[1] = &mGrp->smplBuf[0][mGrp->bufSize];
+	return;
+}
+
+static UINT8 MixGrp_Silent(void* info)
+{
+	return 1;
+}
+
+static UINT8 MixGrp_IsIdle(void* info)
+{
+	const VGM_MIXGRP* mGrp = (const VGM_MIXGRP*)info;
+	UINT32 curMbr;
+	
+	for (curMbr = 0; curMbr < mGrp->mbrCount; curMbr ++)
+	{
+		if (MixGrp_IsMemberActive(&mGrp->mbrs[curMbr]))
+			return 0;
+	}
+	return 1;
+}
+
+// Renders all devices of the group and mixes them, applying the volume of each device.
+static void MixGrp_Update(void* info, UINT32 samples, DEV_SMPL** outputs)
+{
+	VGM_MIXGRP* mGrp = (VGM_MIXGRP*)info;
+	UINT32 curMbr;
+	UINT32 curSmpl;
+	
+	memset(outputs[0], 0x00, samples * sizeof(DEV_SMPL));
+	memset(outputs[1], 0x00, samples * sizeof(DEV_SMPL));
+	MixGrp_EnsureBuffer(mGrp, samples);
+	for (curMbr = 0; curMbr < mGrp->mbrCount; curMbr ++)
+	{
+		RESMPL_STATE* rsmpl = &mGrp->mbrs[curMbr].clDev->resmpl;
+		INT32 volL = rsmpl->volumeL;
+		INT32 volR = rsmpl->volumeR;
+		
+		if (! MixGrp_IsMemberActive(&mGrp->mbrs[curMbr]))
+			continue;
+		// The call goes through the resampler's function, so that profiling works.
+		rsmpl->StreamUpdate(rsmpl->su_DataPtr, samples, mGrp->smplBuf);
+		// mix (the volume is applied here instead of by the resampler)
+		for (curSmpl = 0; curSmpl < samples; curSmpl ++)
+		{
+			outputs[0][curSmpl] += mGrp->smplBuf[0][curSmpl] * volL;
+			outputs[1][curSmpl] += mGrp->smplBuf[1][curSmpl] * volR;
+		}
+	}
+	
+	return;
+}
+
+static void MixGrp_Advance(void* info, UINT32 samples)
+{
+	VGM_MIXGRP* mGrp = (VGM_MIXGRP*)info;
+	UINT32 curMbr;
+	
+	MixGrp_EnsureBuffer(mGrp, 0x100);
+	for (curMbr = 0; curMbr < mGrp->mbrCount; curMbr ++)
+	{
+		RESMPL_STATE* rsmpl = &mGrp->mbrs[curMbr].clDev->resmpl;
+		
+		if (! MixGrp_IsMemberActive(&mGrp->mbrs[curMbr]))
+			continue;
+		if (rsmpl->su_Advance != NULL)
+		{
+			rsmpl->su_Advance(rsmpl->su_DataPtr, samples);
+		}
+		else
+		{
+			// render and discard the samples
+			UINT32 remSmpls = samples;
+			while(remSmpls > 0)
+			{
+				UINT32 smplCnt = (remSmpls < mGrp->bufSize) ? remSmpls : mGrp->bufSize;
+				rsmpl->StreamUpdate(rsmpl->su_DataPtr, smplCnt, mGrp->smplBuf);
+				remSmpls -= smplCnt;
+			}
+		}
+	}
+	
+	return;
+}
+
+static void MixList_Free(VGM_MIXLIST* mList)
+{
+	UINT32 curGrp;
+	UINT32 curMbr;
+	
+	for (curGrp = 0; curGrp < mList->grpCount; curGrp ++)
+	{
+		VGM_MIXGRP* mGrp = &mList->groups[curGrp];
+		for (curMbr = 0; curMbr < mGrp->mbrCount; curMbr ++)
+			mGrp->mbrs[curMbr].clDev->mixGrp = NULL;
+		if (mGrp->resmpl.resampler != NULL)
+			Resmpl_Deinit(&mGrp->resmpl);
+		free(mGrp->mbrs);
+		free(mGrp->smplBuf[0]);
+	}
+	free(mList->groups);
+	mList->grpCount = 0;
+	mList->groups = NULL;
+	
+	return;
+}
+
+void MixList_Init(VGM_MIXLIST* mList)
+{
+	mList->grpCount = 0;
+	mList->groups = NULL;
+	return;
+}
+
+void MixList_Deinit(VGM_MIXLIST* mList)
+{
+	MixList_Free(mList);
+	return;
+}
+
+void MixList_Restart(VGM_MIXLIST* mList)
+{
+	UINT32 curGrp;
+	UINT32 curMbr;
+	
+	for (curGrp = 0; curGrp < mList->grpCount; curGrp ++)
+	{
+		const VGM_MIXGRP* mGrp = &mList->groups[curGrp];
+		for (curMbr = 0; curMbr < mGrp->mbrCount; curMbr ++)
+		{
+			RESMPL_STATE* rsmpl = &mGrp->mbrs[curMbr].clDev->resmpl;
+			if (rsmpl->smpRateSrc != mGrp->resmpl.smpRateSrc)
+				continue;
+			rsmpl->smpP = mGrp->resmpl.smpP;
+			rsmpl->smpLast = mGrp->resmpl.smpLast;
+			rsmpl->smpNext = mGrp->resmpl.smpNext;
+		}
+	}
+	MixList_Free(mList);
+	
+	return;
+}
+
+void MixList_AddDevice(VGM_MIXLIST* mList, VGM_BASEDEV* clDev, const UINT8* disable, UINT8 linkID)
+{
+	const RESMPL_STATE* rsmpl = &clDev->resmpl;
+	VGM_MIXGRP* mGrp;
+	VGM_MIXMBR* mbr;
+	UINT32 curGrp;
+	
+	clDev->mixGrp = NULL;
+	if (clDev->defInf.dataPtr == NULL || rsmpl->resampler == NULL || linkID >= 8)
+		return;
+	
+	for (curGrp = 0; curGrp < mList->grpCount; curGrp ++)
+	{
+		const RESMPL_STATE* grpRs = &mList->groups[curGrp].resmpl;
+		if (grpRs->smpRateSrc == rsmpl->smpRateSrc && grpRs->resampleMode == rsmpl->resampleMode)
+			break;
+	}
+	if (curGrp >= mList->grpCount)
+	{
+		mList->grpCount ++;
+		mList->groups = (VGM_MIXGRP*)realloc(mList->groups, mList->grpCount * sizeof(VGM_MIXGRP));
+		mGrp = &mList->groups[curGrp];
+		memset(mGrp, 0x00, sizeof(VGM_MIXGRP));
+		mGrp->resmpl.smpRateSrc = rsmpl->smpRateSrc;
+		mGrp->resmpl.resampleMode = rsmpl->resampleMode;
+	}
+	mGrp = &mList->groups[curGrp];
+	mGrp->mbrCount ++;
+	mGrp->mbrs = (VGM_MIXMBR*)realloc(mGrp->mbrs, mGrp->mbrCount * sizeof(VGM_MIXMBR));
+	mbr = &mGrp->mbrs[mGrp->mbrCount - 1];
+	mbr->clDev = clDev;
+	mbr->disable = disable;
+	mbr->linkID = linkID;
+	
+	return;
+}
+
+void MixList_Finish(VGM_MIXLIST* mList, UINT32 outSmplRate)
+{
+	UINT32 curGrp;
+	UINT32 curMbr;
+	
+	// Devices with a unique sample rate keep using their own resampler.
+	for (curGrp = 0; curGrp < mList->grpCount; )
+	{
+		VGM_MIXGRP* mGrp = &mList->groups[curGrp];
+		if (mGrp->mbrCount >= 2)
+		{
+			curGrp ++;
+			continue;
+		}
+		free(mGrp->mbrs);
+		mList->grpCount --;
+		memmove(mGrp, mGrp + 1, (mList->grpCount - curGrp) * sizeof(VGM_MIXGRP));
+	}
+	
+	// The resamplers are set up after the list is complete, because their addresses mustn't change.
+	for (curGrp = 0; curGrp < mList->grpCount; curGrp ++)
+	{
+		VGM_MIXGRP* mGrp = &mList->groups[curGrp];
+		RESMPL_STATE* grpRs = &mGrp->resmpl;
+		const RESMPL_STATE* firstRs = &mGrp->mbrs[0].clDev->resmpl;
+		UINT32 smpRateSrc = grpRs->smpRateSrc;
+		
+		Resmpl_SetVals(grpRs, grpRs->resampleMode, 1, outSmplRate);
+		grpRs->smpRateSrc = smpRateSrc;
+		grpRs->StreamUpdate = MixGrp_Update;
+		grpRs->su_DataPtr = mGrp;
+		grpRs->su_Advance = MixGrp_Advance;
+		// Resmpl_Init would render the first sample for upsampling. Instead, the resampler continues
+		// where the devices' resamplers are, so that nothing is rendered twice.
+		grpRs->su_IsIdle = MixGrp_Silent;
+		Resmpl_Init(grpRs);
+		grpRs->su_IsIdle = MixGrp_IsIdle;
+		grpRs->smpP = firstRs->smpP;
+		grpRs->smpLast = firstRs->smpLast;
+		grpRs->smpNext = firstRs->smpNext;
+		grpRs->lSmpl.L = grpRs->lSmpl.R = 0;
+		grpRs->nSmpl.L = grpRs->nSmpl.R = 0;
+		for (curMbr = 0; curMbr < mGrp->mbrCount; curMbr ++)
+		{
+			VGM_BASEDEV* clDev = mGrp->mbrs[curMbr].clDev;
+			const RESMPL_STATE* rsmpl = &clDev->resmpl;
+			
+			grpRs->lSmpl.L += rsmpl->lSmpl.L * rsmpl->volumeL;
+			grpRs->lSmpl.R += rsmpl->lSmpl.R * rsmpl->volumeR;
+			grpRs->nSmpl.L += rsmpl->nSmpl.L * rsmpl->volumeL;
+			grpRs->nSmpl.R += rsmpl->nSmpl.R * rsmpl->volumeR;
+			clDev->mixGrp = mGrp;
+		}
+	}
+	
+	return;
+}
+
+UINT8 MixList_RateChanged(const VGM_MIXLIST* mList)
+{
+	UINT32 curGrp;
+	UINT32 curMbr;
+	
+	for (curGrp = 0; curGrp < mList->grpCount; curGrp ++)
+	{
+		const VGM_MIXGRP* mGrp = &mList->groups[curGrp];
+		for (curMbr = 0; curMbr < mGrp->mbrCount; curMbr ++)
+		{
+			if (mGrp->mbrs[curMbr].clDev->resmpl.smpRateSrc != mGrp->resmpl.smpRateSrc)
+				return 1;
+		}
+	}
+	return 0;
+}
+
+#ifdef PLAYER_PROFILING
+UINT64 DevProf_GetTime(void)
+{
+#ifdef _WIN32
+	static LARGE_INTEGER freq = {{0, 0}};
+	LARGE_INTEGER cnt;
+	
+	if (! freq.QuadPart)
+		QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&cnt);
+	return (UINT64)((double)cnt.QuadPart * 1000000000.0 / freq.QuadPart);
+#else
+	struct timespec tp;
+	
+	clock_gettime(CLOCK_MONOTONIC, &tp);
+	return (UINT64)tp.tv_sec * 1000000000 + tp.tv_nsec;
+#endif
+}
+
+static void DevProf_Update(void* info, UINT32 samples, DEV_SMPL** outputs)
+{
+	VGM_BASEDEV* cBaseDev = (VGM_BASEDEV*)info;
+	UINT64 startTime = DevProf_GetTime();
+	
+	cBaseDev->defInf.devDef->Update(cBaseDev->defInf.dataPtr, samples, outputs);
+	cBaseDev->prof.updTime += DevProf_GetTime() - startTime;
+	cBaseDev->prof.updCalls ++;
+	cBaseDev->prof.updSmpls += samples;
+	return;
+}
+
+static UINT8 DevProf_IsIdle(void* info)
+{
+	VGM_BASEDEV* cBaseDev = (VGM_BASEDEV*)info;
+	return cBaseDev->prof.isIdle(cBaseDev->defInf.dataPtr);
+}
+
+static void DevProf_Advance(void* info, UINT32 samples)
+{
+	VGM_BASEDEV* cBaseDev = (VGM_BASEDEV*)info;
+	cBaseDev->prof.advance(cBaseDev->defInf.dataPtr, samples);
+	return;
+}
+
+void DevProf_Connect(VGM_BASEDEV* cBaseDev)
+{
+	// The resampler passes su_DataPtr to all these functions, so all of them need a wrapper.
+	cBaseDev->prof.isIdle = cBaseDev->resmpl.su_IsIdle;
+	cBaseDev->prof.advance = cBaseDev->resmpl.su_Advance;
+	cBaseDev->resmpl.StreamUpdate = DevProf_Update;
+	cBaseDev->resmpl.su_IsIdle = (cBaseDev->prof.isIdle != NULL) ? DevProf_IsIdle : NULL;
+	cBaseDev->resmpl.su_Advance = (cBaseDev->prof.advance != NULL) ? DevProf_Advance : NULL;
+	cBaseDev->resmpl.su_DataPtr = cBaseDev;
+	DevProf_Reset(cBaseDev);
+	
+	return;
+}
+
+void DevProf_Reset(VGM_BASEDEV* cBaseDev)
+{
+	VGM_DEVPROF* prof = &cBaseDev->prof;
+	
+	prof->updCalls = 0;
+	prof->updSmpls = 0;
+	prof->updTime = 0;
+	prof->rsmplCalls = 0;
+	prof->rsmplTime = 0;
+	prof->regWrites = 0;
+	prof->dacStrmCmds = 0;
+	return;
+}
+
+void DevProf_ResmplExecute(VGM_BASEDEV* cBaseDev, UINT32 length, WAVE_32BS* retSample)
+{
+	UINT64 startTime = DevProf_GetTime();
+	
+	Resmpl_Execute(&cBaseDev->resmpl, length, retSample);
+	cBaseDev->prof.rsmplTime += DevProf_GetTime() - startTime;
+	cBaseDev->prof.rsmplCalls ++;
+	return;
+}
+#endif
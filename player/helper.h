@@ -11,12 +11,54 @@ extern "C"
 #include "../emu/Resampler.h"
 
 typedef struct _vgm_base_device VGM_BASEDEV;
+typedef struct _vgm_mix_group VGM_MIXGRP;
+#ifdef PLAYER_PROFILING
+typedef struct _vgm_device_profile
+{
+	DEVFUNC_READ_IDLE isIdle;	// idle function of the device (the resampler calls a wrapper)
+	DEVFUNC_ADVANCE advance;	// advance function of the device (the resampler calls a wrapper)
+	UINT64 updCalls;	// number of DEV_DEF::Update() calls
+	UINT64 updSmpls;	// samples rendered by DEV_DEF::Update()
+	UINT64 updTime;		// time spent in DEV_DEF::Update() [ns]
+	UINT64 rsmplCalls;	// number of Resmpl_Execute() calls
+	UINT64 rsmplTime;	// time spent in Resmpl_Execute(), includes DEV_DEF::Update() [ns]
+	UINT64 regWrites;	// register writes sent by the player
+	UINT64 dacStrmCmds;	// DAC stream commands for this device
+} VGM_DEVPROF;
+#endif
 struct _vgm_base_device
 {
 	DEV_INFO defInf;
 	RESMPL_STATE resmpl;
 	VGM_BASEDEV* linkDev;
+	VGM_MIXGRP* mixGrp;	// mix group that renders this device, NULL = the device uses its own resampler
+#ifdef PLAYER_PROFILING
+	VGM_DEVPROF prof;
+#endif
+};
+
+// Mix groups: Devices with the same sample rate are mixed at their native sample rate
+// and resampled together, so the resampling work depends on the number of different
+// sample rates instead of the number of devices.
+typedef struct _vgm_mix_member
+{
+	VGM_BASEDEV* clDev;
+	const UINT8* disable;	// mute mask of the device (bit n = linked device n), may be NULL
+	UINT8 linkID;	// position in the list of linked devices
+} VGM_MIXMBR;
+struct _vgm_mix_group
+{
+	RESMPL_STATE resmpl;	// resamples the mixed output, the device volumes are applied during mixing
+	UINT32 mbrCount;
+	VGM_MIXMBR* mbrs;
+	UINT32 bufSize;	// [work] size of smplBuf, in samples
+	DEV_SMPL* smplBuf[2];	// [work] output of a single device
 };
+typedef struct _vgm_mix_list
+{
+	UINT32 grpCount;
+	VGM_MIXGRP* groups;
+} VGM_MIXLIST;
 
 // callback function typedef for SetupLinkedDevices
 typedef void (*SETUPLINKDEV_CB)(void* userParam, VGM_BASEDEV* cDev, DEVLINK_INFO* dLink);
@@ -25,6 +67,47 @@ typedef void (*SETUPLINKDEV_CB)(void* userParam, VGM_BASEDEV* cDev, DEVLINK_INFO
 void SetupLinkedDevices(VGM_BASEDEV* cBaseDev, SETUPLINKDEV_CB devCfgCB, void* cbUserParam);
 void FreeDeviceTree(VGM_BASEDEV* cBaseDev, UINT8 freeBase);
 
+// Usage: MixList_Restart, then MixList_AddDevice for all devices, then MixList_Finish.
+// The group resamplers render the devices using their resamplers' StreamUpdate function.
+void MixList_Init(VGM_MIXLIST* mList);
+// Frees all groups. It has to be called while the devices still exist.
+void MixList_Deinit(VGM_MIXLIST* mList);
+// Frees all groups. The devices continue at the position of their group.
+void MixList_Restart(VGM_MIXLIST* mList);
+// Devices that are not running or whose linkID is 8 or higher are ignored.
+void MixList_AddDevice(VGM_MIXLIST* mList, VGM_BASEDEV* clDev, const UINT8* disable, UINT8 linkID);
+// Removes groups with a single device and sets up the group resamplers.
+void MixList_Finish(VGM_MIXLIST* mList, UINT32 outSmplRate);
+// returns 1 if a device changed its sample rate, the groups have to be set up again in this case
+UINT8 MixList_RateChanged(const VGM_MIXLIST* mList);
+
+// Profiling (enabled by defining PLAYER_PROFILING)
+// The DEVPROF_ macros compile to nothing when profiling is disabled.
+#ifdef PLAYER_PROFILING
+UINT64 DevProf_GetTime(void);	// returns a timestamp in nanoseconds
+// Redirects the resampler's Update() calls through a wrapper that measures them and clears the counters.
+// Call it after Resmpl_DevConnect().
+void DevProf_Connect(VGM_BASEDEV* cBaseDev);
+void DevProf_Reset(VGM_BASEDEV* cBaseDev);
+void DevProf_ResmplExecute(VGM_BASEDEV* cBaseDev, UINT32 length, WAVE_32BS* retSample);
+
+#define DEVPROF_CONNECT(cBaseDev)	DevProf_Connect(cBaseDev)
+#define DEVPROF_RESMPL_EXEC(cBaseDev, length, retSample)	DevProf_ResmplExecute(cBaseDev, length, retSample)
+#define DEVPROF_REGWRITE(cBaseDev)	(cBaseDev)->prof.regWrites ++
+#define DEVPROF_DACCMD(cBaseDev)	(cBaseDev)->prof.dacStrmCmds ++
+#define DEVPROF_TIMER_START(var)	UINT64 var = DevProf_GetTime()
+#define DEVPROF_TIMER_ADD(var, counter)	counter += DevProf_GetTime() - var
+#define DEVPROF_COUNT(counter)	counter ++
+#else
+#define DEVPROF_CONNECT(cBaseDev)
+#define DEVPROF_RESMPL_EXEC(cBaseDev, length, retSample)	Resmpl_Execute(&(cBaseDev)->resmpl, length, retSample)
+#define DEVPROF_REGWRITE(cBaseDev)
+#define DEVPROF_DACCMD(cBaseDev)
+#define DEVPROF_TIMER_START(var)
+#define DEVPROF_TIMER_ADD(var, counter)
+#define DEVPROF_COUNT(counter)
+#endif
+
 #ifdef __cplusplus
 }
 #endif
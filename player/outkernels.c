@@ -0,0 +1,594 @@
+// PlayerA Output Kernels
+// ----------------------
+// Block processing functions for volume and sample packing, with SIMD versions that are selected at runtime.
+// All versions produce exactly the same results as the plain C versions.
+#include <stddef.h>
+#include <string.h>
+
+#include "../stdtype.h"
+#include "../common_def.h"
+#include "../emu/Resampler.h"
+#include "outkernels.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define OK_X86
+#if defined(__x86_64__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define OK_SSE2_ALWAYS	// SSE2 is part of the base instruction set
+#endif
+#if defined(__GNUC__) && (__GNUC__ >= 5 || defined(__clang__))
+#define OK_HAVE_SSE2
+#define OK_HAVE_AVX2
+#define OK_TGT_SSE2	__attribute__((target("sse2")))
+#define OK_TGT_AVX2	__attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(_MSC_VER) && _MSC_VER >= 1800	// MSVC 2013+
+#define OK_HAVE_SSE2
+#define OK_HAVE_AVX2
+#define OK_TGT_SSE2
+#define OK_TGT_AVX2
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+#endif	// x86
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define OK_HAVE_NEON
+#include <arm_neon.h>
+#endif
+
+// The SIMD packing functions write the samples in little endian byte order.
+#if defined(VGM_LITTLE_ENDIAN)
+#define OK_SIMD_PACK
+#endif
+
+#define SMPL_MIN_24	-0x800000
+#define SMPL_MAX_24	+0x7FFFFF
+#define CHN_NEG(inv, bit)	(((inv) & (bit)) ? -1 : 0)
+
+
+// ---- plain C ----
+static void Kern_VolConst_C(WAVE_32BS* buf, UINT32 length, INT32 vol, UINT8 chnInvert)
+{
+	UINT32 curSmpl;
+	INT32 negL = CHN_NEG(chnInvert, 0x01);
+	INT32 negR = CHN_NEG(chnInvert, 0x02);
+	
+	for (curSmpl = 0; curSmpl < length; curSmpl ++)
+	{
+		// (x ^ -1) - (-1) = -x
+		buf[curSmpl].L = ((INT32)(((INT64)buf[curSmpl].L * vol) >> 16) ^ negL) - negL;
+		buf[curSmpl].R = ((INT32)(((INT64)buf[curSmpl].R * vol) >> 16) ^ negR) - negR;
+	}
+	
+	return;
+}
+
+static void Kern_VolList_C(WAVE_32BS* buf, UINT32 length, const INT32* volList, UINT8 chnInvert)
+{
+	UINT32 curSmpl;
+	INT32 negL = CHN_NEG(chnInvert, 0x01);
+	INT32 negR = CHN_NEG(chnInvert, 0x02);
+	
+	for (curSmpl = 0; curSmpl < length; curSmpl ++)
+	{
+		buf[curSmpl].L = ((INT32)(((INT64)buf[curSmpl].L * volList[curSmpl]) >> 16) ^ negL) - negL;
+		buf[curSmpl].R = ((INT32)(((INT64)buf[curSmpl].R * volList[curSmpl]) >> 16) ^ negR) - negR;
+	}
+	
+	return;
+}
+
+INLINE INT32 Clamp24(INT32 value)
+{
+	if (value < SMPL_MIN_24)
+		return SMPL_MIN_24;
+	else if (value > SMPL_MAX_24)
+		return SMPL_MAX_24;
+	else
+		return value;
+}
+
+static void Kern_PackU8_C(void* dst, const WAVE_32BS* src, UINT32 length)
+{
+	UINT8* out = (UINT8*)dst;
+	const INT32* in = &src[0].L;
+	UINT32 curVal;
+	INT32 value;
+	
+	for (curVal = 0; curVal < length * 2; curVal ++)
+	{
+		value = in[curVal] >> 16;	// 24 bit -> 8 bit
+		if (value < -0x80)
+			value = -0x80;
+		else if (value > +0x7F)
+			value = +0x7F;
+		out[curVal] = (UINT8)(0x80 + value);
+	}
+	
+	return;
+}
+
+static void Kern_PackS16_C(void* dst, const WAVE_32BS* src, UINT32 length)
+{
+	UINT8* out = (UINT8*)dst;
+	const INT32* in = &src[0].L;
+	UINT32 curVal;
+	INT32 value;
+	INT16 v;
+	
+	for (curVal = 0; curVal < length * 2; curVal ++)
+	{
+		value = in[curVal] >> 8;	// 24 bit -> 16 bit
+		if (value < -0x8000)
+			value = -0x8000;
+		else if (value > +0x7FFF)
+			value = +0x7FFF;
+		v = (INT16)value;
+		memcpy(&out[curVal * 2], &v, sizeof(v));
+	}
+	
+	return;
+}
+
+static void Kern_PackS24_C(void* dst, const WAVE_32BS* src, UINT32 length)
+{
+	UINT8* out = (UINT8*)dst;
+	const INT32* in = &src[0].L;
+	UINT32 curVal;
+	INT32 value;
+	
+	for (curVal = 0; curVal < length * 2; curVal ++, out += 3)
+	{
+		value = Clamp24(in[curVal]);
+#if defined(VGM_LITTLE_ENDIAN)
+		out[0] = ( value       ) & 0xFF;
+		out[1] = ( value >> 8  ) & 0xFF;
+		out[2] = ( value >> 16 ) & 0xFF;
+#elif defined(VGM_BIG_ENDIAN)
+		out[0] = ( value >> 16 ) & 0xFF;
+		out[1] = ( value >> 8  ) & 0xFF;
+		out[2] = ( value       ) & 0xFF;
+#else
+#error unknown endianness
+#endif
+	}
+	
+	return;
+}
+
+static void Kern_PackS32_C(void* dst, const WAVE_32BS* src, UINT32 length)
+{
+	UINT8* out = (UINT8*)dst;
+	const INT32* in = &src[0].L;
+	UINT32 curVal;
+	INT32 value;
+	
+	for (curVal = 0; curVal < length * 2; curVal ++)
+	{
+		// internal scale is 24-bit, so limit to that
+		value = Clamp24(in[curVal]) * (1 << 8);	// 24 bit -> 32 bit
+		memcpy(&out[curVal * 4], &value, sizeof(value));
+	}
+	
+	return;
+}
+
+static void Kern_PackF32_C(void* dst, const WAVE_32BS* src, UINT32 length)
+{
+	UINT8* out = (UINT8*)dst;
+	const INT32* in = &src[0].L;
+	UINT32 curVal;
+	float v;
+	
+	for (curVal = 0; curVal < length * 2; curVal ++)
+	{
+		// limiting not required here
+		v = in[curVal] / (float)0x800000;
+		memcpy(&out[curVal * 4], &v, sizeof(v));
+	}
+	
+	return;
+}
+
+
+// ---- SSE2 ----
+#ifdef OK_HAVE_SSE2
+OK_TGT_SSE2 INLINE __m128i MulVol_SSE2(__m128i smpl, __m128i vol)
+{
+	// (smpl * vol) >> 16 with 64-bit intermediate
+	// pmuldq (signed) requires SSE4.1, so do an unsigned multiplication and correct the upper half.
+	// Only bits 16..47 of the product are needed.
+	__m128i prodE = _mm_mul_epu32(smpl, vol);	// lanes 0, 2
+	__m128i prodO = _mm_mul_epu32(_mm_srli_epi64(smpl, 32), _mm_srli_epi64(vol, 32));	// lanes 1, 3
+	__m128i tmp01 = _mm_unpacklo_epi32(prodE, prodO);	// lo0 lo1 hi0 hi1
+	__m128i tmp23 = _mm_unpackhi_epi32(prodE, prodO);	// lo2 lo3 hi2 hi3
+	__m128i lo = _mm_unpacklo_epi64(tmp01, tmp23);
+	__m128i hi = _mm_unpackhi_epi64(tmp01, tmp23);
+	__m128i corr = _mm_add_epi32(_mm_and_si128(_mm_srai_epi32(smpl, 31), vol),
+		_mm_and_si128(_mm_srai_epi32(vol, 31), smpl));
+	hi = _mm_sub_epi32(hi, corr);
+	return _mm_or_si128(_mm_srli_epi32(lo, 16), _mm_slli_epi32(hi, 16));
+}
+
+OK_TGT_SSE2 static void Kern_VolConst_SSE2(WAVE_32BS* buf, UINT32 length, INT32 vol, UINT8 chnInvert)
+{
+	UINT32 curSmpl;
+	__m128i volV = _mm_set1_epi32(vol);
+	__m128i neg = _mm_set_epi32(CHN_NEG(chnInvert, 0x02), CHN_NEG(chnInvert, 0x01),
+		CHN_NEG(chnInvert, 0x02), CHN_NEG(chnInvert, 0x01));
+	
+	for (curSmpl = 0; curSmpl + 2 <= length; curSmpl += 2)
+	{
+		__m128i* data = (__m128i*)&buf[curSmpl];
+		__m128i smpl = MulVol_SSE2(_mm_loadu_si128(data), volV);
+		_mm_storeu_si128(data, _mm_sub_epi32(_mm_xor_si128(smpl, neg), neg));
+	}
+	Kern_VolConst_C(&buf[curSmpl], length - curSmpl, vol, chnInvert);
+	
+	return;
+}
+
+OK_TGT_SSE2 static void Kern_VolList_SSE2(WAVE_32BS* buf, UINT32 length, const INT32* volList, UINT8 chnInvert)
+{
+	UINT32 curSmpl;
+	__m128i neg = _mm_set_epi32(CHN_NEG(chnInvert, 0x02), CHN_NEG(chnInvert, 0x01),
+		CHN_NEG(chnInvert, 0x02), CHN_NEG(chnInvert, 0x01));
+	
+	for (curSmpl = 0; curSmpl + 2 <= length; curSmpl += 2)
+	{
+		__m128i* data = (__m128i*)&buf[curSmpl];
+		__m128i vol = _mm_loadl_epi64((const __m128i*)&volList[curSmpl]);
+		__m128i smpl = MulVol_SSE2(_mm_loadu_si128(data), _mm_unpacklo_epi32(vol, vol));
+		_mm_storeu_si128(data, _mm_sub_epi32(_mm_xor_si128(smpl, neg), neg));
+	}
+	Kern_VolList_C(&buf[curSmpl], length - curSmpl, &volList[curSmpl], chnInvert);
+	
+	return;
+}
+
+#ifdef OK_SIMD_PACK
+OK_TGT_SSE2 INLINE __m128i Clamp24_SSE2(__m128i value)
+{
+	// pminsd/pmaxsd require SSE4.1
+	__m128i vMin = _mm_set1_epi32(SMPL_MIN_24);
+	__m128i vMax = _mm_set1_epi32(SMPL_MAX_24);
+	__m128i mask;
+	
+	mask = _mm_cmpgt_epi32(value, vMax);
+	value = _mm_or_si128(_mm_andnot_si128(mask, value), _mm_and_si128(mask, vMax));
+	mask = _mm_cmplt_epi32(value, vMin);
+	value = _mm_or_si128(_mm_andnot_si128(mask, value), _mm_and_si128(mask, vMin));
+	return value;
+}
+
+OK_TGT_SSE2 static void Kern_PackS16_SSE2(void* dst, const WAVE_32BS* src, UINT32 length)
+{
+	UINT32 curSmpl;
+	__m128i* out = (__m128i*)dst;
+	
+	for (curSmpl = 0; curSmpl + 4 <= length; curSmpl += 4, out ++)
+	{
+		const __m128i* in = (const __m128i*)&src[curSmpl];
+		__m128i smp01 = _mm_srai_epi32(_mm_loadu_si128(&in[0]), 8);	// 24 bit -> 16 bit
+		__m128i smp23 = _mm_srai_epi32(_mm_loadu_si128(&in[1]), 8);
+		_mm_storeu_si128(out, _mm_packs_epi32(smp01, smp23));	// with saturation
+	}
+	Kern_PackS16_C(out, &src[curSmpl], length - curSmpl);
+	
+	return;
+}
+
+OK_TGT_SSE2 static void Kern_PackS32_SSE2(void* dst, const WAVE_32BS* src, UINT32 length)
+{
+	UINT32 curSmpl;
+	__m128i* out = (__m128i*)dst;
+	
+	for (curSmpl = 0; curSmpl + 2 <= length; curSmpl += 2, out ++)
+	{
+		__m128i smpl = Clamp24_SSE2(_mm_loadu_si128((const __m128i*)&src[curSmpl]));
+		_mm_storeu_si128(out, _mm_slli_epi32(smpl, 8));	// 24 bit -> 32 bit
+	}
+	Kern_PackS32_C(out, &src[curSmpl], length - curSmpl);
+	
+	return;
+}
+
+OK_TGT_SSE2 static void Kern_PackF32_SSE2(void* dst, const WAVE_32BS* src, UINT32 length)
+{
+	UINT32 curSmpl;
+	float* out = (float*)dst;
+	// multiplying with 1/2^23 is exact, so this is the same as dividing by 0x800000
+	__m128 scale = _mm_set1_ps(1.0f / 0x800000);
+	
+	for (curSmpl = 0; curSmpl + 2 <= length; curSmpl += 2, out += 4)
+	{
+		__m128i smpl = _mm_loadu_si128((const __m128i*)&src[curSmpl]);
+		_mm_storeu_ps(out, _mm_mul_ps(_mm_cvtepi32_ps(smpl), scale));
+	}
+	Kern_PackF32_C(out, &src[curSmpl], length - curSmpl);
+	
+	return;
+}
+#define PACK_S16_SSE2	Kern_PackS16_SSE2
+#define PACK_S32_SSE2	Kern_PackS32_SSE2
+#define PACK_F32_SSE2	Kern_PackF32_SSE2
+#else
+#define PACK_S16_SSE2	Kern_PackS16_C
+#define PACK_S32_SSE2	Kern_PackS32_C
+#define PACK_F32_SSE2	Kern_PackF32_C
+#endif	// OK_SIMD_PACK
+
+static const OUT_KERNELS kernSSE2 =
+{
+	OUTKERN_TYPE_SSE2,
+	Kern_VolConst_SSE2,
+	Kern_VolList_SSE2,
+	{Kern_PackU8_C, PACK_S16_SSE2, Kern_PackS24_C, PACK_S32_SSE2, PACK_F32_SSE2},
+};
+#endif	// OK_HAVE_SSE2
+
+
+// ---- AVX2 ----
+#ifdef OK_HAVE_AVX2
+OK_TGT_AVX2 INLINE __m256i MulVol_AVX2(__m256i smpl, __m256i vol)
+{
+	// (smpl * vol) >> 16 with 64-bit intermediate, only the lower 32 bits of the result are kept
+	__m256i prodE = _mm256_mul_epi32(smpl, vol);	// even lanes
+	__m256i prodO = _mm256_mul_epi32(_mm256_srli_epi64(smpl, 32), _mm256_srli_epi64(vol, 32));	// odd lanes
+	prodE = _mm256_srli_epi64(prodE, 16);
+	prodO = _mm256_slli_epi64(_mm256_srli_epi64(prodO, 16), 32);
+	return _mm256_blend_epi32(prodE, prodO, 0xAA);
+}
+
+OK_TGT_AVX2 static void Kern_VolConst_AVX2(WAVE_32BS* buf, UINT32 length, INT32 vol, UINT8 chnInvert)
+{
+	UINT32 curSmpl;
+	__m256i volV = _mm256_set1_epi32(vol);
+	INT32 negL = CHN_NEG(chnInvert, 0x01);
+	INT32 negR = CHN_NEG(chnInvert, 0x02);
+	__m256i neg = _mm256_set_epi32(negR, negL, negR, negL, negR, negL, negR, negL);
+	
+	for (curSmpl = 0; curSmpl + 4 <= length; curSmpl += 4)
+	{
+		__m256i* data = (__m256i*)&buf[curSmpl];
+		__m256i smpl = MulVol_AVX2(_mm256_loadu_si256(data), volV);
+		_mm256_storeu_si256(data, _mm256_sub_epi32(_mm256_xor_si256(smpl, neg), neg));
+	}
+	Kern_VolConst_C(&buf[curSmpl], length - curSmpl, vol, chnInvert);
+	
+	return;
+}
+
+OK_TGT_AVX2 static void Kern_VolList_AVX2(WAVE_32BS* buf, UINT32 length, const INT32* volList, UINT8 chnInvert)
+{
+	UINT32 curSmpl;
+	INT32 negL = CHN_NEG(chnInvert, 0x01);
+	INT32 negR = CHN_NEG(chnInvert, 0x02);
+	__m256i neg = _mm256_set_epi32(negR, negL, negR, negL, negR, negL, negR, negL);
+	__m256i volIdx = _mm256_set_epi32(3, 3, 2, 2, 1, 1, 0, 0);
+	
+	for (curSmpl = 0; curSmpl + 4 <= length; curSmpl += 4)
+	{
+		__m256i* data = (__m256i*)&buf[curSmpl];
+		__m256i vol = _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)&volList[curSmpl]));
+		__m256i smpl = MulVol_AVX2(_mm256_loadu_si256(data), _mm256_permutevar8x32_epi32(vol, volIdx));
+		_mm256_storeu_si256(data, _mm256_sub_epi32(_mm256_xor_si256(smpl, neg), neg));
+	}
+	Kern_VolList_C(&buf[curSmpl], length - curSmpl, &volList[curSmpl], chnInvert);
+	
+	return;
+}
+
+// The packing functions are limited by memory bandwidth, so the SSE2 versions are used.
+static const OUT_KERNELS kernAVX2 =
+{
+	OUTKERN_TYPE_AVX2,
+	Kern_VolConst_AVX2,
+	Kern_VolList_AVX2,
+	{Kern_PackU8_C, PACK_S16_SSE2, Kern_PackS24_C, PACK_S32_SSE2, PACK_F32_SSE2},
+};
+#endif	// OK_HAVE_AVX2
+
+
+// ---- NEON ----
+#ifdef OK_HAVE_NEON
+INLINE int32x4_t MulVol_NEON(int32x4_t smpl, int32x4_t vol)
+{
+	// (smpl * vol) >> 16 with 64-bit intermediate, vshrn keeps the lower 32 bits
+	int64x2_t prodLo = vmull_s32(vget_low_s32(smpl), vget_low_s32(vol));
+	int64x2_t prodHi = vmull_s32(vget_high_s32(smpl), vget_high_s32(vol));
+	return vcombine_s32(vshrn_n_s64(prodLo, 16), vshrn_n_s64(prodHi, 16));
+}
+
+static void Kern_VolConst_NEON(WAVE_32BS* buf, UINT32 length, INT32 vol, UINT8 chnInvert)
+{
+	UINT32 curSmpl;
+	int32x4_t volV = vdupq_n_s32(vol);
+	int32x2_t neg2 = vset_lane_s32(CHN_NEG(chnInvert, 0x02), vdup_n_s32(CHN_NEG(chnInvert, 0x01)), 1);
+	int32x4_t neg = vcombine_s32(neg2, neg2);
+	
+	for (curSmpl = 0; curSmpl + 2 <= length; curSmpl += 2)
+	{
+		int32_t* data = (int32_t*)&buf[curSmpl];
+		int32x4_t smpl = MulVol_NEON(vld1q_s32(data), volV);
+		vst1q_s32(data, vsubq_s32(veorq_s32(smpl, neg), neg));
+	}
+	Kern_VolConst_C(&buf[curSmpl], length - curSmpl, vol, chnInvert);
+	
+	return;
+}
+
+static void Kern_VolList_NEON(WAVE_32BS* buf, UINT32 length, const INT32* volList, UINT8 chnInvert)
+{
+	UINT32 curSmpl;
+	int32x2_t neg2 = vset_lane_s32(CHN_NEG(chnInvert, 0x02), vdup_n_s32(CHN_NEG(chnInvert, 0x01)), 1);
+	int32x4_t neg = vcombine_s32(neg2, neg2);
+	
+	for (curSmpl = 0; curSmpl + 2 <= length; curSmpl += 2)
+	{
+		int32_t* data = (int32_t*)&buf[curSmpl];
+		int32x4_t vol = vcombine_s32(vdup_n_s32(volList[curSmpl + 0]), vdup_n_s32(volList[curSmpl + 1]));
+		int32x4_t smpl = MulVol_NEON(vld1q_s32(data), vol);
+		vst1q_s32(data, vsubq_s32(veorq_s32(smpl, neg), neg));
+	}
+	Kern_VolList_C(&buf[curSmpl], length - curSmpl, &volList[curSmpl], chnInvert);
+	
+	return;
+}
+
+#ifdef OK_SIMD_PACK
+static void Kern_PackS16_NEON(void* dst, const WAVE_32BS* src, UINT32 length)
+{
+	UINT32 curSmpl;
+	int16_t* out = (int16_t*)dst;
+	
+	for (curSmpl = 0; curSmpl + 4 <= length; curSmpl += 4, out += 8)
+	{
+		const int32_t* in = (const int32_t*)&src[curSmpl];
+		int16x4_t smp01 = vqmovn_s32(vshrq_n_s32(vld1q_s32(&in[0]), 8));	// 24 bit -> 16 bit, with saturation
+		int16x4_t smp23 = vqmovn_s32(vshrq_n_s32(vld1q_s32(&in[4]), 8));
+		vst1q_s16(out, vcombine_s16(smp01, smp23));
+	}
+	Kern_PackS16_C(out, &src[curSmpl], length - curSmpl);
+	
+	return;
+}
+
+static void Kern_PackS32_NEON(void* dst, const WAVE_32BS* src, UINT32 length)
+{
+	UINT32 curSmpl;
+	int32_t* out = (int32_t*)dst;
+	int32x4_t vMin = vdupq_n_s32(SMPL_MIN_24);
+	int32x4_t vMax = vdupq_n_s32(SMPL_MAX_24);
+	
+	for (curSmpl = 0; curSmpl + 2 <= length; curSmpl += 2, out += 4)
+	{
+		int32x4_t smpl = vld1q_s32((const int32_t*)&src[curSmpl]);
+		smpl = vmaxq_s32(vminq_s32(smpl, vMax), vMin);
+		vst1q_s32(out, vshlq_n_s32(smpl, 8));	// 24 bit -> 32 bit
+	}
+	Kern_PackS32_C(out, &src[curSmpl], length - curSmpl);
+	
+	return;
+}
+
+static void Kern_PackF32_NEON(void* dst, const WAVE_32BS* src, UINT32 length)
+{
+	UINT32 curSmpl;
+	float* out = (float*)dst;
+	
+	for (curSmpl = 0; curSmpl + 2 <= length; curSmpl += 2, out += 4)
+	{
+		float32x4_t smpl = vcvtq_f32_s32(vld1q_s32((const int32_t*)&src[curSmpl]));
+		vst1q_f32(out, vmulq_n_f32(smpl, 1.0f / 0x800000));
+	}
+	Kern_PackF32_C(out, &src[curSmpl], length - curSmpl);
+	
+	return;
+}
+#define PACK_S16_NEON	Kern_PackS16_NEON
+#define PACK_S32_NEON	Kern_PackS32_NEON
+#define PACK_F32_NEON	Kern_PackF32_NEON
+#else
+#define PACK_S16_NEON	Kern_PackS16_C
+#define PACK_S32_NEON	Kern_PackS32_C
+#define PACK_F32_NEON	Kern_PackF32_C
+#endif	// OK_SIMD_PACK
+
+static const OUT_KERNELS kernNEON =
+{
+	OUTKERN_TYPE_NEON,
+	Kern_VolConst_NEON,
+	Kern_VolList_NEON,
+	{Kern_PackU8_C, PACK_S16_NEON, Kern_PackS24_C, PACK_S32_NEON, PACK_F32_NEON},
+};
+#endif	// OK_HAVE_NEON
+
+
+static const OUT_KERNELS kernC =
+{
+	OUTKERN_TYPE_C,
+	Kern_VolConst_C,
+	Kern_VolList_C,
+	{Kern_PackU8_C, Kern_PackS16_C, Kern_PackS24_C, Kern_PackS32_C, Kern_PackF32_C},
+};
+
+
+// ---- CPU feature detection ----
+#if defined(OK_HAVE_SSE2) && ! defined(OK_SSE2_ALWAYS)
+static UINT8 CPU_HasSSE2(void)
+{
+#if defined(_MSC_VER)
+	int cpuInfo[4];
+	__cpuid(cpuInfo, 1);
+	return (cpuInfo[3] >> 26) & 0x01;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("sse2") ? 1 : 0;
+#endif
+}
+#endif
+
+#ifdef OK_HAVE_AVX2
+static UINT8 CPU_HasAVX2(void)
+{
+#if defined(_MSC_VER)
+	int cpuInfo[4];
+	__cpuid(cpuInfo, 0);
+	if (cpuInfo[0] < 7)
+		return 0;
+	__cpuid(cpuInfo, 1);
+	if (((cpuInfo[2] >> 27) & 0x03) != 0x03)	// require OSXSAVE + AVX
+		return 0;
+	if ((_xgetbv(0) & 0x06) != 0x06)	// OS saves XMM + YMM registers
+		return 0;
+	__cpuidex(cpuInfo, 7, 0);
+	return (cpuInfo[1] >> 5) & 0x01;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") ? 1 : 0;
+#endif
+}
+#endif
+
+const OUT_KERNELS* OutKern_Get(UINT8 type)
+{
+	switch(type)
+	{
+	case OUTKERN_TYPE_C:
+		return &kernC;
+#ifdef OK_HAVE_SSE2
+	case OUTKERN_TYPE_SSE2:
+#ifndef OK_SSE2_ALWAYS
+		if (! CPU_HasSSE2())
+			return NULL;
+#endif
+		return &kernSSE2;
+#endif
+#ifdef OK_HAVE_AVX2
+	case OUTKERN_TYPE_AVX2:
+		return CPU_HasAVX2() ? &kernAVX2 : NULL;
+#endif
+#ifdef OK_HAVE_NEON
+	case OUTKERN_TYPE_NEON:
+		return &kernNEON;
+#endif
+	default:
+		return NULL;
+	}
+}
+
+const OUT_KERNELS* OutKern_GetBest(void)
+{
+	static const UINT8 KERN_ORDER[] = {OUTKERN_TYPE_AVX2, OUTKERN_TYPE_NEON, OUTKERN_TYPE_SSE2};
+	const OUT_KERNELS* kern;
+	size_t curKern;
+	
+	for (curKern = 0; curKern < sizeof(KERN_ORDER) / sizeof(KERN_ORDER[0]); curKern ++)
+	{
+		kern = OutKern_Get(KERN_ORDER[curKern]);
+		if (kern != NULL)
+			return kern;
+	}
+	return &kernC;
+}
@@ -0,0 +1,62 @@
+#ifndef __OUTKERNELS_H__
+#define __OUTKERNELS_H__
+
+// internal header - kernels used by PlayerA for the final processing (volume + sample packing)
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "../stdtype.h"
+#include "../emu/Resampler.h"	// for WAVE_32BS
+
+// kernel types
+#define OUTKERN_TYPE_C		0x00	// plain C (always available)
+#define OUTKERN_TYPE_SSE2	0x01
+#define OUTKERN_TYPE_AVX2	0x02
+#define OUTKERN_TYPE_NEON	0x03
+
+// output sample formats
+#define OUTFMT_U8		0x00	// 8-bit unsigned
+#define OUTFMT_S16		0x01	// 16-bit signed
+#define OUTFMT_S24		0x02	// 24-bit signed (packed, 3 bytes)
+#define OUTFMT_S32		0x03	// 32-bit signed
+#define OUTFMT_F32		0x04	// 32-bit float
+#define OUTFMT_COUNT	0x05
+
+// buf[i] = (buf[i] * vol) >> 16 (with 64-bit intermediate, vol is 16.16 fixed point)
+// chnInvert: negate the result for the left (bit 0) / right (bit 1) channel
+typedef void (*OUTKERN_VOL_CONST)(WAVE_32BS* buf, UINT32 length, INT32 vol, UINT8 chnInvert);
+// same as OUTKERN_VOL_CONST, but with a separate volume for each sample
+typedef void (*OUTKERN_VOL_LIST)(WAVE_32BS* buf, UINT32 length, const INT32* volList, UINT8 chnInvert);
+// convert samples with 24-bit scale into the output format (native byte order), with saturation
+typedef void (*OUTKERN_PACK)(void* dst, const WAVE_32BS* src, UINT32 length);
+
+typedef struct _output_kernels
+{
+	UINT8 type;	// see OUTKERN_TYPE_ constants
+	OUTKERN_VOL_CONST volConst;
+	OUTKERN_VOL_LIST volList;
+	OUTKERN_PACK pack[OUTFMT_COUNT];	// indexed by OUTFMT_ constants
+} OUT_KERNELS;
+
+/**
+ * @brief Returns the fastest set of kernels that is supported by the CPU.
+ *
+ * @return kernel set, never NULL
+ */
+const OUT_KERNELS* OutKern_GetBest(void);
+/**
+ * @brief Returns a specific set of kernels.
+ *
+ * @param type kernel type, see OUTKERN_TYPE_ constants
+ * @return kernel set or NULL if it is not supported by the CPU or compiler
+ */
+const OUT_KERNELS* OutKern_Get(UINT8 type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// __OUTKERNELS_H__
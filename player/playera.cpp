@@ -6,87 +6,24 @@
 #include "../utils/DataLoader.h"
 #include "playerbase.hpp"
 #include "../emu/Resampler.h"
+#include "outkernels.h"
 
 #include "playera.hpp"
 
-static void SampleConv_toU8(void* buffer, INT32 value)
-{
-	value >>= 16;	// 24 bit -> 8 bit
-	if (value < -0x80)
-		value = -0x80;
-	else if (value > +0x7F)
-		value = +0x7F;
-	*(UINT8*)buffer = (UINT8)(0x80 + value);
-	return;
-}
-
-static void SampleConv_toS16(void* buffer, INT32 value)
-{
-	INT16 v;
-	value >>= 8;	// 24 bit -> 16 bit
-	if (value < -0x8000)
-		value = -0x8000;
-	else if (value > +0x7FFF)
-		value = +0x7FFF;
-	v = (INT16)value;
-	memcpy(buffer,&v,sizeof(v));
-	return;
-}
-
-static void SampleConv_toS24(void* buffer, INT32 value)
-{
-	UINT8 tmp[3];
-	if (value < -0x800000)
-		value = -0x800000;
-	else if (value > +0x7FFFFF)
-		value = +0x7FFFFF;
-#if defined(VGM_LITTLE_ENDIAN)
-	tmp[0] = ( value       ) & 0xFF;
-	tmp[1] = ( value >> 8  ) & 0xFF;
-	tmp[2] = ( value >> 16 ) & 0xFF;
-#elif defined(VGM_BIG_ENDIAN)
-	tmp[0] = ( value >> 16 ) & 0xFF;
-	tmp[1] = ( value >> 8  ) & 0xFF;
-	tmp[2] = ( value       ) & 0xFF;
-#else
-#error unknown endianness
-#endif
-	memcpy(buffer,tmp,sizeof(tmp));
-	return;
-}
-
-static void SampleConv_toS32(void* buffer, INT32 value)
-{
-	// internal scale is 24-bit, so limit to that
-	if (value < -0x800000)
-		value = -0x800000;
-	else if (value > +0x7FFFFF)
-		value = +0x7FFFFF;
-	value *= (1 << 8);	// 24 bit -> 32 bit
-	memcpy(buffer,&value,sizeof(value));
-	return;
-}
-
-static void SampleConv_toF32(void* buffer, INT32 value)
-{
-	// limiting not required here
-	float v = value / (float)0x800000;
-	memcpy(buffer,&v,sizeof(v));
-	return;
-}
-
-static PlayerA::PLR_SMPL_PACK GetSampleConvFunc(UINT8 bits)
+static UINT8 GetOutputFormat(UINT8 bits, bool isFloat)
 {
+	if (isFloat)
+		return (bits == 32) ? OUTFMT_F32 : 0xFF;
 	if (bits == 8)
-		return SampleConv_toU8;
+		return OUTFMT_U8;
 	else if (bits == 16)
-		return SampleConv_toS16;
+		return OUTFMT_S16;
 	else if (bits == 24)
-		return SampleConv_toS24;
+		return OUTFMT_S24;
 	else if (bits == 32)
-		return SampleConv_toS32;
+		return OUTFMT_S32;
 	else
-		return NULL;
+		return 0xFF;
 }
 
 PlayerA::PlayerA()
@@ -101,7 +38,8 @@ PlayerA::PlayerA()
 	
 	_outSmplChns = 2;
 	_outSmplBits = 16;
-	_outSmplPack = GetSampleConvFunc(_outSmplBits);
+	_outSmplFmt = GetOutputFormat(_outSmplBits, false);
+	_outKern = OutKern_GetBest();
 	_smplRate = 44100;
 	_outSmplSize1 = _outSmplBits / 8;
 	_outSmplSizeA = _outSmplSize1 * _outSmplChns;
@@ -153,17 +91,18 @@ UINT8 PlayerA::SetOutputSettings(UINT32 smplRate, UINT8 channels, UINT8 smplBits
 {
 	if (channels != 2)
 		return 0xF0;	// TODO: support channels = 1
-	PLR_SMPL_PACK smplPackFunc = GetSampleConvFunc(smplBits);
-	if (smplPackFunc == NULL)
+	UINT8 smplFmt = GetOutputFormat(smplBits & ~PLR_SMPLFMT_FLOAT, (smplBits & PLR_SMPLFMT_FLOAT) != 0);
+	if (smplFmt == 0xFF)
 		return 0xF1;	// unsupported sample format
 	
 	_outSmplChns = channels;
-	_outSmplBits = smplBits;
-	_outSmplPack = smplPackFunc;
+	_outSmplBits = smplBits & ~PLR_SMPLFMT_FLOAT;
+	_outSmplFmt = smplFmt;
 	SetSampleRate(smplRate);
 	_outSmplSize1 = _outSmplBits / 8;
 	_outSmplSizeA = _outSmplSize1 * _outSmplChns;
 	_smplBuf.resize(smplBufferLen);
+	_volBuf.resize(smplBufferLen);
 	return 0x00;
 }
 
@@ -400,6 +339,18 @@ UINT8 PlayerA::LoadFile(DATA_LOADER* dLoad)
 	return retVal;
 }
 
+UINT8 PlayerA::ProbeFile(DATA_LOADER* dLoad)
+{
+	_dLoad = dLoad;
+	FindPlayerEngine();
+	if (_player == NULL)
+		return 0xFF;
+	
+	_player->SetSampleRate(_smplRate);
+	_player->SetPlaybackSpeed(_config.pbSpeed);
+	return _player->ProbeFile(dLoad);
+}
+
 UINT8 PlayerA::UnloadFile(void)
 {
 	if (_player == NULL)
@@ -484,21 +435,6 @@ UINT8 PlayerA::Seek(UINT8 unit, UINT32 pos)
 	return retVal;
 }
 
-#if 1
-#define VOLCALC64
-#define VOL_BITS	16	// use .X fixed point for working volume
-#else
-#define VOL_BITS	8	// use .X fixed point for working volume
-#endif
-#define VOL_SHIFT	(16 - VOL_BITS)	// shift for master volume -> working volume
-
-// Pre- and post-shifts are used to make the calculations as accurate as possible
-// without causing the sample data (likely 24 bits) to overflow while applying the volume gain.
-// Smaller values for VOL_PRESH are more accurate, but have a higher risk of overflows during calculations.
-// (24 + VOL_POSTSH) must NOT be larger than 31
-#define VOL_PRESH	4	// sample data pre-shift
-#define VOL_POSTSH	(VOL_BITS - VOL_PRESH)	// post-shift after volume multiplication
-
 // 16.16 fixed point multiplication
 #define MUL16X16_FIXED(a, b)	(INT32)(((INT64)a * b) >> 16)
 
@@ -517,41 +453,57 @@ INT32 PlayerA::CalcSongVolume(void)
 	return volume;
 }
 
-INT32 PlayerA::CalcCurrentVolume(UINT32 playbackSmpl)
+// Fills volList with the volume of each sample (master volume + fade-out factor).
+// The fade position is advanced incrementally, so there is no division per sample.
+void PlayerA::CalcFadeVolumes(UINT32 playbackSmpl, UINT32 smplCount, INT32* volList)
 {
-	INT32 curVol;	// 16.16 fixed point
+	UINT32 curSmpl;
+	UINT32 fadeSmpls;
 	
-	// 1. master volume
-	curVol = _songVolume;
+	// samples before the fade starts
+	for (curSmpl = 0; curSmpl < smplCount && playbackSmpl + curSmpl < _fadeSmplStart; curSmpl ++)
+		volList[curSmpl] = _songVolume;
+	if (curSmpl >= smplCount)
+		return;
 	
-	// 2. apply fade-out factor
-	if (playbackSmpl >= _fadeSmplStart)
+	fadeSmpls = playbackSmpl + curSmpl - _fadeSmplStart;
+	if (fadeSmpls < _config.fadeSmpls)
 	{
-		UINT32 fadeSmpls;
-		UINT64 fadeVol;	// 64 bit for less type casts when doing multiplications with .16 fixed point
-		
-		fadeSmpls = playbackSmpl - _fadeSmplStart;
-		if (fadeSmpls >= _config.fadeSmpls)
-			return 0x0000;	// going beyond fade time -> volume 0
+		// fadePos = fadeSmpls * 0x10000 / fadeLen, fadeRem = remainder of the division
+		UINT32 fadeLen = _config.fadeSmpls;
+		UINT32 fadeStep = 0x10000 / fadeLen;
+		UINT32 fadeStepRem = 0x10000 % fadeLen;
+		UINT32 fadePos = (UINT32)((UINT64)fadeSmpls * 0x10000 / fadeLen);
+		UINT32 fadeRem = (UINT32)((UINT64)fadeSmpls * 0x10000 % fadeLen);
 		
-		fadeVol = (UINT64)fadeSmpls * 0x10000 / _config.fadeSmpls;
-		fadeVol = 0x10000 - fadeVol;	// fade from full volume to silence
-		fadeVol = fadeVol * fadeVol;	// logarithmic fading sounds nicer
-		curVol = (INT32)(((INT64)fadeVol * curVol) >> 32);
+		for (; curSmpl < smplCount && fadeSmpls < fadeLen; curSmpl ++, fadeSmpls ++)
+		{
+			UINT64 fadeVol = 0x10000 - fadePos;	// fade from full volume to silence
+			fadeVol = fadeVol * fadeVol;	// logarithmic fading sounds nicer
+			volList[curSmpl] = (INT32)(((INT64)fadeVol * _songVolume) >> 32);
+			
+			fadePos += fadeStep;
+			fadeRem += fadeStepRem;
+			if (fadeRem >= fadeLen)
+			{
+				fadePos ++;
+				fadeRem -= fadeLen;
+			}
+		}
 	}
+	// going beyond fade time -> volume 0
+	for (; curSmpl < smplCount; curSmpl ++)
+		volList[curSmpl] = 0;
 	
-	return curVol;
+	return;
 }
 
 UINT32 PlayerA::Render(UINT32 bufSize, void* data)
 {
-	UINT8* bData = (UINT8*)data;
 	UINT32 basePbSmpl;
 	UINT32 smplCount;
-	UINT32 smplRendered;
-	UINT32 curSmpl;
-	WAVE_32BS fnlSmpl;	// final sample value
-	INT32 curVolume;
+	UINT64 blkEnd;
+	bool finished;
 	
 	smplCount = bufSize / _outSmplSizeA;
 	if (_player == NULL)
@@ -576,60 +528,58 @@ UINT32 PlayerA::Render(UINT32 bufSize, void* data)
 		smplCount = (UINT32)_smplBuf.size();
 	memset(&_smplBuf[0], 0, smplCount * sizeof(WAVE_32BS));
 	basePbSmpl = _player->GetCurPos(PLAYPOS_SAMPLE);
-	smplRendered = _player->Render(smplCount, &_smplBuf[0]);
-	smplCount = smplRendered;
+	smplCount = _player->Render(smplCount, &_smplBuf[0]);
+	blkEnd = (UINT64)basePbSmpl + smplCount;
 	
-	curVolume = CalcCurrentVolume(basePbSmpl) >> VOL_SHIFT;
-	for (curSmpl = 0; curSmpl < smplCount; curSmpl ++, basePbSmpl ++)
+	// 1. find the end of the fade and the end of the trailing silence within this block
+	if (_fadeSmplStart != (UINT32)-1 && ! (_myPlayState & PLAYSTATE_END))
 	{
-		if (basePbSmpl >= _fadeSmplStart)
+		UINT64 fadeEnd = (UINT64)_fadeSmplStart + _config.fadeSmpls;
+		if (fadeEnd < basePbSmpl)
+			fadeEnd = basePbSmpl;
+		if (fadeEnd < blkEnd)
 		{
-			UINT32 fadeSmpls = basePbSmpl - _fadeSmplStart;
-			if (fadeSmpls >= _config.fadeSmpls && ! (_myPlayState & PLAYSTATE_END))
-			{
-				if (_endSilenceStart == (UINT32)-1)
-					_endSilenceStart = basePbSmpl;
-				_myPlayState |= PLAYSTATE_END;
-			}
-			
-			curVolume = CalcCurrentVolume(basePbSmpl) >> VOL_SHIFT;
+			if (_endSilenceStart == (UINT32)-1)
+				_endSilenceStart = (UINT32)fadeEnd;
+			_myPlayState |= PLAYSTATE_END;
 		}
-		if (basePbSmpl >= _endSilenceStart)
+	}
+	finished = false;
+	if (_endSilenceStart != (UINT32)-1 && ! (_myPlayState & PLAYSTATE_FIN))
+	{
+		UINT64 silenceEnd = (UINT64)_endSilenceStart + _config.endSilenceSmpls;
+		if (silenceEnd < basePbSmpl)
+			silenceEnd = basePbSmpl;
+		if (silenceEnd < blkEnd)
 		{
-			UINT32 silenceSmpls = basePbSmpl - _endSilenceStart;
-			if (silenceSmpls >= _config.endSilenceSmpls && ! (_myPlayState & PLAYSTATE_FIN))
-			{
-				_myPlayState |= PLAYSTATE_FIN;
-				if (_plrCbFunc != NULL)
-					_plrCbFunc(_player, _plrCbParam, PLREVT_END, NULL);
-				// NOTE: We are effectively discarding rendered samples here!
-				// We can get away with that for now, as the application is supposed to
-				// stop playback at this point, but we shouldn't really do this.
-				break;
-			}
+			// NOTE: We are effectively discarding rendered samples here!
+			// We can get away with that for now, as the application is supposed to
+			// stop playback at this point, but we shouldn't really do this.
+			smplCount = (UINT32)(silenceEnd - basePbSmpl);
+			_myPlayState |= PLAYSTATE_FIN;
+			finished = true;
 		}
-		
-		// Input is about 24 bits (some cores might output a bit more)
-		fnlSmpl = _smplBuf[curSmpl];
-		
-#ifdef VOLCALC64
-		fnlSmpl.L = (INT32)( ((INT64)fnlSmpl.L * curVolume) >> VOL_BITS );
-		fnlSmpl.R = (INT32)( ((INT64)fnlSmpl.R * curVolume) >> VOL_BITS );
-#else
-		fnlSmpl.L = ((fnlSmpl.L >> VOL_PRESH) * curVolume) >> VOL_POSTSH;
-		fnlSmpl.R = ((fnlSmpl.R >> VOL_PRESH) * curVolume) >> VOL_POSTSH;
-#endif
-		
-		if (_config.chnInvert & 0x01)
-			fnlSmpl.L = -fnlSmpl.L;
-		if (_config.chnInvert & 0x02)
-			fnlSmpl.R = -fnlSmpl.R;
-		
-		_outSmplPack(&bData[(curSmpl * 2 + 0) * _outSmplSize1], fnlSmpl.L);
-		_outSmplPack(&bData[(curSmpl * 2 + 1) * _outSmplSize1], fnlSmpl.R);
 	}
 	
-	return curSmpl * _outSmplSizeA;
+	// 2. apply volume and phase inversion
+	// Input is about 24 bits (some cores might output a bit more)
+	if (blkEnd <= _fadeSmplStart)
+	{
+		_outKern->volConst(&_smplBuf[0], smplCount, _songVolume, _config.chnInvert);
+	}
+	else
+	{
+		CalcFadeVolumes(basePbSmpl, smplCount, &_volBuf[0]);
+		_outKern->volList(&_smplBuf[0], smplCount, &_volBuf[0], _config.chnInvert);
+	}
+	
+	// 3. convert to the output format
+	_outKern->pack[_outSmplFmt](data, &_smplBuf[0], smplCount);
+	
+	if (finished && _plrCbFunc != NULL)
+		_plrCbFunc(_player, _plrCbParam, PLREVT_END, NULL);
+	
+	return smplCount * _outSmplSizeA;
 }
 
 /*static*/ UINT8 PlayerA::PlayCallbackS(PlayerBase* player, void* userParam, UINT8 evtType, void* evtParam)
@@ -17,6 +17,10 @@
 #define PLAYTIME_WITH_FADE	0x10	// include fade out time (looping songs only)
 #define PLAYTIME_WITH_SLNC	0x20	// include silence after songs
 
+#define PLR_SMPLFMT_FLOAT	0x80	// flag for SetOutputSettings: use floating point samples (smplBits must be 32)
+
+struct _output_kernels;
+
 // TODO: find a proper name for this class
 class PlayerA
 {
@@ -31,7 +35,6 @@ public:
 		UINT32 endSilenceSmpls;
 		double pbSpeed;
 	};
-	typedef void (*PLR_SMPL_PACK)(void* buffer, INT32 value);
 
 	PlayerA();
 	~PlayerA();
@@ -69,6 +72,7 @@ public:
 	const PlayerBase* GetPlayer(void) const;
 	
 	UINT8 LoadFile(DATA_LOADER* dLoad);
+	UINT8 ProbeFile(DATA_LOADER* dLoad);	// load song information and tags only (see PlayerBase::ProbeFile)
 	UINT8 UnloadFile(void);
 	UINT32 GetFileSize(void);
 	UINT8 Start(void);
@@ -80,7 +84,7 @@ public:
 private:
 	void FindPlayerEngine(void);
 	INT32 CalcSongVolume(void);
-	INT32 CalcCurrentVolume(UINT32 playbackSmpl);
+	void CalcFadeVolumes(UINT32 playbackSmpl, UINT32 smplCount, INT32* volList);
 	static UINT8 PlayCallbackS(PlayerBase* player, void* userParam, UINT8 evtType, void* evtParam);
 	UINT8 PlayCallback(PlayerBase* player, UINT8 evtType, void* evtParam);
 	
@@ -95,8 +99,10 @@ private:
 	UINT8 _outSmplBits;
 	UINT32 _outSmplSize1;	// for 1 channel
 	UINT32 _outSmplSizeA;	// for all channels
-	PLR_SMPL_PACK _outSmplPack;
+	UINT8 _outSmplFmt;	// see OUTFMT_ constants
+	const struct _output_kernels* _outKern;
 	std::vector<WAVE_32BS> _smplBuf;
+	std::vector<INT32> _volBuf;	// volume for each sample while fading
 	PlayerBase* _player;
 	DATA_LOADER* _dLoad;
 	INT32 _songVolume;
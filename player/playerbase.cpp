@@ -5,6 +5,8 @@
 
 PlayerBase::PlayerBase() :
 	_outSmplRate(0),
+	_userDevList(NULL),
+	_devStartOpts(0),
 	_eventCbFunc(NULL),
 	_eventCbParam(NULL),
 	_fileReqCbFunc(NULL),
@@ -12,6 +14,10 @@ PlayerBase::PlayerBase() :
 	_logCbFunc(NULL),
 	_logCbParam(NULL)
 {
+#ifdef PLAYER_PROFILING
+	_profParseCalls = 0;
+	_profParseTime = 0;
+#endif
 }
 
 PlayerBase::~PlayerBase()
@@ -38,6 +44,12 @@ UINT8 PlayerBase::CanLoadFile(DATA_LOADER *dataLoader) const
 	return this->PlayerCanLoadFile(dataLoader);
 }
 
+UINT8 PlayerBase::ProbeFile(DATA_LOADER *dataLoader)
+{
+	// default: formats without a faster way need the whole file
+	return LoadFile(dataLoader);
+}
+
 /*static*/ UINT8 PlayerBase::InitDeviceOptions(PLR_DEV_OPTS& devOpts)
 {
 	devOpts.emuCore[0] = 0x00;
@@ -119,3 +131,63 @@ UINT32 PlayerBase::GetTotalPlayTicks(UINT32 numLoops) const
 		return (UINT32)-1;
 	return GetTotalTicks() + GetLoopTicks() * (numLoops - 1);
 }
+
+UINT8 PlayerBase::GetProfile(PLR_PROFILE& prof) const
+{
+	// Players fill prof.devices after calling this.
+#ifdef PLAYER_PROFILING
+	prof.parseCalls = _profParseCalls;
+	prof.parseTime = _profParseTime;
+	prof.devices.clear();
+	return 0x00;
+#else
+	return 0xFF;	// not compiled in
+#endif
+}
+
+void PlayerBase::ResetProfile(void)
+{
+#ifdef PLAYER_PROFILING
+	_profParseCalls = 0;
+	_profParseTime = 0;
+#endif
+	return;
+}
+
+#ifdef PLAYER_PROFILING
+/*static*/ void PlayerBase::AddDevProfiles(std::vector<PLR_DEV_PROFILE>& devProfs, UINT32 id, const VGM_BASEDEV* cBaseDev)
+{
+	const VGM_BASEDEV* clDev;
+	UINT8 linkIdx;
+	
+	for (clDev = cBaseDev, linkIdx = 0; clDev != NULL; clDev = clDev->linkDev, linkIdx ++)
+	{
+		PLR_DEV_PROFILE devProf;
+		
+		if (clDev->defInf.dataPtr == NULL)
+			continue;
+		devProf.id = id;
+		devProf.linkIdx = linkIdx;
+		devProf.type = (clDev->defInf.devDecl != NULL) ? clDev->defInf.devDecl->deviceID : 0xFF;
+		devProf.updCalls = clDev->prof.updCalls;
+		devProf.updSmpls = clDev->prof.updSmpls;
+		devProf.updTime = clDev->prof.updTime;
+		devProf.rsmplCalls = clDev->prof.rsmplCalls;
+		devProf.rsmplTime = clDev->prof.rsmplTime;
+		devProf.regWrites = clDev->prof.regWrites;
+		devProf.dacStrmCmds = clDev->prof.dacStrmCmds;
+		devProfs.push_back(devProf);
+	}
+	
+	return;
+}
+
+/*static*/ void PlayerBase::ResetDevProfiles(VGM_BASEDEV* cBaseDev)
+{
+	VGM_BASEDEV* clDev;
+	
+	for (clDev = cBaseDev; clDev != NULL; clDev = clDev->linkDev)
+		DevProf_Reset(clDev);
+	return;
+}
+#endif
@@ -5,6 +5,7 @@
 #include "../emu/EmuStructs.h"	// for DEV_DECL, DEV_GEN_CFG
 #include "../emu/Resampler.h"	// for WAVE_32BS
 #include "../utils/DataLoader.h"
+#include "helper.h"	// for VGM_BASEDEV
 #include <vector>
 
 
@@ -86,7 +87,7 @@ struct PLR_DEV_OPTS
 {
 	UINT32 emuCore[2];	// enforce a certain sound core (0 = use default, [1] is used for linked devices)
 	UINT8 srMode;		// sample rate mode (see DEVRI_SRMODE)
-	UINT8 resmplMode;	// resampling mode (0 - high quality, 1 - low quality, 2 - LQ down, HQ up)
+	UINT8 resmplMode;	// resampling mode (0 - high quality, 1 - low quality, 2 - LQ down, HQ up, 3 - windowed sinc)
 	UINT32 smplRate;	// emulaiton sample rate
 	UINT32 coreOpts;
 	PLR_MUTE_OPTS muteOpts;
@@ -98,6 +99,28 @@ struct PLR_GEN_OPTS
 	UINT32 pbSpeed; // playback speed (16.16 fixed point scale, 0x10000 = 100%)
 };
 
+// profiling data, see PlayerBase::GetProfile()
+struct PLR_DEV_PROFILE
+{
+	UINT32 id;			// device ID (as in PLR_DEV_INFO)
+	UINT8 linkIdx;		// 0 = main device, 1+ = linked device (e.g. the SSG of an OPN)
+	DEV_ID type;		// device type
+	UINT64 updCalls;	// number of DEV_DEF::Update() calls
+	UINT64 updSmpls;	// samples rendered by DEV_DEF::Update()
+	UINT64 updTime;		// time spent in DEV_DEF::Update() [ns]
+	UINT64 rsmplCalls;	// number of Resmpl_Execute() calls
+	UINT64 rsmplTime;	// time spent in Resmpl_Execute(), including DEV_DEF::Update() [ns]
+	UINT64 regWrites;	// register writes (linkIdx 0 only)
+	UINT64 dacStrmCmds;	// DAC stream commands for this device (linkIdx 0 only)
+};
+
+struct PLR_PROFILE
+{
+	UINT64 parseCalls;	// number of ParseFile() calls
+	UINT64 parseTime;	// time spent in ParseFile() [ns], includes register writes
+	std::vector<PLR_DEV_PROFILE> devices;
+};
+
 
 //	--- concept ---
 //	- Player class does file rendering at fixed volume (but changeable speed)
@@ -115,6 +138,10 @@ public:
 	static UINT8 PlayerCanLoadFile(DATA_LOADER *dataLoader);
 	virtual UINT8 CanLoadFile(DATA_LOADER *dataLoader) const;
 	virtual UINT8 LoadFile(DATA_LOADER *dataLoader) = 0;
+	// Loads only what GetSongInfo(), GetSongDeviceInfo() and GetTags() need, without reading
+	// the whole file if the format allows it. No devices are allocated.
+	// The file can not be played afterwards. Call UnloadFile() before loading the next file.
+	virtual UINT8 ProbeFile(DATA_LOADER *dataLoader);
 	virtual UINT8 UnloadFile(void) = 0;
 	
 	virtual const char* const* GetTags(void) = 0;
@@ -155,7 +182,19 @@ public:
 	virtual UINT8 Seek(UINT8 unit, UINT32 pos) = 0; // seek to playback position
 	virtual UINT32 Render(UINT32 smplCnt, WAVE_32BS* data) = 0;
 	
+	// Returns the profiling data collected since Start() or ResetProfile().
+	// Profiling must be enabled at compile time (PLAYER_PROFILING), else 0xFF is returned.
+	virtual UINT8 GetProfile(PLR_PROFILE& prof) const;
+	virtual void ResetProfile(void);
+	
 protected:
+#ifdef PLAYER_PROFILING
+	static void AddDevProfiles(std::vector<PLR_DEV_PROFILE>& devProfs, UINT32 id, const VGM_BASEDEV* cBaseDev);
+	static void ResetDevProfiles(VGM_BASEDEV* cBaseDev);
+	
+	UINT64 _profParseCalls;
+	UINT64 _profParseTime;
+#endif
 	UINT32 _outSmplRate;
 	const DEV_DECL** _userDevList;
 	UINT8 _devStartOpts;
@@ -0,0 +1,457 @@
+#include <string.h>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>	// for Sleep()
+#else
+#include <unistd.h>	// for usleep()
+#define	Sleep(msec)	usleep(msec * 1000)
+#endif
+
+#include "../stdtype.h"
+#include "../common_def.h"
+#include "../utils/OSThread.h"
+#include "playerbase.hpp"
+#include "playera.hpp"
+
+#include "renderahead.hpp"
+
+#if defined(_MSC_VER) && _MSC_VER >= 1400
+#include <intrin.h>
+#define RA_ATOMIC_MSVC
+#elif defined(__GNUC__)
+#define RA_ATOMIC_GCC
+#endif
+
+#define RACMD_SEEK		0x01
+#define RACMD_RESET		0x02
+#define RACMD_FADE		0x03
+#define RACMD_QUIT		0x7F
+
+#define RA_WAIT_MSEC	1	// wait time when the ring is full
+
+#define RA_ARR_SIZE(x)	(sizeof(x) / sizeof(x[0]))
+
+// The SPSC queues need acquire/release semantics only.
+// Each counter is written by a single thread.
+INLINE UINT32 LoadAcq(const volatile UINT32* ptr)
+{
+#if defined(RA_ATOMIC_MSVC)
+	return (UINT32)_InterlockedCompareExchange((volatile long*)ptr, 0, 0);	// full barrier
+#elif defined(RA_ATOMIC_GCC) && defined(__ATOMIC_ACQUIRE)
+	return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+#elif defined(RA_ATOMIC_GCC)
+	return __sync_val_compare_and_swap((volatile UINT32*)ptr, 0, 0);	// full barrier
+#else
+	return *ptr;
+#endif
+}
+
+INLINE void StoreRel(volatile UINT32* ptr, UINT32 val)
+{
+#if defined(RA_ATOMIC_MSVC)
+	_InterlockedExchange((volatile long*)ptr, (long)val);
+#elif defined(RA_ATOMIC_GCC) && defined(__ATOMIC_RELEASE)
+	__atomic_store_n(ptr, val, __ATOMIC_RELEASE);
+#elif defined(RA_ATOMIC_GCC)
+	__sync_synchronize();
+	*ptr = val;
+#else
+	*ptr = val;
+#endif
+	return;
+}
+
+RenderAhead::RenderAhead() :
+	_player(NULL),
+	_plrCbFunc(NULL),
+	_plrCbParam(NULL),
+	_thread(NULL),
+	_blkSize(0),
+	_blkCount(0),
+	_writeBlk(0),
+	_readBlk(0),
+	_readOfs(0),
+	_flushID(0),
+	_flushBlk(0),
+	_readFlushID(0),
+	_underruns(0),
+	_underrunBytes(0),
+	_cmdWrite(0),
+	_cmdRead(0),
+	_evtWrite(0),
+	_evtRead(0)
+{
+}
+
+RenderAhead::~RenderAhead()
+{
+	Deinit();
+}
+
+UINT8 RenderAhead::Init(PlayerA* player, UINT32 blockSize, UINT32 blockCount)
+{
+	if (player == NULL || ! blockSize || ! blockCount)
+		return 0xFF;
+	Deinit();
+	
+	_blkCount = 1;
+	while(_blkCount < blockCount)
+		_blkCount <<= 1;
+	_blkSize = blockSize;
+	_ring.resize(_blkSize * _blkCount);
+	
+	_writeBlk = _readBlk = _readOfs = 0;
+	_flushID = _flushBlk = _readFlushID = 0;
+	_underruns = _underrunBytes = 0;
+	_cmdWrite = _cmdRead = 0;
+	_evtWrite = _evtRead = 0;
+	
+	_player = player;
+	_player->SetEventCallback(RenderAhead::PlayCallbackS, this);
+	return 0x00;
+}
+
+void RenderAhead::Deinit(void)
+{
+	if (_player == NULL)
+		return;
+	
+	Stop();
+	_player->SetEventCallback(NULL, NULL);
+	_player = NULL;
+	_ring.clear();
+	return;
+}
+
+void RenderAhead::SetEventCallback(PLAYER_EVENT_CB cbFunc, void* cbParam)
+{
+	_plrCbFunc = cbFunc;
+	_plrCbParam = cbParam;
+	return;
+}
+
+UINT8 RenderAhead::Start(void)
+{
+	UINT8 retVal;
+	
+	if (_player == NULL)
+		return 0xFF;
+	if (_thread != NULL)
+		return 0x01;	// already running
+	
+	retVal = OSThread_Init(&_thread, RenderAhead::RenderThreadS, this);
+	if (retVal)
+	{
+		_thread = NULL;
+		return 0xC8;	// CreateThread failed
+	}
+	return 0x00;
+}
+
+UINT8 RenderAhead::Stop(void)
+{
+	if (_thread == NULL)
+		return 0x01;	// not running
+	
+	PostCommand(RACMD_QUIT, 0, 0);
+	OSThread_Join(_thread);
+	OSThread_Deinit(_thread);	_thread = NULL;
+	
+	// The render thread has finished, so the reader's state can be reset safely.
+	// (The audio driver must not call Read at this point.)
+	_cmdRead = _cmdWrite;
+	_readBlk = _writeBlk;
+	_readOfs = 0;
+	_readFlushID = _flushID;
+	_evtRead = _evtWrite;	// events of discarded audio
+	return 0x00;
+}
+
+UINT8 RenderAhead::IsRunning(void) const
+{
+	return (_thread != NULL);
+}
+
+UINT32 RenderAhead::Read(UINT32 bufSize, void* data)
+{
+	UINT8* bData = (UINT8*)data;
+	UINT32 wrtBlk;
+	UINT32 rdBlk;
+	UINT32 rdOfs;
+	UINT32 remBytes;
+	
+	if (_player == NULL)
+	{
+		memset(data, 0x00, bufSize);
+		return bufSize;
+	}
+	if (_thread == NULL)
+	{
+		// no render thread - do everything here
+		ProcessCommands();
+		CheckFlush();
+		return _player->Render(bufSize, data);
+	}
+	
+	// Note: _writeBlk has to be loaded after checking the flush. The render thread may render
+	//       and flush in between, so an earlier value can be before the new read position.
+	//       (_flushBlk is always <= _writeBlk, so with this order, rdBlk never passes wrtBlk.)
+	rdBlk = CheckFlush();
+	wrtBlk = LoadAcq(&_writeBlk);
+	rdOfs = _readOfs;
+	remBytes = bufSize;
+	while(remBytes > 0 && (INT32)(wrtBlk - rdBlk) > 0)
+	{
+		const UINT8* blkData = &_ring[(rdBlk & (_blkCount - 1)) * _blkSize];
+		UINT32 cpyBytes = _blkSize - rdOfs;
+		if (cpyBytes > remBytes)
+			cpyBytes = remBytes;
+		memcpy(bData, &blkData[rdOfs], cpyBytes);
+		bData += cpyBytes;	remBytes -= cpyBytes;
+		rdOfs += cpyBytes;
+		if (rdOfs >= _blkSize)
+		{
+			rdBlk ++;	rdOfs = 0;
+			StoreRel(&_readBlk, rdBlk);	// free the block for the render thread
+		}
+	}
+	StoreRel(&_readOfs, rdOfs);
+	
+	if (remBytes > 0)
+	{
+		memset(bData, 0x00, remBytes);
+		StoreRel(&_underruns, _underruns + 1);
+		StoreRel(&_underrunBytes, _underrunBytes + remBytes);
+	}
+	return bufSize;
+}
+
+// [audio thread] apply a flush that was done by the render thread, returns the current read block
+UINT32 RenderAhead::CheckFlush(void)
+{
+	UINT32 flushID = LoadAcq(&_flushID);
+	if (flushID == _readFlushID)
+		return _readBlk;
+	
+	// skip everything that was rendered before the flush
+	// _readFlushID has to be updated first, see PopEvent().
+	StoreRel(&_readFlushID, flushID);
+	StoreRel(&_readOfs, 0);
+	StoreRel(&_readBlk, LoadAcq(&_flushBlk));
+	return _readBlk;
+}
+
+UINT8 RenderAhead::Seek(UINT8 unit, UINT32 pos)
+{
+	return PostCommand(RACMD_SEEK, unit, pos);
+}
+
+UINT8 RenderAhead::Reset(void)
+{
+	return PostCommand(RACMD_RESET, 0, 0);
+}
+
+UINT8 RenderAhead::FadeOut(void)
+{
+	return PostCommand(RACMD_FADE, 0, 0);
+}
+
+// [control thread]
+UINT8 RenderAhead::PostCommand(UINT8 type, UINT8 unit, UINT32 pos)
+{
+	UINT32 cmdWrite;
+	RA_CMD* cmd;
+	
+	if (_player == NULL)
+		return 0xFF;
+	
+	cmdWrite = _cmdWrite;
+	// The queue is only full when the render thread is stuck. Wait for it.
+	while(cmdWrite - LoadAcq(&_cmdRead) >= RA_ARR_SIZE(_cmds))
+		Sleep(RA_WAIT_MSEC);
+	
+	cmd = &_cmds[cmdWrite & (RA_ARR_SIZE(_cmds) - 1)];
+	cmd->type = type;
+	cmd->unit = unit;
+	cmd->pos = pos;
+	StoreRel(&_cmdWrite, cmdWrite + 1);
+	return 0x00;
+}
+
+// [render thread] returns 0x01 when the thread should quit
+UINT8 RenderAhead::ProcessCommands(void)
+{
+	UINT32 cmdWrite = LoadAcq(&_cmdWrite);
+	UINT32 cmdRead = _cmdRead;
+	UINT8 needFlush = 0;
+	UINT8 retVal = 0x00;
+	
+	while(cmdRead != cmdWrite)
+	{
+		const RA_CMD* cmd = &_cmds[cmdRead & (RA_ARR_SIZE(_cmds) - 1)];
+		switch(cmd->type)
+		{
+		case RACMD_SEEK:
+			_player->Seek(cmd->unit, cmd->pos);
+			needFlush = 1;
+			break;
+		case RACMD_RESET:
+			_player->Reset();
+			needFlush = 1;
+			break;
+		case RACMD_FADE:
+			_player->FadeOut();	// no flush, the fade starts after the buffered audio
+			break;
+		case RACMD_QUIT:
+			retVal = 0x01;
+			break;
+		}
+		cmdRead ++;
+	}
+	StoreRel(&_cmdRead, cmdRead);
+	
+	if (needFlush)
+	{
+		StoreRel(&_flushBlk, _writeBlk);
+		StoreRel(&_flushID, _flushID + 1);
+	}
+	return retVal;
+}
+
+/*static*/ void RenderAhead::RenderThreadS(void* args)
+{
+	RenderAhead* ra = (RenderAhead*)args;
+	ra->RenderThread();
+	return;
+}
+
+void RenderAhead::RenderThread(void)
+{
+	while(true)
+	{
+		UINT32 wrtBlk;
+		UINT8* blkData;
+		UINT32 renderedBytes;
+		
+		if (ProcessCommands())
+			break;
+		
+		wrtBlk = _writeBlk;
+		if (wrtBlk - LoadAcq(&_readBlk) >= _blkCount)
+		{
+			// Ring is full. (This includes a pending flush that the reader didn't apply yet.)
+			Sleep(RA_WAIT_MSEC);
+			continue;
+		}
+		
+		blkData = &_ring[(wrtBlk & (_blkCount - 1)) * _blkSize];
+		renderedBytes = 0;
+		while(renderedBytes < _blkSize)
+		{
+			// PlayerA may render less than requested when its sample buffer is smaller.
+			UINT32 rendered = _player->Render(_blkSize - renderedBytes, &blkData[renderedBytes]);
+			if (! rendered)
+				break;
+			renderedBytes += rendered;
+		}
+		if (renderedBytes < _blkSize)
+			memset(&blkData[renderedBytes], 0x00, _blkSize - renderedBytes);
+		StoreRel(&_writeBlk, wrtBlk + 1);
+	}
+	
+	return;
+}
+
+/*static*/ UINT8 RenderAhead::PlayCallbackS(PlayerBase* player, void* userParam, UINT8 evtType, void* evtParam)
+{
+	RenderAhead* ra = (RenderAhead*)userParam;
+	return ra->PlayCallback(player, evtType, evtParam);
+}
+
+// [render thread] (or the thread that calls PlayerA::Start/Stop)
+UINT8 RenderAhead::PlayCallback(PlayerBase* player, UINT8 evtType, void* evtParam)
+{
+	UINT32 evtWrite;
+	RA_EVENT* evt;
+	
+	// Events that happen while seeking are never heard.
+	if (! (player->GetState() & PLAYSTATE_SEEK))
+	{
+		evtWrite = _evtWrite;
+		if (evtWrite - LoadAcq(&_evtRead) < RA_ARR_SIZE(_evts))
+		{
+			evt = &_evts[evtWrite & (RA_ARR_SIZE(_evts) - 1)];
+			evt->flushID = _flushID;
+			evt->block = _writeBlk;
+			evt->type = evtType;
+			evt->param = (evtType == PLREVT_LOOP) ? *(UINT32*)evtParam : 0;
+			StoreRel(&_evtWrite, evtWrite + 1);
+		}
+		// else: The control thread doesn't fetch events. Drop the new one.
+	}
+	
+	if (_plrCbFunc != NULL)
+		return _plrCbFunc(player, _plrCbParam, evtType, evtParam);
+	return 0x00;
+}
+
+// [control thread]
+UINT8 RenderAhead::PopEvent(UINT32* evtParam)
+{
+	UINT32 evtRead = _evtRead;
+	UINT32 rdBlk;
+	UINT32 rdFlushID;
+	
+	// Load order matters: CheckFlush updates _readFlushID before _readBlk.
+	rdBlk = LoadAcq(&_readBlk);
+	rdFlushID = LoadAcq(&_readFlushID);
+	while(evtRead != LoadAcq(&_evtWrite))
+	{
+		const RA_EVENT* evt = &_evts[evtRead & (RA_ARR_SIZE(_evts) - 1)];
+		INT32 flushDiff = (INT32)(rdFlushID - evt->flushID);
+		if (flushDiff < 0)
+			break;	// The reader didn't reach the flush yet.
+		if (flushDiff == 0 && (INT32)(rdBlk - evt->block) < 0)
+			break;	// not played yet
+		
+		evtRead ++;
+		StoreRel(&_evtRead, evtRead);
+		if (flushDiff > 0)
+			continue;	// The audio of this event was discarded.
+		if (evtParam != NULL)
+			*evtParam = evt->param;
+		return evt->type;
+	}
+	
+	return PLREVT_NONE;
+}
+
+UINT32 RenderAhead::GetBufferSize(void) const
+{
+	return _blkSize * _blkCount;
+}
+
+UINT32 RenderAhead::GetFillLevel(void) const
+{
+	UINT32 rdOfs = LoadAcq(&_readOfs);
+	UINT32 rdBlk = LoadAcq(&_readBlk);
+	UINT32 wrtBlk = LoadAcq(&_writeBlk);
+	UINT32 blocks = wrtBlk - rdBlk;
+	
+	if (blocks > _blkCount)	// pending flush
+		return 0;
+	if (! blocks)
+		return 0;
+	return blocks * _blkSize - rdOfs;
+}
+
+UINT32 RenderAhead::GetUnderrunCount(void) const
+{
+	return LoadAcq(&_underruns);
+}
+
+UINT32 RenderAhead::GetUnderrunBytes(void) const
+{
+	return LoadAcq(&_underrunBytes);
+}
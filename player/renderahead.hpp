@@ -0,0 +1,107 @@
+#ifndef __RENDERAHEAD_HPP__
+#define __RENDERAHEAD_HPP__
+
+#include <vector>
+#include "../stdtype.h"
+#include "../utils/OSThread.h"
+#include "playerbase.hpp"
+#include "playera.hpp"
+
+// Render-ahead buffer for PlayerA
+// A dedicated thread renders audio into a ring buffer, so that the audio driver callback
+// only has to copy data.
+// The ring is a single-producer/single-consumer queue that works without locks:
+//	- render thread: the only writer of the ring
+//	- audio thread (Read): the only reader of the ring
+//	- control thread (Seek/Reset/FadeOut/PopEvent): sends commands to the render thread
+//	  and receives player events, both via message queues
+// Commands are executed by the render thread between two blocks. Seek and Reset discard the
+// audio that was already rendered.
+// When the render thread is not running, Read executes pending commands and renders directly.
+class RenderAhead
+{
+public:
+	RenderAhead();
+	~RenderAhead();
+	
+	// blockSize: size of a rendering block in bytes (should be the audio driver's buffer size)
+	// blockCount: number of blocks in the ring (rounded up to a power of 2)
+	UINT8 Init(PlayerA* player, UINT32 blockSize, UINT32 blockCount);
+	void Deinit(void);
+	// Callback for player events, called from the render thread when the event is rendered.
+	// For events when they are actually played, use PopEvent().
+	void SetEventCallback(PLAYER_EVENT_CB cbFunc, void* cbParam);
+	
+	UINT8 Start(void);	// start render thread
+	UINT8 Stop(void);	// stop render thread, buffered data is discarded
+	UINT8 IsRunning(void) const;
+	
+	// --- audio thread ---
+	// Copy buffered audio data. Missing data is filled with silence and counts as underrun.
+	UINT32 Read(UINT32 bufSize, void* data);
+	
+	// --- control thread ---
+	UINT8 Seek(UINT8 unit, UINT32 pos);
+	UINT8 Reset(void);
+	UINT8 FadeOut(void);
+	// Returns the next player event (PLREVT_*) that was reached by the audio thread
+	// or PLREVT_NONE if there is none. For PLREVT_LOOP, evtParam receives the loop number.
+	UINT8 PopEvent(UINT32* evtParam);
+	
+	UINT32 GetBufferSize(void) const;	// ring size in bytes
+	UINT32 GetFillLevel(void) const;	// buffered bytes
+	UINT32 GetUnderrunCount(void) const;	// number of Read calls that ran out of data
+	UINT32 GetUnderrunBytes(void) const;	// number of bytes filled with silence
+private:
+	struct RA_CMD
+	{
+		UINT8 type;
+		UINT8 unit;
+		UINT32 pos;
+	};
+	struct RA_EVENT
+	{
+		UINT32 flushID;	// ID of the flush that preceded the event
+		UINT32 block;	// block that was being rendered
+		UINT8 type;
+		UINT32 param;
+	};
+	
+	static void RenderThreadS(void* args);
+	void RenderThread(void);
+	UINT8 PostCommand(UINT8 type, UINT8 unit, UINT32 pos);
+	UINT8 ProcessCommands(void);
+	UINT32 CheckFlush(void);
+	static UINT8 PlayCallbackS(PlayerBase* player, void* userParam, UINT8 evtType, void* evtParam);
+	UINT8 PlayCallback(PlayerBase* player, UINT8 evtType, void* evtParam);
+	
+	PlayerA* _player;
+	PLAYER_EVENT_CB _plrCbFunc;
+	void* _plrCbParam;
+	OS_THREAD* _thread;
+	
+	UINT32 _blkSize;
+	UINT32 _blkCount;	// power of 2
+	std::vector<UINT8> _ring;
+	// All counters below increase continuously and are masked when used as indices.
+	// They are accessed using atomic operations.
+	volatile UINT32 _writeBlk;	// [render thread] number of blocks rendered
+	volatile UINT32 _readBlk;	// [audio thread] number of blocks read completely
+	volatile UINT32 _readOfs;	// [audio thread] read offset in the current block
+	volatile UINT32 _flushID;	// [render thread] number of flushes
+	volatile UINT32 _flushBlk;	// [render thread] block where the audio after the last flush starts
+	volatile UINT32 _readFlushID;	// [audio thread] last flush that was applied by the reader
+	volatile UINT32 _underruns;	// [audio thread]
+	volatile UINT32 _underrunBytes;	// [audio thread]
+	
+	// control -> render thread
+	RA_CMD _cmds[0x10];
+	volatile UINT32 _cmdWrite;
+	volatile UINT32 _cmdRead;
+	// render -> control thread
+	RA_EVENT _evts[0x40];
+	volatile UINT32 _evtWrite;
+	volatile UINT32 _evtRead;
+};
+
+#endif	// __RENDERAHEAD_HPP__
@@ -0,0 +1,145 @@
+// Shared ROM Image Cache
+// ----------------------
+// The entries are kept in a simple linked list, as there are usually only a few ROM images
+// in use at the same time.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../stdtype.h"
+#include "../common_def.h"
+#include "../emu/EmuOnce.h"
+#include "../utils/OSMutex.h"
+#include "romcache.h"
+
+struct _rom_cache_entry
+{
+	ROMCACHE_ENTRY* next;
+	UINT32 refCount;
+	UINT32 hash;
+	UINT32 size;
+	UINT8* data;
+};
+
+static void ROMCache_InitMutex(void);
+static UINT32 CalcHash(UINT32 size, const UINT8* data);
+
+static EMU_ONCE cacheInit = EMU_ONCE_INIT;
+static OS_MUTEX* cacheMutex = NULL;
+static ROMCACHE_ENTRY* cacheList = NULL;
+
+static void ROMCache_InitMutex(void)
+{
+	OSMutex_Init(&cacheMutex, 0);
+	return;
+}
+
+static UINT32 CalcHash(UINT32 size, const UINT8* data)
+{
+	// FNV-1a, processing 4 bytes at once
+	UINT32 hash = 0x811C9DC5 ^ size;
+	UINT32 pos;
+	
+	for (pos = 0; pos + 4 <= size; pos += 4)
+	{
+		UINT32 val = (data[pos + 0] << 0) | (data[pos + 1] << 8) |
+					(data[pos + 2] << 16) | ((UINT32)data[pos + 3] << 24);
+		hash = (hash ^ val) * 0x01000193;
+	}
+	for (; pos < size; pos ++)
+		hash = (hash ^ data[pos]) * 0x01000193;
+	
+	return hash;
+}
+
+ROMCACHE_ENTRY* ROMCache_Acquire(UINT32 size, const UINT8* data)
+{
+	ROMCACHE_ENTRY* entry;
+	UINT32 hash;
+	
+	EmuOnce_Run(&cacheInit, ROMCache_InitMutex);
+	if (cacheMutex == NULL)
+		return NULL;
+	
+	hash = CalcHash(size, data);	// The hash is calculated before locking, as it is the slowest part.
+	OSMutex_Lock(cacheMutex);
+	for (entry = cacheList; entry != NULL; entry = entry->next)
+	{
+		if (entry->hash == hash && entry->size == size && ! memcmp(entry->data, data, size))
+		{
+			entry->refCount ++;
+			OSMutex_Unlock(cacheMutex);
+			return entry;
+		}
+	}
+	
+	entry = (ROMCACHE_ENTRY*)malloc(sizeof(ROMCACHE_ENTRY));
+	if (entry != NULL)
+	{
+		entry->data = (UINT8*)malloc(size ? size : 1);
+		if (entry->data == NULL)
+		{
+			free(entry);
+			entry = NULL;
+		}
+	}
+	if (entry != NULL)
+	{
+		memcpy(entry->data, data, size);
+		entry->refCount = 1;
+		entry->hash = hash;
+		entry->size = size;
+		entry->next = cacheList;
+		cacheList = entry;
+	}
+	OSMutex_Unlock(cacheMutex);
+	
+	return entry;
+}
+
+void ROMCache_AddRef(ROMCACHE_ENTRY* entry)
+{
+	OSMutex_Lock(cacheMutex);
+	entry->refCount ++;
+	OSMutex_Unlock(cacheMutex);
+	
+	return;
+}
+
+void ROMCache_Release(ROMCACHE_ENTRY* entry)
+{
+	ROMCACHE_ENTRY** prevPtr;
+	
+	OSMutex_Lock(cacheMutex);
+	entry->refCount --;
+	if (entry->refCount > 0)
+	{
+		OSMutex_Unlock(cacheMutex);
+		return;
+	}
+	
+	for (prevPtr = &cacheList; *prevPtr != NULL; prevPtr = &(*prevPtr)->next)
+	{
+		if (*prevPtr == entry)
+		{
+			*prevPtr = entry->next;
+			break;
+		}
+	}
+	OSMutex_Unlock(cacheMutex);
+	
+	free(entry->data);
+	free(entry);
+	
+	return;
+}
+
+UINT32 ROMCache_GetSize(const ROMCACHE_ENTRY* entry)
+{
+	return entry->size;
+}
+
+const UINT8* ROMCache_GetData(const ROMCACHE_ENTRY* entry)
+{
+	return entry->data;
+}
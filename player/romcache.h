@@ -0,0 +1,48 @@
+#ifndef __ROMCACHE_H__
+#define __ROMCACHE_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "../stdtype.h"
+
+// Process-wide store for sample ROM images.
+// Images with the same contents are stored only once and shared by all players and
+// sound devices, that link them via DEVRW_MEMLINK. The data is immutable.
+// All functions are thread-safe.
+
+typedef struct _rom_cache_entry ROMCACHE_ENTRY;
+
+/**
+ * @brief Returns the cache entry of a ROM image. A copy of the data is added to the cache,
+ *        unless there is already an image with the same contents.
+ *        The reference count of the entry is increased.
+ *
+ * @param size size of the ROM image in bytes
+ * @param data ROM image data
+ * @return cache entry or NULL on failure
+ */
+ROMCACHE_ENTRY* ROMCache_Acquire(UINT32 size, const UINT8* data);
+/**
+ * @brief Increases the reference count of a cache entry.
+ *
+ * @param entry cache entry returned by ROMCache_Acquire
+ */
+void ROMCache_AddRef(ROMCACHE_ENTRY* entry);
+/**
+ * @brief Decreases the reference count of a cache entry.
+ *        The data is freed when there are no references left.
+ *
+ * @param entry cache entry returned by ROMCache_Acquire
+ */
+void ROMCache_Release(ROMCACHE_ENTRY* entry);
+UINT32 ROMCache_GetSize(const ROMCACHE_ENTRY* entry);
+const UINT8* ROMCache_GetData(const ROMCACHE_ENTRY* entry);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// __ROMCACHE_H__
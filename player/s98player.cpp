@@ -111,6 +111,7 @@ S98Player::S98Player() :
 	_lastTsDiv = 0;
 	
 	dev_logger_set(&_logger, this, S98Player::PlayerLogCB, NULL);
+	MixList_Init(&_mixList);
 	
 	for (optChip = 0x00; optChip < 0x100; optChip ++)
 	{
@@ -975,6 +976,7 @@ UINT8 S98Player::Start(void)
 		cDev->base.defInf.dataPtr = NULL;
 		cDev->base.defInf.devDef = NULL;
 		cDev->base.linkDev = NULL;
+		cDev->base.mixGrp = NULL;
 		deviceID = (devHdr->devType < S98DEV_END) ? S98_DEV_LIST[devHdr->devType] : 0xFF;
 		if (deviceID == 0xFF)
 			continue;
@@ -1031,7 +1033,7 @@ UINT8 S98Player::Start(void)
 			VGM_BASEDEV* clDev = cDev->base.linkDev;
 			size_t optID = DeviceID2OptionID(PLR_DEV_ID(DEVID_AY8910, instance));
 			if (optID != (size_t)-1 && clDev != NULL && clDev->defInf.devDef->SetOptionBits != NULL)
-				clDev->defInf.devDef->SetOptionBits(cDev->base.defInf.dataPtr, _devOpts[optID].coreOpts);
+				clDev->defInf.devDef->SetOptionBits(clDev->defInf.dataPtr, _devOpts[optID].coreOpts);
 		}
 		
 		for (clDev = &cDev->base; clDev != NULL; clDev = clDev->linkDev)
@@ -1045,10 +1047,13 @@ UINT8 S98Player::Start(void)
 					clDev->resmpl.volumeL = clDev->resmpl.volumeR = 0xCD;
 			}
 			Resmpl_DevConnect(&clDev->resmpl, &clDev->defInf);
+			DEVPROF_CONNECT(clDev);
 			Resmpl_Init(&clDev->resmpl);
 		}
 	}
+	SetupMixGroups();
 	
+	ResetProfile();
 	_playState |= PLAYSTATE_PLAY;
 	Reset();
 	if (_eventCbFunc != NULL)
@@ -1063,6 +1068,7 @@ UINT8 S98Player::Stop(void)
 	
 	_playState &= ~PLAYSTATE_PLAY;
 	
+	MixList_Deinit(&_mixList);	// accesses the devices
 	for (curDev = 0; curDev < _devices.size(); curDev ++)
 	{
 		S98_CHIPDEV* cDev = &_devices[curDev];
@@ -1075,6 +1081,28 @@ UINT8 S98Player::Stop(void)
 	return 0x00;
 }
 
+// Groups devices with the same sample rate (e.g. the SSG parts of several YM2203/YM2608),
+// so that they are mixed at their native sample rate and resampled together.
+void S98Player::SetupMixGroups(void)
+{
+	size_t curDev;
+	
+	MixList_Restart(&_mixList);
+	for (curDev = 0; curDev < _devices.size(); curDev ++)
+	{
+		S98_CHIPDEV* cDev = &_devices[curDev];
+		const UINT8* disable = (cDev->optID != (size_t)-1) ? &_devOpts[cDev->optID].muteOpts.disable : NULL;
+		VGM_BASEDEV* clDev;
+		UINT8 linkID;
+		
+		for (clDev = &cDev->base, linkID = 0; clDev != NULL; clDev = clDev->linkDev, linkID ++)
+			MixList_AddDevice(&_mixList, clDev, disable, linkID);
+	}
+	MixList_Finish(&_mixList, _outSmplRate);
+	
+	return;
+}
+
 UINT8 S98Player::Reset(void)
 {
 	size_t curDev;
@@ -1174,6 +1202,32 @@ UINT8 S98Player::SeekToFilePos(UINT32 pos)
 	return 0x00;
 }
 
+UINT8 S98Player::GetProfile(PLR_PROFILE& prof) const
+{
+#ifdef PLAYER_PROFILING
+	size_t curDev;
+	
+	PlayerBase::GetProfile(prof);
+	for (curDev = 0; curDev < _devices.size(); curDev ++)
+		AddDevProfiles(prof.devices, (UINT32)curDev, &_devices[curDev].base);
+	return 0x00;
+#else
+	return 0xFF;
+#endif
+}
+
+void S98Player::ResetProfile(void)
+{
+#ifdef PLAYER_PROFILING
+	size_t curDev;
+	
+	PlayerBase::ResetProfile();
+	for (curDev = 0; curDev < _devices.size(); curDev ++)
+		ResetDevProfiles(&_devices[curDev].base);
+#endif
+	return;
+}
+
 UINT32 S98Player::Render(UINT32 smplCnt, WAVE_32BS* data)
 {
 	UINT32 curSmpl;
@@ -1181,6 +1235,7 @@ UINT32 S98Player::Render(UINT32 smplCnt, WAVE_32BS* data)
 	UINT32 maxSmpl;
 	INT32 smplStep;	// might be negative due to rounding errors in Tick2Sample
 	size_t curDev;
+	UINT32 curGrp;
 	
 	// Note: use do {} while(), so that "smplCnt == 0" can be used to process until reaching the next sample.
 	curSmpl = 0;
@@ -1188,6 +1243,9 @@ UINT32 S98Player::Render(UINT32 smplCnt, WAVE_32BS* data)
 	{
 		smplFileTick = Sample2Tick(_playSmpl);
 		ParseFile(smplFileTick - _playTick);
+		// devices may change their sample rate during playback
+		if (MixList_RateChanged(&_mixList))
+			SetupMixGroups();
 		
 		// render as many samples at once as possible (for better performance)
 		maxSmpl = Tick2Sample(_fileTick);
@@ -1205,10 +1263,12 @@ UINT32 S98Player::Render(UINT32 smplCnt, WAVE_32BS* data)
 			
 			for (clDev = &cDev->base; clDev != NULL; clDev = clDev->linkDev, disable >>= 1)
 			{
-				if (clDev->defInf.dataPtr != NULL && ! (disable & 0x01))
-					Resmpl_Execute(&clDev->resmpl, smplStep, &data[curSmpl]);
+				if (clDev->defInf.dataPtr != NULL && ! (disable & 0x01) && clDev->mixGrp == NULL)
+					DEVPROF_RESMPL_EXEC(clDev, smplStep, &data[curSmpl]);
 			}
 		}
+		for (curGrp = 0; curGrp < _mixList.grpCount; curGrp ++)
+			Resmpl_Execute(&_mixList.groups[curGrp].resmpl, smplStep, &data[curSmpl]);
 		curSmpl += smplStep;
 		_playSmpl += smplStep;
 		if (_psTrigger & PLAYSTATE_END)
@@ -1227,8 +1287,11 @@ void S98Player::ParseFile(UINT32 ticks)
 	if (_playState & PLAYSTATE_END)
 		return;
 	
+	DEVPROF_TIMER_START(profTime);
 	while(_fileTick <= _playTick && ! (_playState & PLAYSTATE_END))
 		DoCommand();
+	DEVPROF_TIMER_ADD(profTime, _profParseTime);
+	DEVPROF_COUNT(_profParseCalls);
 	
 	return;
 }
@@ -1328,6 +1391,7 @@ void S98Player::DoRegWrite(UINT8 deviceID, UINT8 port, UINT8 reg, UINT8 data)
 	if (dataPtr == NULL || cDev->write == NULL)
 		return;
 	
+	DEVPROF_REGWRITE(&cDev->base);
 	if (_devHdrs[deviceID].devType == S98DEV_DCSG)
 	{
 		if (reg == 1)	// GG stereo
@@ -109,6 +109,8 @@ public:
 	UINT8 Reset(void);
 	UINT8 Seek(UINT8 unit, UINT32 pos);
 	UINT32 Render(UINT32 smplCnt, WAVE_32BS* data);
+	UINT8 GetProfile(PLR_PROFILE& prof) const;
+	void ResetProfile(void);
 	
 private:
 	UINT8 GetDeviceInstance(size_t id) const;
@@ -129,6 +131,7 @@ private:
 	
 	void GenerateDeviceConfig(void);
 	static void DeviceLinkCallback(void* userParam, VGM_BASEDEV* cDev, DEVLINK_INFO* dLink);
+	void SetupMixGroups(void);
 	UINT8 SeekToTick(UINT32 tick);
 	UINT8 SeekToFilePos(UINT32 pos);
 	void ParseFile(UINT32 ticks);
@@ -171,6 +174,7 @@ private:
 	std::vector<S98_CHIPDEV> _devices;
 	std::vector<std::string> _devNames;
 	size_t _optDevMap[_OPT_DEV_COUNT * 2];	// maps _devOpts vector index to _devices vector
+	VGM_MIXLIST _mixList;	// devices that share a resampler
 	
 	UINT32 _filePos;
 	UINT32 _fileTick;
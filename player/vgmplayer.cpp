@@ -12,6 +12,7 @@
 #include "../emu/EmuStructs.h"
 #include "../emu/SoundEmu.h"
 #include "../emu/Resampler.h"
+#include "../emu/dac_control.h"
 #include "../emu/SoundDevs.h"
 #include "../emu/EmuCores.h"
 #include "../emu/cores/sn764intf.h"	// for SN76496_CFG
@@ -166,10 +167,27 @@ VGMPlayer::VGMPlayer() :
 	UINT8 chipID;
 	
 	dev_logger_set(&_logger, this, VGMPlayer::PlayerLogCB, NULL);
+	MixList_Init(&_mixList);
 	
 	_playOpts.playbackHz = 0;
 	_playOpts.hardStopOld = 0;
+	_playOpts.snapInterval = 0;
+	_playOpts.snapMemLimit = 0x2000000;	// 32 MB
+	_playOpts.renderThreads = 0;
+	_playOpts.progressiveLoad = 0;
+	_playOpts.compileCmds = 0;
+	_playOpts.accurateSeek = 1;
 	_playOpts.genOpts.pbSpeed = 0x10000;
+	
+	_snapSupport = 0x00;
+	_nextSnapTick = 0;
+	_snapMemUsage = 0;
+	_yrwRom = NULL;
+	
+	_rtMutex = NULL;
+	_rtNextDev = 0;
+	_rtSmplCnt = 0;
+	_rtExit = 0;
 
 	_lastTsMult = 0;
 	_lastTsDiv = 0;
@@ -211,6 +229,17 @@ VGMPlayer::VGMPlayer() :
 	if (retVal)
 		_cpcUTF16 = NULL;
 	memset(&_pcmComprTbl, 0x00, sizeof(PCM_COMPR_TBL));
+	for (size_t curStrm = 0; curStrm < 0x100; curStrm ++)
+		_dacStrmMap[curStrm] = (size_t)-1;
+	_dblkLoadPos = 0x00;
+	_probeOnly = 0x00;
+	_cmdEvtPos = 0;
+	_cmdEvtTickBase = 0;
+	for (size_t curBank = 0x00; curBank < _PCM_BANK_COUNT; curBank ++)
+	{
+		_pcmBank[curBank].totalSize = 0;
+		_pcmBank[curBank].totalItems = 0;
+	}
 	_tagList[0] = NULL;
 	return;
 }
@@ -223,6 +252,8 @@ VGMPlayer::~VGMPlayer()
 		Stop();
 	UnloadFile();
 	
+	if (_yrwRom != NULL)
+		ROMCache_Release(_yrwRom);
 	if (_cpcUTF16 != NULL)
 		CPConv_Deinit(_cpcUTF16);
 	
@@ -255,6 +286,17 @@ UINT8 VGMPlayer::CanLoadFile(DATA_LOADER *dataLoader) const
 }
 
 UINT8 VGMPlayer::LoadFile(DATA_LOADER *dataLoader)
+{
+	return OpenFile(dataLoader, 0x00);
+}
+
+UINT8 VGMPlayer::ProbeFile(DATA_LOADER *dataLoader)
+{
+	// read only the header (like progressive loading does) and the GD3 tag
+	return OpenFile(dataLoader, 0x01);
+}
+
+UINT8 VGMPlayer::OpenFile(DATA_LOADER *dataLoader, UINT8 probeOnly)
 {
 	_dLoad = NULL;
 	DataLoader_ReadUntil(dataLoader,0x38);
@@ -263,8 +305,12 @@ UINT8 VGMPlayer::LoadFile(DATA_LOADER *dataLoader)
 		return 0xF0;	// invalid file
 	
 	_dLoad = dataLoader;
-	DataLoader_ReadAll(_dLoad);
+	_probeOnly = probeOnly;
+	if (! _playOpts.progressiveLoad && ! _probeOnly)
+		DataLoader_ReadAll(_dLoad);
+	// else: only the parts that are required are read (see LoadFileData)
 	_fileData = DataLoader_GetData(_dLoad);
+	_fileLoaded = DataLoader_GetSize(_dLoad);
 	
 	// parse main header
 	ParseHeader();
@@ -274,6 +320,7 @@ UINT8 VGMPlayer::LoadFile(DATA_LOADER *dataLoader)
 	ParseXHdr_Data16(_fileHdr.xhChpVolOfs, _xHdrChipVol);
 	
 	GenerateDeviceConfig();
+	ScanPCMBanks();
 	
 	// parse tags
 	LoadTags();
@@ -285,7 +332,10 @@ UINT8 VGMPlayer::LoadFile(DATA_LOADER *dataLoader)
 
 UINT8 VGMPlayer::ParseHeader(void)
 {
+	UINT32 fileSize;
+	
 	memset(&_fileHdr, 0x00, sizeof(VGM_HEADER));
+	LoadFileData(_HDR_BUF_SIZE);
 	
 	_fileHdr.fileVer = ReadLE32(&_fileData[0x08]);
 	
@@ -325,11 +375,16 @@ UINT8 VGMPlayer::ParseHeader(void)
 		_fileHdr.volumeGain = _hdrBuffer[0x7C] - 0x100;
 	_fileHdr.volumeGain <<= 3;	// 3.5 fixed point -> 8.8 fixed point
 	
-	if (! _fileHdr.eofOfs || _fileHdr.eofOfs > DataLoader_GetSize(_dLoad))
+	// use the expected size while the file is still being loaded
+	if ((_playOpts.progressiveLoad || _probeOnly) && DataLoader_GetStatus(_dLoad) == DLSTAT_LOADING)
+		fileSize = DataLoader_GetTotalSize(_dLoad);
+	else
+		fileSize = _fileLoaded;
+	if (! _fileHdr.eofOfs || _fileHdr.eofOfs > fileSize)
 	{
 		emu_logf(&_logger, PLRLOG_WARN, "Invalid EOF Offset 0x%06X! (should be: 0x%06X)\n",
-				_fileHdr.eofOfs, DataLoader_GetSize(_dLoad));
-		_fileHdr.eofOfs = DataLoader_GetSize(_dLoad);	// catch invalid EOF values
+				_fileHdr.eofOfs, fileSize);
+		_fileHdr.eofOfs = fileSize;	// catch invalid EOF values
 	}
 	_fileHdr.dataEnd = _fileHdr.eofOfs;
 	// command data ends at the GD3 offset if:
@@ -339,6 +394,7 @@ UINT8 VGMPlayer::ParseHeader(void)
 	
 	if (_fileHdr.extraHdrOfs && _fileHdr.extraHdrOfs < _fileHdr.eofOfs)
 	{
+		LoadFileData(_fileHdr.extraHdrOfs + 0x0C);
 		UINT32 xhLen = ReadLE32(&_fileData[_fileHdr.extraHdrOfs]);
 		if (xhLen >= 0x08)
 			_fileHdr.xhChpClkOfs = ReadRelOfs(_fileData, _fileHdr.extraHdrOfs + 0x04);
@@ -384,7 +440,10 @@ UINT8 VGMPlayer::ParseHeader(void)
 void VGMPlayer::ParseXHdr_Data32(UINT32 fileOfs, std::vector<XHDR_DATA32>& xData)
 {
 	xData.clear();
-	if (! fileOfs || fileOfs >= DataLoader_GetSize(_dLoad))
+	if (! fileOfs)
+		return;
+	LoadFileData(fileOfs + 0x01 + 0xFF * 0x05);	// maximum size of the list
+	if (fileOfs >= _fileLoaded)
 		return;
 	
 	UINT32 curPos = fileOfs;
@@ -393,7 +452,7 @@ void VGMPlayer::ParseXHdr_Data32(UINT32 fileOfs, std::vector<XHDR_DATA32>& xData
 	xData.resize(_fileData[curPos]);	curPos ++;
 	for (curChip = 0; curChip < xData.size(); curChip ++, curPos += 0x05)
 	{
-		if (curPos + 0x05 > DataLoader_GetSize(_dLoad))
+		if (curPos + 0x05 > _fileLoaded)
 		{
 			xData.resize(curChip);
 			break;
@@ -410,7 +469,10 @@ void VGMPlayer::ParseXHdr_Data32(UINT32 fileOfs, std::vector<XHDR_DATA32>& xData
 void VGMPlayer::ParseXHdr_Data16(UINT32 fileOfs, std::vector<XHDR_DATA16>& xData)
 {
 	xData.clear();
-	if (! fileOfs || fileOfs >= DataLoader_GetSize(_dLoad))
+	if (! fileOfs)
+		return;
+	LoadFileData(fileOfs + 0x01 + 0xFF * 0x04);	// maximum size of the list
+	if (fileOfs >= _fileLoaded)
 		return;
 	
 	UINT32 curPos = fileOfs;
@@ -419,7 +481,7 @@ void VGMPlayer::ParseXHdr_Data16(UINT32 fileOfs, std::vector<XHDR_DATA16>& xData
 	xData.resize(_fileData[curPos]);	curPos ++;
 	for (curChip = 0; curChip < xData.size(); curChip ++, curPos += 0x04)
 	{
-		if (curPos + 0x04 > DataLoader_GetSize(_dLoad))
+		if (curPos + 0x04 > _fileLoaded)
 		{
 			xData.resize(curChip);
 			break;
@@ -445,24 +507,38 @@ UINT8 VGMPlayer::LoadTags(void)
 		return 0x00;	// no GD3 tag present
 	if (_fileHdr.gd3Ofs >= _fileHdr.eofOfs)
 		return 0xF3;	// tag error (offset out-of-range)
+	if (_fileHdr.eofOfs <= _fileLoaded)
+		return ParseTags(&_fileData[_fileHdr.gd3Ofs], _fileHdr.eofOfs - _fileHdr.gd3Ofs);
+	if (! _probeOnly)
+		return 0x00;	// not loaded yet (progressive loading), LoadFileData calls this again
 	
+	// When probing, read just the tag instead of everything up to the end of the file.
+	std::vector<UINT8> tagData(_fileHdr.eofOfs - _fileHdr.gd3Ofs);
+	UINT32 readBytes = DataLoader_ReadAt(_dLoad, _fileHdr.gd3Ofs, (UINT32)tagData.size(), &tagData[0]);
+	return ParseTags(&tagData[0], readBytes);
+}
+
+UINT8 VGMPlayer::ParseTags(const UINT8* tagData, UINT32 tagLen)
+{
+	size_t curTag;
 	UINT32 curPos;
 	UINT32 eotPos;
 	
-	if (_fileHdr.gd3Ofs + 0x0C > _fileHdr.eofOfs)	// separate check to catch overflows
+	if (tagLen < 0x0C)
 		return 0xF3;	// tag error (GD3 header incomplete)
-	if (memcmp(&_fileData[_fileHdr.gd3Ofs + 0x00], "Gd3 ", 4))
+	if (memcmp(&tagData[0x00], "Gd3 ", 4))
 		return 0xF0;	// bad tag
 	
-	_tagVer = ReadLE32(&_fileData[_fileHdr.gd3Ofs + 0x04]);
+	_tagVer = ReadLE32(&tagData[0x04]);
 	if (_tagVer < 0x100 || _tagVer >= 0x200)
 		return 0xF1;	// unsupported tag version
 	
-	eotPos = ReadLE32(&_fileData[_fileHdr.gd3Ofs + 0x08]);
-	curPos = _fileHdr.gd3Ofs + 0x0C;
-	eotPos += curPos;
-	if (eotPos > _fileHdr.eofOfs)
-		eotPos = _fileHdr.eofOfs;
+	eotPos = ReadLE32(&tagData[0x08]);
+	curPos = 0x0C;
+	if (eotPos > tagLen - curPos)
+		eotPos = tagLen;
+	else
+		eotPos += curPos;
 	
 	const char **tagListEnd = _tagList;
 	for (curTag = 0; curTag < _TAG_COUNT; curTag ++)
@@ -472,9 +548,9 @@ UINT8 VGMPlayer::LoadTags(void)
 			break;
 		
 		// search for UTF-16 L'\0' character
-		while(curPos < eotPos && ReadLE16(&_fileData[curPos]) != L'\0')
+		while(curPos + 0x01 < eotPos && ReadLE16(&tagData[curPos]) != L'\0')
 			curPos += 0x02;
-		_tagData[curTag] = GetUTF8String(&_fileData[startPos], &_fileData[curPos]);
+		_tagData[curTag] = GetUTF8String(&tagData[startPos], &tagData[curPos]);
 		curPos += 0x02;	// skip '\0'
 		
 		*(tagListEnd++) = _TAG_TYPE_LIST[curTag];
@@ -503,14 +579,52 @@ std::string VGMPlayer::GetUTF8String(const UINT8* startPtr, const UINT8* endPtr)
 	return result;
 }
 
+void VGMPlayer::LoadFileData(UINT32 endPos)
+{
+	// make sure that the file data up to endPos is loaded (for progressive loading)
+	if (endPos <= _fileLoaded || DataLoader_GetStatus(_dLoad) != DLSTAT_LOADING)
+		return;
+	
+	UINT32 oldLoaded = _fileLoaded;
+	// Read a bit more, so that the file isn't read in tiny pieces.
+	// The amount grows with the file size in order to limit reallocations of the buffer.
+	UINT32 readAhead = (_fileLoaded / 4 > _PLOAD_CHUNK) ? (_fileLoaded / 4) : _PLOAD_CHUNK;
+	if (endPos + readAhead < endPos)
+		readAhead = (UINT32)-1 - endPos;	// prevent overflow
+	DataLoader_ReadUntil(_dLoad, endPos + readAhead);
+	_fileData = DataLoader_GetData(_dLoad);
+	_fileLoaded = DataLoader_GetSize(_dLoad);
+	if (_fileLoaded == oldLoaded && DataLoader_GetStatus(_dLoad) == DLSTAT_LOADING)
+		DataLoader_CancelLoading(_dLoad);	// no more data available
+	
+	if (DataLoader_GetStatus(_dLoad) != DLSTAT_LOADING)
+	{
+		// everything is loaded now
+		if (_fileHdr.eofOfs > _fileLoaded)
+		{
+			emu_logf(&_logger, PLRLOG_WARN, "File is smaller than expected! (EOF at 0x%06X, loaded 0x%06X)\n",
+					_fileHdr.eofOfs, _fileLoaded);
+			_fileHdr.eofOfs = _fileLoaded;
+			if (_fileHdr.dataEnd > _fileLoaded)
+				_fileHdr.dataEnd = _fileLoaded;
+		}
+		LoadTags();
+	}
+	
+	return;
+}
+
 UINT8 VGMPlayer::UnloadFile(void)
 {
 	if (_playState & PLAYSTATE_PLAY)
 		return 0xFF;
 	
 	_playState = 0x00;
+	ClearSnapshots();
 	_dLoad = NULL;
 	_fileData = NULL;
+	_fileLoaded = 0;
+	_probeOnly = 0x00;
 	_fileHdr.fileVer = 0xFFFFFFFF;
 	_fileHdr.dataOfs = 0x00;
 	_devNames.clear();
@@ -740,8 +854,15 @@ UINT8 VGMPlayer::GetDeviceMuting(UINT32 id, PLR_MUTE_OPTS& muteOpts) const
 
 UINT8 VGMPlayer::SetPlayerOptions(const VGM_PLAY_OPTIONS& playOpts)
 {
+	UINT8 oldThreads = _playOpts.renderThreads;
+	UINT8 oldCompile = _playOpts.compileCmds;
+	
 	_playOpts = playOpts;
 	RefreshTSRates();	// refresh, in case _playOpts.playbackHz changed
+	if ((_playState & PLAYSTATE_PLAY) && _playOpts.renderThreads != oldThreads)
+		StartRenderThreads();	// restart worker threads with the new thread count
+	if ((_playState & PLAYSTATE_PLAY) && _playOpts.compileCmds != oldCompile)
+		CompileCommands();
 	return 0x00;
 }
 
@@ -793,6 +914,7 @@ void VGMPlayer::RefreshTSRates(void)
 	{
 		if (_lastTsMult && _lastTsDiv)	// the order * / * / is required to avoid overflow
 			_playSmpl = (UINT32)(_playSmpl * _lastTsDiv / _lastTsMult * _tsMult / _tsDiv);
+		ClearSnapshots();	// the sample positions of the snapshots are invalid now
 		_lastTsMult = _tsMult;
 		_lastTsDiv = _tsDiv;
 	}
@@ -904,8 +1026,16 @@ const std::vector<VGMPlayer::DACSTRM_DEV>& VGMPlayer::GetStreamDevInfo(void) con
 
 UINT8 VGMPlayer::Start(void)
 {
+	if (_probeOnly)
+		return 0xFF;	// only the header was loaded
+	
 	InitDevices();
+	ClearSnapshots();
+	CheckSnapshotSupport();
+	StartRenderThreads();
+	CompileCommands();
 	
+	ResetProfile();
 	_playState |= PLAYSTATE_PLAY;
 	Reset();
 	if (_eventCbFunc != NULL)
@@ -920,6 +1050,9 @@ UINT8 VGMPlayer::Stop(void)
 	size_t curBank;
 	
 	_playState &= ~PLAYSTATE_PLAY;
+	ClearSnapshots();
+	StopRenderThreads();
+	_cmdEvents.clear();
 	
 	for (curDev = 0; curDev < _dacStreams.size(); curDev ++)
 	{
@@ -927,6 +1060,8 @@ UINT8 VGMPlayer::Stop(void)
 		devInf->devDef->Stop(devInf->dataPtr);
 	}
 	_dacStreams.clear();
+	for (curDev = 0; curDev < 0x100; curDev ++)
+		_dacStrmMap[curDev] = (size_t)-1;
 	
 	for (curBank = 0x00; curBank < _PCM_BANK_COUNT; curBank ++)
 	{
@@ -936,9 +1071,20 @@ UINT8 VGMPlayer::Stop(void)
 		pcmBnk->data.clear();
 	}
 	free(_pcmComprTbl.values.d8);	_pcmComprTbl.values.d8 = NULL;
+	memset(&_pcmComprTbl, 0x00, sizeof(PCM_COMPR_TBL));
+	_dblkLoadPos = 0x00;
 	
+	MixList_Deinit(&_mixList);	// accesses the devices
 	for (curDev = 0; curDev < _devices.size(); curDev ++)
-		FreeDeviceTree(&_devices[curDev].base, 0);
+	{
+		CHIP_DEVICE& chipDev = _devices[curDev];
+		FreeDeviceTree(&chipDev.base, 0);
+		// release the ROM images after the device was stopped
+		if (chipDev.romCache[0] != NULL)
+			ROMCache_Release(chipDev.romCache[0]);
+		if (chipDev.romCache[1] != NULL)
+			ROMCache_Release(chipDev.romCache[1]);
+	}
 	_devNames.clear();
 	_devices.clear();
 	_devCfgs.clear();
@@ -951,9 +1097,7 @@ UINT8 VGMPlayer::Stop(void)
 UINT8 VGMPlayer::Reset(void)
 {
 	size_t curDev;
-	size_t curStrm;
 	UINT8 chipID;
-	size_t curBank;
 	
 	_filePos = _fileHdr.dataOfs;
 	_fileTick = 0;
@@ -966,26 +1110,20 @@ UINT8 VGMPlayer::Reset(void)
 	
 	RefreshTSRates();
 	
-	// TODO (optimization): keep _dacStreams vector and just reset devices
-	for (curDev = 0; curDev < _dacStreams.size(); curDev++)
+	// The DAC streams are kept and just reset. They will be set up again by the DAC stream commands.
+	for (curDev = 0; curDev < _dacStreams.size(); curDev ++)
 	{
-		DEV_INFO* devInf = &_dacStreams[curDev].defInf;
-		devInf->devDef->Stop(devInf->dataPtr);
+		DACSTRM_DEV* dacStrm = &_dacStreams[curDev];
+		dacStrm->defInf.devDef->Reset(dacStrm->defInf.dataPtr);
+		dacStrm->bankID = 0xFF;
+		dacStrm->pbMode = 0x00;
+		dacStrm->freq = 0;
+		dacStrm->lastItem = (UINT32)-1;
+		dacStrm->maxItems = 0;
 	}
-	_dacStreams.clear();
-	for (curStrm = 0; curStrm < 0x100; curStrm ++)
-		_dacStrmMap[curStrm] = (size_t)-1;
 	
-	// TODO (optimization): don't reset _pcmBank and instead skip data that was already loaded
-	for (curBank = 0x00; curBank < _PCM_BANK_COUNT; curBank++)
-	{
-		PCM_BANK* pcmBnk = &_pcmBank[curBank];
-		pcmBnk->bankOfs.clear();
-		pcmBnk->bankSize.clear();
-		pcmBnk->data.clear();
-	}
-	free(_pcmComprTbl.values.d8);	_pcmComprTbl.values.d8 = NULL;
-	memset(&_pcmComprTbl, 0x00, sizeof(PCM_COMPR_TBL));
+	// The PCM banks and the compression table are kept as well.
+	// Data blocks before _dblkLoadPos are skipped when they are parsed again.
 	
 	_ym2612pcm_bnkPos = 0x00;
 	memset(_rf5cBank, 0x00, sizeof(_rf5cBank));
@@ -1001,9 +1139,13 @@ UINT8 VGMPlayer::Reset(void)
 		clDev->defInf.devDef->Reset(clDev->defInf.dataPtr);
 		for (; clDev != NULL; clDev = clDev->linkDev)
 		{
-			// TODO: Resmpl_Reset(&clDev->resmpl);
+			if (clDev->defInf.dataPtr != NULL)
+				Resmpl_Reset(&clDev->resmpl);
 		}
 	}
+	// The groups continue where the devices' resamplers are, so they are set up again as well.
+	MixList_Deinit(&_mixList);
+	SetupMixGroups();
 	
 	if ((_p2612Fix & P2612FIX_ENABLE) && ! (_p2612Fix & P2612FIX_ACTIVE))
 	{
@@ -1362,6 +1504,7 @@ void VGMPlayer::InitDevices(void)
 	
 	memset(_shownCmdWarnings, 0, 0x100);
 	
+	MixList_Deinit(&_mixList);
 	_devices.clear();
 	_devNames.clear();
 	{
@@ -1404,6 +1547,7 @@ void VGMPlayer::InitDevices(void)
 		chipDev.cfgID = curChip;
 		chipDev.base.defInf.dataPtr = NULL;
 		chipDev.base.linkDev = NULL;
+		chipDev.base.mixGrp = NULL;
 
 		
 		devOpts = (chipDev.optID != (size_t)-1) ? &_devOpts[chipDev.optID] : NULL;
@@ -1469,6 +1613,7 @@ void VGMPlayer::InitDevices(void)
 			SndEmu_GetDeviceFunc(devInf->devDef, RWF_REGISTER | RWF_WRITE, DEVRW_A8D8, 0, (void**)&chipDev.write8);
 			SndEmu_GetDeviceFunc(devInf->devDef, RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 0x524F, (void**)&chipDev.romSize);
 			SndEmu_GetDeviceFunc(devInf->devDef, RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 0x524F, (void**)&chipDev.romWrite);
+			SndEmu_GetDeviceFunc(devInf->devDef, RWF_MEMORY | RWF_WRITE, DEVRW_MEMLINK, 0x524F, (void**)&chipDev.romLink);
 			SndEmu_GetDeviceFunc(devInf->devDef, RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 0x5241, (void**)&chipDev.romSizeB);
 			SndEmu_GetDeviceFunc(devInf->devDef, RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 0x5241, (void**)&chipDev.romWriteB);
 			LoadOPL4ROM(&chipDev);
@@ -1494,6 +1639,7 @@ void VGMPlayer::InitDevices(void)
 			SndEmu_GetDeviceFunc(devInf->devDef, RWF_REGISTER | RWF_WRITE, DEVRW_A8D16, 0, (void**)&chipDev.writeD16);
 			SndEmu_GetDeviceFunc(devInf->devDef, RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 0, (void**)&chipDev.romSize);
 			SndEmu_GetDeviceFunc(devInf->devDef, RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 0, (void**)&chipDev.romWrite);
+			SndEmu_GetDeviceFunc(devInf->devDef, RWF_MEMORY | RWF_WRITE, DEVRW_MEMLINK, 0, (void**)&chipDev.romLink);
 			break;
 		case DEVID_C352:
 			retVal = SndEmu_Start2(chipType, devCfg, devInf, _userDevList, _devStartOpts);
@@ -1502,6 +1648,7 @@ void VGMPlayer::InitDevices(void)
 			SndEmu_GetDeviceFunc(devInf->devDef, RWF_REGISTER | RWF_WRITE, DEVRW_A16D16, 0, (void**)&chipDev.writeM16);
 			SndEmu_GetDeviceFunc(devInf->devDef, RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 0, (void**)&chipDev.romSize);
 			SndEmu_GetDeviceFunc(devInf->devDef, RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 0, (void**)&chipDev.romWrite);
+			SndEmu_GetDeviceFunc(devInf->devDef, RWF_MEMORY | RWF_WRITE, DEVRW_MEMLINK, 0, (void**)&chipDev.romLink);
 			break;
 		case DEVID_QSOUND:
 			chipDev.flags = 0x00;
@@ -1519,6 +1666,7 @@ void VGMPlayer::InitDevices(void)
 			SndEmu_GetDeviceFunc(devInf->devDef, RWF_REGISTER | RWF_QUICKWRITE, DEVRW_A8D16, 0, (void**)&chipDev.writeD16);
 			SndEmu_GetDeviceFunc(devInf->devDef, RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 0, (void**)&chipDev.romSize);
 			SndEmu_GetDeviceFunc(devInf->devDef, RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 0, (void**)&chipDev.romWrite);
+			SndEmu_GetDeviceFunc(devInf->devDef, RWF_MEMORY | RWF_WRITE, DEVRW_MEMLINK, 0, (void**)&chipDev.romLink);
 			
 			memset(&_qsWork[chipID], 0x00, sizeof(QSOUND_WORK));
 			if (devInf->devDef->coreID == FCC_MAME)
@@ -1576,6 +1724,7 @@ void VGMPlayer::InitDevices(void)
 			SndEmu_GetDeviceFunc(devInf->devDef, RWF_REGISTER | RWF_WRITE, DEVRW_A16D8, 0, (void**)&chipDev.writeM8);
 			SndEmu_GetDeviceFunc(devInf->devDef, RWF_MEMORY | RWF_WRITE, DEVRW_MEMSIZE, 0, (void**)&chipDev.romSize);
 			SndEmu_GetDeviceFunc(devInf->devDef, RWF_MEMORY | RWF_WRITE, DEVRW_BLOCK, 0, (void**)&chipDev.romWrite);
+			SndEmu_GetDeviceFunc(devInf->devDef, RWF_MEMORY | RWF_WRITE, DEVRW_MEMLINK, 0, (void**)&chipDev.romLink);
 			break;
 		}
 		if (retVal)
@@ -1620,7 +1769,7 @@ void VGMPlayer::InitDevices(void)
 			VGM_BASEDEV* clDev = chipDev.base.linkDev;
 			size_t optID = DeviceID2OptionID(PLR_DEV_ID(DEVID_AY8910, chipID));
 			if (optID != (size_t)-1 && clDev != NULL && clDev->defInf.devDef->SetOptionBits != NULL)
-				clDev->defInf.devDef->SetOptionBits(devInf->dataPtr, _devOpts[optID].coreOpts);
+				clDev->defInf.devDef->SetOptionBits(clDev->defInf.dataPtr, _devOpts[optID].coreOpts);
 		}
 
 		_vdDevMap[sdCfg.vgmChipType][chipID] = _devices.size();
@@ -1649,6 +1798,7 @@ void VGMPlayer::InitDevices(void)
 			
 			Resmpl_SetVals(&clDev->resmpl, resmplMode, chipVol, _outSmplRate);
 			Resmpl_DevConnect(&clDev->resmpl, &clDev->defInf);
+			DEVPROF_CONNECT(clDev);
 			Resmpl_Init(&clDev->resmpl);
 		}
 		
@@ -1674,6 +1824,7 @@ void VGMPlayer::InitDevices(void)
 		}
 	}
 	
+	SetupMixGroups();
 	NormalizeOverallVolume(EstimateOverallVolume());
 	
 	return;
@@ -1730,7 +1881,7 @@ void VGMPlayer::LoadOPL4ROM(CHIP_DEVICE* chipDev)
 	if (chipDev->romWrite == NULL)
 		return;
 	
-	if (_yrwRom.empty())
+	if (_yrwRom == NULL)
 	{
 		if (_fileReqCbFunc == NULL)
 			return;
@@ -1742,15 +1893,22 @@ void VGMPlayer::LoadOPL4ROM(CHIP_DEVICE* chipDev)
 		UINT32 yrwSize = DataLoader_GetSize(romDLoad);
 		const UINT8* yrwData = DataLoader_GetData(romDLoad);
 		if (yrwSize > 0 && yrwData != NULL)
-			_yrwRom.assign(yrwData, yrwData + yrwSize);
+			_yrwRom = ROMCache_Acquire(yrwSize, yrwData);
 		DataLoader_Deinit(romDLoad);
 	}
-	if (_yrwRom.empty())
+	if (_yrwRom == NULL)
 		return;
 	
+	if (chipDev->romLink != NULL)
+	{
+		ROMCache_AddRef(_yrwRom);
+		chipDev->romCache[0] = _yrwRom;
+		chipDev->romLink(chipDev->base.defInf.dataPtr, ROMCache_GetSize(_yrwRom), ROMCache_GetData(_yrwRom));
+		return;
+	}
 	if (chipDev->romSize != NULL)
-		chipDev->romSize(chipDev->base.defInf.dataPtr, (UINT32)_yrwRom.size());
-	chipDev->romWrite(chipDev->base.defInf.dataPtr, 0x00, (UINT32)_yrwRom.size(), &_yrwRom[0]);
+		chipDev->romSize(chipDev->base.defInf.dataPtr, ROMCache_GetSize(_yrwRom));
+	chipDev->romWrite(chipDev->base.defInf.dataPtr, 0x00, ROMCache_GetSize(_yrwRom), ROMCache_GetData(_yrwRom));
 	
 	return;
 }
@@ -1769,8 +1927,14 @@ UINT8 VGMPlayer::Seek(UINT8 unit, UINT32 pos)
 		// fall through
 	case PLAYPOS_TICK:
 		_playState |= PLAYSTATE_SEEK;
-		if (pos < _playTick)
-			Reset();
+		{
+			size_t snapID = FindSnapshot(pos);
+			// use a snapshot when going backwards or when it allows us to skip ahead
+			if (snapID != (size_t)-1 && (pos < _playTick || _snapshots[snapID].playTick > _playTick))
+				LoadSnapshot(snapID);
+			else if (pos < _playTick)
+				Reset();
+		}
 		return SeekToTick(pos);
 	case PLAYPOS_COMMAND:
 	default:
@@ -1782,22 +1946,75 @@ UINT8 VGMPlayer::SeekToTick(UINT32 tick)
 {
 	_playState |= PLAYSTATE_SEEK;
 	if (tick > _playTick)
+	{
+		if (_playOpts.accurateSeek)
+			AdvanceToTick(tick);
 		ParseFile(tick - _playTick);
+	}
 	_playSmpl = Tick2Sample(_playTick);
 	_playState &= ~PLAYSTATE_SEEK;
 	return 0x00;
 }
 
+void VGMPlayer::AdvanceToTick(UINT32 tick)
+{
+	UINT32 endSmpl;
+	UINT32 smplFileTick;
+	UINT32 maxSmpl;
+	INT32 smplStep;
+	size_t curDev;
+	
+	// This works like Render(), except that the sound devices don't generate any output.
+	endSmpl = Tick2Sample(tick);
+	while(_playSmpl < endSmpl && ! (_playState & PLAYSTATE_END))
+	{
+		smplFileTick = Sample2Tick(_playSmpl);
+		ParseFile(smplFileTick - _playTick);
+		if (_snapSupport && _playOpts.snapInterval && _playTick >= _nextSnapTick &&
+			! (_playState & PLAYSTATE_END))
+			SaveSnapshot();
+		
+		maxSmpl = Tick2Sample(_fileTick);
+		smplStep = maxSmpl - _playSmpl;
+		if (smplStep < 1)
+			smplStep = 1;
+		for (curDev = 0; curDev < _dacStreams.size(); curDev ++)
+		{
+			UINT32 dacSteps = daccontrol_get_samples_to_write(_dacStreams[curDev].defInf.dataPtr);
+			if ((UINT32)smplStep > dacSteps)
+				smplStep = dacSteps;
+		}
+		if ((UINT32)smplStep > endSmpl - _playSmpl)
+			smplStep = endSmpl - _playSmpl;
+		
+		AdvanceDevices(smplStep);
+		for (curDev = 0; curDev < _dacStreams.size(); curDev ++)
+		{
+			DEV_INFO* dacDInf = &_dacStreams[curDev].defInf;
+			dacDInf->devDef->Update(dacDInf->dataPtr, smplStep, NULL);
+		}
+		_playSmpl += smplStep;
+	}
+	
+	return;
+}
+
 UINT8 VGMPlayer::SeekToFilePos(UINT32 pos)
 {
 	_playState |= PLAYSTATE_SEEK;
 	while(_filePos < _fileHdr.dataEnd && _filePos <= pos && ! (_playState & PLAYSTATE_END))
 	{
+		if (_filePos + _CMD_MAX_LEN > _fileLoaded)
+			LoadFileData(_filePos + _CMD_MAX_LEN);
 		UINT8 curCmd = _fileData[_filePos];
 		COMMAND_FUNC func = _CMD_INFO[curCmd].func;
+		if (curCmd != 0x67 && ! _romImages.empty())
+			LinkROMImages();	// a sequence of data blocks ended
 		(this->*func)();
 		_filePos += _CMD_INFO[curCmd].cmdLen;
 	}
+	if (! _romImages.empty())
+		LinkROMImages();
 	_playTick = _fileTick;
 	_playSmpl = Tick2Sample(_playTick);
 	
@@ -1814,6 +2031,390 @@ UINT8 VGMPlayer::SeekToFilePos(UINT32 pos)
 	return 0x00;
 }
 
+void VGMPlayer::CheckSnapshotSupport(void)
+{
+	size_t curDev;
+	
+	_snapSupport = 0x00;
+	for (curDev = 0; curDev < _devices.size(); curDev ++)
+	{
+		VGM_BASEDEV* clDev;
+		
+		for (clDev = &_devices[curDev].base; clDev != NULL; clDev = clDev->linkDev)
+		{
+			const DEV_DEF* devDef = clDev->defInf.devDef;
+			DEVFUNC_SAVE_STATE funcSave = NULL;
+			DEVFUNC_LOAD_STATE funcLoad = NULL;
+			if (clDev->defInf.dataPtr == NULL)
+				continue;
+			SndEmu_GetDeviceFunc(devDef, RWF_STATE | RWF_READ, DEVRW_BLOCK, 0, (void**)&funcSave);
+			SndEmu_GetDeviceFunc(devDef, RWF_STATE | RWF_WRITE, DEVRW_BLOCK, 0, (void**)&funcLoad);
+			if (funcSave == NULL || funcLoad == NULL)
+			{
+				emu_logf(&_logger, PLRLOG_DEBUG, "Seek snapshots disabled: %s core %s doesn't support saving its state.\n",
+					devDef->name, devDef->author);
+				return;
+			}
+		}
+	}
+	
+	_snapSupport = 0x01;
+	return;
+}
+
+void VGMPlayer::ClearSnapshots(void)
+{
+	_snapshots.clear();
+	_snapMemUsage = 0;
+	_nextSnapTick = 0;
+	return;
+}
+
+void VGMPlayer::SaveSnapshot(void)
+{
+	size_t curDev;
+	size_t snapPos;
+	
+	// find insertion position (snapshots are sorted by tick)
+	for (snapPos = _snapshots.size(); snapPos > 0; snapPos --)
+	{
+		if (_snapshots[snapPos - 1].playTick <= _playTick)
+			break;
+	}
+	if (snapPos > 0 && _playTick - _snapshots[snapPos - 1].playTick < _playOpts.snapInterval)
+	{
+		// There is already a snapshot close to the current position. (happens after seeking back)
+		_nextSnapTick = _snapshots[snapPos - 1].playTick + _playOpts.snapInterval;
+		return;
+	}
+	if (snapPos < _snapshots.size() && _snapshots[snapPos].playTick - _playTick < _playOpts.snapInterval)
+	{
+		_nextSnapTick = _snapshots[snapPos].playTick + _playOpts.snapInterval;
+		return;
+	}
+	_nextSnapTick = _playTick + _playOpts.snapInterval;
+	
+	STATE_SNAPSHOT snap;
+	snap.filePos = _filePos;
+	snap.fileTick = _fileTick;
+	snap.playTick = _playTick;
+	snap.playSmpl = _playSmpl;
+	snap.curLoop = _curLoop;
+	snap.lastLoopTick = _lastLoopTick;
+	snap.memSize = sizeof(STATE_SNAPSHOT);
+	
+	for (curDev = 0; curDev < _devices.size(); curDev ++)
+	{
+		VGM_BASEDEV* clDev;
+		
+		for (clDev = &_devices[curDev].base; clDev != NULL; clDev = clDev->linkDev)
+		{
+			const RESMPL_STATE* rsmpl = &clDev->resmpl;
+			DEVFUNC_SAVE_STATE funcSave = NULL;
+			if (clDev->defInf.dataPtr == NULL)
+				continue;
+			SndEmu_GetDeviceFunc(clDev->defInf.devDef, RWF_STATE | RWF_READ, DEVRW_BLOCK, 0, (void**)&funcSave);
+			
+			snap.devStates.push_back(SNAP_DEV());
+			SNAP_DEV& sDev = snap.devStates.back();
+			sDev.state.resize(funcSave(clDev->defInf.dataPtr, 0, NULL));
+			if (! sDev.state.empty())
+				funcSave(clDev->defInf.dataPtr, (UINT32)sDev.state.size(), &sDev.state[0]);
+			sDev.smpRateSrc = rsmpl->smpRateSrc;
+			sDev.smpP = rsmpl->smpP;
+			sDev.smpLast = rsmpl->smpLast;
+			sDev.smpNext = rsmpl->smpNext;
+			sDev.lSmpl = rsmpl->lSmpl;
+			sDev.nSmpl = rsmpl->nSmpl;
+			snap.memSize += sizeof(SNAP_DEV) + sDev.state.size();
+		}
+	}
+	for (curDev = 0; curDev < _mixList.grpCount; curDev ++)
+	{
+		const RESMPL_STATE* rsmpl = &_mixList.groups[curDev].resmpl;
+		
+		snap.mixStates.push_back(SNAP_DEV());
+		SNAP_DEV& sDev = snap.mixStates.back();
+		sDev.smpRateSrc = rsmpl->smpRateSrc;
+		sDev.smpP = rsmpl->smpP;
+		sDev.smpLast = rsmpl->smpLast;
+		sDev.smpNext = rsmpl->smpNext;
+		sDev.lSmpl = rsmpl->lSmpl;
+		sDev.nSmpl = rsmpl->nSmpl;
+		snap.memSize += sizeof(SNAP_DEV);
+	}
+	for (curDev = 0; curDev < _dacStreams.size(); curDev ++)
+	{
+		snap.dacStrms.push_back(SNAP_DACSTRM());
+		SNAP_DACSTRM& sDac = snap.dacStrms.back();
+		void* dacData = _dacStreams[curDev].defInf.dataPtr;
+		sDac.info = _dacStreams[curDev];
+		sDac.state.resize(daccontrol_save_state(dacData, 0, NULL));
+		daccontrol_save_state(dacData, (UINT32)sDac.state.size(), &sDac.state[0]);
+		snap.memSize += sizeof(SNAP_DACSTRM) + sDac.state.size();
+	}
+	
+	snap.ym2612pcm_bnkPos = _ym2612pcm_bnkPos;
+	memcpy(snap.rf5cBank, _rf5cBank, sizeof(_rf5cBank));
+	memcpy(snap.qsWork, _qsWork, sizeof(_qsWork));
+	
+	if (snap.memSize > _playOpts.snapMemLimit)
+		return;
+	_snapMemUsage += snap.memSize;
+	_snapshots.insert(_snapshots.begin() + snapPos, snap);
+	// drop the oldest snapshots when going over the memory limit
+	while(_snapMemUsage > _playOpts.snapMemLimit && ! _snapshots.empty())
+	{
+		_snapMemUsage -= _snapshots.front().memSize;
+		_snapshots.erase(_snapshots.begin());
+	}
+	
+	return;
+}
+
+size_t VGMPlayer::FindSnapshot(UINT32 tick) const
+{
+	// return the last snapshot at or before the specified tick
+	size_t snapID;
+	
+	for (snapID = _snapshots.size(); snapID > 0; snapID --)
+	{
+		if (_snapshots[snapID - 1].playTick <= tick)
+			return snapID - 1;
+	}
+	return (size_t)-1;
+}
+
+void VGMPlayer::LoadSnapshot(size_t snapID)
+{
+	const STATE_SNAPSHOT& snap = _snapshots[snapID];
+	size_t curDev;
+	size_t curStrm;
+	size_t devIdx;
+	
+	// PCM banks are never unloaded during playback, so they only need to be completed.
+	// (after the first loop, all data blocks of the file are loaded)
+	LoadPCMBanks(snap.curLoop ? _fileHdr.dataEnd : snap.filePos);
+	
+	// restore sound devices
+	// Note: Loading the state may trigger a sample rate change callback, so the resampler is restored afterwards.
+	devIdx = 0;
+	for (curDev = 0; curDev < _devices.size(); curDev ++)
+	{
+		VGM_BASEDEV* clDev;
+		
+		for (clDev = &_devices[curDev].base; clDev != NULL; clDev = clDev->linkDev)
+		{
+			RESMPL_STATE* rsmpl = &clDev->resmpl;
+			DEVFUNC_LOAD_STATE funcLoad = NULL;
+			if (clDev->defInf.dataPtr == NULL)
+				continue;
+			SndEmu_GetDeviceFunc(clDev->defInf.devDef, RWF_STATE | RWF_WRITE, DEVRW_BLOCK, 0, (void**)&funcLoad);
+			
+			const SNAP_DEV& sDev = snap.devStates[devIdx];
+			devIdx ++;
+			if (! sDev.state.empty())
+				funcLoad(clDev->defInf.dataPtr, (UINT32)sDev.state.size(), &sDev.state[0]);
+			Resmpl_ChangeRate(rsmpl, sDev.smpRateSrc);
+			rsmpl->smpP = sDev.smpP;
+			rsmpl->smpLast = sDev.smpLast;
+			rsmpl->smpNext = sDev.smpNext;
+			rsmpl->lSmpl = sDev.lSmpl;
+			rsmpl->nSmpl = sDev.nSmpl;
+		}
+	}
+	// The groups are built from the restored devices. (The positions of the current groups must not be kept.)
+	MixList_Deinit(&_mixList);
+	SetupMixGroups();
+	if (snap.mixStates.size() == _mixList.grpCount)
+	{
+		for (curDev = 0; curDev < _mixList.grpCount; curDev ++)
+		{
+			RESMPL_STATE* rsmpl = &_mixList.groups[curDev].resmpl;
+			const SNAP_DEV& sDev = snap.mixStates[curDev];
+			if (sDev.smpRateSrc != rsmpl->smpRateSrc)
+				continue;
+			rsmpl->smpP = sDev.smpP;
+			rsmpl->smpLast = sDev.smpLast;
+			rsmpl->smpNext = sDev.smpNext;
+			rsmpl->lSmpl = sDev.lSmpl;
+			rsmpl->nSmpl = sDev.nSmpl;
+		}
+	}
+	
+	// recreate DAC streams
+	for (curStrm = 0; curStrm < _dacStreams.size(); curStrm ++)
+	{
+		DEV_INFO* devInf = &_dacStreams[curStrm].defInf;
+		devInf->devDef->Stop(devInf->dataPtr);
+	}
+	_dacStreams.clear();
+	for (curStrm = 0; curStrm < 0x100; curStrm ++)
+		_dacStrmMap[curStrm] = (size_t)-1;
+	for (curStrm = 0; curStrm < snap.dacStrms.size(); curStrm ++)
+	{
+		const SNAP_DACSTRM& sDac = snap.dacStrms[curStrm];
+		DEV_GEN_CFG devCfg;
+		DACSTRM_DEV dacStrm;
+		UINT8 retVal;
+		
+		devCfg.emuCore = 0x00;
+		devCfg.srMode = DEVRI_SRMODE_NATIVE;
+		devCfg.flags = 0x00;
+		devCfg.clock = 0;
+		devCfg.smplRate = _outSmplRate;
+		retVal = device_start_daccontrol(&devCfg, &dacStrm.defInf);
+		if (retVal)
+			continue;
+		daccontrol_load_state(dacStrm.defInf.dataPtr, (UINT32)sDac.state.size(), &sDac.state[0]);
+		dacStrm.streamID = sDac.info.streamID;
+		dacStrm.bankID = sDac.info.bankID;
+		dacStrm.pbMode = sDac.info.pbMode;
+		dacStrm.freq = sDac.info.freq;
+		dacStrm.lastItem = sDac.info.lastItem;
+		dacStrm.maxItems = sDac.info.maxItems;
+		dacStrm.destDev = sDac.info.destDev;
+		if (dacStrm.bankID < _PCM_BANK_COUNT && ! _pcmBank[dacStrm.bankID].data.empty())
+		{
+			PCM_BANK* pcmBnk = &_pcmBank[dacStrm.bankID];
+			daccontrol_refresh_data(dacStrm.defInf.dataPtr, &pcmBnk->data[0], (UINT32)pcmBnk->data.size());
+		}
+		else
+		{
+			daccontrol_refresh_data(dacStrm.defInf.dataPtr, NULL, 0);
+		}
+		
+		_dacStrmMap[dacStrm.streamID] = _dacStreams.size();
+		_dacStreams.push_back(dacStrm);
+	}
+	
+	_ym2612pcm_bnkPos = snap.ym2612pcm_bnkPos;
+	memcpy(_rf5cBank, snap.rf5cBank, sizeof(_rf5cBank));
+	memcpy(_qsWork, snap.qsWork, sizeof(_qsWork));
+	
+	_filePos = snap.filePos;
+	_fileTick = snap.fileTick;
+	_playTick = snap.playTick;
+	_playSmpl = snap.playSmpl;
+	_curLoop = snap.curLoop;
+	_lastLoopTick = snap.lastLoopTick;
+	_playState &= ~PLAYSTATE_END;
+	_psTrigger = 0x00;
+	_nextSnapTick = _playTick + _playOpts.snapInterval;
+	
+	return;
+}
+
+void VGMPlayer::LoadPCMBanks(UINT32 endPos)
+{
+	// quickly load all PCM data blocks that come before endPos, skipping all other commands
+	UINT32 filePos = _fileHdr.dataOfs;
+	
+	if (_dblkLoadPos >= endPos)
+		return;	// already loaded
+	while(filePos < _fileHdr.dataEnd && filePos < endPos)
+	{
+		if (filePos + _CMD_MAX_LEN > _fileLoaded)
+			LoadFileData(filePos + _CMD_MAX_LEN);
+		UINT8 curCmd = _fileData[filePos];
+		if (curCmd == 0x67)
+		{
+			UINT8 dblkType = _fileData[filePos + 0x02];
+			UINT32 dblkLen = ReadLE32(&_fileData[filePos + 0x03]) & 0x7FFFFFFF;
+			LoadFileData(filePos + 0x07 + dblkLen);
+			if (! (dblkType & 0x80) && filePos + 0x07 >= _dblkLoadPos)
+			{
+				AddPCMDataBlock(dblkType, dblkLen, &_fileData[filePos + 0x07]);
+				_dblkLoadPos = filePos + 0x07 + dblkLen;
+			}
+			filePos += 0x07 + dblkLen;
+		}
+		else
+		{
+			if (curCmd == 0x66 || _CMD_INFO[curCmd].cmdLen == 0)
+				break;
+			filePos += _CMD_INFO[curCmd].cmdLen;
+		}
+	}
+	
+	return;
+}
+
+void VGMPlayer::ScanPCMBanks(void)
+{
+	// determine the final size of all PCM banks, so that they need to be allocated only once
+	UINT32 filePos = _fileHdr.dataOfs;
+	size_t curBank;
+	
+	for (curBank = 0x00; curBank < _PCM_BANK_COUNT; curBank ++)
+	{
+		_pcmBank[curBank].totalSize = 0;
+		_pcmBank[curBank].totalItems = 0;
+	}
+	if (_playOpts.progressiveLoad || _probeOnly)
+		return;	// This would require the whole file to be loaded.
+	
+	while(filePos + _CMD_MAX_LEN <= _fileLoaded && filePos < _fileHdr.dataEnd)
+	{
+		UINT8 curCmd = _fileData[filePos];
+		if (curCmd == 0x67)
+		{
+			UINT8 dblkType = _fileData[filePos + 0x02];
+			UINT32 dblkLen = ReadLE32(&_fileData[filePos + 0x03]) & 0x7FFFFFFF;
+			if (filePos + 0x07 + dblkLen > _fileLoaded)
+				break;
+			if (! (dblkType & 0x80) && dblkType != 0x7F)
+			{
+				PCM_BANK* pcmBnk = &_pcmBank[dblkType & 0x3F];
+				UINT32 dataLen = dblkLen;
+				if (dblkType & 0x40)
+				{
+					PCM_CDB_INF dbCI;
+					ReadComprDataBlkHdr(dblkLen, &_fileData[filePos + 0x07], &dbCI);
+					dataLen = dbCI.decmpLen;
+				}
+				pcmBnk->totalSize += dataLen;
+				pcmBnk->totalItems ++;
+			}
+			filePos += 0x07 + dblkLen;
+		}
+		else
+		{
+			if (curCmd == 0x66 || _CMD_INFO[curCmd].cmdLen == 0)
+				break;
+			filePos += _CMD_INFO[curCmd].cmdLen;
+		}
+	}
+	
+	return;
+}
+
+UINT8 VGMPlayer::GetProfile(PLR_PROFILE& prof) const
+{
+#ifdef PLAYER_PROFILING
+	size_t curDev;
+	
+	PlayerBase::GetProfile(prof);
+	for (curDev = 0; curDev < _devices.size(); curDev ++)
+		AddDevProfiles(prof.devices, (UINT32)curDev, &_devices[curDev].base);
+	return 0x00;
+#else
+	return 0xFF;
+#endif
+}
+
+void VGMPlayer::ResetProfile(void)
+{
+#ifdef PLAYER_PROFILING
+	size_t curDev;
+	
+	PlayerBase::ResetProfile();
+	for (curDev = 0; curDev < _devices.size(); curDev ++)
+		ResetDevProfiles(&_devices[curDev].base);
+#endif
+	return;
+}
+
 UINT32 VGMPlayer::Render(UINT32 smplCnt, WAVE_32BS* data)
 {
 	UINT32 curSmpl;
@@ -1828,28 +2429,26 @@ UINT32 VGMPlayer::Render(UINT32 smplCnt, WAVE_32BS* data)
 	{
 		smplFileTick = Sample2Tick(_playSmpl);
 		ParseFile(smplFileTick - _playTick);
+		if (_snapSupport && _playOpts.snapInterval && _playTick >= _nextSnapTick &&
+			! (_playState & PLAYSTATE_END))
+			SaveSnapshot();
 		
 		// render as many samples at once as possible (for better performance)
 		maxSmpl = Tick2Sample(_fileTick);
 		smplStep = maxSmpl - _playSmpl;
-		// When DAC streams are active, limit step size to 1, so that DAC streams and sound chip emulation are in sync.
-		if (smplStep < 1 || ! _dacStreams.empty())
+		if (smplStep < 1)
 			smplStep = 1;	// must render at least 1 sample in order to advance
+		// When DAC streams are active, render only up to the next DAC write, so that DAC streams and sound chip emulation are in sync.
+		for (curDev = 0; curDev < _dacStreams.size(); curDev ++)
+		{
+			UINT32 dacSteps = daccontrol_get_samples_to_write(_dacStreams[curDev].defInf.dataPtr);
+			if ((UINT32)smplStep > dacSteps)
+				smplStep = dacSteps;
+		}
 		if ((UINT32)smplStep > smplCnt - curSmpl)
 			smplStep = smplCnt - curSmpl;
 		
-		for (curDev = 0; curDev < _devices.size(); curDev ++)
-		{
-			CHIP_DEVICE* cDev = &_devices[curDev];
-			UINT8 disable = (cDev->optID != (size_t)-1) ? _devOpts[cDev->optID].muteOpts.disable : 0x00;
-			VGM_BASEDEV* clDev;
-			
-			for (clDev = &cDev->base; clDev != NULL; clDev = clDev->linkDev, disable >>= 1)
-			{
-				if (clDev->defInf.dataPtr != NULL && ! (disable & 0x01))
-					Resmpl_Execute(&clDev->resmpl, smplStep, &data[curSmpl]);
-			}
-		}
+		RenderDevices(smplStep, &data[curSmpl]);
 		for (curDev = 0; curDev < _dacStreams.size(); curDev ++)
 		{
 			DEV_INFO* dacDInf = &_dacStreams[curDev].defInf;
@@ -1868,19 +2467,284 @@ UINT32 VGMPlayer::Render(UINT32 smplCnt, WAVE_32BS* data)
 	return curSmpl;
 }
 
+void VGMPlayer::StartRenderThreads(void)
+{
+	size_t threadCnt;
+	size_t curThr;
+	
+	StopRenderThreads();
+	
+	// The calling thread renders as well, so it needs 1 worker thread less.
+	threadCnt = (_playOpts.renderThreads > 1) ? (_playOpts.renderThreads - 1) : 0;
+	if (threadCnt >= _devices.size())
+		threadCnt = _devices.empty() ? 0 : (_devices.size() - 1);
+	if (! threadCnt)
+		return;
+	if (OSMutex_Init(&_rtMutex, 0))
+	{
+		_rtMutex = NULL;
+		emu_logf(&_logger, PLRLOG_WARN, "Unable to create render mutex. Rendering will be single-threaded.\n");
+		return;
+	}
+	
+	_rtExit = 0;
+	_rThreads.reserve(threadCnt);
+	for (curThr = 0; curThr < threadCnt; curThr ++)
+	{
+		RENDER_THREAD rThr;
+		
+		rThr.player = this;
+		rThr.hThread = NULL;
+		if (OSSignal_Init(&rThr.sigStart, 0))
+			break;
+		if (OSSignal_Init(&rThr.sigDone, 0))
+		{
+			OSSignal_Deinit(rThr.sigStart);
+			break;
+		}
+		_rThreads.push_back(rThr);
+	}
+	// The threads get pointers into _rThreads, so they can be created only after the vector is complete.
+	for (curThr = 0; curThr < _rThreads.size(); curThr ++)
+	{
+		RENDER_THREAD& rThr = _rThreads[curThr];
+		if (OSThread_Init(&rThr.hThread, VGMPlayer::RenderThread, &rThr))
+			break;
+	}
+	if (curThr < threadCnt)
+	{
+		emu_logf(&_logger, PLRLOG_WARN, "Unable to create all render threads. (%u of %u running)\n",
+			(unsigned)curThr, (unsigned)threadCnt);
+		while(_rThreads.size() > curThr)
+		{
+			OSSignal_Deinit(_rThreads.back().sigStart);
+			OSSignal_Deinit(_rThreads.back().sigDone);
+			_rThreads.pop_back();
+		}
+	}
+	
+	return;
+}
+
+void VGMPlayer::StopRenderThreads(void)
+{
+	size_t curThr;
+	
+	_rtExit = 1;
+	for (curThr = 0; curThr < _rThreads.size(); curThr ++)
+		OSSignal_Signal(_rThreads[curThr].sigStart);
+	for (curThr = 0; curThr < _rThreads.size(); curThr ++)
+	{
+		RENDER_THREAD& rThr = _rThreads[curThr];
+		OSThread_Join(rThr.hThread);
+		OSThread_Deinit(rThr.hThread);
+		OSSignal_Deinit(rThr.sigStart);
+		OSSignal_Deinit(rThr.sigDone);
+	}
+	_rThreads.clear();
+	if (_rtMutex != NULL)
+	{
+		OSMutex_Deinit(_rtMutex);
+		_rtMutex = NULL;
+	}
+	_rtBuffer.clear();
+	
+	return;
+}
+
+/*static*/ void VGMPlayer::RenderThread(void* args)
+{
+	RENDER_THREAD* rThr = (RENDER_THREAD*)args;
+	VGMPlayer* player = rThr->player;
+	
+	while(true)
+	{
+		OSSignal_Wait(rThr->sigStart);
+		if (player->_rtExit)
+			break;
+		player->RenderDevicesMT();
+		OSSignal_Signal(rThr->sigDone);
+	}
+	
+	return;
+}
+
+void VGMPlayer::RenderDevice(size_t devID, UINT32 smplCnt, WAVE_32BS* data)
+{
+	CHIP_DEVICE* cDev = &_devices[devID];
+	UINT8 disable = (cDev->optID != (size_t)-1) ? _devOpts[cDev->optID].muteOpts.disable : 0x00;
+	VGM_BASEDEV* clDev;
+	
+	// devices in a mix group are rendered by RenderUnit()
+	for (clDev = &cDev->base; clDev != NULL; clDev = clDev->linkDev, disable >>= 1)
+	{
+		if (clDev->defInf.dataPtr != NULL && ! (disable & 0x01) && clDev->mixGrp == NULL)
+			DEVPROF_RESMPL_EXEC(clDev, smplCnt, data);
+	}
+	
+	return;
+}
+
+// Render units are all devices, followed by all mix groups.
+void VGMPlayer::RenderUnit(size_t unitID, UINT32 smplCnt, WAVE_32BS* data)
+{
+	if (unitID < _devices.size())
+		RenderDevice(unitID, smplCnt, data);
+	else
+		Resmpl_Execute(&_mixList.groups[unitID - _devices.size()].resmpl, smplCnt, data);
+	
+	return;
+}
+
+void VGMPlayer::RenderDevicesMT(void)
+{
+	size_t unitCnt = _devices.size() + _mixList.grpCount;
+	
+	// Render units are handed out one by one, so that a thread that finishes early can take the next one.
+	while(true)
+	{
+		size_t curUnit;
+		
+		OSMutex_Lock(_rtMutex);
+		curUnit = _rtNextDev;
+		if (curUnit < unitCnt)
+			_rtNextDev ++;
+		OSMutex_Unlock(_rtMutex);
+		if (curUnit >= unitCnt)
+			break;
+		RenderUnit(curUnit, _rtSmplCnt, &_rtBuffer[curUnit * _rtSmplCnt]);
+	}
+	
+	return;
+}
+
+// Groups devices with the same sample rate, so that they are mixed at their native sample rate
+// and resampled together. This way the resampling work depends on the number of different
+// sample rates instead of the number of devices.
+void VGMPlayer::SetupMixGroups(void)
+{
+	size_t curDev;
+	
+	MixList_Restart(&_mixList);
+	for (curDev = 0; curDev < _devices.size(); curDev ++)
+	{
+		CHIP_DEVICE& chipDev = _devices[curDev];
+		const UINT8* disable = (chipDev.optID != (size_t)-1) ? &_devOpts[chipDev.optID].muteOpts.disable : NULL;
+		VGM_BASEDEV* clDev;
+		UINT8 linkID;
+		
+		for (clDev = &chipDev.base, linkID = 0; clDev != NULL; clDev = clDev->linkDev, linkID ++)
+			MixList_AddDevice(&_mixList, clDev, disable, linkID);
+	}
+	MixList_Finish(&_mixList, _outSmplRate);
+	
+	return;
+}
+
+// Devices may change their sample rate during playback. The groups are set up again when this happens.
+// (This results in a short discontinuity, which doesn't matter, as the rate changes anyway.)
+void VGMPlayer::CheckMixGroups(void)
+{
+	if (MixList_RateChanged(&_mixList))
+		SetupMixGroups();
+	return;
+}
+
+// Blocks smaller than this are rendered by the calling thread only, as waking up
+// the worker threads would take longer than rendering the samples.
+#define RENDER_MT_MIN_SMPLS	32
+
+void VGMPlayer::RenderDevices(UINT32 smplCnt, WAVE_32BS* data)
+{
+	size_t unitCnt;
+	size_t curUnit;
+	size_t curThr;
+	UINT32 curSmpl;
+	
+	CheckMixGroups();
+	unitCnt = _devices.size() + _mixList.grpCount;
+	if (_rThreads.empty() || smplCnt < RENDER_MT_MIN_SMPLS)
+	{
+		for (curUnit = 0; curUnit < unitCnt; curUnit ++)
+			RenderUnit(curUnit, smplCnt, data);
+		return;
+	}
+	
+	// Each render unit renders into a separate buffer. The buffers are then mixed in the same order
+	// as in single-threaded mode. The resampler only adds to its output buffer, so the result is
+	// bit-identical to rendering all units into "data" directly.
+	// All register writes are done before, so each device is accessed by only one thread at a time.
+	_rtSmplCnt = smplCnt;
+	_rtBuffer.resize((size_t)smplCnt * unitCnt);
+	memset(&_rtBuffer[0], 0x00, _rtBuffer.size() * sizeof(WAVE_32BS));
+	_rtNextDev = 0;
+	for (curThr = 0; curThr < _rThreads.size(); curThr ++)
+		OSSignal_Signal(_rThreads[curThr].sigStart);
+	RenderDevicesMT();
+	for (curThr = 0; curThr < _rThreads.size(); curThr ++)
+		OSSignal_Wait(_rThreads[curThr].sigDone);
+	
+	for (curUnit = 0; curUnit < unitCnt; curUnit ++)
+	{
+		const WAVE_32BS* devBuf = &_rtBuffer[curUnit * smplCnt];
+		for (curSmpl = 0; curSmpl < smplCnt; curSmpl ++)
+		{
+			data[curSmpl].L += devBuf[curSmpl].L;
+			data[curSmpl].R += devBuf[curSmpl].R;
+		}
+	}
+	
+	return;
+}
+
+void VGMPlayer::AdvanceDevices(UINT32 smplCnt)
+{
+	size_t curDev;
+	size_t curGrp;
+	
+	CheckMixGroups();
+	for (curDev = 0; curDev < _devices.size(); curDev ++)
+	{
+		CHIP_DEVICE* cDev = &_devices[curDev];
+		UINT8 disable = (cDev->optID != (size_t)-1) ? _devOpts[cDev->optID].muteOpts.disable : 0x00;
+		VGM_BASEDEV* clDev;
+		
+		for (clDev = &cDev->base; clDev != NULL; clDev = clDev->linkDev, disable >>= 1)
+		{
+			if (clDev->defInf.dataPtr != NULL && ! (disable & 0x01) && clDev->mixGrp == NULL)
+				Resmpl_Advance(&clDev->resmpl, smplCnt);
+		}
+	}
+	for (curGrp = 0; curGrp < _mixList.grpCount; curGrp ++)
+		Resmpl_Advance(&_mixList.groups[curGrp].resmpl, smplCnt);
+	
+	return;
+}
+
 void VGMPlayer::ParseFile(UINT32 ticks)
 {
 	_playTick += ticks;
 	if (_playState & PLAYSTATE_END)
 		return;
 	
+	DEVPROF_TIMER_START(profTime);
+	if (! _cmdEvents.empty())
+		ParseCmdEvents();
+	// The loop below processes the commands when there is no compiled command list.
+	// (It also takes over when the compiled list can not be used at the current file position.)
 	while(_filePos < _fileHdr.dataEnd && _fileTick <= _playTick && ! (_playState & PLAYSTATE_END))
 	{
+		if (_filePos + _CMD_MAX_LEN > _fileLoaded)
+			LoadFileData(_filePos + _CMD_MAX_LEN);
 		UINT8 curCmd = _fileData[_filePos];
 		COMMAND_FUNC func = _CMD_INFO[curCmd].func;
+		if (curCmd != 0x67 && ! _romImages.empty())
+			LinkROMImages();	// a sequence of data blocks ended
 		(this->*func)();
 		_filePos += _CMD_INFO[curCmd].cmdLen;
 	}
+	if (! _romImages.empty())
+		LinkROMImages();
 	
 	if (_p2612Fix & P2612FIX_ACTIVE)
 	{
@@ -1906,6 +2770,8 @@ void VGMPlayer::ParseFile(UINT32 ticks)
 			_eventCbFunc(this, _eventCbParam, PLREVT_END, NULL);
 		emu_logf(&_logger, PLRLOG_WARN, "VGM file ends early! (filePos 0x%06X, end at 0x%06X)\n", _filePos, _fileHdr.dataEnd);
 	}
+	DEVPROF_TIMER_ADD(profTime, _profParseTime);
+	DEVPROF_COUNT(_profParseCalls);
 	
 	return;
 }
@@ -1920,6 +2786,8 @@ void VGMPlayer::ParseFileForFMClocks()
 
 	while(filePos < _fileHdr.dataEnd)
 	{
+		if (filePos + _CMD_MAX_LEN > _fileLoaded)
+			LoadFileData(filePos + _CMD_MAX_LEN);
 		UINT8 curCmd = _fileData[filePos];
 
 		switch (curCmd)
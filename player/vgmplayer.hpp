@@ -8,8 +8,12 @@
 #include "helper.h"
 #include "playerbase.hpp"
 #include "../utils/DataLoader.h"
+#include "../utils/OSThread.h"
+#include "../utils/OSSignal.h"
+#include "../utils/OSMutex.h"
 #include "../emu/logging.h"
 #include "dblk_compr.h"
+#include "romcache.h"
 #include <vector>
 #include <string>
 
@@ -46,6 +50,18 @@ struct VGM_PLAY_OPTIONS
 	UINT32 playbackHz;	// set to 60 (NTSC) or 50 (PAL) for region-specific song speed adjustment
 						// Note: requires VGM_HEADER.recordHz to be non-zero to work.
 	UINT8 hardStopOld;	// enforce silence at end of old VGMs (<1.50), fixes Key Off events being trimmed off
+	UINT32 snapInterval;	// interval (in ticks) for state snapshots used for fast seeking, 0 = disabled
+						// Note: Snapshots are only taken when all sound cores support saving their state.
+	UINT32 snapMemLimit;	// memory budget for state snapshots in bytes, oldest snapshots are dropped first
+	UINT8 renderThreads;	// number of threads for rendering sound devices (including the calling thread), 0/1 = single-threaded
+						// Note: The output is identical to single-threaded rendering.
+	UINT8 progressiveLoad;	// 1 = LoadFile reads only the header, the rest of the file is read while playing
+						// This makes large compressed files start almost immediately.
+						// Note: Tags (GD3) are available only after the whole file has been read.
+	UINT8 compileCmds;	// 1 = decode all commands into a list of events at Start(), for faster parsing
+						// The list takes about 16 bytes per command. Ignored when using progressive loading.
+	UINT8 accurateSeek;	// 1 = advance the sound chips through the skipped part when seeking forward
+						// 0 = only send the register writes (faster, but envelopes/sample positions are wrong afterwards)
 };
 
 
@@ -75,6 +91,9 @@ public:
 		DEVFUNC_WRITE_BLOCK romWrite;
 		DEVFUNC_WRITE_MEMSIZE romSizeB;
 		DEVFUNC_WRITE_BLOCK romWriteB;
+		DEVFUNC_WRITE_MEMLINK romLink;	// link shared ROM image (used instead of romSize/romWrite when available)
+		DEVFUNC_WRITE_MEMLINK romLinkB;
+		ROMCACHE_ENTRY* romCache[2];	// linked ROM images
 		DEVLOG_CB_DATA logCbData;
 	};
 	struct DACSTRM_DEV
@@ -86,6 +105,7 @@ public:
 		UINT32 freq;
 		UINT32 lastItem;
 		UINT32 maxItems;
+		VGM_BASEDEV* destDev;	// device the stream writes to (NULL = not set up yet)
 	};
 
 protected:
@@ -110,11 +130,20 @@ protected:
 		std::vector<UINT8> cfgData;
 	};
 	
+	struct ROM_IMAGE
+	{
+		size_t devID;
+		UINT8 memID;
+		std::vector<UINT8> data;
+	};
+	
 	struct PCM_BANK
 	{
 		std::vector<UINT8> data;
 		std::vector<UINT32> bankOfs;
 		std::vector<UINT32> bankSize;
+		UINT32 totalSize;	// size of all data blocks of the bank in the file (0 = unknown)
+		UINT32 totalItems;	// number of data blocks of the bank in the file
 	};
 	
 	typedef void (VGMPlayer::*COMMAND_FUNC)(void);	// VGM command member function callback
@@ -130,6 +159,24 @@ protected:
 		UINT32 cmdLen;
 		COMMAND_FUNC func;
 	};
+	struct CMD_EVENT	// pre-decoded VGM command (see CompileCommands)
+	{
+		UINT32 tick;	// file tick of the command, relative to _cmdEvtTickBase
+		UINT32 filePos;	// file offset of the command
+		UINT8 type;		// CEVT_* constant
+		UINT8 cmd;		// VGM command ID
+		UINT16 devID;	// index into _devices
+		UINT16 ofs;
+		UINT16 data;
+	};
+	
+	struct RENDER_THREAD
+	{
+		VGMPlayer* player;
+		OS_THREAD* hThread;
+		OS_SIGNAL* sigStart;	// set by Render(): a new block is ready to be rendered
+		OS_SIGNAL* sigDone;		// set by the worker thread: all devices are done
+	};
 	
 	struct QSOUND_WORK
 	{
@@ -147,6 +194,7 @@ public:
 	static UINT8 PlayerCanLoadFile(DATA_LOADER *dataLoader);
 	UINT8 CanLoadFile(DATA_LOADER *dataLoader) const;
 	UINT8 LoadFile(DATA_LOADER *dataLoader);
+	UINT8 ProbeFile(DATA_LOADER *dataLoader);
 	UINT8 UnloadFile(void);
 	const VGM_HEADER* GetFileHeader(void) const;
 	
@@ -187,13 +235,18 @@ public:
 	UINT8 Reset(void);
 	UINT8 Seek(UINT8 unit, UINT32 pos);
 	UINT32 Render(UINT32 smplCnt, WAVE_32BS* data);
+	UINT8 GetProfile(PLR_PROFILE& prof) const;
+	void ResetProfile(void);
 	
 protected:
+	UINT8 OpenFile(DATA_LOADER *dataLoader, UINT8 probeOnly);
 	UINT8 ParseHeader(void);
 	void ParseXHdr_Data32(UINT32 fileOfs, std::vector<XHDR_DATA32>& xData);
 	void ParseXHdr_Data16(UINT32 fileOfs, std::vector<XHDR_DATA16>& xData);
 	
 	UINT8 LoadTags(void);
+	UINT8 ParseTags(const UINT8* tagData, UINT32 tagLen);
+	void LoadFileData(UINT32 endPos);
 	std::string GetUTF8String(const UINT8* startPtr, const UINT8* endPtr);
 	
 	size_t DeviceID2OptionID(UINT32 id) const;
@@ -218,10 +271,36 @@ protected:
 	static void DeviceLinkCallback(void* userParam, VGM_BASEDEV* cDev, DEVLINK_INFO* dLink);
 	CHIP_DEVICE* GetDevicePtr(UINT8 chipType, UINT8 chipID);
 	void LoadOPL4ROM(CHIP_DEVICE* chipDev);
+	void WriteChipROM(CHIP_DEVICE* cDev, UINT8 memID, UINT32 memSize, UINT32 dataOfs, UINT32 dataLen, const UINT8* data);
+	void LinkROMImages(void);
 	
 	UINT8 SeekToTick(UINT32 tick);
 	UINT8 SeekToFilePos(UINT32 pos);
+	void AdvanceToTick(UINT32 tick);
 	void ParseFile(UINT32 ticks);
+	void CompileCommands(void);
+	UINT32 GetCompiledCmdLen(UINT32 filePos) const;
+	UINT8 SyncCmdEvents(void);
+	void ParseCmdEvents(void);
+	
+	void CheckSnapshotSupport(void);
+	void ClearSnapshots(void);
+	void SaveSnapshot(void);
+	size_t FindSnapshot(UINT32 tick) const;
+	void LoadSnapshot(size_t snapID);
+	void LoadPCMBanks(UINT32 endPos);
+	void ScanPCMBanks(void);
+	
+	void StartRenderThreads(void);
+	void StopRenderThreads(void);
+	static void RenderThread(void* args);
+	void RenderDevice(size_t devID, UINT32 smplCnt, WAVE_32BS* data);
+	void RenderDevicesMT(void);
+	void SetupMixGroups(void);
+	void CheckMixGroups(void);
+	void RenderUnit(size_t unitID, UINT32 smplCnt, WAVE_32BS* data);
+	void RenderDevices(UINT32 smplCnt, WAVE_32BS* data);
+	void AdvanceDevices(UINT32 smplCnt);
 
 	void ParseFileForFMClocks();
 	
@@ -234,6 +313,7 @@ protected:
 	void Cmd_Delay50Hz(void);				// command 63 - wait 882 samples (1/50 second)
 	void Cmd_DelaySamplesN1(void);			// command 70..7F - wait (N+1) samples
 	void DoRAMOfsPatches(UINT8 chipType, UINT8 chipID, UINT32& dataOfs, UINT32& dataLen);
+	void AddPCMDataBlock(UINT8 dblkType, UINT32 dblkLen, const UINT8* dblkData);
 	void Cmd_DataBlock(void);				// command 67
 	void Cmd_PcmRamWrite(void);				// command 68
 	void Cmd_YM2612PCM_Delay(void);			// command 80..8F - write YM2612 PCM from data block + delay by N samples
@@ -278,12 +358,16 @@ protected:
 	DEV_LOGGER _logger;
 	DATA_LOADER *_dLoad;
 	const UINT8* _fileData;	// data pointer for quick access, equals _dLoad->GetFileData().data()
-	std::vector<UINT8> _yrwRom;	// cache for OPL4 sample ROM (yrw801.rom)
+	UINT32 _fileLoaded;		// number of bytes in _fileData, may be less than the file size with progressive loading
+	UINT8 _probeOnly;		// file was opened using ProbeFile(), only header and tags are available
+	ROMCACHE_ENTRY* _yrwRom;	// OPL4 sample ROM (yrw801.rom)
 	UINT8 _shownCmdWarnings[0x100];
 	
 	enum
 	{
 		_HDR_BUF_SIZE = 0x100,
+		_CMD_MAX_LEN = 0x10,	// maximum length of commands with fixed size
+		_PLOAD_CHUNK = 0x4000,	// minimum number of bytes to read ahead with progressive loading
 		_OPT_DEV_COUNT = 0x30,
 		_CHIP_COUNT = 0x30,
 		_PCM_BANK_COUNT = 0x40
@@ -364,12 +448,63 @@ protected:
 	
 	PCM_BANK _pcmBank[_PCM_BANK_COUNT];
 	PCM_COMPR_TBL _pcmComprTbl;
+	UINT32 _dblkLoadPos;	// PCM data blocks before this file offset are already loaded
+	std::vector<ROM_IMAGE> _romImages;	// ROM images that are assembled from consecutive data blocks
+	
+	std::vector<CMD_EVENT> _cmdEvents;	// compiled command list, terminated by a CEVT_END event
+	size_t _cmdEvtPos;			// current event (matches _filePos)
+	UINT32 _cmdEvtTickBase;		// _fileTick = _cmdEvtTickBase + event tick (changes when looping)
 	
 	UINT8 _p2612Fix;	// enable hack/fix for Project2612 VGMs
 	UINT32 _ym2612pcm_bnkPos;
 	UINT8 _rf5cBank[2][2];	// [0 RF5C68 / 1 RF5C164][chipID]
 	QSOUND_WORK _qsWork[2];
 
+	struct SNAP_DEV	// saved state of a sound device + its resampler
+	{
+		std::vector<UINT8> state;
+		UINT32 smpRateSrc;
+		UINT32 smpP;
+		UINT32 smpLast;
+		UINT32 smpNext;
+		WAVE_32BS lSmpl;
+		WAVE_32BS nSmpl;
+	};
+	struct SNAP_DACSTRM
+	{
+		DACSTRM_DEV info;	// Note: info.defInf is not used
+		std::vector<UINT8> state;
+	};
+	struct STATE_SNAPSHOT
+	{
+		UINT32 filePos;
+		UINT32 fileTick;
+		UINT32 playTick;
+		UINT32 playSmpl;
+		UINT32 curLoop;
+		UINT32 lastLoopTick;
+		std::vector<SNAP_DEV> devStates;	// all devices + linked devices, in rendering order
+		std::vector<SNAP_DEV> mixStates;	// resamplers of the mix groups (no device state)
+		std::vector<SNAP_DACSTRM> dacStrms;
+		UINT32 ym2612pcm_bnkPos;
+		UINT8 rf5cBank[2][2];
+		QSOUND_WORK qsWork[2];
+		size_t memSize;	// estimated memory usage
+	};
+	
+	UINT8 _snapSupport;	// all devices support saving/restoring their state
+	UINT32 _nextSnapTick;
+	size_t _snapMemUsage;
+	std::vector<STATE_SNAPSHOT> _snapshots;	// sorted by playTick
+	
+	std::vector<RENDER_THREAD> _rThreads;	// worker threads for multi-threaded rendering
+	OS_MUTEX* _rtMutex;		// protects _rtNextDev
+	size_t _rtNextDev;		// next render unit (device or mix group) to be rendered by a worker thread
+	UINT32 _rtSmplCnt;		// number of samples of the current block
+	UINT8 _rtExit;			// tells worker threads to quit
+	std::vector<WAVE_32BS> _rtBuffer;	// separate output buffers for all render units (_rtSmplCnt samples each)
+	VGM_MIXLIST _mixList;	// devices that share a resampler
+
 	UINT8 _v101Fix;	// enable hack/fix for v1.00/v1.01 VGMs with FM clock
 	UINT32 _v101ym2413clock;
 	UINT32 _v101ym2612clock;
@@ -17,6 +17,24 @@
 
 #define fData	(&_fileData[_filePos])	// used by command handlers for better readability
 
+// compiled command event types
+#define CEVT_NONE		0x00	// no action (delays, commands for missing devices)
+#define CEVT_CMD		0x01	// call the command handler
+#define CEVT_W8			0x02	// write8(ofs, data)
+#define CEVT_YM			0x03	// SendYMCommand(port = ofs, reg = data >> 8, data & 0xFF)
+#define CEVT_M8			0x04	// writeM8(ofs, data)
+#define CEVT_D16		0x05	// writeD16(ofs, data)
+#define CEVT_M16		0x06	// writeM16(ofs, data)
+#define CEVT_YM2612PCM	0x07	// YM2612 DAC write from PCM bank 0 (command 80..8F)
+#define CEVT_END		0xFF	// end of the list
+
+// counts a DAC stream command for the device the stream writes to
+#ifdef PLAYER_PROFILING
+#define DACSTRM_PROFCMD(dacStrm)	if ((dacStrm)->destDev != NULL) DEVPROF_DACCMD((dacStrm)->destDev)
+#else
+#define DACSTRM_PROFCMD(dacStrm)
+#endif
+
 /*static*/ const VGMPlayer::COMMAND_INFO VGMPlayer::_CMD_INFO[0x100] =
 {
 	// {chip type, function},                         VGM command
@@ -642,9 +660,53 @@ INLINE void SendYMCommand(VGMPlayer::CHIP_DEVICE* cDev, UINT8 port, UINT8 reg, U
 	return;
 }
 
-static void WriteChipROM(VGMPlayer::CHIP_DEVICE* cDev, UINT8 memID,
-						 UINT32 memSize, UINT32 dataOfs, UINT32 dataLen, const UINT8* data)
+void VGMPlayer::WriteChipROM(CHIP_DEVICE* cDev, UINT8 memID,
+							 UINT32 memSize, UINT32 dataOfs, UINT32 dataLen, const UINT8* data)
 {
+	if ((memID ? cDev->romLinkB : cDev->romLink) != NULL)
+	{
+		// The device can use shared ROM images, so collect the data and link the image
+		// when all data blocks were processed. (see LinkROMImages)
+		size_t devID = cDev - &_devices[0];
+		ROM_IMAGE* romImg = NULL;
+		size_t curImg;
+		
+		for (curImg = 0; curImg < _romImages.size(); curImg ++)
+		{
+			if (_romImages[curImg].devID == devID && _romImages[curImg].memID == memID)
+			{
+				romImg = &_romImages[curImg];
+				break;
+			}
+		}
+		if (romImg != NULL && romImg->data.size() != memSize)
+		{
+			LinkROMImages();	// ROM size changed - finish the previous image first
+			romImg = NULL;
+		}
+		if (romImg == NULL)
+		{
+			const ROMCACHE_ENTRY* oldROM = cDev->romCache[memID];
+			
+			_romImages.push_back(ROM_IMAGE());
+			romImg = &_romImages.back();
+			romImg->devID = devID;
+			romImg->memID = memID;
+			// keep the current contents, like the romSize function does when the size doesn't change
+			if (oldROM != NULL && ROMCache_GetSize(oldROM) == memSize)
+				romImg->data.assign(ROMCache_GetData(oldROM), ROMCache_GetData(oldROM) + memSize);
+			else
+				romImg->data.resize(memSize, 0xFF);
+		}
+		if (dataOfs >= memSize)
+			return;
+		if (dataLen > memSize - dataOfs)
+			dataLen = memSize - dataOfs;
+		if (dataLen)
+			memcpy(&romImg->data[dataOfs], data, dataLen);
+		return;
+	}
+	
 	if (memID == 0)
 	{
 		if (cDev->romSize != NULL)
@@ -663,6 +725,45 @@ static void WriteChipROM(VGMPlayer::CHIP_DEVICE* cDev, UINT8 memID,
 	return;
 }
 
+void VGMPlayer::LinkROMImages(void)
+{
+	size_t curImg;
+	
+	for (curImg = 0; curImg < _romImages.size(); curImg ++)
+	{
+		const ROM_IMAGE& romImg = _romImages[curImg];
+		CHIP_DEVICE* cDev = &_devices[romImg.devID];
+		DEVFUNC_WRITE_MEMLINK romLink = romImg.memID ? cDev->romLinkB : cDev->romLink;
+		UINT32 memSize = (UINT32)romImg.data.size();
+		const UINT8* data = romImg.data.empty() ? NULL : &romImg.data[0];
+		ROMCACHE_ENTRY* romEntry;
+		
+		romEntry = memSize ? ROMCache_Acquire(memSize, data) : NULL;
+		if (romEntry == NULL)
+		{
+			// fall back to letting the device keep its own copy
+			DEVFUNC_WRITE_MEMSIZE romSize = romImg.memID ? cDev->romSizeB : cDev->romSize;
+			DEVFUNC_WRITE_BLOCK romWrite = romImg.memID ? cDev->romWriteB : cDev->romWrite;
+			romLink(cDev->base.defInf.dataPtr, 0, NULL);	// unlink the current image
+			if (romSize != NULL)
+				romSize(cDev->base.defInf.dataPtr, memSize);
+			if (romWrite != NULL && memSize)
+				romWrite(cDev->base.defInf.dataPtr, 0x00, memSize, data);
+		}
+		else
+		{
+			romLink(cDev->base.defInf.dataPtr, memSize, ROMCache_GetData(romEntry));
+		}
+		// the device doesn't use the old image anymore, so it can be released now
+		if (cDev->romCache[romImg.memID] != NULL)
+			ROMCache_Release(cDev->romCache[romImg.memID]);
+		cDev->romCache[romImg.memID] = romEntry;
+	}
+	_romImages.clear();
+	
+	return;
+}
+
 void VGMPlayer::DoRAMOfsPatches(UINT8 chipType, UINT8 chipID, UINT32& dataOfs, UINT32& dataLen)
 {
 	switch(chipType)
@@ -678,6 +779,69 @@ void VGMPlayer::DoRAMOfsPatches(UINT8 chipType, UINT8 chipID, UINT32& dataOfs, U
 	return;
 }
 
+void VGMPlayer::AddPCMDataBlock(UINT8 dblkType, UINT32 dblkLen, const UINT8* dblkData)
+{
+	if (dblkType == 0x7F)
+	{
+		ReadPCMComprTable(dblkLen, dblkData, &_pcmComprTbl);
+	}
+	else
+	{
+		PCM_BANK* pcmBnk = &_pcmBank[dblkType & 0x3F];
+		PCM_CDB_INF dbCI;
+		UINT32 oldLen = (UINT32)pcmBnk->data.size();
+		UINT32 dataLen = dblkLen;
+		const UINT8* dataPtr = dblkData;
+		
+		if (dblkType & 0x40)
+		{
+			ReadComprDataBlkHdr(dblkLen, dataPtr, &dbCI);
+			dbCI.cmprInfo.comprTbl = &_pcmComprTbl;
+			dataLen = dbCI.decmpLen;
+		}
+		
+		// allocate the whole bank at once, if its final size is known
+		if (pcmBnk->bankOfs.capacity() < pcmBnk->totalItems)
+		{
+			pcmBnk->bankOfs.reserve(pcmBnk->totalItems);
+			pcmBnk->bankSize.reserve(pcmBnk->totalItems);
+		}
+		if (pcmBnk->data.capacity() < oldLen + dataLen && pcmBnk->totalSize >= oldLen + dataLen)
+			pcmBnk->data.reserve(pcmBnk->totalSize);
+		pcmBnk->bankOfs.push_back(oldLen);
+		pcmBnk->bankSize.push_back(dataLen);
+		
+		pcmBnk->data.resize(oldLen + dataLen);
+		if (dblkType & 0x40)
+		{
+			UINT8 retVal = DecompressDataBlk(dataLen, &pcmBnk->data[oldLen],
+				dblkLen - dbCI.hdrSize, &dataPtr[dbCI.hdrSize], &dbCI.cmprInfo);
+			if (retVal == 0x10)
+				emu_logf(&_logger, PLRLOG_ERROR, "Error loading table-compressed data block! No table loaded!\n");
+			else if (retVal == 0x11)
+				emu_logf(&_logger, PLRLOG_ERROR, "Data block and loaded value table incompatible!\n");
+			else if (retVal == 0x80)
+				emu_logf(&_logger, PLRLOG_ERROR, "Unknown data block compression!\n");
+		}
+		else
+		{
+			memcpy(&pcmBnk->data[oldLen], dataPtr, dataLen);
+		}
+		
+		// the data may have been moved, so the DAC streams that use the bank need to be updated
+		for (size_t curStrm = 0; curStrm < _dacStreams.size(); curStrm ++)
+		{
+			DACSTRM_DEV* dacStrm = &_dacStreams[curStrm];
+			if (dacStrm->bankID != (dblkType & 0x3F) || pcmBnk->data.empty())
+				continue;
+			dacStrm->maxItems = (UINT32)pcmBnk->bankOfs.size();
+			daccontrol_refresh_data(dacStrm->defInf.dataPtr, &pcmBnk->data[0], (UINT32)pcmBnk->data.size());
+		}
+	}
+	
+	return;
+}
+
 void VGMPlayer::Cmd_DataBlock(void)
 {
 	UINT8 dblkType;
@@ -694,56 +858,18 @@ void VGMPlayer::Cmd_DataBlock(void)
 	dblkLen = ReadLE32(&fData[0x03]);
 	chipID = (dblkLen & 0x80000000) >> 31;
 	dblkLen &= 0x7FFFFFFF;
+	LoadFileData(_filePos + 0x07 + dblkLen);
 	_filePos += 0x07;
 	
 	switch(dblkType & 0xC0)
 	{
 	case 0x00:	// uncompressed data block
 	case 0x40:	// compressed data block
-		if (_curLoop > 0)
-			return;	// skip during the 2nd/3rd/... loop, as these blocks were already loaded
+		if (_filePos < _dblkLoadPos)
+			break;	// skip blocks that were already loaded (2nd/3rd/... loop, after Reset/seeking)
 		
-		if (dblkType == 0x7F)
-		{
-			ReadPCMComprTable(dblkLen, &fData[0x00], &_pcmComprTbl);
-		}
-		else
-		{
-			PCM_BANK* pcmBnk = &_pcmBank[dblkType & 0x3F];
-			PCM_CDB_INF dbCI;
-			UINT32 oldLen = (UINT32)pcmBnk->data.size();
-			dataLen = dblkLen;
-			dataPtr = &fData[0x00];
-			
-			if (dblkType & 0x40)
-			{
-				ReadComprDataBlkHdr(dblkLen, dataPtr, &dbCI);
-				dbCI.cmprInfo.comprTbl = &_pcmComprTbl;
-				dataLen = dbCI.decmpLen;
-			}
-			
-			pcmBnk->bankOfs.push_back(oldLen);
-			pcmBnk->bankSize.push_back(dataLen);
-			
-			pcmBnk->data.resize(oldLen + dataLen);
-			if (dblkType & 0x40)
-			{
-				UINT8 retVal = DecompressDataBlk(dataLen, &pcmBnk->data[oldLen],
-					dblkLen - dbCI.hdrSize, &dataPtr[dbCI.hdrSize], &dbCI.cmprInfo);
-				if (retVal == 0x10)
-					emu_logf(&_logger, PLRLOG_ERROR, "Error loading table-compressed data block! No table loaded!\n");
-				else if (retVal == 0x11)
-					emu_logf(&_logger, PLRLOG_ERROR, "Data block and loaded value table incompatible!\n");
-				else if (retVal == 0x80)
-					emu_logf(&_logger, PLRLOG_ERROR, "Unknown data block compression!\n");
-			}
-			else
-			{
-				memcpy(&pcmBnk->data[oldLen], dataPtr, dataLen);
-			}
-			
-			// TODO: refresh DAC Stream pointers (call daccontrol_refresh_data)
-		}
+		AddPCMDataBlock(dblkType, dblkLen, &fData[0x00]);
+		_dblkLoadPos = _filePos + dblkLen;
 		break;
 	case 0x80:	// ROM/RAM write
 		chipType = _VGM_ROM_CHIPS[dblkType & 0x3F][0];
@@ -841,6 +967,7 @@ void VGMPlayer::Cmd_YM2612PCM_Delay(void)
 	
 	if (cDev == NULL || cDev->write8 == NULL)
 		return;
+	DEVPROF_REGWRITE(&cDev->base);
 	if (_ym2612pcm_bnkPos >= _pcmBank[0].data.size())
 		return;
 	
@@ -885,6 +1012,7 @@ void VGMPlayer::Cmd_DACCtrl_Setup(void)	// DAC Stream Control: Setup Chip
 		dacStrm.freq = 0;
 		dacStrm.lastItem = (UINT32)-1;
 		dacStrm.maxItems = 0;
+		dacStrm.destDev = NULL;
 		
 		_dacStrmMap[dacStrm.streamID] = _dacStreams.size();
 		_dacStreams.push_back(dacStrm);
@@ -900,6 +1028,8 @@ void VGMPlayer::Cmd_DACCtrl_Setup(void)	// DAC Stream Control: Setup Chip
 	if (destChip == NULL)
 		return;
 	
+	dacStrm->destDev = &destChip->base;
+	DACSTRM_PROFCMD(dacStrm);
 	daccontrol_setup_chip(dacStrm->defInf.dataPtr, &destChip->base.defInf, destChip->chipType, chipCmd);
 	return;
 }
@@ -911,6 +1041,7 @@ void VGMPlayer::Cmd_DACCtrl_SetData(void)	// DAC Stream Control: Set Data Bank
 		return;
 	DACSTRM_DEV* dacStrm = &_dacStreams[dsID];
 	
+	DACSTRM_PROFCMD(dacStrm);
 	dacStrm->bankID = fData[0x02];
 	if (dacStrm->bankID >= _PCM_BANK_COUNT)
 		return;
@@ -931,6 +1062,7 @@ void VGMPlayer::Cmd_DACCtrl_SetFrequency(void)	// DAC Stream Control: Set Freque
 		return;
 	DACSTRM_DEV* dacStrm = &_dacStreams[dsID];
 	
+	DACSTRM_PROFCMD(dacStrm);
 	dacStrm->freq = ReadLE32(&fData[0x02]);
 	daccontrol_set_frequency(dacStrm->defInf.dataPtr, dacStrm->freq);
 	return;
@@ -945,6 +1077,7 @@ void VGMPlayer::Cmd_DACCtrl_PlayData_Loc(void)	// DAC Stream Control: Play Data
 	
 	UINT32 startOfs = ReadLE32(&fData[0x02]);
 	UINT32 soundLen = ReadLE32(&fData[0x07]);
+	DACSTRM_PROFCMD(dacStrm);
 	dacStrm->lastItem = (UINT32)-1;
 	dacStrm->pbMode = fData[0x06];
 	daccontrol_start(dacStrm->defInf.dataPtr, startOfs, dacStrm->pbMode, soundLen);
@@ -958,6 +1091,7 @@ void VGMPlayer::Cmd_DACCtrl_Stop(void)	// DAC Stream Control: Stop immediately
 		for (size_t curStrm = 0; curStrm < _dacStreams.size(); curStrm++)
 		{
 			DACSTRM_DEV* dacStrm = &_dacStreams[curStrm];
+			DACSTRM_PROFCMD(dacStrm);
 			dacStrm->lastItem = (UINT32)-1;
 			daccontrol_stop(dacStrm->defInf.dataPtr);
 		}
@@ -969,6 +1103,7 @@ void VGMPlayer::Cmd_DACCtrl_Stop(void)	// DAC Stream Control: Stop immediately
 		return;
 	DACSTRM_DEV* dacStrm = &_dacStreams[dsID];
 	
+	DACSTRM_PROFCMD(dacStrm);
 	dacStrm->lastItem = (UINT32)-1;
 	daccontrol_stop(dacStrm->defInf.dataPtr);
 	return;
@@ -985,6 +1120,7 @@ void VGMPlayer::Cmd_DACCtrl_PlayData_Blk(void)	// DAC Stream Control: Play Data
 	PCM_BANK* pcmBnk = &_pcmBank[dacStrm->bankID];
 	
 	UINT16 sndID = ReadLE16(&fData[0x02]);
+	DACSTRM_PROFCMD(dacStrm);
 	dacStrm->lastItem = sndID;
 	dacStrm->maxItems = (UINT32)pcmBnk->bankOfs.size();
 	if (sndID >= pcmBnk->bankOfs.size())
@@ -1005,6 +1141,7 @@ void VGMPlayer::Cmd_GGStereo(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->write8 == NULL)
 		return;
+	DEVPROF_REGWRITE(&cDev->base);
 	
 	cDev->write8(cDev->base.defInf.dataPtr, SN76496_W_GGST, fData[0x01]);
 	return;
@@ -1017,6 +1154,7 @@ void VGMPlayer::Cmd_SN76489(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->write8 == NULL)
 		return;
+	DEVPROF_REGWRITE(&cDev->base);
 	
 	cDev->write8(cDev->base.defInf.dataPtr, SN76496_W_REG, fData[0x01]);
 	return;
@@ -1029,6 +1167,7 @@ void VGMPlayer::Cmd_Reg8_Data8(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->write8 == NULL)
 		return;
+	DEVPROF_REGWRITE(&cDev->base);
 	
 	SendYMCommand(cDev, 0, fData[0x01], fData[0x02]);
 	return;
@@ -1041,6 +1180,7 @@ void VGMPlayer::Cmd_CPort_Reg8_Data8(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->write8 == NULL)
 		return;
+	DEVPROF_REGWRITE(&cDev->base);
 	
 	SendYMCommand(cDev, fData[0x00] & 0x01, fData[0x01], fData[0x02]);
 	return;
@@ -1053,6 +1193,7 @@ void VGMPlayer::Cmd_Port_Reg8_Data8(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->write8 == NULL)
 		return;
+	DEVPROF_REGWRITE(&cDev->base);
 	
 	SendYMCommand(cDev, fData[0x01] & 0x7F, fData[0x02], fData[0x03]);
 	return;
@@ -1065,6 +1206,7 @@ void VGMPlayer::Cmd_Ofs8_Data8(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->write8 == NULL)
 		return;
+	DEVPROF_REGWRITE(&cDev->base);
 	
 	cDev->write8(cDev->base.defInf.dataPtr, fData[0x01] & 0x7F, fData[0x02]);
 	return;
@@ -1077,6 +1219,7 @@ void VGMPlayer::Cmd_MSM5205_Reg(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->write8 == NULL)
 		return;
+	DEVPROF_REGWRITE(&cDev->base);
 	
 	if ((fData[0x01] & 0x7F) == 0)
 	{
@@ -1095,6 +1238,7 @@ void VGMPlayer::Cmd_Ofs16_Data8(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->writeM8 == NULL)
 		return;
+	DEVPROF_REGWRITE(&cDev->base);
 	
 	UINT16 ofs = ReadBE16(&fData[0x01]) & 0x7FFF;
 	cDev->writeM8(cDev->base.defInf.dataPtr, ofs, fData[0x03]);
@@ -1108,6 +1252,7 @@ void VGMPlayer::Cmd_Ofs8_Data16(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->writeD16 == NULL)
 		return;
+	DEVPROF_REGWRITE(&cDev->base);
 	
 	UINT16 value = ReadLE16(&fData[0x02]);
 	cDev->writeD16(cDev->base.defInf.dataPtr, fData[0x01] & 0x7F, value);
@@ -1121,6 +1266,7 @@ void VGMPlayer::Cmd_Ofs16_Data16(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->writeM16 == NULL)
 		return;
+	DEVPROF_REGWRITE(&cDev->base);
 	
 	UINT16 ofs = ReadBE16(&fData[0x01]) & 0x7FFF;
 	UINT16 value = ReadBE16(&fData[0x03]);
@@ -1135,6 +1281,7 @@ void VGMPlayer::Cmd_Port_Ofs8_Data8(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->write8 == NULL)
 		return;
+	DEVPROF_REGWRITE(&cDev->base);
 	
 	cDev->write8(cDev->base.defInf.dataPtr, fData[0x02], fData[0x03]);
 	return;
@@ -1147,6 +1294,7 @@ void VGMPlayer::Cmd_DReg8_Data8(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->write8 == NULL)
 		return;
+	DEVPROF_REGWRITE(&cDev->base);
 	
 	SendYMCommand(cDev, 0, fData[0x01] & 0x7F, fData[0x02]);
 	return;
@@ -1159,6 +1307,7 @@ void VGMPlayer::Cmd_SegaPCM_Mem(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->writeM8 == NULL)
 		return;
+	DEVPROF_REGWRITE(&cDev->base);
 	
 	UINT16 memOfs = ReadLE16(&fData[0x01]) & 0x7FFF;
 	cDev->writeM8(cDev->base.defInf.dataPtr, memOfs, fData[0x03]);
@@ -1172,6 +1321,7 @@ void VGMPlayer::Cmd_RF5C_Mem(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->writeM8 == NULL)
 		return;
+	DEVPROF_REGWRITE(&cDev->base);
 	
 	UINT16 memOfs = ReadLE16(&fData[0x01]);
 	if (memOfs & 0xF000)
@@ -1187,6 +1337,7 @@ void VGMPlayer::Cmd_RF5C_Reg(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->write8 == NULL)
 		return;
+	DEVPROF_REGWRITE(&cDev->base);
 	
 	UINT8 ofs = fData[0x01] & 0x7F;
 	cDev->write8(cDev->base.defInf.dataPtr, ofs, fData[0x02]);
@@ -1208,6 +1359,7 @@ void VGMPlayer::Cmd_PWM_Reg(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->writeD16 == NULL)
 		return;
+	DEVPROF_REGWRITE(&cDev->base);
 	
 	UINT8 ofs = (fData[0x01] >> 4) & 0x0F;
 	UINT16 value = ReadBE16(&fData[0x01]) & 0x0FFF;
@@ -1222,6 +1374,7 @@ void VGMPlayer::Cmd_K005289_Reg(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->writeD16 == NULL)
 		return;
+	DEVPROF_REGWRITE(&cDev->base);
 	
 	UINT8 ofs = (fData[0x01] >> 4) & 0x07;
 	UINT16 value = ReadBE16(&fData[0x01]) & 0x0FFF;
@@ -1237,6 +1390,7 @@ void VGMPlayer::Cmd_QSound_Reg(void)
 	QSOUND_WORK* qsWork = &_qsWork[chipID];
 	if (cDev == NULL || qsWork->write == NULL)
 		return;
+	DEVPROF_REGWRITE(&cDev->base);
 	
 	if (cDev->flags & 0x01)	// enable hacks for proper playback of old VGMs with a good QSound core
 	{
@@ -1294,6 +1448,7 @@ void VGMPlayer::Cmd_WSwan_Reg(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->write8 == NULL)
 		return;
+	DEVPROF_REGWRITE(&cDev->base);
 	
 	cDev->write8(cDev->base.defInf.dataPtr, 0x80 + (fData[0x01] & 0x7F), fData[0x02]);
 	return;
@@ -1306,6 +1461,7 @@ void VGMPlayer::Cmd_NES_Reg(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->write8 == NULL)
 		return;
+	DEVPROF_REGWRITE(&cDev->base);
 	
 	UINT8 ofs = fData[0x01] & 0x7F;
 	
@@ -1326,6 +1482,7 @@ void VGMPlayer::Cmd_YMW_Bank(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->write8 == NULL)
 		return;
+	DEVPROF_REGWRITE(&cDev->base);
 	
 	UINT8 bankmask = fData[0x01] & 0x03;
 	// fData[0x03] is ignored as we don't support YMW258 ROMs > 16 MB
@@ -1353,6 +1510,7 @@ void VGMPlayer::Cmd_SAA_Reg(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->write8 == NULL)
 		return;
+	DEVPROF_REGWRITE(&cDev->base);
 	
 	cDev->write8(cDev->base.defInf.dataPtr, 0x01, fData[0x01] & 0x7F);	// SAA commands are at offset 1, not 0
 	cDev->write8(cDev->base.defInf.dataPtr, 0x00, fData[0x02]);
@@ -1366,6 +1524,7 @@ void VGMPlayer::Cmd_OKIM6295_Reg(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->write8 == NULL)
 		return;
+	DEVPROF_REGWRITE(&cDev->base);
 	
 	UINT8 ofs = fData[0x01] & 0x7F;
 	UINT8 data = fData[0x02];
@@ -1390,7 +1549,8 @@ void VGMPlayer::Cmd_K007232_Reg(void)
 	CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
 	if (cDev == NULL || cDev->write8 == NULL)
 		return;
-
+	DEVPROF_REGWRITE(&cDev->base);
+	
 	UINT8 ofs = fData[0x01] & 0x7F;
 	if (ofs == 0x1F)	// offset 0x1F: execute chip read
 		cDev->read8(cDev->base.defInf.dataPtr, fData[0x02]);	// the data value is the offset
@@ -1416,6 +1576,7 @@ void VGMPlayer::Cmd_AY_Stereo(void)
 		clDev = cDev->base.linkDev;
 	if (clDev == NULL)
 		return;
+	DEVPROF_REGWRITE(clDev);
 	
 	retVal = SndEmu_GetDeviceFunc(clDev->defInf.devDef, RWF_REGISTER | RWF_WRITE, DEVRW_ALL, 0x5354, (void**)&writeStMask);
 	if (writeStMask != NULL)
@@ -1430,7 +1591,309 @@ void VGMPlayer::Cmd_BSMT2000_Reg(void)
     CHIP_DEVICE* cDev = GetDevicePtr(chipType, chipID);
     if (cDev == NULL || cDev->write8 == NULL)
         return;
+    DEVPROF_REGWRITE(&cDev->base);
 
     WriteQSound_B(cDev, fData[0x01] & 0x7f, ReadBE16(&fData[0x02]));
     return;
-}
\ No newline at end of file
+}
+
+void VGMPlayer::CompileCommands(void)
+{
+	// Decode the whole command stream once, so that ParseCmdEvents() can process simple register writes
+	// without decoding the command and looking up the device again.
+	// Delays are turned into absolute ticks. Commands that depend on the player state (data blocks,
+	// DAC streams, end of data, ...) are still processed by their command handlers.
+	UINT32 filePos;
+	UINT32 fileTick;
+	UINT32 cmdLen;
+	size_t evtCount;
+	
+	_cmdEvents.clear();
+	_cmdEvtPos = 0;
+	_cmdEvtTickBase = 0;
+	if (! _playOpts.compileCmds || _playOpts.progressiveLoad)
+		return;
+	
+	// count the commands first, so that the list is allocated only once
+	evtCount = 0;
+	filePos = _fileHdr.dataOfs;
+	while(filePos < _fileHdr.dataEnd)
+	{
+		cmdLen = GetCompiledCmdLen(filePos);
+		if (cmdLen == (UINT32)-1)
+			break;
+		evtCount ++;
+		if (cmdLen == 0)
+			break;
+		filePos += cmdLen;
+	}
+	_cmdEvents.reserve(evtCount + 1);
+	
+	filePos = _fileHdr.dataOfs;
+	fileTick = 0;
+	while(filePos < _fileHdr.dataEnd)
+	{
+		const UINT8* cData = &_fileData[filePos];
+		COMMAND_FUNC func = _CMD_INFO[cData[0x00]].func;
+		UINT8 chipType = _CMD_INFO[cData[0x00]].chipType;
+		UINT8 chipID = 0;
+		CMD_EVENT evt;
+		
+		cmdLen = GetCompiledCmdLen(filePos);
+		if (cmdLen == (UINT32)-1)
+			break;
+		
+		evt.tick = fileTick;
+		evt.filePos = filePos;
+		evt.type = CEVT_CMD;
+		evt.cmd = cData[0x00];
+		evt.devID = 0;
+		evt.ofs = 0x00;
+		evt.data = 0x00;
+		if (func == &VGMPlayer::Cmd_DelaySamples2B)
+		{
+			evt.type = CEVT_NONE;
+			fileTick += ReadLE16(&cData[0x01]);
+		}
+		else if (func == &VGMPlayer::Cmd_Delay60Hz)
+		{
+			evt.type = CEVT_NONE;
+			fileTick += 735;
+		}
+		else if (func == &VGMPlayer::Cmd_Delay50Hz)
+		{
+			evt.type = CEVT_NONE;
+			fileTick += 882;
+		}
+		else if (func == &VGMPlayer::Cmd_DelaySamplesN1)
+		{
+			evt.type = CEVT_NONE;
+			fileTick += 1 + (cData[0x00] & 0x0F);
+		}
+		else if (func == &VGMPlayer::Cmd_YM2612PCM_Delay)
+		{
+			evt.type = CEVT_YM2612PCM;
+			fileTick += (cData[0x00] & 0x0F);
+		}
+		else if (func == &VGMPlayer::Cmd_SN76489 || func == &VGMPlayer::Cmd_GGStereo)
+		{
+			evt.type = CEVT_W8;
+			chipID = (cData[0x00] == 0x30 || cData[0x00] == 0x3F) ? 1 : 0;
+			evt.ofs = (func == &VGMPlayer::Cmd_GGStereo) ? SN76496_W_GGST : SN76496_W_REG;
+			evt.data = cData[0x01];
+		}
+		else if (func == &VGMPlayer::Cmd_Reg8_Data8 || func == &VGMPlayer::Cmd_CPort_Reg8_Data8)
+		{
+			evt.type = CEVT_YM;
+			chipID = (cData[0x00] >= 0xA0) ? 1 : 0;
+			evt.ofs = (func == &VGMPlayer::Cmd_CPort_Reg8_Data8) ? (cData[0x00] & 0x01) : 0;
+			evt.data = (cData[0x01] << 8) | cData[0x02];
+		}
+		else if (func == &VGMPlayer::Cmd_Port_Reg8_Data8)
+		{
+			evt.type = CEVT_YM;
+			chipID = (cData[0x01] & 0x80) >> 7;
+			evt.ofs = cData[0x01] & 0x7F;
+			evt.data = (cData[0x02] << 8) | cData[0x03];
+		}
+		else if (func == &VGMPlayer::Cmd_DReg8_Data8)
+		{
+			evt.type = CEVT_YM;
+			chipID = (cData[0x01] & 0x80) >> 7;
+			evt.ofs = 0;
+			evt.data = ((cData[0x01] & 0x7F) << 8) | cData[0x02];
+		}
+		else if (func == &VGMPlayer::Cmd_Ofs8_Data8)
+		{
+			evt.type = CEVT_W8;
+			chipID = (cData[0x01] & 0x80) >> 7;
+			evt.ofs = cData[0x01] & 0x7F;
+			evt.data = cData[0x02];
+		}
+		else if (func == &VGMPlayer::Cmd_Port_Ofs8_Data8)
+		{
+			evt.type = CEVT_W8;
+			chipID = (cData[0x01] & 0x80) >> 7;
+			evt.ofs = cData[0x02];
+			evt.data = cData[0x03];
+		}
+		else if (func == &VGMPlayer::Cmd_Ofs16_Data8)
+		{
+			evt.type = CEVT_M8;
+			chipID = (cData[0x01] & 0x80) >> 7;
+			evt.ofs = ReadBE16(&cData[0x01]) & 0x7FFF;
+			evt.data = cData[0x03];
+		}
+		else if (func == &VGMPlayer::Cmd_Ofs8_Data16)
+		{
+			evt.type = CEVT_D16;
+			chipID = (cData[0x01] & 0x80) >> 7;
+			evt.ofs = cData[0x01] & 0x7F;
+			evt.data = ReadLE16(&cData[0x02]);
+		}
+		else if (func == &VGMPlayer::Cmd_Ofs16_Data16)
+		{
+			evt.type = CEVT_M16;
+			chipID = (cData[0x01] & 0x80) >> 7;
+			evt.ofs = ReadBE16(&cData[0x01]) & 0x7FFF;
+			evt.data = ReadBE16(&cData[0x03]);
+		}
+		
+		if (evt.type >= CEVT_W8)
+		{
+			// resolve the device now (the device list doesn't change while playing)
+			CHIP_DEVICE* cDev = (evt.type == CEVT_YM2612PCM) ? GetDevicePtr(0x02, 0) : GetDevicePtr(chipType, chipID);
+			if (cDev == NULL)
+				evt.type = CEVT_NONE;
+			else
+				evt.devID = (UINT16)(cDev - &_devices[0]);
+		}
+		_cmdEvents.push_back(evt);
+		
+		if (cmdLen == 0)
+			break;	// end of data or invalid command - the handler decides how to continue
+		filePos += cmdLen;
+	}
+	
+	// The terminating event marks the position where compiling stopped.
+	// Parsing continues with the command handlers from there.
+	{
+		CMD_EVENT evt;
+		evt.tick = fileTick;
+		evt.filePos = filePos;
+		evt.type = CEVT_END;
+		evt.cmd = 0x00;
+		evt.devID = 0;
+		evt.ofs = 0x00;
+		evt.data = 0x00;
+		_cmdEvents.push_back(evt);
+	}
+	
+	return;
+}
+
+UINT32 VGMPlayer::GetCompiledCmdLen(UINT32 filePos) const
+{
+	// returns the length of the command at filePos (including data block data) or (UINT32)-1 if it isn't fully loaded
+	UINT32 cmdLen;
+	
+	if (filePos >= _fileLoaded)
+		return (UINT32)-1;
+	cmdLen = _CMD_INFO[_fileData[filePos]].cmdLen;
+	if (_fileData[filePos] == 0x67)
+	{
+		if (filePos + 0x07 > _fileLoaded)
+			return (UINT32)-1;
+		cmdLen = 0x07 + (ReadLE32(&_fileData[filePos + 0x03]) & 0x7FFFFFFF);
+	}
+	if (filePos + cmdLen > _fileLoaded)
+		return (UINT32)-1;
+	return cmdLen;
+}
+
+UINT8 VGMPlayer::SyncCmdEvents(void)
+{
+	// find the event for the current file position, returns 0 if there is none
+	size_t evtLow;
+	size_t evtHigh;
+	
+	if (_cmdEvtPos >= _cmdEvents.size() || _cmdEvents[_cmdEvtPos].filePos != _filePos)
+	{
+		// binary search (the events are sorted by file offset)
+		evtLow = 0;
+		evtHigh = _cmdEvents.size();
+		while(evtLow < evtHigh)
+		{
+			size_t evtMid = (evtLow + evtHigh) / 2;
+			if (_cmdEvents[evtMid].filePos < _filePos)
+				evtLow = evtMid + 1;
+			else
+				evtHigh = evtMid;
+		}
+		if (evtLow >= _cmdEvents.size() || _cmdEvents[evtLow].filePos != _filePos)
+			return 0x00;
+		_cmdEvtPos = evtLow;
+	}
+	_cmdEvtTickBase = _fileTick - _cmdEvents[_cmdEvtPos].tick;
+	
+	return 0x01;
+}
+
+void VGMPlayer::ParseCmdEvents(void)
+{
+	// equivalent to the command loop in ParseFile(), but processes the compiled command list
+	if (! SyncCmdEvents())
+		return;
+	
+	while(_fileTick <= _playTick && ! (_playState & PLAYSTATE_END))
+	{
+		const CMD_EVENT* evt = &_cmdEvents[_cmdEvtPos];
+		CHIP_DEVICE* cDev;
+		
+		if (evt->type == CEVT_END)
+			break;
+		if (evt->cmd != 0x67 && ! _romImages.empty())
+			LinkROMImages();	// a sequence of data blocks ended
+		switch(evt->type)
+		{
+		case CEVT_NONE:
+			break;
+		case CEVT_W8:
+			cDev = &_devices[evt->devID];
+			DEVPROF_REGWRITE(&cDev->base);
+			if (cDev->write8 != NULL)
+				cDev->write8(cDev->base.defInf.dataPtr, (UINT8)evt->ofs, (UINT8)evt->data);
+			break;
+		case CEVT_YM:
+			cDev = &_devices[evt->devID];
+			DEVPROF_REGWRITE(&cDev->base);
+			if (cDev->write8 != NULL)
+				SendYMCommand(cDev, (UINT8)evt->ofs, evt->data >> 8, evt->data & 0xFF);
+			break;
+		case CEVT_M8:
+			cDev = &_devices[evt->devID];
+			DEVPROF_REGWRITE(&cDev->base);
+			if (cDev->writeM8 != NULL)
+				cDev->writeM8(cDev->base.defInf.dataPtr, evt->ofs, (UINT8)evt->data);
+			break;
+		case CEVT_D16:
+			cDev = &_devices[evt->devID];
+			DEVPROF_REGWRITE(&cDev->base);
+			if (cDev->writeD16 != NULL)
+				cDev->writeD16(cDev->base.defInf.dataPtr, (UINT8)evt->ofs, evt->data);
+			break;
+		case CEVT_M16:
+			cDev = &_devices[evt->devID];
+			DEVPROF_REGWRITE(&cDev->base);
+			if (cDev->writeM16 != NULL)
+				cDev->writeM16(cDev->base.defInf.dataPtr, evt->ofs, evt->data);
+			break;
+		case CEVT_YM2612PCM:
+			cDev = &_devices[evt->devID];
+			DEVPROF_REGWRITE(&cDev->base);
+			if (cDev->write8 != NULL && _ym2612pcm_bnkPos < _pcmBank[0].data.size())
+			{
+				SendYMCommand(cDev, 0x00, 0x2A, _pcmBank[0].data[_ym2612pcm_bnkPos]);
+				_ym2612pcm_bnkPos ++;
+			}
+			break;
+		case CEVT_CMD:
+			_filePos = evt->filePos;
+			(this->*_CMD_INFO[evt->cmd].func)();
+			_filePos += _CMD_INFO[evt->cmd].cmdLen;
+			if (_filePos != evt[1].filePos)
+			{
+				// The handler jumped to another position (loop), so the event has to be searched.
+				if (! SyncCmdEvents())
+					return;
+				continue;
+			}
+			break;
+		}
+		_cmdEvtPos ++;
+		_fileTick = _cmdEvtTickBase + _cmdEvents[_cmdEvtPos].tick;
+	}
+	_filePos = _cmdEvents[_cmdEvtPos].filePos;
+	
+	return;
+}
@@ -0,0 +1,244 @@
+// Resampler Benchmark
+// -------------------
+// Compares quality and speed of all resampling modes, using a synthetic sine wave generator
+// as sound device.
+//	SNR 1k: signal-to-noise ratio of a 1 kHz sine wave
+//	SNR hi: signal-to-noise ratio of a sine wave at 40% of the lower sample rate
+//	alias: level of a sine wave above the output Nyquist frequency (downsampling only)
+//	speed: output samples per second (in millions)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "stdtype.h"
+#include "emu/EmuStructs.h"
+#include "emu/Resampler.h"
+
+typedef struct _tone_generator
+{
+	DEV_SMPL* data;	// precalculated sine wave, so that the generator itself is very fast
+	UINT32 length;
+	UINT32 pos;
+} TONE_GEN;
+
+static void ToneGen_Update(void* info, UINT32 samples, DEV_SMPL** outputs);
+static void ToneGen_Init(TONE_GEN* tg, UINT32 srcRate, double freq, UINT32 length);
+static void Resampler_Start(RESMPL_STATE* rs, TONE_GEN* tg, UINT8 mode, UINT32 srcRate, UINT32 dstRate);
+static double MeasureSNR(UINT8 mode, UINT32 srcRate, UINT32 dstRate, double freq);
+static double MeasureAlias(UINT8 mode, UINT32 srcRate, UINT32 dstRate, double freq);
+static double MeasureSpeed(UINT8 mode, UINT32 srcRate, UINT32 dstRate);
+
+static const double PI = 3.14159265358979323846;
+#define TONE_AMP		8192.0
+#define SKIP_SMPLS		4096	// skip the filter's warm-up
+#define MEASURE_SMPLS	48000
+#define SPEED_RUNS		3		// the fastest run is used
+
+static DEV_DEF devDef_ToneGen;
+
+int main(int argc, char* argv[])
+{
+	static const UINT32 SRC_RATES[] = {22050, 32000, 44100, 53267, 96000, 223721};
+	static const UINT8 MODES[] = {RSMODE_NEAREST, RSMODE_LUP_NDWN, RSMODE_LINEAR, RSMODE_SINC};
+	static const char* MODE_NAMES[] = {"nearest", "LUP/NDWN", "linear", "sinc"};
+	UINT32 dstRate = 48000;
+	size_t curRate;
+	size_t curMode;
+	
+	if (argc > 1)
+		dstRate = (UINT32)strtoul(argv[1], NULL, 0);
+	if (! dstRate)
+	{
+		printf("Usage: %s [output sample rate]\n", argv[0]);
+		return 1;
+	}
+	
+	memset(&devDef_ToneGen, 0x00, sizeof(DEV_DEF));
+	devDef_ToneGen.name = "Tone Generator";
+	devDef_ToneGen.Update = ToneGen_Update;
+	
+	printf("Output sample rate: %u Hz\n", dstRate);
+	printf("%-8s  %-8s  %8s  %8s  %8s  %10s\n", "src rate", "mode", "SNR 1k", "SNR hi", "alias", "speed");
+	for (curRate = 0; curRate < sizeof(SRC_RATES) / sizeof(SRC_RATES[0]); curRate ++)
+	{
+		UINT32 srcRate = SRC_RATES[curRate];
+		UINT32 lowRate = (srcRate < dstRate) ? srcRate : dstRate;
+		
+		for (curMode = 0; curMode < sizeof(MODES) / sizeof(MODES[0]); curMode ++)
+		{
+			UINT8 mode = MODES[curMode];
+			char aliasStr[0x10];
+			
+			if (srcRate > dstRate * 1.2)
+				sprintf(aliasStr, "%6.1f dB", MeasureAlias(mode, srcRate, dstRate, dstRate * 0.6));
+			else
+				strcpy(aliasStr, "-");
+			printf("%8u  %-8s  %5.1f dB  %5.1f dB  %8s  %6.2f M/s\n", srcRate, MODE_NAMES[curMode],
+				MeasureSNR(mode, srcRate, dstRate, 1000.0),
+				MeasureSNR(mode, srcRate, dstRate, lowRate * 0.4), aliasStr,
+				MeasureSpeed(mode, srcRate, dstRate) / 1000000.0);
+		}
+	}
+	
+	return 0;
+}
+
+static void ToneGen_Update(void* info, UINT32 samples, DEV_SMPL** outputs)
+{
+	TONE_GEN* tg = (TONE_GEN*)info;
+	UINT32 curSmpl;
+	
+	for (curSmpl = 0; curSmpl < samples; curSmpl ++)
+	{
+		outputs[0][curSmpl] = tg->data[tg->pos];
+		outputs[1][curSmpl] = tg->data[tg->pos];
+		tg->pos ++;
+		if (tg->pos >= tg->length)
+			tg->pos = 0;
+	}
+	
+	return;
+}
+
+static void ToneGen_Init(TONE_GEN* tg, UINT32 srcRate, double freq, UINT32 length)
+{
+	double step = 2.0 * PI * freq / srcRate;
+	UINT32 curSmpl;
+	
+	tg->length = length;
+	tg->pos = 0;
+	tg->data = (DEV_SMPL*)malloc(length * sizeof(DEV_SMPL));
+	for (curSmpl = 0; curSmpl < length; curSmpl ++)
+		tg->data[curSmpl] = (DEV_SMPL)floor(sin(step * curSmpl) * TONE_AMP + 0.5);
+	
+	return;
+}
+
+static void Resampler_Start(RESMPL_STATE* rs, TONE_GEN* tg, UINT8 mode, UINT32 srcRate, UINT32 dstRate)
+{
+	DEV_INFO devInf;
+	
+	memset(&devInf, 0x00, sizeof(DEV_INFO));
+	devInf.dataPtr = (DEV_DATA*)tg;
+	devInf.sampleRate = srcRate;
+	devInf.devDef = &devDef_ToneGen;
+	memset(rs, 0x00, sizeof(RESMPL_STATE));
+	Resmpl_DevConnect(rs, &devInf);
+	Resmpl_SetVals(rs, mode, 0x100, dstRate);
+	Resmpl_Init(rs);
+	
+	return;
+}
+
+static WAVE_32BS* RenderTone(UINT8 mode, UINT32 srcRate, UINT32 dstRate, double freq)
+{
+	RESMPL_STATE rs;
+	TONE_GEN tg;
+	WAVE_32BS* smplData;
+	
+	smplData = (WAVE_32BS*)calloc(SKIP_SMPLS + MEASURE_SMPLS, sizeof(WAVE_32BS));
+	ToneGen_Init(&tg, srcRate, freq, (UINT32)((UINT64)(SKIP_SMPLS + MEASURE_SMPLS) * srcRate / dstRate) + 1);
+	Resampler_Start(&rs, &tg, mode, srcRate, dstRate);
+	Resmpl_Execute(&rs, SKIP_SMPLS + MEASURE_SMPLS, smplData);
+	Resmpl_Deinit(&rs);
+	free(tg.data);
+	
+	return smplData;
+}
+
+static double MeasureSNR(UINT8 mode, UINT32 srcRate, UINT32 dstRate, double freq)
+{
+	// least-squares fit of sin/cos at the tone frequency, everything else is counted as noise
+	WAVE_32BS* smplData;
+	double w = 2.0 * PI * freq / dstRate;
+	double ss = 0.0, sc = 0.0, cc = 0.0, ys = 0.0, yc = 0.0;
+	double det, a, b;
+	double sigPow = 0.0, noisePow = 0.0;
+	UINT32 curSmpl;
+	
+	smplData = RenderTone(mode, srcRate, dstRate, freq);
+	for (curSmpl = 0; curSmpl < MEASURE_SMPLS; curSmpl ++)
+	{
+		double s = sin(w * curSmpl);
+		double c = cos(w * curSmpl);
+		double y = smplData[SKIP_SMPLS + curSmpl].L;
+		ss += s * s;	sc += s * c;	cc += c * c;
+		ys += y * s;	yc += y * c;
+	}
+	det = ss * cc - sc * sc;
+	a = (ys * cc - yc * sc) / det;
+	b = (yc * ss - ys * sc) / det;
+	for (curSmpl = 0; curSmpl < MEASURE_SMPLS; curSmpl ++)
+	{
+		double fit = a * sin(w * curSmpl) + b * cos(w * curSmpl);
+		double err = smplData[SKIP_SMPLS + curSmpl].L - fit;
+		sigPow += fit * fit;
+		noisePow += err * err;
+	}
+	free(smplData);
+	
+	if (noisePow <= 0.0)
+		return 999.9;
+	return 10.0 * log10(sigPow / noisePow);
+}
+
+static double MeasureAlias(UINT8 mode, UINT32 srcRate, UINT32 dstRate, double freq)
+{
+	// output level of a tone that can't be represented at the output sample rate
+	WAVE_32BS* smplData;
+	double outPow = 0.0;
+	double inPow;
+	UINT32 curSmpl;
+	
+	smplData = RenderTone(mode, srcRate, dstRate, freq);
+	for (curSmpl = 0; curSmpl < MEASURE_SMPLS; curSmpl ++)
+	{
+		double y = smplData[SKIP_SMPLS + curSmpl].L / 256.0;	// remove volume factor
+		outPow += y * y;
+	}
+	free(smplData);
+	
+	inPow = TONE_AMP * TONE_AMP / 2.0 * MEASURE_SMPLS;
+	if (outPow <= 0.0)
+		return -999.9;
+	return 10.0 * log10(outPow / inPow);
+}
+
+static double MeasureSpeed(UINT8 mode, UINT32 srcRate, UINT32 dstRate)
+{
+	const UINT32 BLOCK_SIZE = 512;
+	RESMPL_STATE rs;
+	TONE_GEN tg;
+	WAVE_32BS* smplData;
+	UINT32 renderSmpls;
+	UINT32 curSmpl;
+	UINT32 curRun;
+	clock_t startTime;
+	clock_t runTime;
+	clock_t bestTime;
+	
+	smplData = (WAVE_32BS*)calloc(BLOCK_SIZE, sizeof(WAVE_32BS));
+	ToneGen_Init(&tg, srcRate, 1000.0, srcRate);	// 1 second of 1 kHz is a whole number of periods
+	renderSmpls = dstRate * 10;
+	bestTime = 0;
+	for (curRun = 0; curRun < SPEED_RUNS; curRun ++)
+	{
+		tg.pos = 0;
+		Resampler_Start(&rs, &tg, mode, srcRate, dstRate);
+		startTime = clock();
+		for (curSmpl = 0; curSmpl < renderSmpls; curSmpl += BLOCK_SIZE)
+			Resmpl_Execute(&rs, BLOCK_SIZE, smplData);
+		runTime = clock() - startTime;
+		Resmpl_Deinit(&rs);
+		if (! curRun || runTime < bestTime)
+			bestTime = runTime;
+	}
+	free(smplData);
+	free(tg.data);
+	
+	if (bestTime <= 0)
+		bestTime = 1;
+	return (double)renderSmpls * CLOCKS_PER_SEC / bestTime;
+}
@@ -0,0 +1,223 @@
+// Resampler Kernel Test
+// ---------------------
+// Runs all kernel sets that are supported by the CPU with random input and compares
+// their results with the plain C kernels. The results must be exactly the same.
+// The lengths and buffer offsets are random as well, so that all unaligned cases and
+// the remainder loops of the SIMD kernels are used.
+// The program returns 0 when all kernels match.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "stdtype.h"
+#include "emu/snddef.h"
+#include "emu/Resampler.h"
+#include "emu/ResmplKernels.h"
+
+#define TEST_RUNS	2000	// number of random tests per kernel
+#define MAX_LEN		300		// maximum number of output samples per test
+#define BUF_LEN		(MAX_LEN * 8 + 16)
+#define MAX_TAPS	128
+
+static UINT32 rngState = 1;
+
+static UINT32 NextRandom(UINT32 range);
+static INT32 RandomSample(void);
+static INT32 RandomVolume(void);
+static void FillBuffers(void);
+static UINT32 TestCopy(const RSMPL_KERNELS* kern, const RSMPL_KERNELS* kernC);
+static UINT32 TestLinear(const RSMPL_KERNELS* kern, const RSMPL_KERNELS* kernC);
+static UINT32 TestSum(const RSMPL_KERNELS* kern, const RSMPL_KERNELS* kernC);
+static UINT32 TestFIR(const RSMPL_KERNELS* kern, const RSMPL_KERNELS* kernC);
+
+static DEV_SMPL bufL[BUF_LEN];
+static DEV_SMPL bufR[BUF_LEN];
+static WAVE_32BS dstC[MAX_LEN + 8];
+static WAVE_32BS dstK[MAX_LEN + 8];
+static UINT32 posList[MAX_LEN];
+static float coefA[MAX_TAPS + 8];
+static float coefB[MAX_TAPS + 8];
+static float fbufL[MAX_TAPS + 8];
+static float fbufR[MAX_TAPS + 8];
+
+int main(int argc, char* argv[])
+{
+	static const UINT8 KERN_TYPES[] = {RSMPLK_TYPE_SSE2, RSMPLK_TYPE_AVX2, RSMPLK_TYPE_NEON};
+	static const char* KERN_NAMES[] = {"SSE2", "AVX2", "NEON"};
+	const RSMPL_KERNELS* kernC = ResmplKern_Get(RSMPLK_TYPE_C);
+	unsigned int failCnt = 0;
+	size_t curKern;
+
+	for (curKern = 0; curKern < sizeof(KERN_TYPES) / sizeof(KERN_TYPES[0]); curKern ++)
+	{
+		const RSMPL_KERNELS* kern = ResmplKern_Get(KERN_TYPES[curKern]);
+		UINT32 errCopy, errLinear, errSum, errFIR;
+
+		if (kern == NULL)
+		{
+			printf("%s: not supported\n", KERN_NAMES[curKern]);
+			continue;
+		}
+		rngState = 1;
+		errCopy = TestCopy(kern, kernC);
+		errLinear = TestLinear(kern, kernC);
+		errSum = TestSum(kern, kernC);
+		errFIR = TestFIR(kern, kernC);
+		if (errCopy || errLinear || errSum || errFIR)
+		{
+			printf("%s: FAILED (mismatches: copy %u, linear %u, sum %u, FIR %u)\n", KERN_NAMES[curKern],
+				errCopy, errLinear, errSum, errFIR);
+			failCnt ++;
+		}
+		else
+		{
+			printf("%s: OK\n", KERN_NAMES[curKern]);
+		}
+	}
+
+	if (failCnt)
+		printf("%u kernel set(s) failed.\n", failCnt);
+	else
+		printf("All tests passed.\n");
+	return failCnt ? 1 : 0;
+}
+
+static UINT32 NextRandom(UINT32 range)
+{
+	rngState = rngState * 1103515245 + 12345;
+	return (rngState >> 8) % range;
+}
+
+static INT32 RandomSample(void)
+{
+	// mostly values in the range of sound chips, sometimes full-scale values
+	if (NextRandom(16) == 0)
+		return (INT32)NextRandom(0x200000) - 0x100000;
+	return (INT32)NextRandom(0x20000) - 0x10000;
+}
+
+static INT32 RandomVolume(void)
+{
+	// includes negative (inverted) volumes
+	return (INT32)NextRandom(0x800) - 0x200;
+}
+
+static void FillBuffers(void)
+{
+	UINT32 curSmpl;
+
+	for (curSmpl = 0; curSmpl < BUF_LEN; curSmpl ++)
+	{
+		bufL[curSmpl] = RandomSample();
+		bufR[curSmpl] = RandomSample();
+	}
+	for (curSmpl = 0; curSmpl < MAX_LEN + 8; curSmpl ++)
+	{
+		dstC[curSmpl].L = RandomSample();
+		dstC[curSmpl].R = RandomSample();
+	}
+	memcpy(dstK, dstC, sizeof(dstC));
+	return;
+}
+
+static UINT32 TestCopy(const RSMPL_KERNELS* kern, const RSMPL_KERNELS* kernC)
+{
+	UINT32 errCnt = 0;
+	UINT32 curRun;
+
+	for (curRun = 0; curRun < TEST_RUNS; curRun ++)
+	{
+		UINT32 len = NextRandom(MAX_LEN + 1);
+		UINT32 srcOfs = NextRandom(8);
+		UINT32 dstOfs = NextRandom(8);
+		INT32 volL = RandomVolume();
+		INT32 volR = RandomVolume();
+
+		FillBuffers();
+		kernC->copy(&dstC[dstOfs], &bufL[srcOfs], &bufR[srcOfs], len, volL, volR);
+		kern->copy(&dstK[dstOfs], &bufL[srcOfs], &bufR[srcOfs], len, volL, volR);
+		if (memcmp(dstC, dstK, sizeof(dstC)))
+			errCnt ++;
+	}
+	return errCnt;
+}
+
+static UINT32 TestLinear(const RSMPL_KERNELS* kern, const RSMPL_KERNELS* kernC)
+{
+	UINT32 errCnt = 0;
+	UINT32 curRun;
+	UINT32 curSmpl;
+
+	for (curRun = 0; curRun < TEST_RUNS; curRun ++)
+	{
+		UINT32 len = NextRandom(MAX_LEN + 1);
+		UINT32 dstOfs = NextRandom(8);
+		UINT32 maxStep = 1 + NextRandom(6 << RSMPLK_FRAC_BITS);	// up- and downsampling
+		UINT32 pos = NextRandom(8 << RSMPLK_FRAC_BITS);
+		INT32 volL = RandomVolume();
+		INT32 volR = RandomVolume();
+
+		FillBuffers();
+		// increasing positions, like the resampler generates them
+		for (curSmpl = 0; curSmpl < len; curSmpl ++)
+		{
+			posList[curSmpl] = pos;
+			pos += NextRandom(maxStep);
+		}
+		kernC->linear(&dstC[dstOfs], bufL, bufR, posList, len, volL, volR);
+		kern->linear(&dstK[dstOfs], bufL, bufR, posList, len, volL, volR);
+		if (memcmp(dstC, dstK, sizeof(dstC)))
+			errCnt ++;
+	}
+	return errCnt;
+}
+
+static UINT32 TestSum(const RSMPL_KERNELS* kern, const RSMPL_KERNELS* kernC)
+{
+	UINT32 errCnt = 0;
+	UINT32 curRun;
+
+	for (curRun = 0; curRun < TEST_RUNS; curRun ++)
+	{
+		UINT32 len = NextRandom(MAX_LEN + 1);
+		UINT32 srcOfs = NextRandom(8);
+		INT64 sumLC, sumRC;
+		INT64 sumLK, sumRK;
+
+		FillBuffers();
+		kernC->sum(&bufL[srcOfs], &bufR[srcOfs], len, &sumLC, &sumRC);
+		kern->sum(&bufL[srcOfs], &bufR[srcOfs], len, &sumLK, &sumRK);
+		if (sumLC != sumLK || sumRC != sumRK)
+			errCnt ++;
+	}
+	return errCnt;
+}
+
+static UINT32 TestFIR(const RSMPL_KERNELS* kern, const RSMPL_KERNELS* kernC)
+{
+	UINT32 errCnt = 0;
+	UINT32 curRun;
+	UINT32 curTap;
+
+	for (curRun = 0; curRun < TEST_RUNS; curRun ++)
+	{
+		UINT32 taps = 8 * (1 + NextRandom(MAX_TAPS / 8));
+		UINT32 ofs = NextRandom(8);
+		float frac = NextRandom(0x10000) / 65536.0f;
+		float outLC, outRC;
+		float outLK, outRK;
+
+		for (curTap = 0; curTap < MAX_TAPS + 8; curTap ++)
+		{
+			coefA[curTap] = ((INT32)NextRandom(0x10000) - 0x8000) / 32768.0f;
+			coefB[curTap] = ((INT32)NextRandom(0x10000) - 0x8000) / 32768.0f;
+			fbufL[curTap] = (float)RandomSample();
+			fbufR[curTap] = (float)RandomSample();
+		}
+		kernC->fir(&coefA[ofs], &coefB[ofs], frac, &fbufL[ofs], &fbufR[ofs], taps, &outLC, &outRC);
+		kern->fir(&coefA[ofs], &coefB[ofs], frac, &fbufL[ofs], &fbufR[ofs], taps, &outLK, &outRK);
+		if (memcmp(&outLC, &outLK, sizeof(float)) || memcmp(&outRC, &outRK, sizeof(float)))
+			errCnt ++;
+	}
+	return errCnt;
+}
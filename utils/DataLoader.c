@@ -1,3 +1,4 @@
+#include <stdio.h>	/* for SEEK_SET */
 #include <stdlib.h>
 #include <string.h>
 
@@ -11,10 +12,16 @@ UINT8 DataLoader_Reset(DATA_LOADER *loader)
 	DataLoader_CancelLoading(loader);
 
 	if(loader->_data) {
-		free(loader->_data);
+		if(loader->_mapped) {
+			if(loader->_callbacks->dunmap)
+				loader->_callbacks->dunmap(loader->_context);
+		} else {
+			free(loader->_data);
+		}
 		loader->_data = NULL;
 		loader->_bytesLoaded = 0;
 	}
+	loader->_mapped = 0;
 
 	loader->_status = DLSTAT_EMPTY;
 
@@ -61,6 +68,12 @@ UINT8 DataLoader_Load(DATA_LOADER *loader)
 	loader->_bytesLoaded = 0x00;
 	loader->_status = DLSTAT_LOADING;
 	loader->_bytesTotal = loader->_callbacks->dlength(loader->_context);
+	if (loader->_callbacks->dmap != NULL)
+	{
+		/* use the data directly, if the loader can provide it (e.g. memory-mapped files) */
+		loader->_data = loader->_callbacks->dmap(loader->_context);
+		loader->_mapped = (loader->_data != NULL);
+	}
 
 	if (loader->_readStopOfs > 0)
 		DataLoader_Read(loader,loader->_readStopOfs);
@@ -77,7 +90,7 @@ void DataLoader_SetPreloadBytes(DATA_LOADER *loader, UINT32 byteCount)
 void DataLoader_ReadUntil(DATA_LOADER *loader, UINT32 fileOffset)
 {
 	if (fileOffset > loader->_bytesLoaded)
-		DataLoader_Read(loader,fileOffset);
+		DataLoader_Read(loader,fileOffset - loader->_bytesLoaded);
 	return;
 }
 
@@ -88,6 +101,45 @@ void DataLoader_ReadAll(DATA_LOADER *loader)
 	return;
 }
 
+UINT32 DataLoader_ReadAt(DATA_LOADER *loader, UINT32 fileOffset, UINT32 numBytes, UINT8 *buffer)
+{
+	UINT32 availBytes;
+	UINT32 readBytes;
+
+	if (loader->_status == DLSTAT_EMPTY)
+		return 0;
+
+	/* data that is in memory already */
+	availBytes = (loader->_mapped) ? loader->_bytesTotal : loader->_bytesLoaded;
+	if (loader->_status != DLSTAT_LOADING || (fileOffset <= availBytes && numBytes <= availBytes - fileOffset))
+	{
+		if (fileOffset >= availBytes)
+			return 0;
+		if (numBytes > availBytes - fileOffset)
+			numBytes = availBytes - fileOffset;
+		memcpy(buffer, &loader->_data[fileOffset], numBytes);
+		return numBytes;
+	}
+
+	if (fileOffset >= loader->_bytesTotal)
+		return 0;
+	if (numBytes > loader->_bytesTotal - fileOffset)
+		numBytes = loader->_bytesTotal - fileOffset;
+	if (loader->_callbacks->dseek(loader->_context, fileOffset, SEEK_SET))
+		return 0;
+	readBytes = loader->_callbacks->dread(loader->_context, buffer, numBytes);
+
+	/* go back to where DataLoader_Read stopped */
+	if (loader->_callbacks->dseek(loader->_context, loader->_bytesLoaded, SEEK_SET))
+	{
+		/* reading more data would return garbage now */
+		DataLoader_CancelLoading(loader);
+		loader->_status = DLSTAT_LOADED;
+	}
+
+	return readBytes;
+}
+
 UINT32 DataLoader_Read(DATA_LOADER *loader, UINT32 numBytes)
 {
 	UINT32 endOfs;
@@ -102,6 +154,19 @@ UINT32 DataLoader_Read(DATA_LOADER *loader, UINT32 numBytes)
 	if (endOfs > loader->_bytesTotal)
 		endOfs = loader->_bytesTotal;
 
+	if (loader->_mapped)
+	{
+		/* all data is accessible already */
+		numBytes = endOfs - loader->_bytesLoaded;
+		loader->_bytesLoaded = endOfs;
+		if (loader->_bytesLoaded >= loader->_bytesTotal)
+		{
+			DataLoader_CancelLoading(loader);
+			loader->_status = DLSTAT_LOADED;
+		}
+		return numBytes;
+	}
+
 	loader->_data = (UINT8 *)realloc(loader->_data,endOfs);
 	if(loader->_data == NULL) {
 		return 0;
@@ -139,6 +204,7 @@ void DataLoader_Deinit(DATA_LOADER *dLoader)
 
 void DataLoader_Setup(DATA_LOADER *loader, const DATA_LOADER_CALLBACKS *callbacks, void *context) {
 	loader->_data = NULL;
+	loader->_mapped = 0;
 	loader->_status = DLSTAT_EMPTY;
 	loader->_readStopOfs = (UINT32)-1;
 	loader->_context = context;
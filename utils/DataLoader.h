@@ -13,6 +13,7 @@ typedef UINT32 (*DLOADCB_READ)(void *context, UINT8 *buffer, UINT32 numBytes);
 typedef UINT8 (*DLOADCB_SEEK)(void *context, UINT32 offset, UINT8 whence);
 typedef INT32 (*DLOADCB_TELL)(void *context);
 typedef UINT32 (*DLOADCB_LENGTH)(void *context);
+typedef UINT8 *(*DLOADCB_MAP)(void *context);
 
 typedef struct _data_loader_callbacks
 {
@@ -26,6 +27,9 @@ typedef struct _data_loader_callbacks
 	DLOADCB_LENGTH dlength; /* returns the length of the data, in bytes */
 	DLOADCB_GENERIC deof;   /* determines if we've seen eof or not (return 1 for eof) */
 	DLOADCB_GEN_CALL ddeinit;   /* deinitialize loader and free context, may be NULL */
+	DLOADCB_MAP dmap;       /* returns a pointer to all data (dlength bytes) that is used instead of
+	                           reading into a buffer, may be NULL (called after dopen/dlength) */
+	DLOADCB_GEN_CALL dunmap;    /* releases the data returned by dmap, may be NULL */
 } DATA_LOADER_CALLBACKS;
 
 enum
@@ -38,6 +42,7 @@ enum
 typedef struct _data_loader
 {
 	UINT8 _status;
+	UINT8 _mapped;	/* _data was returned by dmap and isn't owned by the DataLoader */
 	UINT32 _bytesTotal;
 	UINT32 _bytesLoaded;
 	UINT32 _readStopOfs;
@@ -56,7 +61,8 @@ UINT8 DataLoader_Reset(DATA_LOADER *loader);
 
 /* Returns a pointer to the DataLoader's memory buffer
  * call after any invocation of "Read", "ReadUntil", etc,
- * since the memory buffer pointer can change */
+ * since the memory buffer pointer can change
+ * For loaders with a dmap callback, this points directly to the mapped data. */
 UINT8 *DataLoader_GetData(DATA_LOADER *loader);
 
 /* returns _bytesTotal */
@@ -84,6 +90,12 @@ void DataLoader_ReadUntil(DATA_LOADER *loader, UINT32 fileOffset);
 /* read all data */
 void DataLoader_ReadAll(DATA_LOADER *loader);
 
+/* copies numBytes from fileOffset into buffer, without loading the data in between
+ * Data that isn't loaded yet is read using dseek/dread. Afterwards the source is
+ * positioned at the end of the loaded data again, so that loading can continue.
+ * returns the number of bytes copied */
+UINT32 DataLoader_ReadAt(DATA_LOADER *loader, UINT32 fileOffset, UINT32 numBytes, UINT8 *buffer);
+
 /* convenience function for MemoryLoader,FileLoader, etc */
 void DataLoader_Setup(DATA_LOADER *loader, const DATA_LOADER_CALLBACKS *callbacks, void *context);
 
@@ -1,3 +1,4 @@
+#include <stdio.h>	// for SEEK_SET/SEEK_CUR/SEEK_END
 #include <stdlib.h>
 #include <string.h>
 #include <zlib.h>
@@ -127,10 +128,30 @@ static INT32 MemoryLoader_dtell(void *context)
 
 static UINT8 MemoryLoader_dseek(void *context, UINT32 offset, UINT8 whence)
 {
-	(void)context;
-	(void)offset;
-	(void)whence;
-	return 0; /* TODO */
+	MEMORY_LOADER *loader = (MEMORY_LOADER *)context;
+	INT64 newPos;
+
+	if(loader->modeCompr != MLMODE_CMP_RAW)
+		return 0x01;	// not supported for compressed data
+
+	switch(whence)
+	{
+	case SEEK_SET:
+		newPos = offset;
+		break;
+	case SEEK_CUR:
+		newPos = (INT64)loader->pos + (INT32)offset;
+		break;
+	case SEEK_END:
+		newPos = (INT64)loader->decSize + (INT32)offset;
+		break;
+	default:
+		return 0x01;
+	}
+	if(newPos < 0 || newPos > loader->decSize)
+		return 0x01;
+	loader->pos = (UINT32)newPos;
+	return 0x00;
 }
 
 static UINT8 MemoryLoader_dclose(void *context)
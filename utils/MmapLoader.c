@@ -0,0 +1,390 @@
+#include <stdio.h>	// for SEEK_SET/SEEK_CUR/SEEK_END
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
+
+#include "../common_def.h"
+#include "MmapLoader.h"
+
+#if HAVE_MMAPLOADER_W
+#include <wchar.h>
+#endif
+
+#ifdef _MSC_VER
+#define strdup	_strdup
+#define wcsdup	_wcsdup
+#endif
+
+enum
+{
+	// mode: compression
+	MMLMODE_CMP_RAW = 0x00,
+	MMLMODE_CMP_GZ = 0x10
+};
+
+typedef struct _mmap_loader
+{
+	UINT8 modeCompr;
+	char *fileName;
+#if HAVE_MMAPLOADER_W
+	wchar_t* fileNameW;	// Note: used when fileName == NULL
+#endif
+	UINT8 *mapData;	// mapped file
+	UINT32 mapSize;
+	UINT8 mapShared;	// mapData is used by the DataLoader (via dmap)
+	UINT32 decSize;	// decompressed size
+	UINT32 pos;
+	z_stream zStream;
+} MMAP_LOADER;
+
+
+static UINT8 MapFile(MMAP_LOADER *loader);
+static void UnmapFile(MMAP_LOADER *loader);
+
+static UINT8 MmapLoader_dopen(void *context);
+static UINT32 MmapLoader_dread(void *context, UINT8 *buffer, UINT32 numBytes);
+static UINT8 MmapLoader_dseek(void *context, UINT32 offset, UINT8 whence);
+static UINT8 MmapLoader_dclose(void *context);
+static INT32 MmapLoader_dtell(void *context);
+static UINT32 MmapLoader_dlength(void *context);
+static UINT8 MmapLoader_deof(void *context);
+static UINT8 *MmapLoader_dmap(void *context);
+static void MmapLoader_dunmap(void *context);
+static void MmapLoader_dfree(void *context);
+
+//DATA_LOADER *MmapLoader_Init(const char *fileName);
+//DATA_LOADER *MmapLoader_InitW(const wchar_t *fileName);
+
+
+INLINE UINT32 ReadLE32(const UINT8 *data)
+{
+	return	(data[0x03] << 24) | (data[0x02] << 16) |
+			(data[0x01] <<  8) | (data[0x00] <<  0);
+}
+
+#ifdef _WIN32
+static UINT8 MapFile(MMAP_LOADER *loader)
+{
+	HANDLE hFile;
+	HANDLE hMap;
+	LARGE_INTEGER fileSize;
+
+#if HAVE_MMAPLOADER_W
+	if (loader->fileName == NULL)
+		hFile = CreateFileW(loader->fileNameW, GENERIC_READ, FILE_SHARE_READ, NULL,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	else
+#endif
+		hFile = CreateFileA(loader->fileName, GENERIC_READ, FILE_SHARE_READ, NULL,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE)
+		return 0x01;
+	if (! GetFileSizeEx(hFile, &fileSize) || fileSize.QuadPart > 0xFFFFFFFF)
+	{
+		CloseHandle(hFile);
+		return 0x01;
+	}
+
+	loader->mapSize = (UINT32)fileSize.QuadPart;
+	loader->mapData = NULL;
+	if (loader->mapSize > 0)	// mapping empty files is not possible
+	{
+		hMap = CreateFileMapping(hFile, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+		if (hMap != NULL)
+		{
+			loader->mapData = (UINT8 *)MapViewOfFile(hMap, FILE_MAP_COPY, 0, 0, 0);
+			CloseHandle(hMap);	// the view keeps the mapping alive
+		}
+		if (loader->mapData == NULL)
+		{
+			CloseHandle(hFile);
+			return 0x01;
+		}
+	}
+	CloseHandle(hFile);
+
+	return 0x00;
+}
+
+static void UnmapFile(MMAP_LOADER *loader)
+{
+	if (loader->mapData != NULL)
+		UnmapViewOfFile(loader->mapData);
+	loader->mapData = NULL;
+	loader->mapSize = 0;
+	loader->mapShared = 0;
+	return;
+}
+#else
+static UINT8 MapFile(MMAP_LOADER *loader)
+{
+	int hFile;
+	struct stat fileStat;
+	void *mapPtr;
+
+	hFile = open(loader->fileName, O_RDONLY);
+	if (hFile < 0)
+		return 0x01;
+	if (fstat(hFile, &fileStat) || ! S_ISREG(fileStat.st_mode) ||
+		(UINT64)fileStat.st_size > 0xFFFFFFFF)
+	{
+		close(hFile);
+		return 0x01;
+	}
+
+	loader->mapSize = (UINT32)fileStat.st_size;
+	loader->mapData = NULL;
+	if (loader->mapSize > 0)	// mapping empty files is not possible
+	{
+		// private mapping: shares the page cache, but writes go to a private copy
+		mapPtr = mmap(NULL, loader->mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE, hFile, 0);
+		if (mapPtr == MAP_FAILED)
+		{
+			close(hFile);
+			return 0x01;
+		}
+		loader->mapData = (UINT8 *)mapPtr;
+	}
+	close(hFile);	// the mapping stays valid
+
+	return 0x00;
+}
+
+static void UnmapFile(MMAP_LOADER *loader)
+{
+	if (loader->mapData != NULL)
+		munmap(loader->mapData, loader->mapSize);
+	loader->mapData = NULL;
+	loader->mapSize = 0;
+	loader->mapShared = 0;
+	return;
+}
+#endif
+
+static UINT8 MmapLoader_dopen(void *context)
+{
+	MMAP_LOADER *loader = (MMAP_LOADER *)context;
+
+	UnmapFile(loader);
+	if (MapFile(loader))
+		return 0x01;
+	loader->pos = 0;
+
+	// minimum gzip size of 18 bytes (10 bytes header + 4 bytes CRC32 + 4 bytes size)
+	if (loader->mapSize >= 18 && loader->mapData[0] == 31 && loader->mapData[1] == 139)	// check for .gz file header
+	{
+		loader->modeCompr = MMLMODE_CMP_GZ;
+		loader->decSize = ReadLE32(&loader->mapData[loader->mapSize - 4]);
+		if (loader->decSize < loader->mapSize / 2)	// catch "decompressed size too small"
+			loader->decSize = 0;
+		loader->zStream.zalloc = Z_NULL;
+		loader->zStream.zfree = Z_NULL;
+		loader->zStream.opaque = Z_NULL;
+		loader->zStream.avail_in = loader->mapSize;
+		loader->zStream.next_in = (z_const Bytef *)loader->mapData;
+		if (inflateInit2(&loader->zStream, 0x20 | 15) != Z_OK)
+		{
+			UnmapFile(loader);
+			return 0x01;
+		}
+		return 0x00;
+	}
+
+	loader->modeCompr = MMLMODE_CMP_RAW;
+	loader->decSize = loader->mapSize;
+	return 0x00;
+}
+
+static UINT32 MmapLoader_dread(void *context, UINT8 *buffer, UINT32 numBytes)
+{
+	MMAP_LOADER *loader = (MMAP_LOADER *)context;
+	UINT32 bytesWritten;
+	int ret;
+
+	if (loader->pos >= loader->decSize) return 0;
+	if (loader->pos + numBytes > loader->decSize)
+		numBytes = loader->decSize - loader->pos;
+
+	if (loader->modeCompr == MMLMODE_CMP_RAW)
+	{
+		// only used when the DataLoader doesn't use dmap
+		memcpy(buffer, &loader->mapData[loader->pos], numBytes);
+		loader->pos += numBytes;
+		return numBytes;
+	}
+
+	loader->zStream.avail_out = numBytes;
+	loader->zStream.next_out = (Bytef *)buffer;
+	ret = inflate(&loader->zStream, Z_SYNC_FLUSH);
+	// see MemoryLoader: even in case of errors, we'll just return the amount of bytes read.
+	bytesWritten = loader->zStream.total_out - loader->pos;
+	loader->pos = loader->zStream.total_out;
+	if (ret == Z_STREAM_END)
+		loader->decSize = loader->pos;
+	return bytesWritten;
+}
+
+static UINT8 MmapLoader_dseek(void *context, UINT32 offset, UINT8 whence)
+{
+	MMAP_LOADER *loader = (MMAP_LOADER *)context;
+	INT64 newPos;
+
+	if (loader->modeCompr != MMLMODE_CMP_RAW)
+		return 0x01;	// not supported for compressed data
+
+	switch(whence)
+	{
+	case SEEK_SET:
+		newPos = offset;
+		break;
+	case SEEK_CUR:
+		newPos = (INT64)loader->pos + (INT32)offset;
+		break;
+	case SEEK_END:
+		newPos = (INT64)loader->decSize + (INT32)offset;
+		break;
+	default:
+		return 0x01;
+	}
+	if (newPos < 0 || newPos > loader->decSize)
+		return 0x01;
+	loader->pos = (UINT32)newPos;
+	return 0x00;
+}
+
+static UINT8 MmapLoader_dclose(void *context)
+{
+	MMAP_LOADER *loader = (MMAP_LOADER *)context;
+
+	if (loader->modeCompr == MMLMODE_CMP_GZ)
+	{
+		inflateEnd(&loader->zStream);
+		UnmapFile(loader);	// the decompressed data is in the DataLoader's buffer
+	}
+	else if (! loader->mapShared)
+	{
+		UnmapFile(loader);
+	}
+	// else: the DataLoader keeps using the mapped data until dunmap is called
+	return 0x00;
+}
+
+static INT32 MmapLoader_dtell(void *context)
+{
+	MMAP_LOADER *loader = (MMAP_LOADER *)context;
+	return loader->pos;
+}
+
+static UINT32 MmapLoader_dlength(void *context)
+{
+	MMAP_LOADER *loader = (MMAP_LOADER *)context;
+	return loader->decSize;
+}
+
+static UINT8 MmapLoader_deof(void *context)
+{
+	MMAP_LOADER *loader = (MMAP_LOADER *)context;
+	return loader->pos >= loader->decSize;
+}
+
+static UINT8 *MmapLoader_dmap(void *context)
+{
+	MMAP_LOADER *loader = (MMAP_LOADER *)context;
+
+	if (loader->modeCompr != MMLMODE_CMP_RAW || loader->mapData == NULL)
+		return NULL;	// data has to be decompressed/read into a buffer
+	loader->mapShared = 1;
+	loader->pos = loader->decSize;
+	return loader->mapData;
+}
+
+static void MmapLoader_dunmap(void *context)
+{
+	MMAP_LOADER *loader = (MMAP_LOADER *)context;
+	UnmapFile(loader);
+	return;
+}
+
+DATA_LOADER *MmapLoader_Init(const char *fileName)
+{
+	DATA_LOADER *dLoader;
+	MMAP_LOADER *mLoader;
+
+	dLoader = (DATA_LOADER *)calloc(1, sizeof(DATA_LOADER));
+	if(dLoader == NULL) return NULL;
+
+	mLoader = (MMAP_LOADER *)calloc(1, sizeof(MMAP_LOADER));
+	if(mLoader == NULL)
+	{
+		free(dLoader);
+		return NULL;
+	}
+
+	mLoader->fileName = strdup(fileName);
+
+	DataLoader_Setup(dLoader,&mmapLoader,mLoader);
+
+	return dLoader;
+}
+
+#if HAVE_MMAPLOADER_W
+DATA_LOADER *MmapLoader_InitW(const wchar_t *fileName)
+{
+	DATA_LOADER *dLoader;
+	MMAP_LOADER *mLoader;
+
+	dLoader = (DATA_LOADER *)calloc(1, sizeof(DATA_LOADER));
+	if(dLoader == NULL) return NULL;
+
+	mLoader = (MMAP_LOADER *)calloc(1, sizeof(MMAP_LOADER));
+	if(mLoader == NULL)
+	{
+		free(dLoader);
+		return NULL;
+	}
+
+	mLoader->fileName = NULL;	// explicitly mark as "unused"
+	mLoader->fileNameW = wcsdup(fileName);
+
+	DataLoader_Setup(dLoader,&mmapLoader,mLoader);
+
+	return dLoader;
+}
+#endif
+
+static void MmapLoader_dfree(void *context)
+{
+	MMAP_LOADER *loader = (MMAP_LOADER *)context;
+	UnmapFile(loader);
+#if HAVE_MMAPLOADER_W
+	if (loader->fileName == NULL)
+		free(loader->fileNameW);
+#endif
+	free(loader->fileName);
+	free(loader);
+}
+
+const DATA_LOADER_CALLBACKS mmapLoader = {
+	0x4D4D4150,		// "MMAP"
+	"Memory-Mapped File Loader",
+	MmapLoader_dopen,
+	MmapLoader_dread,
+	MmapLoader_dseek,
+	MmapLoader_dclose,
+	MmapLoader_dtell,
+	MmapLoader_dlength,
+	MmapLoader_deof,
+	MmapLoader_dfree,
+	MmapLoader_dmap,
+	MmapLoader_dunmap,
+};
@@ -0,0 +1,43 @@
+#ifndef __MMAPLOADER_H__
+#define __MMAPLOADER_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef _WIN32
+#define HAVE_MMAPLOADER_W	1
+#endif
+
+#include "DataLoader.h"
+
+// Loads files by mapping them into memory.
+// Uncompressed files are accessed directly via DataLoader_GetData without copying them.
+// The pages are mapped copy-on-write, so the data can be modified like with other loaders.
+// Compressed (.gz) files are decompressed from the mapped file.
+DATA_LOADER *MmapLoader_Init(const char *fileName);
+#ifdef HAVE_MMAPLOADER_W
+#include <wchar.h>
+DATA_LOADER *MmapLoader_InitW(const wchar_t *fileName);
+#endif
+
+#define MmapLoader_Load				DataLoader_Load
+#define MmapLoader_Reset			DataLoader_Reset
+#define MmapLoader_GetData			DataLoader_GetData
+#define MmapLoader_GetTotalSize		DataLoader_GetTotalSize
+#define MmapLoader_GetSize			DataLoader_GetSize
+#define MmapLoader_GetStatus		DataLoader_GetStatus
+#define MmapLoader_Read				DataLoader_Read
+#define MmapLoader_CancelLoading	DataLoader_CancelLoading
+#define MmapLoader_SetPreloadBytes	DataLoader_SetPreloadBytes
+#define MmapLoader_ReadUntil		DataLoader_ReadUntil
+#define MmapLoader_ReadAll			DataLoader_ReadAll
+#define MmapLoader_Deinit			DataLoader_Deinit
+
+extern const DATA_LOADER_CALLBACKS mmapLoader;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// __MMAPLOADER_H__
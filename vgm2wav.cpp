@@ -8,9 +8,23 @@
  * z
  */
 
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#ifndef _WIN32
+#include <time.h>		// for clock_gettime()
+#include <unistd.h>		// for sysconf()
+#include <dirent.h>
+#endif
 
 #include "player/playerbase.hpp"
 #include "player/vgmplayer.hpp"
@@ -19,13 +33,16 @@
 #include "player/gymplayer.hpp"
 #include "player/playera.hpp"
 #include "utils/DataLoader.h"
-#include "utils/FileLoader.h"
+#include "utils/MmapLoader.h"
+#include "utils/OSMutex.h"
+#include "utils/OSThread.h"
 #include "emu/SoundDevs.h"
 #include "emu/EmuCores.h"
 #include "emu/SoundEmu.h"
 
 #ifdef _MSC_VER
 #define strncasecmp	_strnicmp
+#define strcasecmp	_stricmp
 #define snprintf	_snprintf
 #endif
 
@@ -44,9 +61,44 @@ sample_rate = 44100;
 static unsigned int
 bit_depth = 16;
 
+/* write 32-bit floating point samples instead of integers */
+static unsigned int
+float_output = 0;
+
 static unsigned int
 loops = 2;
 
+/* number of threads for rendering sound chips (VGM only) */
+static unsigned int
+render_threads = 0;
+
+/* number of files that are rendered in parallel (batch mode only, 0 = number of CPUs) */
+static unsigned int
+batch_jobs = 0;
+
+/* one file of a batch */
+typedef struct _batch_job {
+    std::string inFile;
+    std::string outFile;
+} BATCH_JOB;
+
+/* state shared by all batch workers */
+typedef struct _batch_state {
+    std::vector<BATCH_JOB> jobs;
+    size_t nextJob;
+    OS_MUTEX *mutex;
+    unsigned int failCnt;
+    double audioTime;   /* total length of all rendered files, in seconds */
+} BATCH_STATE;
+
+/* Each worker keeps its player, engines and buffers for all files it renders. */
+typedef struct _batch_worker {
+    BATCH_STATE *state;
+    PlayerA player;
+    UINT8 *packed;
+    OS_THREAD *thread;
+} BATCH_WORKER;
+
 /* vgm-specific functions */
 static void
 FCC2STR(char *str, UINT32 fcc);
@@ -60,6 +112,40 @@ set_core(PlayerBase *player, UINT8 devId, UINT32 coreId);
 static void
 dump_info(PlayerBase *player);
 
+static int
+setup_player(PlayerA *player);
+
+static int
+render_file(PlayerA *player, const char *inFile, const char *outFile, UINT8 *packed, int verbose, unsigned int *renderedFrames);
+
+/* batch functions */
+static int
+run_batch(const char *source, const char *outDir);
+
+static int
+read_manifest(const char *fileName, const char *outDir, std::vector<BATCH_JOB> &jobs);
+
+static int
+read_directory(const char *dirName, const char *outDir, std::vector<BATCH_JOB> &jobs);
+
+static void
+batch_worker(void *args);
+
+static std::string
+make_out_path(const char *outDir, const char *fileName, int replaceExt);
+
+static int
+is_directory(const char *path);
+
+static int
+is_song_file(const char *fileName);
+
+static double
+get_time(void);
+
+static unsigned int
+get_cpu_count(void);
+
 static void
 pack_uint16le(UINT8 *d, UINT16 n);
 
@@ -83,31 +169,22 @@ static unsigned int
 scan_uint(const char *str);
 
 static const char *
-fmt_time(double ts);
+fmt_time(char *ts, double sec);
 
 static const char *
 extensible_guid_trailer= "\x00\x00\x00\x00\x10\x00\x80\x00\x00\xAA\x00\x38\x9B\x71";
 
 int main(int argc, const char *argv[]) {
     PlayerA player;
-    PlayerBase* plrEngine;
-
-    unsigned int totalFrames;
-    unsigned int fadeFrames;
-    unsigned int curFrames;
-    const char *const *tags;
+    const char *batch_src;
     const char *self;
     const char *c;
     const char *s;
-    FILE *f;
-    DATA_LOADER *loader;
     UINT8 *packed;
-    double complete;
-    double inc;
+    unsigned int frames;
+    int ret;
 
-    fadeFrames = 0;
-    complete = 0.0;
-    inc = 0.0;
+    batch_src = NULL;
 
     self = *argv++;
     argc--;
@@ -157,6 +234,11 @@ int main(int argc, const char *argv[]) {
             argv++;
             argc--;
         }
+        else if(str_equals(*argv,"--float")) {
+            float_output = 1;
+            argv++;
+            argc--;
+        }
         else if(str_istarts(*argv,"--fade")) {
             c = strchr(*argv,'=');
             if(c != NULL) {
@@ -170,6 +252,45 @@ int main(int argc, const char *argv[]) {
             argv++;
             argc--;
         }
+        else if(str_istarts(*argv,"--threads")) {
+            c = strchr(*argv,'=');
+            if(c != NULL) {
+                s = &c[1];
+            } else {
+                argv++;
+                argc--;
+                s = *argv;
+            }
+            render_threads = scan_uint(s);
+            argv++;
+            argc--;
+        }
+        else if(str_istarts(*argv,"--batch")) {
+            c = strchr(*argv,'=');
+            if(c != NULL) {
+                s = &c[1];
+            } else {
+                argv++;
+                argc--;
+                s = *argv;
+            }
+            batch_src = s;
+            argv++;
+            argc--;
+        }
+        else if(str_istarts(*argv,"--jobs")) {
+            c = strchr(*argv,'=');
+            if(c != NULL) {
+                s = &c[1];
+            } else {
+                argv++;
+                argc--;
+                s = *argv;
+            }
+            batch_jobs = scan_uint(s);
+            argv++;
+            argc--;
+        }
         else {
             break;
         }
@@ -189,17 +310,31 @@ int main(int argc, const char *argv[]) {
         case 32: break;
         default: bit_depth = 16;
     }
+    if(float_output) {
+        bit_depth = 32;
+    }
 
-    if(argc < 2) {
+    if(argc < (batch_src != NULL ? 1 : 2)) {
         fprintf(stderr,"Usage: %s [options] /path/to/vgm-file /path/to/out.wav\n",self);
+        fprintf(stderr,"       %s [options] --batch /path/to/list.txt|/path/to/dir /path/to/outdir\n",self);
         fprintf(stderr,"Available options:\n");
         fprintf(stderr,"    --samplerate\n");
         fprintf(stderr,"    --bps\n");
+        fprintf(stderr,"    --float\n");
         fprintf(stderr,"    --fade\n");
         fprintf(stderr,"    --loops\n");
+        fprintf(stderr,"    --threads\n");
+        fprintf(stderr,"    --batch\n");
+        fprintf(stderr,"    --jobs\n");
+        fprintf(stderr,"Batch mode renders all files listed in a text file (one per line, optionally followed\n");
+        fprintf(stderr,"by a tab and the output file name) or all song files in a directory.\n");
         return 1;
     }
 
+    if(batch_src != NULL) {
+        return run_batch(batch_src,argv[0]);
+    }
+
     /* if we were writing a library that uses libvgm, we'd want
      * to have way better clean-up of resources when we see an error
      * (free all our allocated memory, close files, etc).
@@ -218,66 +353,109 @@ int main(int argc, const char *argv[]) {
         return 1;
     }
 
+    if(setup_player(&player)) {
+        return 1;
+    }
+
+    ret = render_file(&player, argv[0], argv[1], packed, 1, &frames);
+
+    free(packed);
+    player.UnregisterAllPlayers();
+
+    return ret;
+}
+
+static int setup_player(PlayerA *player) {
     /* Register all player engines.
      * libvgm will automatically choose the correct one depending on the file format. */
-    player.RegisterPlayerEngine(new VGMPlayer);
-    player.RegisterPlayerEngine(new S98Player);
-    player.RegisterPlayerEngine(new DROPlayer);
-    player.RegisterPlayerEngine(new GYMPlayer);
+    player->RegisterPlayerEngine(new VGMPlayer);
+    player->RegisterPlayerEngine(new S98Player);
+    player->RegisterPlayerEngine(new DROPlayer);
+    player->RegisterPlayerEngine(new GYMPlayer);
 
     /* setup the player's output parameters and allocate internal buffers */
-    if (player.SetOutputSettings(sample_rate, 2, bit_depth, BUFFER_LEN)) {
+    if (player->SetOutputSettings(sample_rate, 2, bit_depth | (float_output ? PLR_SMPLFMT_FLOAT : 0), BUFFER_LEN)) {
         fprintf(stderr, "Unsupported sample rate / bps\n");
         return 1;
     }
 
     /* set playback parameters */
     {
-        PlayerA::Config pCfg = player.GetConfiguration();
+        PlayerA::Config pCfg = player->GetConfiguration();
         pCfg.masterVol = 0x10000;	// == 1.0 == 100%
         pCfg.loopCount = loops;
         pCfg.fadeSmpls = sample_rate * fade_len;
         pCfg.endSilenceSmpls = 0;
         pCfg.pbSpeed = 1.0;
-        player.SetConfiguration(pCfg);
+        player->SetConfiguration(pCfg);
     }
 
-    f = fopen(argv[1],"wb");
-    if(f == NULL) {
-        fprintf(stderr,"unable to open output file\n");
-        return 1;
-    }
+    return 0;
+}
+
+/* Renders one file. The player can be reused for the next file afterwards.
+ * In non-verbose mode, only errors are printed. */
+static int render_file(PlayerA *player, const char *inFile, const char *outFile, UINT8 *packed, int verbose, unsigned int *renderedFrames) {
+    PlayerBase* plrEngine;
+
+    unsigned int totalFrames;
+    unsigned int fadeFrames;
+    unsigned int curFrames;
+    const char *const *tags;
+    FILE *f;
+    DATA_LOADER *loader;
+    double complete;
+    double inc;
+    char ts[0x20];
+    int ret;
+
+    fadeFrames = 0;
+    complete = 0.0;
+    inc = 0.0;
+    ret = 0;
+    *renderedFrames = 0;
 
     /* past all the boilerplate now!
-     * create a FileLoader object - able to read gzip'd
-     * files on-the-fly */
+     * create a MmapLoader object - maps the file into memory, so
+     * uncompressed files don't need to be copied, and is able to
+     * read gzip'd files on-the-fly.
+     * (FileLoader_Init works the same way, but reads into a buffer) */
 
-    loader = FileLoader_Init(argv[0]);
+    loader = MmapLoader_Init(inFile);
     if(loader == NULL) {
-        fprintf(stderr,"failed to create FileLoader\n");
+        fprintf(stderr,"%s: failed to create MmapLoader\n",inFile);
         return 1;
     }
 
     /* attempt to load 256 bytes, bail if not possible */
     DataLoader_SetPreloadBytes(loader,0x100);
     if(DataLoader_Load(loader)) {
-        fprintf(stderr,"failed to load DataLoader\n");
+        fprintf(stderr,"%s: failed to load DataLoader\n",inFile);
         DataLoader_Deinit(loader);
         return 1;
     }
 
     /* associate the fileloader to the player -
      * automatically reads the rest of the file */
-    if(player.LoadFile(loader)) {
-        fprintf(stderr,"failed to load file\n");
+    if(player->LoadFile(loader)) {
+        fprintf(stderr,"%s: failed to load file\n",inFile);
+        DataLoader_Deinit(loader);
         return 1;
     }
-    plrEngine = player.GetPlayer();
+    plrEngine = player->GetPlayer();
 
+    /* the loop count may have been changed by the previous file */
+    player->SetLoopCount(loops);
     if (plrEngine->GetPlayerType() == FCC_VGM)
     {
         VGMPlayer* vgmplay = dynamic_cast<VGMPlayer*>(plrEngine);
-        player.SetLoopCount(vgmplay->GetModifiedLoopCount(loops));
+        VGM_PLAY_OPTIONS vgmOpts;
+        player->SetLoopCount(vgmplay->GetModifiedLoopCount(loops));
+
+        /* render multiple sound chips in parallel */
+        vgmplay->GetPlayerOptions(vgmOpts);
+        vgmOpts.renderThreads = (UINT8)render_threads;
+        vgmplay->SetPlayerOptions(vgmOpts);
     }
 
     /* example for setting cores */
@@ -294,18 +472,22 @@ int main(int argc, const char *argv[]) {
      * if we wanted to get *really* fancy we could add
      * an "id3 " chunk or "LIST" "INFO" chunk to the
      * wave file. */
-    tags = plrEngine->GetTags();
-    while(*tags) {
-        fprintf(stderr,"%s: %s\n",tags[0],tags[1]);
-        tags += 2;
+    if(verbose) {
+        tags = plrEngine->GetTags();
+        while(*tags) {
+            fprintf(stderr,"%s: %s\n",tags[0],tags[1]);
+            tags += 2;
+        }
     }
 
     /* need to call Start before calls like Tick2Sample or
      * checking any kind of timing info, because
      * Start updates the sample rate multiplier/divisors */
-    player.Start();
+    player->Start();
 
-    dump_info(plrEngine);
+    if(verbose) {
+        dump_info(plrEngine);
+    }
 
     /* libvgm uses the term "Sample" but its' really a PCM frame! */
     /* In a mono configuration, 1 frame = 1 sample, in a stereo
@@ -321,31 +503,46 @@ int main(int argc, const char *argv[]) {
         totalFrames += fadeFrames;
     }
 
+    f = fopen(outFile,"wb");
+    if(f == NULL) {
+        fprintf(stderr,"%s: unable to open output file\n",outFile);
+        player->Stop();
+        player->UnloadFile();
+        DataLoader_Deinit(loader);
+        return 1;
+    }
+
     /* Let's tell the user what we're doing */
-    fprintf(stderr,"Rendering %s to %s\n",argv[0],argv[1]);
-    fprintf(stderr,"Samplerate: %u\n",sample_rate);
-    fprintf(stderr,"BPS: %u\n",bit_depth);
-    fprintf(stderr,"Channels: 2\n");
-    fprintf(stderr,"Length: %s\n",fmt_time(plrEngine->Sample2Second(totalFrames)));
+    if(verbose) {
+        fprintf(stderr,"Rendering %s to %s\n",inFile,outFile);
+        fprintf(stderr,"Samplerate: %u\n",sample_rate);
+        fprintf(stderr,"BPS: %u%s\n",bit_depth,float_output ? " (float)" : "");
+        fprintf(stderr,"Channels: 2\n");
+        fprintf(stderr,"Length: %s\n",fmt_time(ts,plrEngine->Sample2Second(totalFrames)));
+    }
 
-    write_wav_header(f,totalFrames);
+    if(!write_wav_header(f,totalFrames)) {
+        ret = 1;
+    }
 
     /* figure out an incrementor for showing a progress bar */
     inc = (double)BUFFER_LEN / totalFrames;
 
     /* we'll just print a '-' character each time we've hit the
      * next 10% of the file */
-    fprintf(stderr,"[");
-    fflush(stderr);
+    if(verbose) {
+        fprintf(stderr,"[");
+        fflush(stderr);
+    }
 
-    while(totalFrames) {
+    while(totalFrames && !ret) {
 
         memset(packed,0,sizeof(INT32)     * BUFFER_LEN * 2);
 
         /* default to BUFFER_LEN PCM frames unless we have under BUFFER_LEN remaining */
         curFrames = (BUFFER_LEN > totalFrames ? totalFrames : BUFFER_LEN);
 
-        player.Render(curFrames * ((bit_depth / 8) * 2),packed);
+        player->Render(curFrames * ((bit_depth / 8) * 2),packed);
 
         /* convert machine-native frames into little-endian bytes */
         /* if this were a plugin in a music player, we likely wouldn't
@@ -357,30 +554,389 @@ int main(int argc, const char *argv[]) {
         frames_to_little_endian(packed, curFrames);
 
         /* write out to disk */
-        write_frames(f, curFrames, packed);
+        if(!write_frames(f, curFrames, packed)) {
+            ret = 1;
+        }
 
         totalFrames -= curFrames;
+        *renderedFrames += curFrames;
 
         /* if we've done the next 10% of rendering, update the progress bar */
         complete += inc;
         if(complete >= 0.10) {
             complete -= 0.10;
-            fprintf(stderr,"-");
-            fflush(stderr);
+            if(verbose) {
+                fprintf(stderr,"-");
+                fflush(stderr);
+            }
         }
     }
-    fprintf(stderr,"]\n");
-    player.Stop();
-    player.UnloadFile();
+    if(verbose) {
+        fprintf(stderr,"]\n");
+    }
+    if(ret) {
+        fprintf(stderr,"%s: error writing output file\n",outFile);
+    }
+    player->Stop();
+    player->UnloadFile();
 
-    free(packed);
-    player.UnregisterAllPlayers();
     DataLoader_Deinit(loader);
     fclose(f);
 
+    return ret;
+}
+
+static int run_batch(const char *source, const char *outDir) {
+    BATCH_STATE state;
+    std::vector<BATCH_WORKER *> workers;
+    unsigned int jobCnt;
+    unsigned int i;
+    double startTime;
+    double runTime;
+    int ret;
+
+    if(is_directory(source)) {
+        ret = read_directory(source,outDir,state.jobs);
+    } else {
+        ret = read_manifest(source,outDir,state.jobs);
+    }
+    if(ret) {
+        return 1;
+    }
+    if(state.jobs.empty()) {
+        fprintf(stderr,"%s: no files to render\n",source);
+        return 1;
+    }
+    {
+        std::vector<std::string> outFiles;
+        for(i=0;i<state.jobs.size();i++) {
+            outFiles.push_back(state.jobs[i].outFile);
+        }
+        std::sort(outFiles.begin(),outFiles.end());
+        for(i=1;i<outFiles.size();i++) {
+            if(outFiles[i] == outFiles[i - 1]) {
+                fprintf(stderr,"%s: output file is used for multiple input files\n",outFiles[i].c_str());
+                return 1;
+            }
+        }
+    }
+
+    state.nextJob = 0;
+    state.failCnt = 0;
+    state.audioTime = 0.0;
+    if(OSMutex_Init(&state.mutex,0)) {
+        fprintf(stderr,"failed to create mutex\n");
+        return 1;
+    }
+
+    jobCnt = batch_jobs ? batch_jobs : get_cpu_count();
+    if(jobCnt > state.jobs.size()) {
+        jobCnt = (unsigned int)state.jobs.size();
+    }
+
+    /* The players are set up in advance, so that the workers can't fail
+     * and each one reuses its allocations for all of its files. */
+    for(i=0;i<jobCnt;i++) {
+        BATCH_WORKER *bw = new BATCH_WORKER;
+        bw->state = &state;
+        bw->thread = NULL;
+        bw->packed = (UINT8 *)malloc(sizeof(INT32) * 2 * BUFFER_LEN);
+        workers.push_back(bw);
+        if(bw->packed == NULL) {
+            fprintf(stderr,"out of memory\n");
+            ret = 1;
+            break;
+        }
+        if(setup_player(&bw->player)) {
+            ret = 1;
+            break;
+        }
+    }
+
+    if(!ret) {
+        fprintf(stderr,"Rendering %u files using %u threads\n",(unsigned int)state.jobs.size(),jobCnt);
+        startTime = get_time();
+        /* the main thread works on the jobs as well */
+        for(i=1;i<jobCnt;i++) {
+            if(OSThread_Init(&workers[i]->thread,batch_worker,workers[i])) {
+                workers[i]->thread = NULL;
+                fprintf(stderr,"failed to create thread %u\n",i);
+            }
+        }
+        batch_worker(workers[0]);
+        for(i=1;i<jobCnt;i++) {
+            if(workers[i]->thread != NULL) {
+                OSThread_Join(workers[i]->thread);
+                OSThread_Deinit(workers[i]->thread);
+            }
+        }
+        runTime = get_time() - startTime;
+
+        printf("Total: %u files, %u failed, %.1f s audio, %.3f s, %.1fx realtime\n",
+          (unsigned int)state.jobs.size(),
+          state.failCnt,
+          state.audioTime,
+          runTime,
+          runTime > 0.0 ? state.audioTime / runTime : 0.0);
+        ret = state.failCnt ? 1 : 0;
+    }
+
+    for(i=0;i<workers.size();i++) {
+        workers[i]->player.UnregisterAllPlayers();
+        free(workers[i]->packed);
+        delete workers[i];
+    }
+    OSMutex_Deinit(state.mutex);
+
+    return ret;
+}
+
+static void batch_worker(void *args) {
+    BATCH_WORKER *bw = (BATCH_WORKER *)args;
+    BATCH_STATE *bs = bw->state;
+    const BATCH_JOB *job;
+    unsigned int frames;
+    double startTime;
+    double runTime;
+    double audioTime;
+    char ts[0x20];
+    int ret;
+
+    while(1) {
+        OSMutex_Lock(bs->mutex);
+        job = (bs->nextJob < bs->jobs.size()) ? &bs->jobs[bs->nextJob] : NULL;
+        bs->nextJob++;
+        OSMutex_Unlock(bs->mutex);
+        if(job == NULL) {
+            break;
+        }
+
+        startTime = get_time();
+        ret = render_file(&bw->player, job->inFile.c_str(), job->outFile.c_str(), bw->packed, 0, &frames);
+        runTime = get_time() - startTime;
+        audioTime = (double)frames / sample_rate;
+
+        OSMutex_Lock(bs->mutex);
+        if(ret) {
+            bs->failCnt++;
+        }
+        bs->audioTime += audioTime;
+        OSMutex_Unlock(bs->mutex);
+
+        /* one printf per line, so that the lines of different workers don't get mixed */
+        if(ret) {
+            printf("%s: FAILED\n",job->inFile.c_str());
+        } else {
+            printf("%s: %s audio, %.3f s, %.1fx realtime\n",
+              job->inFile.c_str(),
+              fmt_time(ts,audioTime),
+              runTime,
+              runTime > 0.0 ? audioTime / runTime : 0.0);
+        }
+        fflush(stdout);
+    }
+
+    return;
+}
+
+/* manifest format: one input file per line, optionally followed by a tab and the output file name
+ * empty lines and lines starting with '#' are ignored */
+static int read_manifest(const char *fileName, const char *outDir, std::vector<BATCH_JOB> &jobs) {
+    FILE *f;
+    char line[0x1000];
+    char *tab;
+    size_t len;
+    BATCH_JOB job;
+
+    f = fopen(fileName,"rt");
+    if(f == NULL) {
+        fprintf(stderr,"%s: unable to open file list\n",fileName);
+        return 1;
+    }
+
+    while(fgets(line,sizeof(line),f) != NULL) {
+        len = strlen(line);
+        while(len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+            len--;
+        }
+        line[len] = '\0';
+        if(len == 0 || line[0] == '#') {
+            continue;
+        }
+
+        tab = strchr(line,'\t');
+        if(tab != NULL) {
+            *tab = '\0';
+            job.inFile = line;
+            job.outFile = make_out_path(outDir,&tab[1],0);
+        } else {
+            job.inFile = line;
+            job.outFile = make_out_path(outDir,line,1);
+        }
+        jobs.push_back(job);
+    }
+
+    fclose(f);
+    return 0;
+}
+
+static int read_directory(const char *dirName, const char *outDir, std::vector<BATCH_JOB> &jobs) {
+    std::vector<std::string> files;
+    std::string path;
+    BATCH_JOB job;
+    size_t i;
+
+    path = dirName;
+    if(!path.empty() && path[path.length() - 1] != '/' && path[path.length() - 1] != '\\') {
+        path += '/';
+    }
+
+#ifdef _WIN32
+    {
+        WIN32_FIND_DATAA findData;
+        HANDLE hFind;
+
+        hFind = FindFirstFileA((path + "*").c_str(),&findData);
+        if(hFind == INVALID_HANDLE_VALUE) {
+            fprintf(stderr,"%s: unable to read directory\n",dirName);
+            return 1;
+        }
+        do {
+            if(findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+                continue;
+            }
+            if(is_song_file(findData.cFileName)) {
+                files.push_back(findData.cFileName);
+            }
+        } while(FindNextFileA(hFind,&findData));
+        FindClose(hFind);
+    }
+#else
+    {
+        DIR *dir;
+        struct dirent *de;
+
+        dir = opendir(dirName);
+        if(dir == NULL) {
+            fprintf(stderr,"%s: unable to read directory\n",dirName);
+            return 1;
+        }
+        while((de = readdir(dir)) != NULL) {
+            if(is_song_file(de->d_name) && !is_directory((path + de->d_name).c_str())) {
+                files.push_back(de->d_name);
+            }
+        }
+        closedir(dir);
+    }
+#endif
+
+    /* render in a predictable order */
+    std::sort(files.begin(),files.end());
+    for(i=0;i<files.size();i++) {
+        job.inFile = path + files[i];
+        job.outFile = make_out_path(outDir,files[i].c_str(),1);
+        jobs.push_back(job);
+    }
+    /* "song.vgm" and "song.vgz" would both be written to "song.wav", so keep the extension for those */
+    for(i=0;i<files.size();i++) {
+        job.outFile = make_out_path(outDir,files[i].c_str(),1);
+        if((i > 0 && job.outFile == make_out_path(outDir,files[i - 1].c_str(),1)) ||
+           (i + 1 < files.size() && job.outFile == make_out_path(outDir,files[i + 1].c_str(),1))) {
+            jobs[jobs.size() - files.size() + i].outFile = make_out_path(outDir,files[i].c_str(),0) + ".wav";
+        }
+    }
+
     return 0;
 }
 
+/* returns outDir + file title of fileName, optionally with the extension replaced by ".wav" */
+static std::string make_out_path(const char *outDir, const char *fileName, int replaceExt) {
+    std::string path;
+    const char *title;
+    const char *ext;
+    const char *c;
+
+    title = fileName;
+    for(c = fileName; *c; c++) {
+        if(*c == '/' || *c == '\\') {
+            title = c + 1;
+        }
+    }
+
+    path = outDir;
+    if(!path.empty() && path[path.length() - 1] != '/' && path[path.length() - 1] != '\\') {
+        path += '/';
+    }
+    ext = replaceExt ? strrchr(title,'.') : NULL;
+    if(ext != NULL && ext != title) {
+        path.append(title,ext - title);
+        path += ".wav";
+    } else {
+        path += title;
+        if(replaceExt) {
+            path += ".wav";
+        }
+    }
+
+    return path;
+}
+
+static int is_directory(const char *path) {
+    struct stat st;
+
+    if(stat(path,&st)) {
+        return 0;
+    }
+    return (st.st_mode & S_IFMT) == S_IFDIR;
+}
+
+static int is_song_file(const char *fileName) {
+    static const char *SONG_EXTS[] = {"vgm", "vgz", "s98", "dro", "gym", NULL};
+    const char *ext;
+    const char **curExt;
+
+    ext = strrchr(fileName,'.');
+    if(ext == NULL) {
+        return 0;
+    }
+    for(curExt = SONG_EXTS; *curExt != NULL; curExt++) {
+        if(strcasecmp(&ext[1],*curExt) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* returns a monotonic time in seconds */
+static double get_time(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq;
+    LARGE_INTEGER cnt;
+
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&cnt);
+    return (double)cnt.QuadPart / (double)freq.QuadPart;
+#else
+    struct timespec tp;
+
+    clock_gettime(CLOCK_MONOTONIC,&tp);
+    return tp.tv_sec + tp.tv_nsec / 1000000000.0;
+#endif
+}
+
+static unsigned int get_cpu_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO sysInfo;
+
+    GetSystemInfo(&sysInfo);
+    return sysInfo.dwNumberOfProcessors ? sysInfo.dwNumberOfProcessors : 1;
+#else
+    long cpuCnt = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return (cpuCnt > 0) ? (unsigned int)cpuCnt : 1;
+#endif
+}
+
 static void set_core(PlayerBase *player, UINT8 devId, UINT32 coreId) {
     PLR_DEV_OPTS devOpts;
     UINT32 id;
@@ -439,8 +995,7 @@ static void dump_info(PlayerBase *player) {
 }
 
 static const char *
-fmt_time(double sec) {
-    static char ts[256];
+fmt_time(char *ts, double sec) {
     unsigned int i_sec;
     unsigned int i_min;
     unsigned int i_hour;
@@ -583,7 +1138,7 @@ static int write_wav_header(FILE *f, unsigned int totalFrames) {
     if(fwrite(tmp,1,4,f) != 4) return 0;
 
     /* subformatcode - same as above audioFormat */
-    pack_uint16le(tmp,1);
+    pack_uint16le(tmp,float_output ? 3 : 1);
     if(fwrite(tmp,1,2,f) != 2) return 0;
 
     /* rest of the GUID */
@@ -0,0 +1,128 @@
+// VGM Parsing Benchmark
+// ---------------------
+// Measures how fast VGMPlayer processes the command stream, without rendering any sound.
+// The whole song is processed by seeking to its end, once using the command handlers and
+// once using the compiled command list (VGM_PLAY_OPTIONS.compileCmds).
+// The register writes are still sent to the sound devices, so the numbers include their write handlers.
+//	cmd data: size of the command data (without header and tags)
+//	handlers: time for processing the song using the command handlers (the fastest run is used)
+//	compiled: time for processing the song using the compiled command list (the fastest run is used)
+//	compile: time for compiling the command list
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "stdtype.h"
+#include "player/playerbase.hpp"
+#include "player/vgmplayer.hpp"
+#include "utils/DataLoader.h"
+#include "utils/FileLoader.h"
+
+#define SMPL_RATE	44100
+#define DEF_RUNS	5
+
+static double ParseSong(VGMPlayer& player, UINT8 compile, unsigned int runs, double* retCompileTime);
+static int BenchmarkFile(const char* fileName, unsigned int runs);
+
+int main(int argc, char* argv[])
+{
+	unsigned int runs = DEF_RUNS;
+	int argbase = 1;
+	int curFile;
+	
+	if (argbase + 1 < argc && ! strcmp(argv[argbase], "-r"))
+	{
+		runs = (unsigned int)strtoul(argv[argbase + 1], NULL, 0);
+		argbase += 2;
+	}
+	if (argbase >= argc || ! runs)
+	{
+		printf("Usage: %s [-r runs] file1.vgm [file2.vgm ...]\n", argv[0]);
+		printf("Parses every file %u times (default) with and without the compiled command list\n", DEF_RUNS);
+		printf("and reports the speed of the fastest run.\n");
+		return 1;
+	}
+	
+	printf("%-32s %9s %10s %10s %10s %10s %8s\n", "file", "cmd data", "handlers", "MB/s", "compiled", "MB/s", "compile");
+	for (curFile = argbase; curFile < argc; curFile ++)
+		BenchmarkFile(argv[curFile], runs);
+	
+	return 0;
+}
+
+static double ParseSong(VGMPlayer& player, UINT8 compile, unsigned int runs, double* retCompileTime)
+{
+	VGM_PLAY_OPTIONS playOpts;
+	UINT32 songTicks;
+	clock_t bestTime;
+	clock_t startTime;
+	unsigned int curRun;
+	
+	player.GetPlayerOptions(playOpts);
+	playOpts.compileCmds = 0;
+	playOpts.snapInterval = 0;	// seeking must process all commands
+	player.SetPlayerOptions(playOpts);
+	player.Start();
+	if (compile)
+	{
+		// switching the option while playing compiles the command list
+		playOpts.compileCmds = 1;
+		startTime = clock();
+		player.SetPlayerOptions(playOpts);
+		*retCompileTime = (double)(clock() - startTime) / CLOCKS_PER_SEC;
+	}
+	
+	songTicks = player.GetTotalPlayTicks(1);
+	bestTime = 0;
+	for (curRun = 0; curRun < runs; curRun ++)
+	{
+		clock_t runTime;
+		
+		player.Reset();
+		startTime = clock();
+		player.Seek(PLAYPOS_TICK, songTicks);
+		runTime = clock() - startTime;
+		if (curRun == 0 || runTime < bestTime)
+			bestTime = runTime;
+	}
+	player.Stop();
+	
+	return (double)bestTime / CLOCKS_PER_SEC;
+}
+
+static int BenchmarkFile(const char* fileName, unsigned int runs)
+{
+	VGMPlayer player;
+	DATA_LOADER* dLoad;
+	const VGM_HEADER* vgmHdr;
+	double dataMB;
+	double timeHandlers;
+	double timeCompiled;
+	double timeCompile;
+	
+	dLoad = FileLoader_Init(fileName);
+	if (dLoad == NULL)
+		return 1;
+	DataLoader_SetPreloadBytes(dLoad, 0x100);
+	player.SetSampleRate(SMPL_RATE);
+	if (DataLoader_Load(dLoad) || player.LoadFile(dLoad))
+	{
+		printf("%s: failed to load file\n", fileName);
+		DataLoader_Deinit(dLoad);
+		return 1;
+	}
+	vgmHdr = player.GetFileHeader();
+	dataMB = (vgmHdr->dataEnd - vgmHdr->dataOfs) / 1048576.0;
+	
+	timeCompile = 0.0;
+	timeHandlers = ParseSong(player, 0, runs, &timeCompile);
+	timeCompiled = ParseSong(player, 1, runs, &timeCompile);
+	printf("%-32s %8.2fM %9.4fs %10.1f %9.4fs %10.1f %7.4fs\n", fileName, dataMB,
+		timeHandlers, (timeHandlers > 0.0) ? dataMB / timeHandlers : 0.0,
+		timeCompiled, (timeCompiled > 0.0) ? dataMB / timeCompiled : 0.0, timeCompile);
+	
+	player.UnloadFile();
+	DataLoader_Deinit(dLoad);
+	return 0;
+}
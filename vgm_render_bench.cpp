@@ -0,0 +1,213 @@
+// VGM Rendering Benchmark
+// -----------------------
+// Renders song files as fast as possible and measures the speed of the sound emulation.
+// Arcade VGMs are a good workload for the PCM cores (C352, MultiPCM, K054539, ES5503, SCSP, ...),
+// as most of their voices are idle most of the time.
+// The files are loaded into memory before rendering, so disk access isn't measured.
+//	length: length of the song (without loops)
+//	time: rendering time (the fastest run is used)
+//	speed: song length / rendering time
+// With -p, the per-device profiling data of the last run is printed as well.
+// (This requires the player library to be built with PLAYER_PROFILING.)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+#include <string>
+
+#include "stdtype.h"
+#include "player/playerbase.hpp"
+#include "player/vgmplayer.hpp"
+#include "player/s98player.hpp"
+#include "player/droplayer.hpp"
+#include "player/gymplayer.hpp"
+#include "player/playera.hpp"
+#include "utils/DataLoader.h"
+#include "utils/FileLoader.h"
+#include "emu/SoundEmu.h"
+
+#define SMPL_RATE	44100
+#define BUFFER_SMPLS	2048
+#define DEF_RUNS	3
+
+static std::string GetDeviceList(PlayerBase* plrEngine);
+static void PrintProfile(const PLR_PROFILE& prof);
+static int BenchmarkFile(PlayerA& player, const char* fileName, unsigned int runs,
+	double* retLength, double* retTime, std::string& retDevList, PLR_PROFILE* retProf);
+
+int main(int argc, char* argv[])
+{
+	PlayerA player;
+	unsigned int runs = DEF_RUNS;
+	bool showProf = false;
+	int argbase = 1;
+	double totalLen = 0.0;
+	double totalTime = 0.0;
+	int curFile;
+	
+	while (argbase < argc && argv[argbase][0] == '-')
+	{
+		if (argbase + 1 < argc && ! strcmp(argv[argbase], "-r"))
+		{
+			runs = (unsigned int)strtoul(argv[argbase + 1], NULL, 0);
+			argbase += 2;
+		}
+		else if (! strcmp(argv[argbase], "-p"))
+		{
+			showProf = true;
+			argbase ++;
+		}
+		else
+		{
+			break;
+		}
+	}
+	if (argbase >= argc || ! runs)
+	{
+		printf("Usage: %s [-r runs] [-p] file1.vgm [file2.vgm ...]\n", argv[0]);
+		printf("Renders every file %u times (default) and reports the speed of the fastest run.\n", DEF_RUNS);
+		printf("-p prints the profiling data of the player (requires PLAYER_PROFILING).\n");
+		return 1;
+	}
+	
+	player.RegisterPlayerEngine(new VGMPlayer);
+	player.RegisterPlayerEngine(new S98Player);
+	player.RegisterPlayerEngine(new DROPlayer);
+	player.RegisterPlayerEngine(new GYMPlayer);
+	if (player.SetOutputSettings(SMPL_RATE, 2, 16, BUFFER_SMPLS))
+	{
+		printf("Unsupported output settings!\n");
+		return 1;
+	}
+	{
+		PlayerA::Config pCfg = player.GetConfiguration();
+		pCfg.masterVol = 0x10000;
+		pCfg.loopCount = 1;
+		pCfg.fadeSmpls = 0;
+		pCfg.endSilenceSmpls = 0;
+		pCfg.pbSpeed = 1.0;
+		player.SetConfiguration(pCfg);
+	}
+	
+	printf("%-40s %10s %10s %10s\n", "file", "length", "time", "speed");
+	for (curFile = argbase; curFile < argc; curFile ++)
+	{
+		double songLen;
+		double rendTime;
+		std::string devList;
+		PLR_PROFILE prof;
+		
+		if (BenchmarkFile(player, argv[curFile], runs, &songLen, &rendTime, devList, showProf ? &prof : NULL))
+			continue;
+		printf("%-40s %9.2fs %9.3fs %9.1fx\n", argv[curFile], songLen, rendTime,
+			(rendTime > 0.0) ? songLen / rendTime : 0.0);
+		printf("  devices:%s\n", devList.c_str());
+		if (showProf && ! prof.devices.empty())
+			PrintProfile(prof);
+		totalLen += songLen;
+		totalTime += rendTime;
+	}
+	printf("%-40s %9.2fs %9.3fs %9.1fx\n", "total", totalLen, totalTime,
+		(totalTime > 0.0) ? totalLen / totalTime : 0.0);
+	
+	player.UnregisterAllPlayers();
+	return 0;
+}
+
+static std::string GetDeviceList(PlayerBase* plrEngine)
+{
+	std::vector<PLR_DEV_INFO> devInfList;
+	std::string result;
+	size_t curDev;
+	
+	plrEngine->GetSongDeviceInfo(devInfList);
+	for (curDev = 0; curDev < devInfList.size(); curDev ++)
+	{
+		const PLR_DEV_INFO& pdi = devInfList[curDev];
+		const char* devName = SndEmu_GetDevName(pdi.type, 0x00, pdi.devCfg);
+		result += " ";
+		result += (devName != NULL) ? devName : "?";
+	}
+	
+	return result;
+}
+
+static void PrintProfile(const PLR_PROFILE& prof)
+{
+	size_t curDev;
+	
+	printf("  parse: %llu calls, %.3f ms\n", (unsigned long long)prof.parseCalls, prof.parseTime / 1000000.0);
+	for (curDev = 0; curDev < prof.devices.size(); curDev ++)
+	{
+		const PLR_DEV_PROFILE& dp = prof.devices[curDev];
+		const char* devName = SndEmu_GetDevName(dp.type, 0x00, NULL);
+		
+		printf("  dev %u.%u %-12s update: %llu calls, %llu smpls, %.3f ms | resample: %.3f ms | writes: %llu, DAC cmds: %llu\n",
+			dp.id, dp.linkIdx, (devName != NULL) ? devName : "?",
+			(unsigned long long)dp.updCalls, (unsigned long long)dp.updSmpls, dp.updTime / 1000000.0,
+			dp.rsmplTime / 1000000.0, (unsigned long long)dp.regWrites, (unsigned long long)dp.dacStrmCmds);
+	}
+	
+	return;
+}
+
+static int BenchmarkFile(PlayerA& player, const char* fileName, unsigned int runs,
+	double* retLength, double* retTime, std::string& retDevList, PLR_PROFILE* retProf)
+{
+	std::vector<UINT8> smplBuf(BUFFER_SMPLS * 2 * sizeof(INT16));
+	clock_t bestTime;
+	unsigned int curRun;
+	
+	*retLength = 0.0;
+	bestTime = 0;
+	for (curRun = 0; curRun < runs; curRun ++)
+	{
+		DATA_LOADER* dLoad;
+		PlayerBase* plrEngine;
+		UINT32 totalSmpls;
+		clock_t startTime;
+		clock_t runTime;
+		
+		dLoad = FileLoader_Init(fileName);
+		if (dLoad == NULL)
+			return 1;
+		DataLoader_SetPreloadBytes(dLoad, 0x100);
+		if (DataLoader_Load(dLoad) || player.LoadFile(dLoad))
+		{
+			printf("%s: failed to load file\n", fileName);
+			DataLoader_Deinit(dLoad);
+			return 1;
+		}
+		DataLoader_ReadAll(dLoad);	// exclude loading from the measurement
+		plrEngine = player.GetPlayer();
+		player.Start();
+		if (curRun == 0)
+			retDevList = GetDeviceList(plrEngine);
+		
+		totalSmpls = plrEngine->Tick2Sample(plrEngine->GetTotalPlayTicks(1));
+		*retLength = (double)totalSmpls / SMPL_RATE;
+		startTime = clock();
+		while (totalSmpls > 0)
+		{
+			UINT32 smpls = (totalSmpls < BUFFER_SMPLS) ? totalSmpls : BUFFER_SMPLS;
+			player.Render(smpls * 2 * sizeof(INT16), &smplBuf[0]);
+			totalSmpls -= smpls;
+		}
+		runTime = clock() - startTime;
+		if (curRun == 0 || runTime < bestTime)
+			bestTime = runTime;
+		if (retProf != NULL && plrEngine->GetProfile(*retProf))
+		{
+			printf("%s: no profiling data (player library built without PLAYER_PROFILING)\n", fileName);
+			retProf = NULL;
+		}
+		
+		player.Stop();
+		player.UnloadFile();
+		DataLoader_Deinit(dLoad);
+	}
+	*retTime = (double)bestTime / CLOCKS_PER_SEC;
+	
+	return 0;
+}
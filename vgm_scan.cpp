@@ -0,0 +1,418 @@
+// Song Library Scanner
+// --------------------
+// Collects song information (length, loop, sound chips, tags) of all song files in the
+// given directories, using several threads. Files are opened with ProbeFile(), which reads
+// only the parts of the file that are required for the information.
+// One line per file is printed (tab-separated: format, length, loop length, chips, title, game),
+// followed by the number of files per second.
+//	-t n: number of threads (default: number of CPUs)
+//	-l: use LoadFile() instead of ProbeFile() for comparison
+//	-q: don't print the file list, only the summary
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#ifndef _WIN32
+#include <time.h>		// for clock_gettime()
+#include <unistd.h>		// for sysconf()
+#include <dirent.h>
+#include <strings.h>	// for strcasecmp()
+#else
+#define strcasecmp	_stricmp
+#endif
+
+#include "stdtype.h"
+#include "player/playerbase.hpp"
+#include "player/vgmplayer.hpp"
+#include "player/s98player.hpp"
+#include "player/droplayer.hpp"
+#include "player/gymplayer.hpp"
+#include "player/playera.hpp"
+#include "utils/DataLoader.h"
+#include "utils/FileLoader.h"
+#include "utils/OSMutex.h"
+#include "utils/OSThread.h"
+#include "emu/SoundEmu.h"
+
+#define MAX_THREADS	64
+
+struct SCAN_FILE
+{
+	std::string fileName;
+	std::string info;	// output line (without file name), empty = loading failed
+};
+
+struct SCAN_WORKER
+{
+	OS_THREAD* hThread;
+	PlayerA player;
+};
+
+static void ScanDirectory(const std::string& dirName, std::vector<SCAN_FILE>& files);
+static bool IsDirectory(const char* path);
+static bool IsSongFile(const char* fileName);
+static double GetTime(void);
+static unsigned int GetCPUCount(void);
+static void ScanThread(void* args);
+static std::string GetSongInfoLine(PlayerA& player);
+static const char* FindTag(const char* const* tagList, const char* tagName);
+
+static std::vector<SCAN_FILE> scanFiles;
+static size_t nextFile;
+static OS_MUTEX* hMutex;
+static bool fullLoad;
+
+int main(int argc, char* argv[])
+{
+	std::vector<SCAN_WORKER*> workers;
+	unsigned int threads = 0;
+	bool quiet = false;
+	int argbase = 1;
+	size_t curFile;
+	size_t curThr;
+	size_t failCnt;
+	double startTime;
+	double scanTime;
+	
+	fullLoad = false;
+	while (argbase < argc && argv[argbase][0] == '-')
+	{
+		if (! strcmp(argv[argbase], "-t") && argbase + 1 < argc)
+		{
+			threads = (unsigned int)strtoul(argv[argbase + 1], NULL, 0);
+			argbase ++;
+		}
+		else if (! strcmp(argv[argbase], "-l"))
+			fullLoad = true;
+		else if (! strcmp(argv[argbase], "-q"))
+			quiet = true;
+		else
+			break;
+		argbase ++;
+	}
+	if (argbase >= argc)
+	{
+		printf("Usage: %s [-t threads] [-l] [-q] dir1/file1 [dir2/file2 ...]\n", argv[0]);
+		printf("Scans all song files (including subdirectories) and prints their information.\n");
+		printf("  -t n  number of threads (default: number of CPUs)\n");
+		printf("  -l    fully load every file (LoadFile instead of ProbeFile)\n");
+		printf("  -q    print only the summary\n");
+		return 1;
+	}
+	if (! threads)
+		threads = GetCPUCount();
+	if (threads > MAX_THREADS)
+		threads = MAX_THREADS;
+	
+	for (; argbase < argc; argbase ++)
+	{
+		if (IsDirectory(argv[argbase]))
+		{
+			ScanDirectory(argv[argbase], scanFiles);
+		}
+		else
+		{
+			SCAN_FILE sf;
+			sf.fileName = argv[argbase];
+			scanFiles.push_back(sf);
+		}
+	}
+	if (OSMutex_Init(&hMutex, 0))
+	{
+		printf("Error creating mutex!\n");
+		return 2;
+	}
+	
+	startTime = GetTime();
+	nextFile = 0;
+	for (curThr = 0; curThr < threads; curThr ++)
+	{
+		SCAN_WORKER* sw = new SCAN_WORKER;
+		sw->player.RegisterPlayerEngine(new VGMPlayer);
+		sw->player.RegisterPlayerEngine(new S98Player);
+		sw->player.RegisterPlayerEngine(new DROPlayer);
+		sw->player.RegisterPlayerEngine(new GYMPlayer);
+		if (OSThread_Init(&sw->hThread, &ScanThread, sw))
+		{
+			sw->player.UnregisterAllPlayers();
+			delete sw;
+			break;
+		}
+		workers.push_back(sw);
+	}
+	if (workers.empty())
+		ScanThread(NULL);	// no threads available - do it here
+	for (curThr = 0; curThr < workers.size(); curThr ++)
+	{
+		SCAN_WORKER* sw = workers[curThr];
+		OSThread_Join(sw->hThread);
+		OSThread_Deinit(sw->hThread);
+		sw->player.UnregisterAllPlayers();
+		delete sw;
+	}
+	scanTime = GetTime() - startTime;
+	OSMutex_Deinit(hMutex);
+	
+	failCnt = 0;
+	for (curFile = 0; curFile < scanFiles.size(); curFile ++)
+	{
+		const SCAN_FILE& sf = scanFiles[curFile];
+		if (sf.info.empty())
+			failCnt ++;
+		if (quiet)
+			continue;
+		if (sf.info.empty())
+			printf("%s\t(unable to load)\n", sf.fileName.c_str());
+		else
+			printf("%s\t%s\n", sf.fileName.c_str(), sf.info.c_str());
+	}
+	fprintf(stderr, "%u files (%u failed) in %.3f s using %u threads (%s): %.1f files/s\n",
+		(unsigned int)scanFiles.size(), (unsigned int)failCnt, scanTime,
+		(unsigned int)(workers.empty() ? 1 : workers.size()), fullLoad ? "LoadFile" : "ProbeFile",
+		(scanTime > 0.0) ? scanFiles.size() / scanTime : 0.0);
+	
+	return 0;
+}
+
+static void ScanDirectory(const std::string& dirName, std::vector<SCAN_FILE>& files)
+{
+	std::vector<std::string> names;
+	std::string path;
+	size_t curName;
+	
+	path = dirName;
+	if (! path.empty() && path[path.length() - 1] != '/' && path[path.length() - 1] != '\\')
+		path += '/';
+	
+#ifdef _WIN32
+	{
+		WIN32_FIND_DATAA findData;
+		HANDLE hFind;
+		
+		hFind = FindFirstFileA((path + "*").c_str(), &findData);
+		if (hFind == INVALID_HANDLE_VALUE)
+		{
+			fprintf(stderr, "%s: unable to read directory\n", dirName.c_str());
+			return;
+		}
+		do
+		{
+			if (strcmp(findData.cFileName, ".") && strcmp(findData.cFileName, ".."))
+				names.push_back(findData.cFileName);
+		} while(FindNextFileA(hFind, &findData));
+		FindClose(hFind);
+	}
+#else
+	{
+		DIR* dir;
+		struct dirent* de;
+		
+		dir = opendir(dirName.c_str());
+		if (dir == NULL)
+		{
+			fprintf(stderr, "%s: unable to read directory\n", dirName.c_str());
+			return;
+		}
+		while((de = readdir(dir)) != NULL)
+		{
+			if (strcmp(de->d_name, ".") && strcmp(de->d_name, ".."))
+				names.push_back(de->d_name);
+		}
+		closedir(dir);
+	}
+#endif
+	
+	// list the files in a predictable order
+	std::sort(names.begin(), names.end());
+	for (curName = 0; curName < names.size(); curName ++)
+	{
+		std::string fullName = path + names[curName];
+		if (IsDirectory(fullName.c_str()))
+		{
+			ScanDirectory(fullName, files);
+		}
+		else if (IsSongFile(names[curName].c_str()))
+		{
+			SCAN_FILE sf;
+			sf.fileName = fullName;
+			files.push_back(sf);
+		}
+	}
+	
+	return;
+}
+
+static bool IsDirectory(const char* path)
+{
+	struct stat st;
+	
+	if (stat(path, &st))
+		return false;
+	return (st.st_mode & S_IFMT) == S_IFDIR;
+}
+
+static bool IsSongFile(const char* fileName)
+{
+	static const char* SONG_EXTS[] = {"vgm", "vgz", "s98", "dro", "gym", NULL};
+	const char* ext;
+	const char** curExt;
+	
+	ext = strrchr(fileName, '.');
+	if (ext == NULL)
+		return false;
+	for (curExt = SONG_EXTS; *curExt != NULL; curExt ++)
+	{
+		if (! strcasecmp(&ext[1], *curExt))
+			return true;
+	}
+	return false;
+}
+
+// returns a monotonic time in seconds
+static double GetTime(void)
+{
+#ifdef _WIN32
+	LARGE_INTEGER freq;
+	LARGE_INTEGER cnt;
+	
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&cnt);
+	return (double)cnt.QuadPart / (double)freq.QuadPart;
+#else
+	struct timespec tp;
+	
+	clock_gettime(CLOCK_MONOTONIC, &tp);
+	return tp.tv_sec + tp.tv_nsec / 1000000000.0;
+#endif
+}
+
+static unsigned int GetCPUCount(void)
+{
+#ifdef _WIN32
+	SYSTEM_INFO sysInfo;
+	
+	GetSystemInfo(&sysInfo);
+	return sysInfo.dwNumberOfProcessors ? sysInfo.dwNumberOfProcessors : 1;
+#else
+	long cpuCnt = sysconf(_SC_NPROCESSORS_ONLN);
+	
+	return (cpuCnt > 0) ? (unsigned int)cpuCnt : 1;
+#endif
+}
+
+static void ScanThread(void* args)
+{
+	SCAN_WORKER* sw = (SCAN_WORKER*)args;
+	PlayerA localPlayer;
+	PlayerA* player;
+	
+	if (sw != NULL)
+	{
+		player = &sw->player;
+	}
+	else
+	{
+		player = &localPlayer;
+		player->RegisterPlayerEngine(new VGMPlayer);
+		player->RegisterPlayerEngine(new S98Player);
+		player->RegisterPlayerEngine(new DROPlayer);
+		player->RegisterPlayerEngine(new GYMPlayer);
+	}
+	
+	while(true)
+	{
+		DATA_LOADER* dLoad;
+		size_t curFile;
+		UINT8 retVal;
+		
+		OSMutex_Lock(hMutex);
+		curFile = nextFile;
+		if (nextFile < scanFiles.size())
+			nextFile ++;
+		OSMutex_Unlock(hMutex);
+		if (curFile >= scanFiles.size())
+			break;
+		
+		// Each thread only accesses its own file entry, so no locking is needed here.
+		SCAN_FILE& sf = scanFiles[curFile];
+		dLoad = FileLoader_Init(sf.fileName.c_str());
+		if (dLoad == NULL)
+			continue;
+		DataLoader_SetPreloadBytes(dLoad, 0x100);
+		retVal = DataLoader_Load(dLoad);
+		if (! retVal)
+			retVal = fullLoad ? player->LoadFile(dLoad) : player->ProbeFile(dLoad);
+		if (! retVal)
+			sf.info = GetSongInfoLine(*player);
+		player->UnloadFile();
+		DataLoader_Deinit(dLoad);
+	}
+	
+	if (sw == NULL)
+		player->UnregisterAllPlayers();
+	return;
+}
+
+static std::string GetSongInfoLine(PlayerA& player)
+{
+	PlayerBase* plrEngine = player.GetPlayer();
+	std::vector<PLR_DEV_INFO> devInfList;
+	PLR_SONG_INFO songInf;
+	const char* const* tagList;
+	const char* tagStr;
+	std::string result;
+	std::string devList;
+	char buffer[0x40];
+	size_t curDev;
+	
+	if (plrEngine->GetSongInfo(songInf))
+		return std::string();
+	plrEngine->GetSongDeviceInfo(devInfList);
+	for (curDev = 0; curDev < devInfList.size(); curDev ++)
+	{
+		const PLR_DEV_INFO& pdi = devInfList[curDev];
+		const char* devName = SndEmu_GetDevName(pdi.type, 0x00, pdi.devCfg);
+		if (! devList.empty())
+			devList += ",";
+		devList += (devName != NULL) ? devName : "?";
+	}
+	tagList = plrEngine->GetTags();
+	
+	result = plrEngine->GetPlayerName();
+	sprintf(buffer, "\t%.2f", plrEngine->Tick2Second(songInf.songLen));
+	result += buffer;
+	if (songInf.loopTick != (UINT32)-1)
+		sprintf(buffer, "\t%.2f", plrEngine->Tick2Second(songInf.loopTick));	// the players return the loop length here
+	else
+		strcpy(buffer, "\t-");
+	result += buffer;
+	result += "\t" + devList;
+	tagStr = FindTag(tagList, "TITLE");
+	result += "\t";
+	result += (tagStr != NULL) ? tagStr : "";
+	tagStr = FindTag(tagList, "GAME");
+	result += "\t";
+	result += (tagStr != NULL) ? tagStr : "";
+	
+	return result;
+}
+
+static const char* FindTag(const char* const* tagList, const char* tagName)
+{
+	const char* const* t;
+	
+	for (t = tagList; *t != NULL; t += 2)
+	{
+		if (! strcmp(t[0], tagName))
+			return t[1];
+	}
+	return NULL;
+}
@@ -0,0 +1,363 @@
+// VGM Snapshot Seek Test
+// ----------------------
+// Checks that seeking with state snapshots (VGM_PLAY_OPTIONS.snapInterval) gives the same output
+// as resetting the player and replaying the song up to the seek position.
+// The test song is generated in memory. It uses a YM2612 (GPGX) and an SN76496 (MAME), whose cores
+// support saving their state, and plays PCM data with DAC streams and with direct DAC writes
+// (commands 0x8n/0xE0). A second PCM data block is added during the song, so that snapshots
+// taken before it have to rebuild the PCM bank.
+// The first player plays the whole song once to record snapshots and then seeks backwards and
+// forwards. A second player without snapshots seeks to the same positions after a Reset().
+// The program returns 0 when the output after every seek matches.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "stdtype.h"
+#include "player/playerbase.hpp"
+#include "player/vgmplayer.hpp"
+#include "utils/DataLoader.h"
+#include "utils/MemoryLoader.h"
+#include "emu/SoundDevs.h"
+#include "emu/EmuCores.h"
+
+#define SMPL_RATE	44100
+#define SNAP_INTERVAL	22050	// snapshot every 0.5 seconds (in ticks)
+#define FRAME_TICKS	735		// 1/60 second
+#define SONG_FRAMES	480		// 8 seconds
+#define PCM_BLK_LEN	0x3000
+#define CMP_SMPLS	22050	// samples compared after each seek
+#define BUFFER_SMPLS	1000
+
+static const UINT32 SEEK_LIST[] =
+{
+	300000, 70000, 200000, 5000, 330000, 140000, 160000,
+};
+#define SEEK_COUNT	(sizeof(SEEK_LIST) / sizeof(SEEK_LIST[0]))
+
+static UINT32 NextRandom(UINT32* rngState, UINT32 range);
+static void WriteLE32(std::vector<UINT8>& data, size_t ofs, UINT32 value);
+static void AddCommand(std::vector<UINT8>& data, UINT8 cmd, UINT8 reg, UINT8 value);
+static void AddDataBlock(std::vector<UINT8>& data, UINT32* rngState, UINT32 length);
+static void GenerateSong(std::vector<UINT8>& data);
+static void PlayerLogCB(void* userParam, PlayerBase* player, UINT8 level, UINT8 srcType, const char* srcTag, const char* message);
+static UINT8 SetupPlayer(VGMPlayer& player, DATA_LOADER* dLoad, UINT32 snapInterval);
+static void RenderSamples(VGMPlayer& player, UINT32 smplCnt, WAVE_32BS* data);
+
+int main(int argc, char* argv[])
+{
+	std::vector<UINT8> songData;
+	std::vector<WAVE_32BS> smplsSnap(CMP_SMPLS);
+	std::vector<WAVE_32BS> smplsReplay(CMP_SMPLS);
+	VGMPlayer plrSnap;
+	VGMPlayer plrReplay;
+	DATA_LOADER* dLoadSnap;
+	DATA_LOADER* dLoadReplay;
+	UINT8 snapDisabled;
+	unsigned int failCnt;
+	size_t curSeek;
+
+	GenerateSong(songData);
+	dLoadSnap = MemoryLoader_Init(&songData[0], (UINT32)songData.size());
+	dLoadReplay = MemoryLoader_Init(&songData[0], (UINT32)songData.size());
+	snapDisabled = 0;
+	plrSnap.SetLogCallback(PlayerLogCB, &snapDisabled);
+	if (SetupPlayer(plrSnap, dLoadSnap, SNAP_INTERVAL) || SetupPlayer(plrReplay, dLoadReplay, 0))
+	{
+		printf("Failed to load the test song!\n");
+		return 1;
+	}
+	if (snapDisabled)
+	{
+		printf("The sound cores of the test song don't support snapshots!\n");
+		return 1;
+	}
+
+	// play the song once to record the snapshots
+	while(! (plrSnap.GetState() & PLAYSTATE_END))
+		RenderSamples(plrSnap, BUFFER_SMPLS, &smplsSnap[0]);
+
+	failCnt = 0;
+	for (curSeek = 0; curSeek < SEEK_COUNT; curSeek ++)
+	{
+		UINT32 seekPos = SEEK_LIST[curSeek];
+		UINT32 curSmpl;
+
+		if (curSeek == SEEK_COUNT - 2)
+			plrSnap.Reset();	// the snapshots have to restore the PCM banks after a Reset()
+		plrSnap.Seek(PLAYPOS_SAMPLE, seekPos);
+		RenderSamples(plrSnap, CMP_SMPLS, &smplsSnap[0]);
+		plrReplay.Reset();
+		plrReplay.Seek(PLAYPOS_SAMPLE, seekPos);
+		RenderSamples(plrReplay, CMP_SMPLS, &smplsReplay[0]);
+
+		printf("Seek to sample %u: ", seekPos);
+		for (curSmpl = 0; curSmpl < CMP_SMPLS; curSmpl ++)
+		{
+			if (smplsSnap[curSmpl].L != smplsReplay[curSmpl].L || smplsSnap[curSmpl].R != smplsReplay[curSmpl].R)
+				break;
+		}
+		if (curSmpl < CMP_SMPLS)
+		{
+			printf("FAILED (output differs at sample %u)\n", seekPos + curSmpl);
+			failCnt ++;
+		}
+		else
+		{
+			printf("OK\n");
+		}
+	}
+
+	plrSnap.Stop();
+	plrReplay.Stop();
+	plrSnap.UnloadFile();
+	plrReplay.UnloadFile();
+	DataLoader_Deinit(dLoadSnap);
+	DataLoader_Deinit(dLoadReplay);
+
+	if (failCnt)
+		printf("%u of %u seek(s) failed.\n", failCnt, (unsigned int)SEEK_COUNT);
+	else
+		printf("All seeks passed.\n");
+	return failCnt ? 1 : 0;
+}
+
+static UINT32 NextRandom(UINT32* rngState, UINT32 range)
+{
+	*rngState = *rngState * 1103515245 + 12345;
+	return (*rngState >> 8) % range;
+}
+
+static void WriteLE32(std::vector<UINT8>& data, size_t ofs, UINT32 value)
+{
+	data[ofs + 0] = (UINT8)(value >>  0);
+	data[ofs + 1] = (UINT8)(value >>  8);
+	data[ofs + 2] = (UINT8)(value >> 16);
+	data[ofs + 3] = (UINT8)(value >> 24);
+	return;
+}
+
+static void AddCommand(std::vector<UINT8>& data, UINT8 cmd, UINT8 reg, UINT8 value)
+{
+	data.push_back(cmd);
+	data.push_back(reg);
+	data.push_back(value);
+	return;
+}
+
+static void AddDataBlock(std::vector<UINT8>& data, UINT32* rngState, UINT32 length)
+{
+	size_t blkOfs = data.size();
+	UINT32 curPos;
+	UINT8 smplVal;
+
+	data.resize(blkOfs + 0x07 + length);
+	data[blkOfs + 0x00] = 0x67;
+	data[blkOfs + 0x01] = 0x66;
+	data[blkOfs + 0x02] = 0x00;	// YM2612 PCM data
+	WriteLE32(data, blkOfs + 0x03, length);
+	// square wave with a random period and noise
+	smplVal = 0x80;
+	for (curPos = 0; curPos < length; curPos ++)
+	{
+		if (NextRandom(rngState, 24) == 0)
+			smplVal ^= 0x60;
+		data[blkOfs + 0x07 + curPos] = (UINT8)(smplVal + NextRandom(rngState, 0x10));
+	}
+	return;
+}
+
+static void GenerateSong(std::vector<UINT8>& data)
+{
+	UINT32 rngState = 1;
+	UINT32 curFrame;
+	UINT8 curChn;
+	UINT8 curOp;
+	UINT8 pcmBlocks;
+
+	data.assign(0x100, 0x00);
+	memcpy(&data[0x00], "Vgm ", 4);
+	WriteLE32(data, 0x08, 0x171);	// version
+	WriteLE32(data, 0x0C, 3579545);	// SN76496 clock
+	WriteLE32(data, 0x18, SONG_FRAMES * FRAME_TICKS);	// total samples
+	WriteLE32(data, 0x24, 60);	// rate
+	data[0x28] = 0x09;	data[0x29] = 0x00;	// SN76496 feedback
+	data[0x2A] = 16;	// SN76496 shift register width
+	WriteLE32(data, 0x2C, 7670453);	// YM2612 clock
+	WriteLE32(data, 0x34, 0x100 - 0x34);	// data offset
+
+	AddDataBlock(data, &rngState, PCM_BLK_LEN);
+	pcmBlocks = 1;
+
+	// YM2612: instruments for channels 1-5, channel 6 is used for the DAC
+	for (curChn = 0; curChn < 5; curChn ++)
+	{
+		UINT8 cmd = (curChn < 3) ? 0x52 : 0x53;
+		UINT8 chn = curChn % 3;
+
+		for (curOp = 0; curOp < 4; curOp ++)
+		{
+			UINT8 opOfs = (UINT8)(curOp * 4 + chn);
+			AddCommand(data, cmd, 0x30 + opOfs, (UINT8)NextRandom(&rngState, 0x80));	// DT/MUL
+			AddCommand(data, cmd, 0x40 + opOfs, (UINT8)((curOp == 3) ? 0x08 : 0x18 + NextRandom(&rngState, 0x20)));	// TL
+			AddCommand(data, cmd, 0x50 + opOfs, (UINT8)(0x1C + NextRandom(&rngState, 4)));	// KS/AR
+			AddCommand(data, cmd, 0x60 + opOfs, (UINT8)NextRandom(&rngState, 0x10));	// AM/DR
+			AddCommand(data, cmd, 0x70 + opOfs, (UINT8)NextRandom(&rngState, 0x08));	// SR
+			AddCommand(data, cmd, 0x80 + opOfs, (UINT8)NextRandom(&rngState, 0x100));	// SL/RR
+		}
+		AddCommand(data, cmd, 0xB0 + chn, (UINT8)NextRandom(&rngState, 0x40));	// FB/algorithm
+		AddCommand(data, cmd, 0xB4 + chn, 0xC0);	// pan
+	}
+	AddCommand(data, 0x53, 0xB6, 0xC0);
+	AddCommand(data, 0x52, 0x2B, 0x80);	// DAC enable
+
+	// DAC stream 0 -> YM2612 register 0x2A, data from PCM bank 0x00
+	data.push_back(0x90);	data.push_back(0x00);	data.push_back(0x02);	data.push_back(0x00);	data.push_back(0x2A);
+	data.push_back(0x91);	data.push_back(0x00);	data.push_back(0x00);	data.push_back(0x01);	data.push_back(0x00);
+	data.push_back(0x92);	data.push_back(0x00);	data.resize(data.size() + 4);	WriteLE32(data, data.size() - 4, 11025);
+
+	for (curFrame = 0; curFrame < SONG_FRAMES; curFrame ++)
+	{
+		UINT8 dacMode = (curFrame >= 300 && curFrame < 360);	// direct DAC writes instead of the stream
+
+		// FM notes
+		if ((curFrame % 6) == 0)
+		{
+			UINT8 chnID = (UINT8)((curFrame / 6) % 5);
+			UINT8 cmd = (chnID < 3) ? 0x52 : 0x53;
+			UINT8 chn = chnID % 3;
+			UINT16 fnum = (UINT16)(0x200 + NextRandom(&rngState, 0x300));
+			UINT8 block = (UINT8)(2 + NextRandom(&rngState, 4));
+			UINT8 keyChn = (UINT8)((chnID < 3) ? chn : (4 + chn));
+
+			AddCommand(data, 0x52, 0x28, keyChn);	// key off
+			AddCommand(data, cmd, 0xA4 + chn, (UINT8)((block << 3) | (fnum >> 8)));
+			AddCommand(data, cmd, 0xA0 + chn, (UINT8)(fnum & 0xFF));
+			AddCommand(data, 0x52, 0x28, (UINT8)(0xF0 | keyChn));	// key on
+		}
+		if (NextRandom(&rngState, 4) == 0)
+		{
+			UINT8 chnID = (UINT8)NextRandom(&rngState, 5);
+			AddCommand(data, (chnID < 3) ? 0x52 : 0x53, (UINT8)(0x40 + NextRandom(&rngState, 4) * 4 + chnID % 3),
+				(UINT8)NextRandom(&rngState, 0x30));	// TL change
+		}
+
+		// PSG
+		if ((curFrame % 4) == 0)
+		{
+			UINT8 chn = (UINT8)((curFrame / 4) % 4);
+			UINT16 period = (UINT16)(0x40 + NextRandom(&rngState, 0x300));
+
+			data.push_back(0x50);	data.push_back((UINT8)(0x80 | (chn << 5) | (period & 0x0F)));
+			if (chn < 3)
+			{
+				data.push_back(0x50);	data.push_back((UINT8)(period >> 4));
+			}
+			data.push_back(0x50);	data.push_back((UINT8)(0x90 | (chn << 5) | NextRandom(&rngState, 0x10)));
+		}
+
+		// second PCM data block, added while the song is playing
+		if (curFrame == 150)
+		{
+			AddDataBlock(data, &rngState, PCM_BLK_LEN / 2);
+			pcmBlocks ++;
+		}
+
+		// DAC stream
+		if (curFrame == 300)
+		{
+			data.push_back(0x94);	data.push_back(0x00);	// stop
+		}
+		else if (! dacMode && (curFrame % 20) == 5)
+		{
+			if (NextRandom(&rngState, 3) == 0)
+			{
+				data.push_back(0x92);	data.push_back(0x00);	data.resize(data.size() + 4);
+				WriteLE32(data, data.size() - 4, 8000 + NextRandom(&rngState, 14000));
+			}
+			if (NextRandom(&rngState, 2))
+			{
+				// play one of the data blocks
+				data.push_back(0x95);	data.push_back(0x00);
+				data.push_back((UINT8)NextRandom(&rngState, pcmBlocks));	data.push_back(0x00);
+				data.push_back(NextRandom(&rngState, 4) ? 0x00 : 0x01);	// sometimes looped
+			}
+			else
+			{
+				// play a part of the PCM bank
+				data.push_back(0x93);	data.push_back(0x00);	data.resize(data.size() + 4);
+				WriteLE32(data, data.size() - 4, NextRandom(&rngState, PCM_BLK_LEN));
+				data.push_back(0x01);	// length = number of commands
+				data.resize(data.size() + 4);
+				WriteLE32(data, data.size() - 4, 2000 + NextRandom(&rngState, 6000));
+			}
+		}
+
+		if (dacMode)
+		{
+			UINT32 curTick;
+
+			// direct DAC writes from the PCM bank with a 5-sample delay each
+			data.push_back(0xE0);	data.resize(data.size() + 4);
+			WriteLE32(data, data.size() - 4, NextRandom(&rngState, PCM_BLK_LEN - FRAME_TICKS / 5));
+			for (curTick = 0; curTick < FRAME_TICKS; curTick += 5)
+				data.push_back(0x85);
+		}
+		else
+		{
+			data.push_back(0x62);	// wait 735 samples
+		}
+	}
+	data.push_back(0x66);
+	WriteLE32(data, 0x04, (UINT32)data.size() - 0x04);	// EOF offset
+
+	return;
+}
+
+static void PlayerLogCB(void* userParam, PlayerBase* player, UINT8 level, UINT8 srcType, const char* srcTag, const char* message)
+{
+	UINT8* snapDisabled = (UINT8*)userParam;
+
+	if (! strncmp(message, "Seek snapshots disabled", 23))
+		*snapDisabled = 1;
+	return;
+}
+
+static UINT8 SetupPlayer(VGMPlayer& player, DATA_LOADER* dLoad, UINT32 snapInterval)
+{
+	VGM_PLAY_OPTIONS playOpts;
+	PLR_DEV_OPTS devOpts;
+
+	player.SetSampleRate(SMPL_RATE);
+	if (DataLoader_Load(dLoad) || player.LoadFile(dLoad))
+		return 0xFF;
+
+	// use cores that support saving their state
+	player.GetDeviceOptions(PLR_DEV_ID(DEVID_YM2612, 0), devOpts);
+	devOpts.emuCore[0] = FCC_GPGX;
+	player.SetDeviceOptions(PLR_DEV_ID(DEVID_YM2612, 0), devOpts);
+	player.GetDeviceOptions(PLR_DEV_ID(DEVID_SN76496, 0), devOpts);
+	devOpts.emuCore[0] = FCC_MAME;
+	player.SetDeviceOptions(PLR_DEV_ID(DEVID_SN76496, 0), devOpts);
+
+	player.GetPlayerOptions(playOpts);
+	playOpts.snapInterval = snapInterval;
+	player.SetPlayerOptions(playOpts);
+	return player.Start();
+}
+
+static void RenderSamples(VGMPlayer& player, UINT32 smplCnt, WAVE_32BS* data)
+{
+	memset(data, 0x00, smplCnt * sizeof(WAVE_32BS));
+	while(smplCnt > 0)
+	{
+		UINT32 blkSize = (smplCnt < BUFFER_SMPLS) ? smplCnt : BUFFER_SMPLS;
+		UINT32 rendered = player.Render(blkSize, data);
+		if (! rendered)
+			break;
+		data += rendered;
+		smplCnt -= rendered;
+	}
+	return;
+}